@@ -1,9 +1,10 @@
 import React from "react";
 import Helmet from "react-helmet";
 import clsx from "classnames";
+import { drainEvents, EventHandlers } from "./events";
 
 interface Part {
-  id: string;
+  id: number;
   transform: Aakara.Transform;
 }
 
@@ -46,6 +47,8 @@ const Router: React.FC = function () {
     is_pressed: false,
     delta: null as Vec2 | null,
   });
+  const eventsRef = React.useRef<Uint32Array>();
+  const eventHandlersRef = React.useRef<EventHandlers>({});
   const [, updateState] = React.useState<any>();
   const [keyMap, set_keyMap] = React.useState<any>({});
   const [sensitivity, set_sensitivity] = React.useState({
@@ -109,9 +112,10 @@ const Router: React.FC = function () {
 
     _app.getRenderer().setColor(1.0, 1.0, 1.0);
 
-    const part_callback = function (part: Aakara.Part) {
-      const id = part.getId();
-      const transform = part.getTransform();
+    eventsRef.current = _app.getEvents();
+
+    const part_loaded = function (id: number) {
+      const transform = part_transform;
 
       console.group("Part Information");
       console.log("ID:       ", id);
@@ -131,7 +135,16 @@ const Router: React.FC = function () {
     };
 
     console.time("Part");
-    _app.loadPart("crate.obj", "crate_diffuse.png", part_transform, part_callback);
+    const part_id = _app.loadPart("crate.obj", "crate_diffuse.png", part_transform);
+
+    eventHandlersRef.current = {
+      partLoaded: (id) => {
+        if (id === part_id) part_loaded(id);
+      },
+      partFailed: (id) => {
+        if (id === part_id) console.error("Part failed to load");
+      },
+    };
 
     ref.addEventListener("click", function (ev: MouseEvent) {
       let rect = ref.getBoundingClientRect();
@@ -249,6 +262,9 @@ const Router: React.FC = function () {
       if (count > 0) {
         // console.log(`Drawing: ${count} items`);
       }
+
+      const dropped = drainEvents(eventsRef.current, eventHandlersRef.current);
+      if (dropped > 0) console.warn(`${dropped} engine events dropped`);
     } catch (error: any) {
       console.error(error);
       debugger;
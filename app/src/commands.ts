@@ -0,0 +1,144 @@
+/**
+ * Opcodes of the engine's command ring. Must match CommandType in wasm/include/aakara/CommandRing.hpp.
+ */
+export enum Command {
+  Pad = 0,
+  SetTransform = 1,
+  SetVisible = 2,
+  SetCamera = 3,
+  SetCameraLens = 4,
+  SetLightDirection = 5,
+  SetLightColor = 6,
+  SetClearColor = 7,
+}
+
+/**
+ * Encodes commands into the ring returned by App.getCommandRing(). Commands become visible to the engine on
+ * flush(), and are applied by the next App.draw().
+ *
+ * Every record is a header word, the opcode in the low 16 bits and the record length in words in the high 16
+ * bits, followed by its payload. A record that does not fit before the end of the ring is preceded by a Pad
+ * record filling the rest of it.
+ */
+export class CommandWriter {
+  private control: Uint32Array;
+  private words: Uint32Array;
+  private floats: Float32Array;
+  private mask: number;
+  private head: number;
+
+  constructor(ring: Aakara.CommandRingViews) {
+    this.control = ring.control;
+    this.words = ring.data;
+    this.floats = new Float32Array(ring.data.buffer, ring.data.byteOffset, ring.data.length);
+    this.mask = ring.capacity - 1;
+    this.head = ring.control[0];
+  }
+
+  setTransform(index: number, position: Vec3, rotation: Vec3, scale: Vec3): boolean {
+    const at = this.reserve(Command.SetTransform, 10);
+    if (at < 0) return false;
+
+    this.words[at] = index;
+    this.vec3(at + 1, position);
+    this.vec3(at + 4, rotation);
+    this.vec3(at + 7, scale);
+    return true;
+  }
+
+  setVisible(index: number, visible: boolean): boolean {
+    const at = this.reserve(Command.SetVisible, 2);
+    if (at < 0) return false;
+
+    this.words[at] = index;
+    this.words[at + 1] = visible ? 1 : 0;
+    return true;
+  }
+
+  setCamera(position: Vec3, rotation: Vec3): boolean {
+    const at = this.reserve(Command.SetCamera, 6);
+    if (at < 0) return false;
+
+    this.vec3(at, position);
+    this.vec3(at + 3, rotation);
+    return true;
+  }
+
+  setCameraLens(fov: number, near: number, far: number): boolean {
+    const at = this.reserve(Command.SetCameraLens, 3);
+    if (at < 0) return false;
+
+    this.floats[at] = fov;
+    this.floats[at + 1] = near;
+    this.floats[at + 2] = far;
+    return true;
+  }
+
+  setLightDirection(direction: Vec3): boolean {
+    const at = this.reserve(Command.SetLightDirection, 3);
+    if (at < 0) return false;
+
+    this.vec3(at, direction);
+    return true;
+  }
+
+  setLightColor(color: Vec3, strength: number): boolean {
+    const at = this.reserve(Command.SetLightColor, 4);
+    if (at < 0) return false;
+
+    this.vec3(at, color);
+    this.floats[at + 3] = strength;
+    return true;
+  }
+
+  setClearColor(r: number, g: number, b: number): boolean {
+    const at = this.reserve(Command.SetClearColor, 3);
+    if (at < 0) return false;
+
+    this.floats[at] = r;
+    this.floats[at + 1] = g;
+    this.floats[at + 2] = b;
+    return true;
+  }
+
+  /**
+   * Publish the commands written so far. Only needs Atomics.store when the engine runs on another thread;
+   * the ring is consumed by App.draw() on this one.
+   */
+  flush(): void {
+    this.control[0] = this.head;
+  }
+
+  /**
+   * Write a record header and return the word index of its payload, or -1 if the ring is full.
+   */
+  private reserve(command: Command, payloadWords: number): number {
+    const bytes = (payloadWords + 1) * 4;
+    const capacity = this.mask + 1;
+    const used = (this.head - this.control[1]) >>> 0;
+    const end = capacity - (this.head & this.mask);
+
+    let free = capacity - used;
+    if (bytes > end) {
+      if (end + bytes > free) return -1;
+
+      this.words[(this.head & this.mask) >>> 2] = ((end >>> 2) << 16) | Command.Pad;
+      this.head = (this.head + end) >>> 0;
+      free -= end;
+    }
+
+    if (bytes > free) return -1;
+
+    const at = (this.head & this.mask) >>> 2;
+    this.words[at] = (((payloadWords + 1) << 16) | command) >>> 0;
+    this.head = (this.head + bytes) >>> 0;
+
+    return at + 1;
+  }
+
+  private vec3(at: number, v: Vec3): void {
+    this.floats[at] = v.x;
+    this.floats[at + 1] = v.y;
+    this.floats[at + 2] = v.z;
+  }
+}
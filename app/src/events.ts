@@ -0,0 +1,75 @@
+/**
+ * Event types of the engine's event buffer. Must match EventType in wasm/include/aakara/EventBuffer.hpp.
+ */
+export enum EngineEvent {
+  PartLoaded = 1,
+  PartFailed = 2,
+  BatchProgress = 3,
+  FrameStats = 4,
+  UploadStats = 5,
+  ChunkFailed = 6,
+}
+
+export interface EventHandlers {
+  /** batch and index are 0 for parts loaded with App.loadPart(). */
+  partLoaded?(part: number, transformIndex: number, batch: number, index: number): void;
+  /** part is 0 when a manifest entry was rejected before loading. */
+  partFailed?(part: number, batch: number, index: number): void;
+  batchProgress?(batch: number, total: number, loaded: number, failed: number): void;
+  frameStats?(packets: number, entries: number, inFlight: number, pending: number): void;
+  /** Sent every frame GPU uploads are queued or done; stallMs is the wait of the oldest queued upload. */
+  uploadStats?(parts: number, chunks: number, bytes: number, uploadUs: number, stallMs: number): void;
+  /** A chunk of a streamed mesh could not be fetched or decoded; the part is drawn without it. */
+  chunkFailed?(part: number, chunk: number, batch: number, index: number): void;
+}
+
+/**
+ * Dispatch every event in the buffer returned by App.getEvents() and empty it. Call once after every
+ * App.draw().
+ *
+ * @returns Number of events dropped since the previous drain because the buffer was full.
+ */
+export function drainEvents(events: Uint32Array, handlers: EventHandlers): number {
+  const used = Math.min(events[0], events.length - 2);
+  const end = 2 + used;
+  const dropped = events[1];
+
+  for (let at = 2; at < end; ) {
+    const type = events[at] & 0xffff;
+    const words = events[at] >>> 16;
+    if (words === 0 || at + words > end) break;
+
+    const p = at + 1;
+    switch (type) {
+      case EngineEvent.PartLoaded:
+        handlers.partLoaded?.(events[p], events[p + 1], events[p + 2], events[p + 3]);
+        break;
+      case EngineEvent.PartFailed:
+        handlers.partFailed?.(events[p], events[p + 1], events[p + 2]);
+        break;
+      case EngineEvent.BatchProgress:
+        handlers.batchProgress?.(events[p], events[p + 1], events[p + 2], events[p + 3]);
+        break;
+      case EngineEvent.FrameStats:
+        handlers.frameStats?.(events[p], events[p + 1], events[p + 2], events[p + 3]);
+        break;
+      case EngineEvent.UploadStats:
+        handlers.uploadStats?.(events[p], events[p + 1], events[p + 2], events[p + 3], events[p + 4]);
+        break;
+      case EngineEvent.ChunkFailed:
+        handlers.chunkFailed?.(events[p], events[p + 1], events[p + 2], events[p + 3]);
+        break;
+    }
+
+    at += words;
+  }
+
+  // keep events pushed by the handlers themselves, e.g. through App.loadParts()
+  const added = Math.min(events[0], events.length - 2) - used;
+  if (added > 0) events.copyWithin(2, end, end + added);
+
+  events[0] = Math.max(added, 0);
+  events[1] = 0;
+
+  return dropped;
+}
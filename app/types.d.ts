@@ -51,8 +51,103 @@ module Aakara {
   }
 
   class Part {
-    getId(): string;
+    getId(): number;
     getTransform(): Transform;
+    /** Index of the part's position, rotation and scale in TransformViews, in units of three floats. */
+    getTransformIndex(): number;
+  }
+
+  interface TransformViews {
+    positions: Float32Array;
+    rotations: Float32Array;
+    scales: Float32Array;
+    /** [range count, layout version, first0, count0, first1, count1, ...] */
+    dirty: Uint32Array;
+    version: number;
+  }
+
+  interface CommandRingViews {
+    /** [head, tail], in bytes. */
+    control: Uint32Array;
+    data: Uint32Array;
+    /** Size of data in bytes, a power of two. */
+    capacity: number;
+  }
+
+  interface PoolReport {
+    live: number;
+    peak: number;
+    /** Slots reserved, live or free; pools grow in blocks and never shrink. */
+    capacity: number;
+    blocks: number;
+    emptyBlocks: number;
+    /** Share of capacity that is free but held by blocks with live objects. */
+    fragmentation: number;
+    objectSize: number;
+    reservedBytes: number;
+  }
+
+  interface MemoryReport {
+    parts: PoolReport;
+    transforms: PoolReport;
+    meshes: PoolReport;
+    textures: PoolReport;
+    gpuBuffers: {
+      blocks: number;
+      meshes: number;
+      capacityBytes: number;
+      usedBytes: number;
+      /** Bytes uploaded again to free sparse blocks. */
+      movedBytes: number;
+    };
+  }
+
+  /** Bytes per subsystem. */
+  interface CpuMemory {
+    meshes: number;
+    textures: number;
+    assimp: number;
+    decode: number;
+    loader: number;
+    render: number;
+  }
+
+  /** Bytes handed to WebGL; pending is decoded but not uploaded yet. */
+  interface GpuMemory {
+    pending: number;
+    buffers: number;
+    textures: number;
+  }
+
+  interface MemoryStats {
+    cpu: CpuMemory & { total: number };
+    gpu: GpuMemory & { total: number };
+    peaks: { cpu: CpuMemory; gpu: GpuMemory };
+    budget: {
+      /** 0 when unlimited. */
+      cpuLimit: number;
+      gpuLimit: number;
+      /** Estimates of assets being decoded. */
+      cpuReserved: number;
+      gpuReserved: number;
+      /** Loads currently waiting for memory. */
+      deferred: number;
+      downscaled: number;
+      rejected: number;
+    };
+    /** Asset bytes copied per pipeline stage since startup. */
+    copied: { fetch: number; decode: number; cache: number; upload: number; total: number };
+  }
+
+  interface PartManifest {
+    /** Distinct asset URLs. */
+    urls: string[];
+    /** Mesh URL index and texture URL index per part. */
+    parts: Uint32Array;
+    /** Position, rotation and scale (9 floats) per part. */
+    transforms: Float32Array;
+    /** Local minimum and maximum corner (6 floats) per part; parts in view and large on screen load first. */
+    bounds?: Float32Array;
   }
 
   class Renderer {
@@ -65,9 +160,37 @@ module Aakara {
     getCamera(): Camera;
     getLight(): Light;
     draw(): number;
-    setTransform(id: string, transform: Transform): void;
-    loadPart(mesh_url: string, tex_url: string, transform: Transform, cb: (part: Part) => void): void;
-    removePart(id: string): void;
+    setTransform(id: number, transform: Transform): void;
+    getTransformViews(): TransformViews;
+    getCommandRing(): CommandRingViews;
+    /** [record words, dropped events, records...]; see drainEvents() in src/events.ts. */
+    getEvents(): Uint32Array;
+    getMemoryReport(): MemoryReport;
+    getMemoryStats(): MemoryStats;
+    /** Limits in bytes, 0 for none. Loads over them wait, are downscaled (textures) or fail. */
+    setMemoryBudget(cpuBytes: number, gpuBytes: number): void;
+    /** GPU uploads per frame, 0 for no limit. Parts appear once uploaded completely. */
+    setUploadBudget(bytes: number, milliseconds: number): void;
+    /** Returns the part id reported by the PartLoaded or PartFailed event. */
+    loadPart(mesh_url: string, tex_url: string, transform: Transform): number;
+    /** Returns the batch id, or 0 if the manifest is malformed. */
+    loadParts(manifest: PartManifest): number;
+    /** Also cancels a part still loading, which then counts as failed in its batch. */
+    removePart(id: number): void;
+    /**
+     * Add a part whose vertices JS writes. Returns the part id, or 0 if the geometry is invalid. Pass
+     * stream when most vertices change every frame.
+     */
+    createDynamicPart(vertexCount: number, indices: Uint16Array, transform: Transform, stream: boolean): number;
+    /** 8 floats per vertex (position, normal, UV) over engine memory, or null if the part is not dynamic. */
+    getDynamicVertices(id: number): Float32Array | null;
+    /** Upload vertices written through getDynamicVertices() with the next draw(). */
+    updateDynamicPart(id: number, firstVertex: number, count: number): void;
+    /** Give a part a unique external name; an empty name removes it. */
+    setPartName(id: number, name: string): void;
+    /** Returns the id of the part with that name, or 0. */
+    findPart(name: string): number;
+    setMaxConcurrentLoads(count: number): void;
   }
 }
 
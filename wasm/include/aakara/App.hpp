@@ -2,17 +2,29 @@
 #define APP_HPP
 
 #include <utils.h>
-#include <thread_pool.h>
+#include <unordered_map>
 #include <glm/vec3.hpp>
 #include "Renderer.hpp"
 #include "Mesh.hpp"
 #include "Texture.hpp"
 #include "Renderer.hpp"
 #include "Transform.hpp"
+#include "TransformStore.hpp"
+#include "MpscQueue.hpp"
+#include "CommandRing.hpp"
+#include "EventBuffer.hpp"
+#include "PartTable.hpp"
+#include "JobSystem.hpp"
+#include "PartLoader.hpp"
+#include "MemoryBudget.hpp"
+#include "UploadScheduler.hpp"
 #include "Camera.hpp"
 #include "Part.hpp"
 #include "Lights.hpp"
 
+class RenderPipeline;
+struct FrameContext;
+
 class App
 {
 public:
@@ -25,10 +37,143 @@ public:
 
     size_t draw();
 
-    void setPartTransform( const string& id, const Transform& transform );
-
-    void loadPart( const string& mesh_url, const string& texture_url, Ptr<Transform> transform, JSObject cb );
-    void removePart( const string& id );
+    void setPartTransform( u32 id, const Transform& transform );
+
+    /**
+     * @brief Views for moving many parts from JS without a call per part.
+     * @details positions, rotations and scales are Float32Arrays over the engine's own transform arrays,
+     * three floats per part at Part.getTransformIndex(). After writing, JS appends (first, count) index
+     * ranges to dirty[2...] and stores the number of ranges in dirty[0]; the next draw() applies them in one
+     * pass and resets dirty[0]. dirty[1] holds the current layout version: once it differs from the version
+     * returned here, the float views are stale and must be fetched again. If the ranges do not fit, mark a
+     * single range covering them.
+     *
+     * @return JSObject { positions, rotations, scales, dirty, version }
+     */
+    JSObject getTransformViews();
+
+    /**
+     * @brief Views for driving the engine from JS through binary commands instead of a call per change.
+     * @details control is a Uint32Array holding the ring's head and tail, in bytes; data is a Uint32Array
+     * over the ring itself. JS writes records (see CommandRing and CommandType) into data and publishes them
+     * by storing the new head with Atomics.store; the next draw() applies every pending command in one
+     * pass. The views never go stale.
+     *
+     * @return JSObject { control, data, capacity }
+     */
+    JSObject getCommandRing();
+
+    /**
+     * @brief Buffer of engine events (see EventBuffer and EventType), as a Uint32Array JS drains after each
+     * draw(). Loads report their outcome here rather than through callbacks. The view never goes stale.
+     */
+    JSObject getEvents();
+
+    /**
+     * @brief Occupancy of the object pools holding parts, transforms, meshes and textures (see ObjectPool),
+     * and of the GPU buffer arena holding every mesh (see GpuBufferArena).
+     *
+     * @return JSObject { parts, transforms, meshes, textures }, each { live, peak, capacity, blocks,
+     * emptyBlocks, fragmentation, objectSize, reservedBytes }, and gpuBuffers { blocks, meshes,
+     * capacityBytes, usedBytes, movedBytes }
+     */
+    JSObject getMemoryReport();
+
+    /**
+     * @brief Bytes in use per subsystem on the heap and on the GPU, their peaks, and the state of the memory
+     * budget (see MemoryBudget).
+     *
+     * @return JSObject { cpu: { meshes, textures, assimp, decode, loader, render, total }, gpu: { pending,
+     * buffers, textures, total }, peaks: { cpu, gpu }, budget: { cpuLimit, gpuLimit, cpuReserved,
+     * gpuReserved, deferred, downscaled, rejected } }
+     */
+    JSObject getMemoryStats();
+
+    /**
+     * @brief Limit the memory assets may take. Loads over the limits wait, are downscaled or fail.
+     *
+     * @param cpuBytes Limit for the WASM heap, or 0 for none.
+     * @param gpuBytes Limit for buffers and textures handed to WebGL, or 0 for none.
+     */
+    void setMemoryBudget( double cpuBytes, double gpuBytes );
+
+    /**
+     * @brief Limit the GPU uploads of loaded parts per frame. Parts uploading over several frames appear once
+     * complete; an UploadStats event reports the queue every frame it is not empty.
+     *
+     * @param bytes Bytes uploaded per frame, or 0 for no limit.
+     * @param milliseconds Time spent uploading per frame, or 0 for no limit.
+     */
+    void setUploadBudget( double bytes, double milliseconds );
+
+    /**
+     * @brief Start loading a part. A PartLoaded or PartFailed event carrying the returned id follows. A chunk
+     * of a streamed mesh that cannot be loaded is reported by a ChunkFailed event, while the part keeps the
+     * other chunks.
+     *
+     * @return u32 Id of the part, or 0 if no more parts can be added.
+     */
+    u32 loadPart( const string& mesh_url, const string& texture_url, Ptr<Transform> transform );
+
+    /**
+     * @brief Give a part an external name, replacing its previous one. An empty name removes it. Names are
+     * unique: a name taken by another part moves to this one.
+     */
+    void setPartName( u32 id, const string& name );
+
+    /**
+     * @return u32 Id of the part with that name, or 0.
+     */
+    u32 findPart( const string& name );
+
+    /**
+     * @brief Load a whole assembly with one call.
+     * @details The manifest holds `urls`, the distinct asset URLs; `parts`, a Uint32Array with a mesh and a
+     * texture index into urls per part; and `transforms`, a Float32Array with position, rotation and scale
+     * per part. Assets shared between parts are loaded once. An optional `bounds` Float32Array, the local
+     * minimum and maximum corner per part, lets parts in view and large on screen load first.
+     *
+     * Every part reports a PartLoaded or PartFailed event carrying the batch and its manifest index, and the
+     * batch reports at most one BatchProgress event per frame.
+     *
+     * @return u32 Batch id, or 0 if the manifest is malformed.
+     */
+    u32  loadParts( JSObject manifest );
+
+    /**
+     * @brief Add a part whose vertices JS writes, e.g. simulation results, drawn untextured. It is ready at
+     * once: a PartLoaded event follows, and removePart(), setTransform() and names work as for other parts.
+     *
+     * @param indices Uint16Array of triangle indices, copied once.
+     * @param stream Whether most vertices change every frame; see DynamicGeometry.
+     * @return u32 Id of the part, or 0 if the geometry is invalid or no more parts can be added.
+     */
+    u32 createDynamicPart( u32 vertexCount, JSObject indices, Ptr<Transform> transform, bool stream );
+
+    /**
+     * @brief The vertices of a dynamic part as a Float32Array over engine memory, 8 floats per vertex:
+     * position, normal, UV. JS writes them in place and reports what it wrote with updateDynamicPart(). The
+     * view stays valid until the part is removed.
+     *
+     * @return JSObject The view, or null if the part is not dynamic.
+     */
+    JSObject getDynamicVertices( u32 id );
+
+    /**
+     * @brief Upload vertices written through getDynamicVertices() with the next draw().
+     */
+    void updateDynamicPart( u32 id, u32 firstVertex, u32 count );
+
+    /**
+     * @brief Remove a part. A part still loading is cancelled: its downloads are aborted and its decodes and
+     * uploads stop, it never reports PartLoaded, and it counts as failed in its batch.
+     */
+    void removePart( u32 id );
+
+    /**
+     * @brief Limit the number of asset requests outstanding at once. Further loads wait in line.
+     */
+    void setMaxConcurrentLoads( u32 count );
 
     Ptr<Renderer> getRenderer() const
     {
@@ -46,16 +191,62 @@ private:
     Ptr<Renderer>         m_renderer = nullptr;
     Ptr<DirectionalLight> m_sunlight = nullptr;
 
-    std::map<string, Ptr<Part>> m_parts;
-    std::queue<Ptr<Part>>       m_queuedParts;
+    // every part from loadPart() until removePart(), loaded or not
+    PartTable      m_parts;
+    TransformStore m_transforms;
+
+    // shared with JS: range count, layout version, then (first, count) pairs; never reallocated
+    Array<u32> m_transformRanges;
+
+    // commands written by JS, applied at the start of draw()
+    CommandRing m_commands;
+    u32         m_commandsCorrupt = 0;
+
+    // parts and streamed mesh chunks finished by loader tasks, drained by the render thread
+    MpscQueue<Ref<Part>>   m_queuedParts;
+    MpscQueue<LoadedChunk> m_queuedChunks;
+    MemoryBudget           m_budget;
+    PartLoader             m_loader;
+
+    // loaded parts and chunks until their GPU upload completes
+    UploadScheduler m_uploads;
+
+    // dynamic parts written since the last draw(), and the texture they are drawn with
+    Array<u32>   m_dirtyDynamicParts;
+    Ref<Texture> m_blankTexture;
+
+    // render list, transform store and frame scratch, recharged every frame
+    MemoryCharge m_renderCharge;
+
+    // events for JS, drained after every draw()
+    EventBuffer m_events;
+
+    struct Batch
+    {
+        u32  total;
+        u32  loaded  = 0;
+        u32  failed  = 0;
+        bool changed = false;
+    };
+
+    std::map<u32, Batch> m_batches;
+    u32                  m_nextBatch = 1;
 
-    // mapped JS callbacks for loading parts
-    std::map<string, JSObject> m_callbacks;
+    UPtr<FrameContext>   m_frame;
+    UPtr<RenderPipeline> m_pipeline;
 
-    thread_pool m_threads;
+    // declared last so queued tasks finish before anything they reference is destroyed
+    JobSystem m_jobs;
 
-    void clearById( const string& id );
+    void clearById( u32 id );
     void _processQueue();
+    void _addChunk( Part& part, Mesh& chunk );
+    void _addPart( Part& part );
+    void _countInBatch( const Part& part, bool loaded );
+    void _flushDynamicParts();
+    void _flushBatches();
+    void _applyTransformRanges();
+    void _applyCommands();
 };
 
 #endif
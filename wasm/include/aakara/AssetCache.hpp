@@ -0,0 +1,133 @@
+#ifndef ASSETCACHE_HPP
+#define ASSETCACHE_HPP
+
+#include <utils.h>
+#include "fetch.hpp"
+
+/**
+ * @brief Named blob storage behind the asset cache.
+ */
+class CacheStorage
+{
+public:
+    virtual ~CacheStorage() = default;
+
+    /**
+     * @return bool False if there is no blob with that name.
+     */
+    virtual bool read( const string& name, Array<u8>& out ) = 0;
+    virtual void write( const string& name, const Array<u8>& data ) = 0;
+    virtual void remove( const string& name ) = 0;
+
+    /**
+     * @brief Make preceding writes durable.
+     */
+    virtual void flush()
+    {
+    }
+
+    /**
+     * @brief False while previously stored blobs are still being restored.
+     */
+    virtual bool ready() const
+    {
+        return true;
+    }
+};
+
+/**
+ * @brief Stores every blob as a file in a directory.
+ */
+class DirectoryStorage : public CacheStorage
+{
+public:
+    explicit DirectoryStorage( const string& directory );
+
+    bool read( const string& name, Array<u8>& out ) override;
+    void write( const string& name, const Array<u8>& data ) override;
+    void remove( const string& name ) override;
+
+protected:
+    string m_directory;
+
+    string pathOf( const string& name ) const;
+};
+
+#ifdef __EMSCRIPTEN__
+/**
+ * @brief Directory storage mounted on IDBFS, so its files survive page reloads.
+ * @details The mount is restored from IndexedDB asynchronously; until that finishes the storage reports not
+ * ready and the cache behaves as empty. flush() writes changes back to IndexedDB. Main thread only.
+ */
+class IdbfsStorage : public DirectoryStorage
+{
+public:
+    explicit IdbfsStorage( const string& mountPoint );
+
+    void flush() override;
+
+    bool ready() const override
+    {
+        return m_ready != 0;
+    }
+
+private:
+    volatile u8 m_ready = 0;
+};
+#endif
+
+/**
+ * @brief Persistent cache of converted, GPU-ready assets keyed by URL.
+ * @details Every entry remembers the ETag or Last-Modified of the response it was converted from, so a later
+ * session can revalidate it with a conditional request and skip both the transfer and the parsing when the
+ * server answers 304 Not Modified.
+ */
+class AssetCache
+{
+public:
+    /**
+     * @brief Bump whenever a serialized asset layout changes; older entries are then ignored.
+     */
+    static constexpr u32 FORMAT_VERSION = 1;
+
+    /**
+     * @param version Layout version entries are stored under; entries stored under any other are ignored.
+     */
+    explicit AssetCache( Ptr<CacheStorage> storage, u32 version = FORMAT_VERSION );
+
+    /**
+     * @brief Conditional request header revalidating the cached copy of url.
+     *
+     * @return bool False if url is not cached.
+     */
+    bool condition( const string& url, HTTP::Header& out );
+
+    /**
+     * @brief Read the cached payload of url.
+     *
+     * @return bool False if url is not cached.
+     */
+    bool load( const string& url, Array<u8>& payload );
+
+    /**
+     * @brief Store the converted payload of url along with the conditional header revalidating it.
+     */
+    void store( const string& url, const HTTP::Header& condition, const Array<u8>& payload );
+
+    void flush();
+
+    /**
+     * @brief Conditional request header matching the validator of a response.
+     *
+     * @return bool False if the response carries neither an ETag nor a Last-Modified header.
+     */
+    static bool ConditionFor( const HTTP::Response& response, HTTP::Header& out );
+
+private:
+    Ptr<CacheStorage> m_storage;
+    u32               m_version;
+
+    string nameOf( const string& url ) const;
+};
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef BINARY_HPP
+#define BINARY_HPP
+
+#include <utils.h>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+/**
+ * @brief Appends trivially copyable values to a byte buffer in native (little-endian) layout.
+ */
+class ByteWriter
+{
+public:
+    explicit ByteWriter( Array<u8>& out )
+        : m_out( out )
+    {
+    }
+
+    template <typename T> void write( const T& value )
+    {
+        writeArray( &value, 1 );
+    }
+
+    template <typename T> void writeArray( const T* values, size_t count )
+    {
+        static_assert( std::is_trivially_copyable<T>::value, "ByteWriter writes trivially copyable types" );
+
+        size_t offset = m_out.size();
+        m_out.resize( offset + sizeof( T ) * count );
+
+        if ( count )
+            std::memcpy( m_out.data() + offset, values, sizeof( T ) * count );
+    }
+
+private:
+    Array<u8>& m_out;
+};
+
+/**
+ * @brief Reads values written by ByteWriter, throwing std::runtime_error on truncated input.
+ */
+class ByteReader
+{
+public:
+    ByteReader( const u8* data, size_t size )
+        : m_data( data )
+        , m_size( size )
+    {
+    }
+
+    template <typename T> T read()
+    {
+        T value;
+        readArray( &value, 1 );
+        return value;
+    }
+
+    template <typename T> void readArray( T* values, size_t count )
+    {
+        static_assert( std::is_trivially_copyable<T>::value, "ByteReader reads trivially copyable types" );
+
+        if ( count > ( m_size - m_offset ) / sizeof( T ) )
+            throw std::runtime_error( "Unexpected end of binary data" );
+
+        if ( count )
+            std::memcpy( values, m_data + m_offset, sizeof( T ) * count );
+
+        m_offset += sizeof( T ) * count;
+    }
+
+    size_t remaining() const
+    {
+        return m_size - m_offset;
+    }
+
+private:
+    const u8* m_data;
+    size_t    m_size;
+    size_t    m_offset = 0;
+};
+
+#endif
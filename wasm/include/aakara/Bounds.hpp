@@ -0,0 +1,79 @@
+#ifndef BOUNDS_HPP
+#define BOUNDS_HPP
+
+#include <cmath>
+#include <utils.h>
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+
+/**
+ * @brief Axis-aligned bounding box.
+ */
+struct Bounds
+{
+    glm::vec3 Min = glm::vec3( 0.0f );
+    glm::vec3 Max = glm::vec3( 0.0f );
+
+    glm::vec3 center() const
+    {
+        return ( Min + Max ) * 0.5f;
+    }
+
+    glm::vec3 extents() const
+    {
+        return ( Max - Min ) * 0.5f;
+    }
+
+    /**
+     * @brief Axis-aligned box enclosing this box after transformation by the given matrix.
+     */
+    Bounds transformed( const glm::mat4& m ) const
+    {
+        glm::vec3 c = center();
+        glm::vec3 e = extents();
+
+        glm::vec3 wc, we;
+        for ( int i = 0; i < 3; i++ )
+        {
+            wc[i] = m[3][i] + m[0][i] * c.x + m[1][i] * c.y + m[2][i] * c.z;
+            we[i] = std::abs( m[0][i] ) * e.x + std::abs( m[1][i] ) * e.y + std::abs( m[2][i] ) * e.z;
+        }
+
+        return { wc - we, wc + we };
+    }
+
+    static Bounds FromPoints( const Array<glm::vec3>& points )
+    {
+        if ( points.empty() )
+            return {};
+
+        Bounds bounds { points[0], points[0] };
+        for ( const glm::vec3& p : points )
+        {
+            bounds.Min = glm::min( bounds.Min, p );
+            bounds.Max = glm::max( bounds.Max, p );
+        }
+
+        return bounds;
+    }
+
+    /**
+     * @brief Box enclosing the position member of each vertex, see GpuVertex.
+     */
+    template <typename Vertex> static Bounds FromVertices( const Array<Vertex>& vertices )
+    {
+        if ( vertices.empty() )
+            return {};
+
+        Bounds bounds { vertices[0].position, vertices[0].position };
+        for ( const Vertex& vertex : vertices )
+        {
+            bounds.Min = glm::min( bounds.Min, vertex.position );
+            bounds.Max = glm::max( bounds.Max, vertex.position );
+        }
+
+        return bounds;
+    }
+};
+
+#endif
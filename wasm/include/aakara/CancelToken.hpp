@@ -0,0 +1,58 @@
+#ifndef CANCELTOKEN_HPP
+#define CANCELTOKEN_HPP
+
+#include <utils.h>
+#include <atomic>
+#include <exception>
+
+/**
+ * @brief Flag telling the stages of a piece of work, on whichever thread, that its result is no longer
+ * wanted.
+ *
+ * The owner cancels; stages check between steps, or call throwIfCancelled() from deep inside a decoder, and
+ * give up early, releasing what they hold. A token lives with the work it belongs to (a Part, a shared asset)
+ * so every stage that can reach the work can reach the token.
+ */
+class CancelToken
+{
+public:
+    /**
+     * @brief Thrown by throwIfCancelled(). Not an error: callers catch it apart from other exceptions.
+     */
+    struct Cancelled : std::exception
+    {
+        const char* what() const noexcept override
+        {
+            return "cancelled";
+        }
+    };
+
+    CancelToken() = default;
+
+    CancelToken( const CancelToken& )            = delete;
+    CancelToken& operator=( const CancelToken& ) = delete;
+
+    void cancel()
+    {
+        m_cancelled.store( true, std::memory_order_relaxed );
+    }
+
+    bool cancelled() const
+    {
+        return m_cancelled.load( std::memory_order_relaxed );
+    }
+
+    /**
+     * @throws Cancelled if the token was cancelled
+     */
+    void throwIfCancelled() const
+    {
+        if ( cancelled() )
+            throw Cancelled();
+    }
+
+private:
+    std::atomic<bool> m_cancelled { false };
+};
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef CHUNKEDMESH_HPP
+#define CHUNKEDMESH_HPP
+
+#include <utils.h>
+#include "ObjectPool.hpp"
+#include "Bounds.hpp"
+
+class Mesh;
+
+/**
+ * @brief Container for meshes too large to fetch and upload in one piece.
+ *
+ * Layout: a u32 magic ("AKC1"), a u32 chunk count, the chunk table, then the chunks themselves. Every chunk
+ * is a standalone mesh written by Mesh::Serialize() with its own 16-bit index space, so it can be fetched
+ * with a single range request, decoded and drawn without waiting for the rest of the file.
+ */
+class ChunkedMesh
+{
+public:
+    static constexpr u32 MAGIC       = 0x31434B41; // "AKC1"
+    static constexpr u32 HEADER_SIZE = 8;
+
+    /**
+     * @brief Chunk table entry.
+     */
+    struct Chunk
+    {
+        u64    offset;
+        u32    size;
+        u32    vertexCount;
+        Bounds bounds;
+    };
+
+    /**
+     * @brief Parse the chunk table from the beginning of a chunked mesh.
+     *
+     * @param data First bytes of the file.
+     * @param size Number of bytes available.
+     * @param out Receives the chunk table.
+     * @param required Set to the size of header and table when false is returned.
+     * @return bool False if more bytes are needed to read the whole table.
+     * @throws std::runtime_error if the data is not a chunked mesh
+     */
+    static bool ReadTable( const u8* data, size_t size, Array<Chunk>& out, size_t& required );
+
+    /**
+     * @brief Write chunks into a chunked mesh.
+     */
+    static void Write( const Array<Ref<Mesh>>& chunks, Array<u8>& out );
+
+    /**
+     * @brief Cut a mesh into spatially coherent chunks of at most maxVertices vertices each.
+     * @details Triangles are ordered along the longest axis of the mesh bounds before being packed, so every
+     * chunk covers a slab of the mesh and culls well on its own.
+     */
+    static Array<Ref<Mesh>> Split( const Mesh& mesh, u32 maxVertices = 0xFFFF );
+
+    /**
+     * @brief Whether a URL names a chunked mesh (".akc"), which is streamed rather than fetched whole.
+     */
+    static bool IsChunked( const string& url );
+};
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef COMMANDRING_HPP
+#define COMMANDRING_HPP
+
+#include <utils.h>
+#include <atomic>
+
+/**
+ * @brief Opcodes of the commands JS writes into the App's command ring, with their payload in 32-bit words.
+ */
+enum class CommandType : u16
+{
+    Pad               = 0, // skipped; fills the ring up to its end
+    SetTransform      = 1, // u32 transform index, f32 position[3], f32 rotation[3], f32 scale[3]
+    SetVisible        = 2, // u32 transform index, u32 visible
+    SetCamera         = 3, // f32 position[3], f32 rotation[3]
+    SetCameraLens     = 4, // f32 fov, f32 near, f32 far
+    SetLightDirection = 5, // f32 direction[3]
+    SetLightColor     = 6, // f32 color[3], f32 strength
+    SetClearColor     = 7, // f32 color[3]
+};
+
+/**
+ * @brief Single-producer / single-consumer ring of binary command records.
+ *
+ * The ring lives in the WASM heap, which is a SharedArrayBuffer in threaded builds, so a JS producer on the
+ * main thread or in a worker writes records straight into it through typed array views. The producer
+ * advances head, the consumer advances tail; both count bytes, grow monotonically and wrap at 2^32.
+ *
+ * A record is a u32 header, the opcode in the low 16 bits and the record length in 32-bit words (header
+ * included) in the high 16 bits, followed by its payload. Records never straddle the end of the ring: a
+ * producer that does not fit writes a Pad record up to the end and continues at the start.
+ */
+class CommandRing
+{
+public:
+    /**
+     * @param capacity Size of the ring in bytes, rounded up to a power of two.
+     */
+    explicit CommandRing( u32 capacity );
+
+    CommandRing( const CommandRing& )            = delete;
+    CommandRing& operator=( const CommandRing& ) = delete;
+
+    /**
+     * @brief Append a record. Producer side, for native producers.
+     *
+     * @return bool False if the ring does not have room for it.
+     */
+    bool write( CommandType type, const u32* payload, u32 words );
+
+    /**
+     * @brief Hand every pending record to fn( CommandType type, const u32* payload, u32 words ). Consumer
+     * side.
+     *
+     * @return size_t Number of records consumed, pads excluded.
+     */
+    template <typename F> size_t consume( F&& fn )
+    {
+        u32    head  = m_head.load( std::memory_order_acquire );
+        u32    tail  = m_tail.load( std::memory_order_relaxed );
+        size_t count = 0;
+
+        while ( tail != head )
+        {
+            u32 offset = ( tail & m_mask ) / 4;
+            u32 header = m_data[offset];
+            u32 words  = header >> 16;
+
+            // a malformed record leaves no way to find the next one: drop everything pending
+            if ( words == 0 || offset + words > m_data.size() || words * 4 > head - tail )
+            {
+                tail = head;
+                m_corrupt++;
+                break;
+            }
+
+            CommandType type = (CommandType)( header & 0xFFFF );
+            if ( type != CommandType::Pad )
+            {
+                fn( type, &m_data[offset + 1], words - 1 );
+                count++;
+            }
+
+            tail += words * 4;
+        }
+
+        m_tail.store( tail, std::memory_order_release );
+
+        return count;
+    }
+
+    /**
+     * @brief The head and tail words, in that order, for a JS producer. Access them with Atomics.
+     */
+    u32* control()
+    {
+        return reinterpret_cast<u32*>( &m_head );
+    }
+
+    u32* data()
+    {
+        return m_data.data();
+    }
+
+    /**
+     * @brief Capacity in bytes.
+     */
+    u32 capacity() const
+    {
+        return m_mask + 1;
+    }
+
+    /**
+     * @brief Number of times pending records were dropped because of a malformed record.
+     */
+    u32 corrupt() const
+    {
+        return m_corrupt;
+    }
+
+private:
+    // laid out back to back so JS sees them as one Uint32Array
+    std::atomic<u32> m_head { 0 };
+    std::atomic<u32> m_tail { 0 };
+
+    Array<u32> m_data;
+    u32        m_mask;
+    u32        m_corrupt = 0;
+};
+
+#endif
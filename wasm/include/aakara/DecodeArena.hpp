@@ -0,0 +1,104 @@
+#ifndef DECODEARENA_HPP
+#define DECODEARENA_HPP
+
+#include <utils.h>
+#include <cstddef>
+
+/**
+ * @brief Per-thread scratch memory for decoding assets.
+ *
+ * Decode stages open a Scope around each asset; while one is open, allocations on that thread that only
+ * live for the decode (see Malloc(), Realloc(), Free()) are bumped from the thread's arena instead of taken
+ * from the shared heap, whose allocator is a single locked dlmalloc under pthreads. Closing the outermost
+ * scope releases everything at once. Only the results, the GPU-ready buffers, are allocated from the heap.
+ *
+ * The arena keeps one block sized to the largest asset decoded so far, up to RETAIN_LIMIT, so steady
+ * loading stops touching the heap for scratch memory.
+ */
+class DecodeArena
+{
+public:
+    /**
+     * @brief Most memory an idle arena keeps. Larger decodes still use the arena, then give it back.
+     */
+    static constexpr size_t RETAIN_LIMIT = 16 << 20;
+
+    /**
+     * @brief Routes scratch allocations of the current thread to its arena until destroyed. Nests.
+     */
+    class Scope
+    {
+    public:
+        Scope();
+        ~Scope();
+
+        Scope( const Scope& )            = delete;
+        Scope& operator=( const Scope& ) = delete;
+
+    private:
+        DecodeArena& m_arena;
+        size_t       m_block;
+        size_t       m_offset;
+    };
+
+    DecodeArena( const DecodeArena& )            = delete;
+    DecodeArena& operator=( const DecodeArena& ) = delete;
+    ~DecodeArena();
+
+    /**
+     * @brief The calling thread's arena.
+     */
+    static DecodeArena& Local();
+
+    /**
+     * @brief Allocate from the calling thread's arena inside a Scope, from the heap otherwise.
+     */
+    static void* Malloc( size_t size );
+
+    /**
+     * @param size Current size of the allocation, which the arena does not track.
+     */
+    static void* Realloc( void* pointer, size_t size, size_t newSize );
+
+    /**
+     * @brief Free a heap allocation; arena allocations are released with their scope.
+     */
+    static void Free( void* pointer );
+
+    /**
+     * @brief Largest number of bytes a single outermost scope used.
+     */
+    size_t highWater() const
+    {
+        return m_highWater;
+    }
+
+private:
+    struct Block
+    {
+        u8*    data;
+        size_t size;
+    };
+
+    Array<Block> m_blocks;
+    size_t       m_block  = 0;
+    size_t       m_offset = 0;
+    u32          m_depth  = 0;
+
+    // bytes handed out by the current outermost scope, and the most any scope used
+    size_t m_used      = 0;
+    size_t m_highWater = 0;
+
+    // last allocation, which Realloc() can grow in place
+    u8* m_last = nullptr;
+
+    DecodeArena() = default;
+
+    void* allocate( size_t size );
+    void* reallocate( void* pointer, size_t size, size_t newSize );
+    bool  owns( const void* pointer ) const;
+    void  rewind( size_t block, size_t offset );
+    void  release();
+};
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef DYNAMICGEOMETRY_HPP
+#define DYNAMICGEOMETRY_HPP
+
+#include <utils.h>
+#include "Bounds.hpp"
+#include "MemoryBudget.hpp"
+#include "GpuBufferArena.hpp"
+
+/**
+ * @brief GPU storage of a mesh whose vertices change after loading, such as simulation results.
+ *
+ * Vertices live in a staging array in the GpuVertex layout that callers, JS included, write in place; they
+ * mark what they wrote with markDirty() and flush() uploads it once per frame. The GPU may still be reading
+ * a buffer drawn by earlier frames, so writing into it would stall: Dynamic geometry rotates through
+ * RING_SIZE buffers, each brought up to date with glBufferSubData of only the vertices it has missed since
+ * it was last drawn, and Stream geometry, rewritten every frame, has its single buffer re-specified, which
+ * lets the driver orphan the old storage. Indices are fixed.
+ *
+ * Only used on the context thread.
+ */
+class DynamicGeometry
+{
+public:
+    enum class Usage : u8
+    {
+        Dynamic, // GL_DYNAMIC_DRAW, a few vertices change now and then
+        Stream   // GL_STREAM_DRAW, most vertices change every frame
+    };
+
+    static constexpr u32 RING_SIZE = 3;
+
+    /**
+     * @throws std::runtime_error if there are no vertices or indices, or an index is out of range
+     */
+    DynamicGeometry( u32 vertexCount, Array<u16> indices, Usage usage );
+    ~DynamicGeometry();
+
+    DynamicGeometry( const DynamicGeometry& )            = delete;
+    DynamicGeometry& operator=( const DynamicGeometry& ) = delete;
+
+    GpuVertex* vertices()
+    {
+        return m_vertices.data();
+    }
+
+    u32 vertexCount() const
+    {
+        return (u32)m_vertices.size();
+    }
+
+    u32 indexCount() const
+    {
+        return m_indexCount;
+    }
+
+    /**
+     * @brief Note that vertices were written to the staging array. Ranges past the end are clipped.
+     */
+    void markDirty( u32 first, u32 count );
+
+    bool isDirty() const
+    {
+        return m_dirty;
+    }
+
+    /**
+     * @brief Upload the vertices marked dirty since the last flush, into the next buffer of the ring.
+     * @return u64 Bytes uploaded.
+     */
+    u64 flush();
+
+    /**
+     * @brief Bounds of the staging vertices.
+     */
+    Bounds bounds() const;
+
+    u32 vertexBuffer() const
+    {
+        return m_vertexBuffers[m_current];
+    }
+
+    u32 indexBuffer() const
+    {
+        return m_indexBuffer;
+    }
+
+private:
+    // vertices [first, end) a ring buffer has not received yet
+    struct Stale
+    {
+        u32 first;
+        u32 end;
+    };
+
+    Array<GpuVertex> m_vertices;
+    u32              m_indexCount = 0;
+    Usage            m_usage;
+
+    u32   m_vertexBuffers[RING_SIZE] = {};
+    Stale m_stale[RING_SIZE]         = {};
+    u32   m_indexBuffer              = 0;
+    u32   m_current                  = 0;
+    bool  m_dirty                    = false;
+
+    MemoryCharge m_cpuCharge;
+    MemoryCharge m_gpuCharge;
+
+    u32 buffers() const
+    {
+        return m_usage == Usage::Stream ? 1 : RING_SIZE;
+    }
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef EVENTBUFFER_HPP
+#define EVENTBUFFER_HPP
+
+#include <utils.h>
+#include <initializer_list>
+
+/**
+ * @brief Kinds of events the engine reports to JS, with their payload in 32-bit words.
+ */
+enum class EventType : u16
+{
+    PartLoaded    = 1, // u32 part, u32 transform index, u32 batch, u32 batch index
+    PartFailed    = 2, // u32 part, u32 batch, u32 batch index
+    BatchProgress = 3, // u32 batch, u32 total, u32 loaded, u32 failed
+    FrameStats    = 4, // u32 draw packets, u32 render entries, u32 loads in flight, u32 loads pending
+    UploadStats   = 5, // u32 parts queued, u32 chunks queued, u32 bytes uploaded, u32 upload time in
+                       // microseconds, u32 wait of the oldest queued upload in milliseconds
+    ChunkFailed   = 6, // u32 part, u32 chunk, u32 batch, u32 batch index
+};
+
+/**
+ * @brief Append-only buffer of engine events that JS drains once per frame, after App::draw().
+ *
+ * Word 0 holds the number of record words written since the last drain and word 1 the number of events
+ * dropped because the buffer was full; records start at word 2. A record is a u32 header, the event type in
+ * the low 16 bits and the record length in words (header included) in the high 16 bits, followed by its
+ * payload. JS reads the records and then zeroes words 0 and 1; nothing calls back into JS.
+ */
+class EventBuffer
+{
+public:
+    static constexpr u32 HEADER_WORDS = 2;
+
+    /**
+     * @param words Size of the buffer in 32-bit words.
+     */
+    explicit EventBuffer( u32 words );
+
+    EventBuffer( const EventBuffer& )            = delete;
+    EventBuffer& operator=( const EventBuffer& ) = delete;
+
+    /**
+     * @return bool False if the event was dropped because the buffer is full.
+     */
+    bool push( EventType type, std::initializer_list<u32> payload );
+
+    u32* data()
+    {
+        return m_words.data();
+    }
+
+    size_t size() const
+    {
+        return m_words.size();
+    }
+
+private:
+    Array<u32> m_words;
+};
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef FRAMEARENA_HPP
+#define FRAMEARENA_HPP
+
+#include <utils.h>
+#include <mutex>
+#include <atomic>
+#include <cstddef>
+
+/**
+ * @brief Double-buffered linear allocator for data that lives for a frame.
+ *
+ * Allocation bumps an offset into the current buffer and is safe from any thread; nothing is freed
+ * individually. reset(), called once at the start of a frame, switches to the other buffer and rewinds it,
+ * so allocations made during a frame stay valid through the next one (e.g. for work still in flight) and are
+ * reclaimed the frame after.
+ *
+ * A buffer that runs out spills to the heap for the rest of the frame; when it is rewound it is regrown to
+ * fit everything it had to hold, so a steady workload stops touching the heap after a few frames.
+ */
+class FrameArena
+{
+public:
+    /**
+     * @param capacity Initial size of each of the two buffers, in bytes.
+     */
+    explicit FrameArena( size_t capacity = 1 << 20 );
+    ~FrameArena();
+
+    FrameArena( const FrameArena& )            = delete;
+    FrameArena& operator=( const FrameArena& ) = delete;
+
+    void* allocate( size_t size, size_t alignment = alignof( std::max_align_t ) );
+
+    template <typename T> T* allocate( size_t count )
+    {
+        return static_cast<T*>( allocate( sizeof( T ) * count, alignof( T ) ) );
+    }
+
+    /**
+     * @brief Start a frame. Not safe to call while other threads allocate.
+     */
+    void reset();
+
+    /**
+     * @brief Bytes allocated from the current buffer, spills included.
+     */
+    size_t used() const;
+
+    size_t capacity() const
+    {
+        return m_buffers[m_current].capacity;
+    }
+
+    /**
+     * @brief Number of heap allocations made because a buffer ran out, since construction.
+     */
+    u64 spills() const
+    {
+        return m_spills;
+    }
+
+private:
+    struct Buffer
+    {
+        u8*                 data     = nullptr;
+        size_t              capacity = 0;
+        std::atomic<size_t> offset { 0 };
+
+        // heap blocks taken after running out, and the bytes they hold
+        std::mutex   spillMutex;
+        Array<void*> spilled;
+        size_t       spilledBytes = 0;
+    };
+
+    Buffer           m_buffers[2];
+    u32              m_current = 0;
+    std::atomic<u64> m_spills { 0 };
+
+    void* spill( Buffer& buffer, size_t size, size_t alignment );
+    void  rewind( Buffer& buffer );
+};
+
+/**
+ * @brief STL allocator drawing from a FrameArena. Deallocation is a no-op, so reserve up front.
+ */
+template <typename T> class ArenaAllocator
+{
+public:
+    using value_type = T;
+
+    ArenaAllocator( FrameArena& arena ) noexcept
+        : m_arena( &arena )
+    {
+    }
+
+    template <typename U>
+    ArenaAllocator( const ArenaAllocator<U>& other ) noexcept
+        : m_arena( other.arena() )
+    {
+    }
+
+    T* allocate( size_t count )
+    {
+        return m_arena->allocate<T>( count );
+    }
+
+    void deallocate( T*, size_t ) noexcept
+    {
+    }
+
+    FrameArena* arena() const noexcept
+    {
+        return m_arena;
+    }
+
+    template <typename U> bool operator==( const ArenaAllocator<U>& other ) const noexcept
+    {
+        return m_arena == other.arena();
+    }
+
+    template <typename U> bool operator!=( const ArenaAllocator<U>& other ) const noexcept
+    {
+        return m_arena != other.arena();
+    }
+
+private:
+    FrameArena* m_arena;
+};
+
+/**
+ * @brief Vector for transient per-frame data, e.g. FrameArray<u32> order( count, 0, arena ).
+ */
+template <typename T> using FrameArray = std::vector<T, ArenaAllocator<T>>;
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef FRUSTUM_HPP
+#define FRUSTUM_HPP
+
+#include <cmath>
+#include <utils.h>
+#include <glm/vec4.hpp>
+#include <glm/mat4x4.hpp>
+#include "Bounds.hpp"
+
+/**
+ * @brief View frustum as six inward-facing planes.
+ */
+struct Frustum
+{
+    // left, right, bottom, top, near, far
+    glm::vec4 Planes[6];
+
+    /**
+     * @brief Extract the planes of a view-projection matrix (Gribb-Hartmann).
+     */
+    static Frustum FromMatrix( const glm::mat4& m )
+    {
+        Frustum frustum;
+        for ( int i = 0; i < 4; i++ )
+        {
+            frustum.Planes[0][i] = m[i][3] + m[i][0];
+            frustum.Planes[1][i] = m[i][3] - m[i][0];
+            frustum.Planes[2][i] = m[i][3] + m[i][1];
+            frustum.Planes[3][i] = m[i][3] - m[i][1];
+            frustum.Planes[4][i] = m[i][3] + m[i][2];
+            frustum.Planes[5][i] = m[i][3] - m[i][2];
+        }
+
+        return frustum;
+    }
+
+    /**
+     * @brief False only if the box lies entirely outside one of the planes.
+     */
+    bool intersects( const Bounds& bounds ) const
+    {
+        glm::vec3 c = bounds.center();
+        glm::vec3 e = bounds.extents();
+
+        for ( const glm::vec4& p : Planes )
+        {
+            float distance = p.x * c.x + p.y * c.y + p.z * c.z + p.w;
+            float radius   = std::abs( p.x ) * e.x + std::abs( p.y ) * e.y + std::abs( p.z ) * e.z;
+
+            if ( distance + radius < 0.0f )
+                return false;
+        }
+
+        return true;
+    }
+};
+
+#endif
@@ -0,0 +1,189 @@
+#ifndef GPUBUFFERARENA_HPP
+#define GPUBUFFERARENA_HPP
+
+#include <utils.h>
+#include <glm/glm.hpp>
+#include "HandleTable.hpp"
+#include "MemoryBudget.hpp"
+
+class Mesh;
+
+/**
+ * @brief Vertex layout of every mesh on the GPU: position, normal and UV interleaved in 32 bytes.
+ */
+struct GpuVertex
+{
+    glm::vec3 position;
+    glm::vec3 normal;
+    glm::vec2 uv;
+};
+
+/**
+ * @brief Vertex and index buffers shared by all static meshes.
+ *
+ * Meshes are sub-allocated from large blocks, each one vertex buffer and one index buffer, instead of owning
+ * buffers of their own; consecutive draws from the same block only set attribute pointers. WebGL 1 has no
+ * base vertex, so a mesh keeps its indices relative to its first vertex and Bind() offsets the attribute
+ * pointers instead. Free space of a block is kept in offset-ordered free lists, coalesced on release.
+ *
+ * A range is allocated first and written by upload(), which may take several calls with a byte budget so
+ * large meshes are spread over frames; the range is resident, and the mesh drawn, once all of it is written.
+ *
+ * defragment() evacuates sparse blocks into the others on idle frames so empty blocks can be deleted. WebGL 1
+ * cannot copy between buffers, so moved meshes are uploaded again from their own arrays; meshes that freed
+ * theirs (see Mesh::setReread()) are asked for them and move once they have them back.
+ *
+ * There is one arena per GL context, see Instance(). Only used on the context thread.
+ */
+class GpuBufferArena
+{
+public:
+    static constexpr u32 Invalid = HandleTable<u32>::Invalid;
+
+    // 4 MB of vertices and 1 MB of indices, four per vertex; larger meshes get a block of their own
+    static constexpr u32 BLOCK_VERTICES = 1 << 17;
+    static constexpr u32 BLOCK_INDICES  = 1 << 19;
+
+    /**
+     * @brief Where a mesh lives: a block, and its first vertex and index in that block's buffers.
+     */
+    struct Range
+    {
+        u32         block       = 0;
+        u32         firstVertex = 0;
+        u32         vertexCount = 0;
+        u32         firstIndex  = 0;
+        u32         indexCount  = 0;
+        Mesh*       owner       = nullptr;
+
+        // bytes written by upload(), vertices first
+        u64 uploaded = 0;
+
+        u64 bytes() const
+        {
+            return (u64)vertexCount * sizeof( GpuVertex ) + (u64)indexCount * sizeof( u16 );
+        }
+
+        bool resident() const
+        {
+            return uploaded == bytes();
+        }
+    };
+
+    struct Stats
+    {
+        u32 blocks        = 0;
+        u32 ranges        = 0;
+        u64 capacityBytes = 0;
+        u64 usedBytes     = 0;
+
+        // bytes uploaded again by defragment(), since startup
+        u64 movedBytes = 0;
+    };
+
+    /**
+     * @brief The arena of the engine's GL context. Never destroyed: the context may be gone by then.
+     */
+    static GpuBufferArena& Instance();
+
+    GpuBufferArena( const GpuBufferArena& )            = delete;
+    GpuBufferArena& operator=( const GpuBufferArena& ) = delete;
+
+    /**
+     * @brief Allocate a range for a mesh. Its vertices and indices are written by upload().
+     * @return u32 Handle of the range, or Invalid if the mesh has no vertices or indices.
+     */
+    u32 allocate( Mesh& mesh );
+
+    /**
+     * @brief Write the next part of a range's vertices and indices, at least one vertex or index.
+     *
+     * @param budget Bytes that may be written; reduced by the bytes written.
+     * @return bool Whether the range is resident, or true if the handle does not resolve.
+     */
+    bool upload( u32 handle, u64& budget );
+
+    void release( u32 handle );
+
+    /**
+     * @return const Range* The range, or null if the handle does not resolve.
+     */
+    const Range* get( u32 handle );
+
+    /**
+     * @brief Bind the buffers of a block, unless they are still bound.
+     */
+    void bind( u32 block );
+
+    /**
+     * @brief Forget which block is bound, after other code bound buffers of its own.
+     */
+    void resetBinding()
+    {
+        m_bound = NO_BLOCK;
+    }
+
+    /**
+     * @brief Move resident meshes out of the sparsest block into free space of the others, deleting the block
+     * once empty. Call on idle frames.
+     *
+     * @param maxBytes Most bytes to upload in this call.
+     * @return u64 Bytes uploaded.
+     */
+    u64 defragment( u64 maxBytes );
+
+    /**
+     * @brief Ranges moved by defragment() since startup. The draw keys of their meshes changed whenever this
+     * did, see Mesh::getKeyGeneration().
+     */
+    u64 moves() const
+    {
+        return m_moves;
+    }
+
+    Stats stats() const;
+
+private:
+    struct Span
+    {
+        u32 offset;
+        u32 size;
+    };
+
+    struct Block
+    {
+        u32          vertexBuffer   = 0;
+        u32          indexBuffer    = 0;
+        u32          vertexCapacity = 0;
+        u32          indexCapacity  = 0;
+        u32          liveVertices   = 0;
+        u32          liveIndices    = 0;
+        u32          ranges         = 0;
+        Array<Span>  freeVertices;
+        Array<Span>  freeIndices;
+        MemoryCharge charge;
+    };
+
+    static constexpr u32 NO_BLOCK = 0xFFFFFFFF;
+
+    // deleted blocks stay as empty slots so that block indices of live ranges do not change
+    Array<Block>       m_blocks;
+    Array<u32>         m_freeBlocks;
+    HandleTable<Range> m_ranges;
+    u32                m_bound      = NO_BLOCK;
+    u64                m_movedBytes = 0;
+    u64                m_moves      = 0;
+
+    GpuBufferArena() = default;
+
+    void createBlock( u32 vertexCapacity, u32 indexCapacity );
+    void destroyBlock( u32 block );
+    bool place( Range& range, u32 skipBlock );
+    u64  write( Range& range, u64 maxBytes );
+    void free( const Range& range );
+
+    static bool Take( Array<Span>& free, u32 size, u32& offset );
+    static void Give( Array<Span>& free, u32 offset, u32 size );
+};
+
+#endif
@@ -0,0 +1,145 @@
+#ifndef HANDLETABLE_HPP
+#define HANDLETABLE_HPP
+
+#include <utils.h>
+#include <utility>
+
+/**
+ * @brief Dense storage addressed by 32-bit generational handles.
+ *
+ * Values live contiguously in insertion order until removed; removal moves the last value into the hole, so
+ * iteration over values() is always linear. A handle packs a slot index (low INDEX_BITS) and the slot's
+ * generation (high bits). Releasing a slot bumps its generation, so handles to removed values stop
+ * resolving instead of aliasing whatever reuses the slot. Handle 0 is never issued.
+ */
+template <typename T> class HandleTable
+{
+public:
+    static constexpr u32 INDEX_BITS = 20;
+    static constexpr u32 INDEX_MASK = ( 1u << INDEX_BITS ) - 1;
+    static constexpr u32 Invalid    = 0;
+
+    /**
+     * @return u32 Handle of the new value, or Invalid if the table is full.
+     */
+    u32 insert( T value )
+    {
+        u32 index;
+        if ( !m_free.empty() )
+        {
+            index = m_free.back();
+            m_free.pop_back();
+        }
+        else
+        {
+            if ( m_slots.size() > INDEX_MASK )
+                return Invalid;
+
+            index = (u32)m_slots.size();
+            m_slots.push_back( { 0, 1 } );
+        }
+
+        m_slots[index].dense = (u32)m_values.size();
+        m_values.push_back( std::move( value ) );
+        m_handles.push_back( HandleOf( index ) );
+
+        return m_handles.back();
+    }
+
+    /**
+     * @return bool False if the handle did not resolve.
+     */
+    bool remove( u32 handle )
+    {
+        if ( !contains( handle ) )
+            return false;
+
+        u32 index = handle & INDEX_MASK;
+        u32 dense = m_slots[index].dense;
+        u32 last  = (u32)m_values.size() - 1;
+
+        if ( dense != last )
+        {
+            m_values[dense]                              = std::move( m_values[last] );
+            m_handles[dense]                             = m_handles[last];
+            m_slots[m_handles[dense] & INDEX_MASK].dense = dense;
+        }
+
+        m_values.pop_back();
+        m_handles.pop_back();
+
+        // generation 0 is skipped so that no handle is ever 0
+        Slot& slot      = m_slots[index];
+        slot.dense      = NONE;
+        slot.generation = ( slot.generation + 1 ) & ( ( 1u << ( 32 - INDEX_BITS ) ) - 1 );
+        if ( slot.generation == 0 )
+            slot.generation = 1;
+
+        m_free.push_back( index );
+
+        return true;
+    }
+
+    bool contains( u32 handle ) const
+    {
+        u32 index = handle & INDEX_MASK;
+        return handle != Invalid && index < m_slots.size() && HandleOf( index ) == handle
+            && m_slots[index].dense != NONE;
+    }
+
+    /**
+     * @return T* The value, or null if the handle does not resolve.
+     */
+    T* get( u32 handle )
+    {
+        return contains( handle ) ? &m_values[m_slots[handle & INDEX_MASK].dense] : nullptr;
+    }
+
+    /**
+     * @brief Live values, densely packed. Order changes on removal.
+     */
+    Array<T>& values()
+    {
+        return m_values;
+    }
+
+    /**
+     * @brief Handle of every value, parallel to values().
+     */
+    const Array<u32>& handles() const
+    {
+        return m_handles;
+    }
+
+    size_t size() const
+    {
+        return m_values.size();
+    }
+
+    void clear()
+    {
+        while ( !m_handles.empty() )
+            remove( m_handles.back() );
+    }
+
+private:
+    static constexpr u32 NONE = 0xFFFFFFFF;
+
+    struct Slot
+    {
+        u32 dense;
+        u32 generation;
+    };
+
+    Array<T>    m_values;
+    Array<u32>  m_handles; // dense index -> handle
+    Array<Slot> m_slots;   // slot index -> dense index and generation
+    Array<u32>  m_free;
+
+    u32 HandleOf( u32 index ) const
+    {
+        return m_slots[index].generation << INDEX_BITS | index;
+    }
+};
+
+#endif
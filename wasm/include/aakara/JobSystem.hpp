@@ -0,0 +1,266 @@
+#ifndef JOBSYSTEM_HPP
+#define JOBSYSTEM_HPP
+
+#include <utils.h>
+#include <new>
+#include <atomic>
+#include <mutex>
+#include <deque>
+#include <thread>
+#include <cstddef>
+#include <algorithm>
+#include <type_traits>
+#include <condition_variable>
+
+/**
+ * @brief Bytes of callable state stored inline in a job. Larger callables are boxed on the heap.
+ */
+constexpr size_t JOB_TASK_SIZE = 88;
+
+/**
+ * @brief Type-erased callable stored inside a job, replacing std::function without allocating for small
+ * captures.
+ */
+class JobTask
+{
+public:
+    template <typename F> void set( F&& fn )
+    {
+        using T = std::decay_t<F>;
+
+        if constexpr ( sizeof( T ) <= JOB_TASK_SIZE && alignof( T ) <= alignof( std::max_align_t ) )
+        {
+            new ( m_storage ) T( std::forward<F>( fn ) );
+            m_invoke  = []( void* p ) { ( *static_cast<T*>( p ) )(); };
+            m_destroy = []( void* p ) { static_cast<T*>( p )->~T(); };
+        }
+        else
+        {
+            new ( m_storage ) T*( new T( std::forward<F>( fn ) ) );
+            m_invoke  = []( void* p ) { ( **static_cast<T**>( p ) )(); };
+            m_destroy = []( void* p ) { delete *static_cast<T**>( p ); };
+        }
+    }
+
+    void invoke()
+    {
+        m_invoke( m_storage );
+    }
+
+    void reset()
+    {
+        if ( !m_destroy )
+            return;
+
+        m_destroy( m_storage );
+        m_invoke  = nullptr;
+        m_destroy = nullptr;
+    }
+
+private:
+    alignas( std::max_align_t ) unsigned char m_storage[JOB_TASK_SIZE];
+    void ( *m_invoke )( void* )  = nullptr;
+    void ( *m_destroy )( void* ) = nullptr;
+};
+
+/**
+ * @brief A unit of work. A job completes once its own task and all of its children have run.
+ */
+struct alignas( 64 ) Job
+{
+    JobTask          task;
+    Job*             parent = nullptr;
+    std::atomic<i32> unfinished { 0 };
+    u8               background = 0;
+};
+
+/**
+ * @brief Work-stealing job scheduler.
+ *
+ * Every participating thread owns a Chase-Lev deque: it pushes and pops its own jobs at the bottom while idle
+ * threads steal from the top. The thread that creates the JobSystem participates as thread 0 whenever it
+ * waits, so frame work never depends on a worker being free. Idle workers park on a condition variable.
+ *
+ * Jobs created with create() come from a per-thread ring of JOB_CAPACITY entries and are only valid until the
+ * creating thread has created that many more. Long-running work that may block, like fetching assets, goes
+ * through pushTask(): it is only ever picked up by workers, never by a thread helping out in wait().
+ */
+class JobSystem
+{
+public:
+    static constexpr u32 JOB_CAPACITY = 4096;
+
+    /**
+     * @param workers Number of worker threads to start, not counting the calling thread.
+     */
+    explicit JobSystem( u32 workers );
+    ~JobSystem();
+
+    JobSystem( const JobSystem& )            = delete;
+    JobSystem& operator=( const JobSystem& ) = delete;
+
+    /**
+     * @brief Create a job without scheduling it. Only callable from thread 0 and the workers.
+     */
+    template <typename F> Job* create( F&& fn )
+    {
+        return createChild( nullptr, std::forward<F>( fn ) );
+    }
+
+    /**
+     * @brief Create a job that parent waits for. The parent must not have completed yet.
+     */
+    template <typename F> Job* createChild( Job* parent, F&& fn )
+    {
+        Job* job = allocate();
+
+        job->task.set( std::forward<F>( fn ) );
+        job->parent     = parent;
+        job->unfinished = 1;
+        job->background = 0;
+
+        if ( parent )
+            parent->unfinished.fetch_add( 1 );
+
+        return job;
+    }
+
+    /**
+     * @brief Schedule a job on the calling thread's deque.
+     */
+    void run( Job* job );
+
+    /**
+     * @brief Help executing jobs until job and all of its children have completed.
+     */
+    void wait( Job* job );
+
+    /**
+     * @brief Execute one queued job on the calling thread, if there is any.
+     *
+     * @return bool False if no job was found.
+     */
+    bool runPending();
+
+    /**
+     * @brief Schedule a detached background task. Callable from any thread.
+     */
+    template <typename F> void pushTask( F&& fn )
+    {
+        Job* job = allocateBackground();
+
+        job->task.set( std::forward<F>( fn ) );
+        job->parent     = nullptr;
+        job->unfinished = 1;
+        job->background = 1;
+
+        submitBackground( job );
+    }
+
+    /**
+     * @brief Block until every task pushed with pushTask() has completed.
+     */
+    void waitForTasks();
+
+    /**
+     * @brief Split [0, count) into chunks of grain items and run fn( begin, end ) once per chunk.
+     * @details Ranges of chunks are split lazily: a thread only hands off half of its remaining range when
+     * its own deque is empty, so work spreads as fast as threads go idle without a job per chunk.
+     */
+    template <typename F> void parallelFor( size_t count, size_t grain, const F& fn )
+    {
+        if ( count == 0 )
+            return;
+
+        grain         = std::max<size_t>( grain, 1 );
+        size_t chunks = ( count + grain - 1 ) / grain;
+
+        if ( chunks == 1 || m_workerCount == 0 || threadIndex() == Invalid )
+        {
+            for ( size_t begin = 0; begin < count; begin += grain )
+                fn( begin, std::min( begin + grain, count ) );
+            return;
+        }
+
+        Job* root = create( [] {} );
+
+        runRange( Range<F> { &fn, root, 0, chunks, count, grain } );
+
+        execute( root );
+        wait( root );
+    }
+
+    u32 getWorkerCount() const
+    {
+        return m_workerCount;
+    }
+
+private:
+    static constexpr u32 Invalid = 0xFFFFFFFF;
+
+    struct Worker;
+
+    template <typename F> struct Range
+    {
+        const F* fn;
+        Job*     root;
+        size_t   begin;
+        size_t   end;
+        size_t   count;
+        size_t   grain;
+    };
+
+    template <typename F> void runRange( Range<F> range )
+    {
+        while ( range.begin < range.end )
+        {
+            if ( range.end - range.begin > 1 && localQueueEmpty() )
+            {
+                Range<F> right = range;
+
+                right.begin = range.begin + ( range.end - range.begin ) / 2;
+                range.end   = right.begin;
+
+                run( createChild( range.root, [this, right] { runRange( right ); } ) );
+                continue;
+            }
+
+            size_t begin = range.begin * range.grain;
+            ( *range.fn )( begin, std::min( begin + range.grain, range.count ) );
+
+            range.begin++;
+        }
+    }
+
+    Array<UPtr<Worker>> m_workers; // index 0 belongs to the creating thread
+    Array<std::thread>  m_threads;
+    u32                 m_workerCount = 0;
+    std::thread::id     m_owner;
+
+    /* ------------------------ Background tasks and parking ----------------------- */
+    std::mutex              m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_idle;
+    std::deque<Job*>        m_backgroundQueue;
+    Array<Job*>             m_backgroundFree;
+    Array<UPtr<Job>>        m_backgroundJobs;
+    std::atomic<u32>        m_backgroundPending { 0 };
+    std::atomic<u32>        m_backgroundActive { 0 };
+    std::atomic<u32>        m_sleeping { 0 };
+    bool                    m_stop = false;
+
+    u32  threadIndex() const;
+    Job* allocate();
+    Job* allocateBackground();
+    void submitBackground( Job* job );
+    bool localQueueEmpty() const;
+    bool anyQueued() const;
+
+    Job* findWork( u32 index, bool background );
+    void execute( Job* job );
+    void finish( Job* job );
+    void wake();
+    void workerLoop( u32 index );
+};
+
+#endif
@@ -0,0 +1,184 @@
+#ifndef MEMORYBUDGET_HPP
+#define MEMORYBUDGET_HPP
+
+#include <utils.h>
+#include <atomic>
+
+/**
+ * @brief What a tracked allocation is for. CPU tags count bytes on the WASM heap, GPU tags bytes handed to
+ * WebGL.
+ */
+enum class MemoryTag : u8
+{
+    Meshes,     // vertex and index arrays of meshes
+    Textures,   // pixels of textures
+    Assimp,     // scene graphs while Assimp imports a mesh
+    Decode,     // decode arenas, see DecodeArena
+    Loader,     // HTTP responses held by loads
+    Render,     // render list, transform store and frame arena
+    GpuPending, // GPU memory decoded meshes and textures will take once uploaded
+    GpuBuffers, // glBufferData
+    GpuTextures,
+    Count
+};
+
+/**
+ * @brief Where asset bytes are copied on their way from the network to the GPU. Buffers are otherwise moved
+ * between stages, so each asset should be copied about once per stage.
+ */
+enum class CopyStage : u8
+{
+    Fetch,  // response bodies, from the browser into the WASM heap
+    Decode, // parsed and decoded assets, into the arrays they keep: imports, images, deserialized copies
+    Cache,  // assets serialized for the AssetCache, and payloads read back from it
+    Upload, // arrays handed to WebGL, which copies them into GPU memory
+    Count
+};
+
+/**
+ * @brief Process-wide byte counts per MemoryTag, and bytes copied per CopyStage. Safe from any thread.
+ */
+namespace Memory
+{
+    void Track( MemoryTag tag, i64 bytes );
+
+    /**
+     * @brief Count bytes of an asset copied at a stage, see Copied().
+     */
+    void CountCopy( CopyStage stage, u64 bytes );
+
+    /**
+     * @return u64 Bytes copied at a stage since startup.
+     */
+    u64 Copied( CopyStage stage );
+
+    u64 Usage( MemoryTag tag );
+    u64 Peak( MemoryTag tag );
+
+    u64 CpuUsage();
+    u64 GpuUsage();
+
+    const char* NameOf( MemoryTag tag );
+    const char* NameOf( CopyStage stage );
+
+    template <typename T> size_t BytesOf( const Array<T>& array )
+    {
+        return array.capacity() * sizeof( T );
+    }
+}
+
+/**
+ * @brief Bytes charged to a MemoryTag for as long as the charge lives. Owners of tracked memory hold one and
+ * replace it when their size changes.
+ */
+class MemoryCharge
+{
+public:
+    MemoryCharge() = default;
+    MemoryCharge( MemoryTag tag, u64 bytes );
+    MemoryCharge( MemoryCharge&& other ) noexcept;
+    MemoryCharge& operator=( MemoryCharge&& other ) noexcept;
+    ~MemoryCharge();
+
+    MemoryCharge( const MemoryCharge& )            = delete;
+    MemoryCharge& operator=( const MemoryCharge& ) = delete;
+
+    u64 bytes() const
+    {
+        return m_bytes;
+    }
+
+private:
+    MemoryTag m_tag   = MemoryTag::Count;
+    u64       m_bytes = 0;
+};
+
+/**
+ * @brief Decides whether a load may go ahead given configured CPU and GPU limits.
+ *
+ * A load asks before it decodes, with an estimate of the CPU and GPU bytes the asset will take. Admitted
+ * estimates are reserved until the decode finishes and the asset's own charges take over, so loads in flight
+ * count against the limits too. A load that does not fit waits while other decodes are still in flight, since
+ * they release their transient memory when done; once none is, a scalable asset (a texture) is downscaled to
+ * fit and anything else is rejected. A limit of 0 means no limit.
+ *
+ * admit() runs on the main thread; release() may run on any thread.
+ */
+class MemoryBudget
+{
+public:
+    enum class Decision : u8
+    {
+        Admit,
+        Defer,
+        Downscale,
+        Reject
+    };
+
+    struct Estimate
+    {
+        u64 cpu = 0;
+        u64 gpu = 0;
+    };
+
+    /**
+     * @brief Every counter of Memory and of the budget, as a JS object. See App::getMemoryStats().
+     */
+    JSObject stats() const;
+
+    void setLimits( u64 cpuLimit, u64 gpuLimit );
+
+    u64 getCpuLimit() const
+    {
+        return m_cpuLimit;
+    }
+
+    u64 getGpuLimit() const
+    {
+        return m_gpuLimit;
+    }
+
+    /**
+     * @param estimate Bytes the asset takes at full size; on Admit and Downscale, what was reserved.
+     * @param scalable Whether the asset can be loaded smaller. Every downscale level quarters it.
+     * @param levels Set to the number of halvings on Downscale.
+     */
+    Decision admit( Estimate& estimate, bool scalable, u32& levels );
+
+    /**
+     * @brief End the reservation of an admitted estimate.
+     */
+    void release( const Estimate& estimate );
+
+    /**
+     * @brief Whether usage and reservations have reached either limit.
+     */
+    bool exhausted() const
+    {
+        return !fits( 1, 1 );
+    }
+
+    /**
+     * @brief Number of loads currently deferred, for stats.
+     */
+    void setDeferred( u32 count )
+    {
+        m_deferred = count;
+    }
+
+private:
+    u64 m_cpuLimit = 0;
+    u64 m_gpuLimit = 0;
+
+    std::atomic<u64> m_reservedCpu { 0 };
+    std::atomic<u64> m_reservedGpu { 0 };
+    std::atomic<u32> m_reservations { 0 };
+
+    u32 m_deferred   = 0;
+    u32 m_downscaled = 0;
+    u32 m_rejected   = 0;
+
+    bool fits( u64 cpu, u64 gpu ) const;
+};
+
+#endif
@@ -2,40 +2,163 @@
 #define MESH_HPP
 
 #include <utils.h>
+#include <functional>
 #include <glm/glm.hpp>
 #include <emscripten/val.h>
+#include "Bounds.hpp"
+#include "ObjectPool.hpp"
+#include "MemoryBudget.hpp"
+#include "GpuBufferArena.hpp"
+#include "DynamicGeometry.hpp"
+#include "CancelToken.hpp"
 
 template <typename T> using Array = std::vector<T>;
 
 class Shader;
 
-class Mesh
+class Mesh : public RefCounted
 {
 public:
-    std::vector<glm::vec3> Positions;
-    std::vector<glm::vec3> Normals;
-    std::vector<glm::vec2> UVMap;
-    std::vector<u16>       Indices;
+    /**
+     * @brief Reads the arrays of a mesh again after it let go of them, see setReread().
+     */
+    using Reread = std::function<void( const Ref<Mesh>& mesh )>;
+
+    /**
+     * @brief Vertices in the layout they have on the GPU, uploaded from as they are. Empty once released,
+     * see setReread().
+     */
+    Array<GpuVertex> Vertices;
+    Array<u16>       Indices;
+
+    /**
+     * @brief Bounds of the vertex positions in model space.
+     */
+    Bounds LocalBounds;
 
     Mesh();
-    Mesh( Array<glm::vec3>& pos, Array<glm::vec3>& norm, Array<u16>& indices, Array<glm::vec2>& uvmap );
+
+    /**
+     * @brief Take over arrays built by a decoder. Only moved in: a mesh's arrays are never copied.
+     */
+    Mesh( Array<GpuVertex>&& vertices, Array<u16>&& indices );
     ~Mesh();
 
     bool Bind( Shader* shader );
     void Unbind();
 
+    /**
+     * @brief Upload the whole mesh at once, unless it is resident already.
+     */
     bool update( Shader* shader );
 
+    /**
+     * @brief Upload the next part of the mesh into the GpuBufferArena, see GpuBufferArena::upload().
+     *
+     * @param budget Bytes that may be uploaded; reduced by the bytes uploaded.
+     * @return bool Whether nothing is left to upload: the mesh is resident, or it has no vertices or indices.
+     */
+    bool upload( u64& budget );
+
     void Draw();
 
+    void computeBounds();
+
+    /**
+     * @brief Whether the mesh has been uploaded to the GpuBufferArena completely.
+     */
+    bool isResident() const;
+
+    /**
+     * @brief Let the mesh free its vertex and index arrays once it is resident, keeping only its copy on the
+     * GPU. WebGL 1 can neither copy nor read back buffers, so when the GpuBufferArena has to move the mesh
+     * it asks for the arrays through requestArrays(), which calls reread on the context thread; reread hands
+     * them back through restoreArrays(), possibly frames later. Used for streamed chunks, which can be
+     * fetched again.
+     */
+    void setReread( Reread reread );
+
+    bool hasArrays() const
+    {
+        return !Vertices.empty();
+    }
+
+    /**
+     * @brief Have the arrays of a mesh that freed them read again, unless that is already under way.
+     */
+    void requestArrays();
+
+    /**
+     * @brief Take back the arrays read for requestArrays(). Empty or mismatched arrays, from a failed read,
+     * are ignored, and the next requestArrays() tries again.
+     */
+    void restoreArrays( Array<GpuVertex>&& vertices, Array<u16>&& indices );
+
+    /**
+     * @brief Called by the GpuBufferArena once it moved the mesh to another block.
+     */
+    void onMoved();
+
+    /**
+     * @brief Storage of a dynamic mesh, see CreateDynamic(); null for meshes in the GpuBufferArena.
+     */
+    DynamicGeometry* getDynamic()
+    {
+        return m_dynamic.get();
+    }
+
+    /**
+     * @brief Upload the changed vertices of a dynamic mesh and refresh LocalBounds from them.
+     * @return bool Whether anything changed.
+     */
+    bool flush();
+
+    /**
+     * @brief Orders meshes by their block in the GpuBufferArena, so that draws sorted by it rebind buffers
+     * as rarely as possible.
+     */
+    u32 getDrawKey() const;
+
+    /**
+     * @brief Incremented whenever getDrawKey() changes, which happens when the GpuBufferArena moves the mesh.
+     */
+    u32 getKeyGeneration() const
+    {
+        return m_keyGeneration;
+    }
+
+    /**
+     * @brief Append the vertex and index data in the form it is uploaded to the GPU.
+     */
+    void Serialize( Array<u8>& out ) const;
+
     static void                   LoadFromURL( const std::string& url, emscripten::val onLoad );
-    static std::vector<Ptr<Mesh>> LoadFromFile( Shader* shader, const std::string& url );
-    static Ptr<Mesh>              LoadFromMemory( const char* data, u32 size );
+    static std::vector<Ref<Mesh>> LoadFromFile( Shader* shader, const std::string& url );
 
-    static Ptr<Mesh> Create( Shader* shader, const Array<glm::vec3>& pos, const Array<glm::vec3>& norm,
-        const Array<u16> indices, const Array<glm::vec2>& uvmap );
+    /**
+     * @brief Import a mesh file. The import is abandoned between steps once cancel is cancelled.
+     * @throws std::runtime_error if the file cannot be imported
+     * @throws CancelToken::Cancelled if cancelled
+     */
+    static Ref<Mesh> LoadFromMemory( const char* data, u32 size, const CancelToken* cancel = nullptr );
+
+    /**
+     * @brief Recreate a mesh written by Serialize(), skipping any parsing. Meshes serialized before vertices
+     * were interleaved are still read.
+     * @throws std::runtime_error if the data is not a serialized mesh
+     */
+    static Ref<Mesh> Deserialize( const u8* data, size_t size );
 
-    u32 VBO = 0, NBO = 0, IBO = 0, CBO = 0;
+    /**
+     * @brief Create a mesh whose vertices are written after creation, through getDynamic(). Vertices start
+     * zeroed; the Vertices and Indices arrays stay empty.
+     *
+     * @throws std::runtime_error if there are no vertices or indices, or an index is out of range
+     */
+    static Ref<Mesh> CreateDynamic( u32 vertexCount, Array<u16> indices, DynamicGeometry::Usage usage );
+
+    static Ref<Mesh> Create( Shader* shader, const Array<glm::vec3>& pos, const Array<glm::vec3>& norm,
+        const Array<u16> indices, const Array<glm::vec2>& uvmap );
 
 private:
     /**
@@ -44,7 +167,31 @@ private:
      */
     void Optimize( f32 ratio = 0.5f );
 
+    /**
+     * @brief Charge the vertex and index arrays to MemoryTag::Meshes, and their GPU memory as pending until
+     * upload() completes. Uploaded meshes are charged with the arena's blocks.
+     */
+    void track();
+
+    /**
+     * @brief Free the arrays of a resident mesh that can read them again, see setReread().
+     */
+    void releaseArrays();
+
     bool m_isOptimized = false;
+
+    Reread m_reread;
+    bool   m_rereading = false;
+
+    u32 m_keyGeneration = 0;
+
+    // range in the GpuBufferArena; meshes keep their arrays, which defragmentation uploads again
+    u32 m_gpuRange = GpuBufferArena::Invalid;
+
+    MemoryCharge m_cpuCharge;
+    MemoryCharge m_gpuCharge;
+
+    UPtr<DynamicGeometry> m_dynamic;
 };
 
 #endif
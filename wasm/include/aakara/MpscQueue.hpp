@@ -0,0 +1,147 @@
+#ifndef MPSCQUEUE_HPP
+#define MPSCQUEUE_HPP
+
+#include <utils.h>
+#include <atomic>
+#include <new>
+#include <utility>
+
+/**
+ * @brief Bounded lock-free multi-producer / single-consumer ring.
+ *
+ * Every cell carries a sequence number telling producers and the consumer whose turn it is. Producers claim a
+ * cell with a single CAS on the tail and publish it by advancing the cell's sequence. The consumer never
+ * blocks: a cell that was claimed but not yet published simply ends the current drain, and is picked up by
+ * the next one. Payloads only need to be movable and default-constructible.
+ *
+ * @tparam T Payload type.
+ */
+template <typename T> class MpscQueue
+{
+public:
+    /**
+     * @param capacity Maximum number of queued items, rounded up to a power of two.
+     */
+    explicit MpscQueue( size_t capacity )
+    {
+        size_t size = 2;
+        while ( size < capacity )
+            size <<= 1;
+
+        m_mask  = size - 1;
+        m_cells = new Cell[size];
+
+        for ( size_t i = 0; i < size; i++ )
+            m_cells[i].sequence.store( i, std::memory_order_relaxed );
+    }
+
+    MpscQueue( const MpscQueue& )            = delete;
+    MpscQueue& operator=( const MpscQueue& ) = delete;
+
+    ~MpscQueue()
+    {
+        T item;
+        while ( tryPop( item ) )
+            ;
+
+        delete[] m_cells;
+    }
+
+    /**
+     * @brief Enqueue an item from any thread.
+     *
+     * @return bool False if the ring is full. The item is left untouched in that case.
+     */
+    bool tryPush( T&& item )
+    {
+        size_t pos = m_tail.load( std::memory_order_relaxed );
+
+        for ( ;; )
+        {
+            Cell&     cell     = m_cells[pos & m_mask];
+            size_t    sequence = cell.sequence.load( std::memory_order_acquire );
+            ptrdiff_t diff     = (ptrdiff_t)sequence - (ptrdiff_t)pos;
+
+            if ( diff == 0 )
+            {
+                if ( m_tail.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+                {
+                    new ( cell.storage ) T( std::move( item ) );
+                    cell.sequence.store( pos + 1, std::memory_order_release );
+                    return true;
+                }
+            }
+            else if ( diff < 0 )
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_tail.load( std::memory_order_relaxed );
+            }
+        }
+    }
+
+    /**
+     * @brief Dequeue the oldest published item. Consumer thread only; wait-free.
+     *
+     * @return bool False if there is nothing ready to take.
+     */
+    bool tryPop( T& item )
+    {
+        Cell&  cell     = m_cells[m_head & m_mask];
+        size_t sequence = cell.sequence.load( std::memory_order_acquire );
+
+        if ( sequence != m_head + 1 )
+            return false;
+
+        T* stored = reinterpret_cast<T*>( cell.storage );
+        item      = std::move( *stored );
+        stored->~T();
+
+        cell.sequence.store( m_head + m_mask + 1, std::memory_order_release );
+        m_head++;
+
+        return true;
+    }
+
+    /**
+     * @brief Pop every item ready right now and hand it to fn. Consumer thread only.
+     *
+     * @return size_t Number of items drained.
+     */
+    template <typename F> size_t drain( F&& fn )
+    {
+        size_t count = 0;
+
+        T item;
+        while ( tryPop( item ) )
+        {
+            fn( std::move( item ) );
+            count++;
+        }
+
+        return count;
+    }
+
+    size_t capacity() const
+    {
+        return m_mask + 1;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        alignas( T ) unsigned char storage[sizeof( T )];
+    };
+
+    Cell*  m_cells = nullptr;
+    size_t m_mask  = 0;
+
+    // producers and the consumer sit on separate cache lines
+    alignas( 64 ) std::atomic<size_t> m_tail { 0 };
+    alignas( 64 ) size_t m_head = 0;
+};
+
+#endif
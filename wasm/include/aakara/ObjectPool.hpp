@@ -0,0 +1,387 @@
+#ifndef OBJECTPOOL_HPP
+#define OBJECTPOOL_HPP
+
+#include <utils.h>
+#include <new>
+#include <mutex>
+#include <atomic>
+#include <utility>
+#include <cstddef>
+#include <algorithm>
+#include <stdexcept>
+
+template <typename T> class ObjectPool;
+template <typename T> class Ref;
+
+/**
+ * @brief Base of objects living in an ObjectPool, carrying their reference count and pool index inline.
+ * @details Copying an object never copies either: the copy starts unreferenced and unpooled.
+ */
+class RefCounted
+{
+public:
+    static constexpr u32 UNPOOLED = 0xFFFFFFFF;
+
+    /**
+     * @brief Index of the object in its pool, stable for the object's lifetime. UNPOOLED if the object was
+     * not created by a pool (e.g. a temporary).
+     */
+    u32 getPoolIndex() const
+    {
+        return m_poolIndex;
+    }
+
+protected:
+    RefCounted()
+    {
+    }
+
+    RefCounted( const RefCounted& )
+    {
+    }
+
+    RefCounted& operator=( const RefCounted& )
+    {
+        return *this;
+    }
+
+    ~RefCounted() = default;
+
+private:
+    template <typename T> friend class ObjectPool;
+    template <typename T> friend class Ref;
+
+    // atomic because decoded assets change hands between job system workers and the main thread
+    mutable std::atomic<u32> m_refs { 0 };
+    u32                      m_poolIndex = UNPOOLED;
+};
+
+/**
+ * @brief Occupancy of an ObjectPool.
+ */
+struct PoolStats
+{
+    size_t objectSize = 0;
+    u32    live       = 0;
+    u32    peak       = 0;
+    u32    capacity   = 0;
+    u32    blocks     = 0;
+
+    // blocks holding no live object
+    u32 emptyBlocks = 0;
+
+    // free slots in blocks that still hold live objects, so cannot be given back, over capacity
+    f32 fragmentation = 0.0f;
+
+    size_t reservedBytes() const
+    {
+        return objectSize * capacity;
+    }
+};
+
+/**
+ * @brief Typed storage for engine objects, handed out through intrusive references.
+ *
+ * Objects are constructed in fixed-size blocks that never move, so neighbours share cache lines and an
+ * object's address and index stay valid for its whole life. Freed slots are reused most recent first. There
+ * is one pool per type, see Instance(); create and destroy are safe from any thread.
+ *
+ * Engine code owns pooled objects through Ref. std::shared_ptr is only used where an object crosses the
+ * embind boundary, see Share() and RefOf().
+ */
+template <typename T> class ObjectPool
+{
+public:
+    static constexpr u32 BLOCK_SIZE = 64;
+
+    /**
+     * @brief The pool of T. Never destroyed, so references released during static destruction stay valid.
+     */
+    static ObjectPool& Instance()
+    {
+        static ObjectPool* pool = new ObjectPool();
+        return *pool;
+    }
+
+    ObjectPool( const ObjectPool& )            = delete;
+    ObjectPool& operator=( const ObjectPool& ) = delete;
+
+    template <typename... Args> Ref<T> create( Args&&... args )
+    {
+        u32   index;
+        Slot* slot = acquire( index );
+
+        T* object;
+        try
+        {
+            object = new ( slot ) T( std::forward<Args>( args )... );
+        }
+        catch ( ... )
+        {
+            release( index );
+            throw;
+        }
+
+        object->RefCounted::m_poolIndex = index;
+
+        return Ref<T>( object );
+    }
+
+    /**
+     * @brief Object at a live index. The index must come from getPoolIndex() of an object still referenced.
+     */
+    T* at( u32 index )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        return reinterpret_cast<T*>( &m_blocks[index / BLOCK_SIZE][index % BLOCK_SIZE] );
+    }
+
+    PoolStats stats()
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        PoolStats stats;
+        stats.objectSize = sizeof( Slot );
+        stats.live       = m_live;
+        stats.peak       = m_peak;
+        stats.blocks     = (u32)m_blocks.size();
+        stats.capacity   = stats.blocks * BLOCK_SIZE;
+
+        u32 pinned = 0;
+        for ( u32 live : m_blockLive )
+        {
+            if ( live == 0 )
+                stats.emptyBlocks++;
+            else
+                pinned += BLOCK_SIZE - live;
+        }
+
+        stats.fragmentation = stats.capacity ? (f32)pinned / stats.capacity : 0.0f;
+
+        return stats;
+    }
+
+private:
+    friend class Ref<T>;
+
+    struct alignas( T ) Slot
+    {
+        unsigned char bytes[sizeof( T )];
+    };
+
+    std::mutex          m_mutex;
+    Array<UPtr<Slot[]>> m_blocks;
+    Array<u32>          m_blockLive;
+    Array<u32>          m_free;
+    u32                 m_live = 0;
+    u32                 m_peak = 0;
+
+    ObjectPool() = default;
+
+    Slot* acquire( u32& index )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        if ( m_free.empty() )
+        {
+            u32 first = (u32)m_blocks.size() * BLOCK_SIZE;
+
+            m_blocks.emplace_back( new Slot[BLOCK_SIZE] );
+            m_blockLive.push_back( 0 );
+
+            // reversed so that the block fills front to back
+            for ( u32 i = BLOCK_SIZE; i-- > 0; )
+                m_free.push_back( first + i );
+        }
+
+        index = m_free.back();
+        m_free.pop_back();
+
+        m_blockLive[index / BLOCK_SIZE]++;
+        m_peak = std::max( m_peak, ++m_live );
+
+        return &m_blocks[index / BLOCK_SIZE][index % BLOCK_SIZE];
+    }
+
+    void release( u32 index )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        m_blockLive[index / BLOCK_SIZE]--;
+        m_live--;
+        m_free.push_back( index );
+    }
+
+    void destroy( T* object )
+    {
+        // outside the lock: the destructor may release references into other pools
+        u32 index = object->RefCounted::m_poolIndex;
+        object->~T();
+
+        release( index );
+    }
+};
+
+/**
+ * @brief Intrusive reference to an object in its ObjectPool; the object is destroyed with its last reference.
+ * @details One pointer wide, no separate control block. Copies are safe across threads, a single Ref is not.
+ */
+template <typename T> class Ref
+{
+public:
+    Ref() = default;
+
+    Ref( std::nullptr_t )
+    {
+    }
+
+    /**
+     * @throws std::invalid_argument if the object was not created by ObjectPool<T>
+     */
+    explicit Ref( T* object )
+        : m_object( object )
+    {
+        if ( m_object && m_object->RefCounted::m_poolIndex == RefCounted::UNPOOLED )
+            throw std::invalid_argument( "Ref to an object outside of its pool" );
+
+        retain();
+    }
+
+    Ref( const Ref& other )
+        : m_object( other.m_object )
+    {
+        retain();
+    }
+
+    Ref( Ref&& other ) noexcept
+        : m_object( other.m_object )
+    {
+        other.m_object = nullptr;
+    }
+
+    ~Ref()
+    {
+        release();
+    }
+
+    Ref& operator=( Ref other ) noexcept
+    {
+        std::swap( m_object, other.m_object );
+        return *this;
+    }
+
+    void reset()
+    {
+        release();
+        m_object = nullptr;
+    }
+
+    T* get() const
+    {
+        return m_object;
+    }
+
+    T* operator->() const
+    {
+        return m_object;
+    }
+
+    T& operator*() const
+    {
+        return *m_object;
+    }
+
+    explicit operator bool() const
+    {
+        return m_object != nullptr;
+    }
+
+    /**
+     * @brief Number of references to the object, 0 for a null reference. Only a hint while other threads
+     * copy or drop references.
+     */
+    u32 useCount() const
+    {
+        return m_object ? m_object->RefCounted::m_refs.load( std::memory_order_relaxed ) : 0;
+    }
+
+    bool operator==( const Ref& other ) const
+    {
+        return m_object == other.m_object;
+    }
+
+    bool operator!=( const Ref& other ) const
+    {
+        return m_object != other.m_object;
+    }
+
+    bool operator==( std::nullptr_t ) const
+    {
+        return m_object == nullptr;
+    }
+
+    bool operator!=( std::nullptr_t ) const
+    {
+        return m_object != nullptr;
+    }
+
+private:
+    T* m_object = nullptr;
+
+    void retain()
+    {
+        if ( m_object )
+            m_object->RefCounted::m_refs.fetch_add( 1, std::memory_order_relaxed );
+    }
+
+    void release()
+    {
+        if ( m_object && m_object->RefCounted::m_refs.fetch_sub( 1, std::memory_order_acq_rel ) == 1 )
+            ObjectPool<T>::Instance().destroy( m_object );
+    }
+};
+
+template <typename T, typename... Args> Ref<T> MakeRef( Args&&... args )
+{
+    return ObjectPool<T>::Instance().create( std::forward<Args>( args )... );
+}
+
+/**
+ * @brief Hand a pooled object to embind. The shared_ptr holds one reference until JS deletes its handle.
+ */
+template <typename T> Ptr<T> Share( const Ref<T>& ref )
+{
+    struct Release
+    {
+        mutable Ref<T> ref;
+
+        void operator()( T* ) const
+        {
+            ref.reset();
+        }
+    };
+
+    if ( !ref )
+        return nullptr;
+
+    return Ptr<T>( ref.get(), Release { ref } );
+}
+
+/**
+ * @brief Take a reference to a pooled object received from embind.
+ * @throws std::invalid_argument if the object was not created by ObjectPool<T>
+ */
+template <typename T> Ref<T> RefOf( const Ptr<T>& shared )
+{
+    return Ref<T>( shared.get() );
+}
+
+/**
+ * @brief Pooled equivalent of std::make_shared, for embind constructors.
+ */
+template <typename T, typename... Args> Ptr<T> MakeShared( Args... args )
+{
+    return Share( MakeRef<T>( std::move( args )... ) );
+}
+
+#endif
@@ -2,21 +2,49 @@
 #define PART_HPP
 
 #include <utils.h>
+#include "ObjectPool.hpp"
+#include "CancelToken.hpp"
 
 class Mesh;
 class Texture;
 class Transform;
 
-struct Part
+struct Part : RefCounted
 {
-    string         id;
-    Ptr<Mesh>      mesh;
-    Ptr<Texture>   texture;
-    Ptr<Transform> transform;
+    Ref<Mesh>      mesh;
+    Ref<Texture>   texture;
+    Ref<Transform> transform;
+
+    // handle of the part in App's part table, the id JS refers to it by
+    u32 handle = 0;
+
+    // optional external name, see App::setPartName()
+    string name;
+
+    // set by App once the part is uploaded and in the RenderList
+    bool ready = false;
+
+    // set by the loader when the mesh or texture could not be loaded
+    bool failed = false;
+
+    // cancelled when the part is removed before it finished loading, see PartLoader::cancel()
+    CancelToken loading;
+
+    // App::loadParts() batch the part belongs to (0 if none) and its index in the manifest
+    u32 batch      = 0;
+    u32 batchIndex = 0;
+
+    // handle of the part's entry in the renderer's RenderList
+    u32 renderHandle = 0xFFFFFFFF;
+
+    // streamed meshes arrive as chunks, each drawn through its own RenderList entry
+    Array<Ref<Mesh>> chunks;
+    Array<u32>       chunkHandles;
 
     Part();
     Part( const Part& other );
-    Part( const string& id, Ptr<Mesh> mesh, Ptr<Texture> texture, Ptr<Transform> transform );
+    Part( Ref<Mesh> mesh, Ref<Texture> texture, Ref<Transform> transform );
+    ~Part();
 };
 
 #endif
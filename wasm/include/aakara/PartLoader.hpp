@@ -0,0 +1,334 @@
+#ifndef PARTLOADER_HPP
+#define PARTLOADER_HPP
+
+#include <utils.h>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+#include "MpscQueue.hpp"
+#include "ObjectPool.hpp"
+#include "MemoryBudget.hpp"
+#include "fetch.hpp"
+#include "AssetCache.hpp"
+#include "ChunkedMesh.hpp"
+#include "Bounds.hpp"
+#include "CancelToken.hpp"
+
+class Mesh;
+class Texture;
+class Transform;
+class JobSystem;
+class Frustum;
+struct Part;
+
+/**
+ * @brief A chunk of a streamed mesh, ready to be uploaded and drawn as part of its part.
+ */
+struct LoadedChunk
+{
+    Ref<Part> part;
+    Ref<Mesh> mesh;      // null if the chunk could not be loaded
+    u32       index = 0; // in the mesh's chunk table
+
+    // resident chunk whose arrays were read again, see Mesh::requestArrays(); mesh holds them
+    Ref<Mesh> refill;
+};
+
+/**
+ * @brief Loads parts as a pipeline: asynchronous HTTP requests, decoding on the job system.
+ *
+ * The mesh and texture of a part are requested concurrently and every request is decoded as soon as its bytes
+ * arrive, so network and decode overlap across parts. At most maxInFlight requests are outstanding; the rest
+ * wait, the most urgent first: parts whose bounds are known (see load()) are ranked by whether they are in
+ * view and by how much of it they cover, re-evaluated whenever the camera moves, and parts of unknown bounds
+ * rank as visible but small. Equal requests go in the order they were made. Finished parts are handed over
+ * through the completed queue, including parts that failed to load, which are flagged as such.
+ *
+ * Parts referring to the same mesh or texture URL share one request, one decode and one Mesh or Texture
+ * instance. A shared asset stays available for new loads as long as any part still uses it.
+ *
+ * With an AssetCache, converted assets are stored after decoding and revalidated with conditional requests
+ * next time; a 304 response restores the cached copy instead of parsing the asset again.
+ *
+ * Chunked meshes (see ChunkedMesh) are streamed instead: a range request fetches the chunk table, the part is
+ * handed over without a mesh as soon as its texture is ready, and every chunk is then fetched with its own
+ * range request and handed over through the chunks queue as it decodes. Pending chunks are requested in
+ * order of visibility, then distance to the camera, so at most maxInFlight chunks are held in memory. A chunk
+ * whose fetch fails for a transient reason is requested again with exponential backoff; a chunk that cannot
+ * be loaded after that, or cannot be decoded, is handed over without a mesh so that App can report it.
+ * Uploaded chunks free their arrays and are fetched again only if the GpuBufferArena has to move them (see
+ * Mesh::setReread()), so the heap holds the chunks in flight rather than the whole file.
+ *
+ * Every mesh and texture is admitted by the MemoryBudget before it is decoded, with an estimate of the memory
+ * it will take. Loads that do not fit wait until decodes in flight finish, then textures are downscaled and
+ * other assets fail. Chunks are not requested while the budget is exhausted.
+ *
+ * A part removed while loading is cancelled (see cancel()) and never handed over. Its requests that have not
+ * gone out are dropped, requests in flight are aborted, fetched assets waiting for the budget are freed and
+ * decodes stop at their next step. Assets shared with parts still loading carry on.
+ *
+ * load(), update(), the response callbacks and the destructor run on the main thread; decoding runs on job
+ * system workers. Responses arriving after the loader is destroyed are ignored.
+ */
+class PartLoader
+{
+public:
+    /**
+     * @param jobs Job system running the decode stages.
+     * @param completed Queue receiving parts whose mesh and texture are both decoded.
+     * @param chunks Queue receiving decoded chunks of streamed meshes.
+     * @param budget Budget admitting every asset before it is decoded. Must outlive the job system's tasks.
+     * @param maxInFlight Maximum number of outstanding HTTP requests.
+     * @param cache Cache of converted assets, or null to always fetch and parse.
+     */
+    PartLoader( JobSystem& jobs, MpscQueue<Ref<Part>>& completed, MpscQueue<LoadedChunk>& chunks,
+        MemoryBudget& budget, u32 maxInFlight, Ptr<AssetCache> cache );
+
+    PartLoader( const PartLoader& )            = delete;
+    PartLoader& operator=( const PartLoader& ) = delete;
+
+    /**
+     * @brief Persist assets converted since the last call, retry loads the budget deferred and reprioritize
+     * pending chunks for the current view. Call once per frame.
+     *
+     * @param viewProjection View-projection matrix of the camera.
+     * @param eye Position of the camera.
+     */
+    void update( const glm::mat4& viewProjection, const glm::vec3& eye );
+
+    /**
+     * @brief Queue the loads of a part's mesh and texture. Requests go out with the next update(), once
+     * they have been ranked against everything else queued.
+     *
+     * @param bounds Model-space bounds of the part, if known before loading, to rank its requests by.
+     * @return Ref<Part> The part that will be handed over once loaded. Only its transform is set.
+     */
+    Ref<Part> load( const string& meshUrl, const string& textureUrl, Ref<Transform> transform,
+        const Bounds* bounds = nullptr );
+
+    /**
+     * @brief Stop loading a part. Decodes see it at once; its requests and fetched assets are let go by the
+     * next update(), so loads queued meanwhile can still share them.
+     */
+    void cancel( Part& part );
+
+    void setMaxInFlight( u32 maxInFlight );
+
+    u32 getInFlight() const
+    {
+        return (u32)m_issued.size();
+    }
+
+    size_t getPending() const
+    {
+        return m_pending.size() + m_chunkQueue.size() + m_chunkRetries.size() + m_deferred.size();
+    }
+
+private:
+    enum class Asset : u8
+    {
+        Mesh,
+        Texture,
+        ChunkTable
+    };
+
+    /**
+     * @brief How urgent a request is: by rank, then by the share of the view its part covers, roughly its
+     * bounding radius over its distance to the camera.
+     */
+    struct Priority
+    {
+        u8  rank     = 1; // 0 out of view, 1 in view or unknown, 2 retried
+        f32 coverage = 0.0f;
+
+        bool operator<( const Priority& other ) const
+        {
+            return rank != other.rank ? rank < other.rank : coverage < other.coverage;
+        }
+    };
+
+    struct Load
+    {
+        Ref<Part>    part;
+        Ref<Mesh>    mesh;
+        Ref<Texture> texture;
+
+        // model-space bounds given to load(), if any
+        Bounds bounds;
+        bool   hasBounds = false;
+
+        // stages left: one per asset
+        std::atomic<u32>  remaining { 2 };
+        std::atomic<bool> failed { false };
+    };
+
+    /**
+     * @brief A mesh or texture shared by every load referring to its URL.
+     */
+    struct Shared
+    {
+        Asset asset;
+
+        // written by the decoding worker before complete() sets done under the mutex: only read once done
+        Ref<Mesh>    mesh;
+        Ref<Texture> texture;
+
+        // cancelled once every part waiting for it was cancelled
+        CancelToken loading;
+
+        std::mutex       mutex;
+        bool             done   = false;
+        bool             failed = false;
+        Array<Ptr<Load>> waiters;
+    };
+
+    struct Request
+    {
+        Ptr<Shared> shared; // mesh and texture requests
+        Ptr<Load>   load;   // chunk table requests
+        string      url;
+        Asset       asset       = Asset::Mesh;
+        bool        conditional = true;
+
+        // bytes requested from the start of a chunk table
+        u32 range = 0;
+
+        Priority priority;
+        u64      sequence = 0;
+    };
+
+    struct Stream
+    {
+        Ref<Part>                 part;
+        string                    url;
+        Array<ChunkedMesh::Chunk> chunks;
+    };
+
+    struct ChunkRequest
+    {
+        Ptr<Stream> stream;
+        u32         chunk    = 0;
+        u8          visible  = 0;
+        f32         distance = 0.0f;
+        u8          attempts = 0; // fetches that failed so far
+        Ref<Mesh>   refill;       // resident chunk to read the arrays of again, see reread()
+    };
+
+    /**
+     * @brief A chunk whose fetch failed, waiting out its backoff before it is requested again.
+     */
+    struct ChunkRetry
+    {
+        ChunkRequest request;
+        double       at; // emscripten_get_now() time it is queued again
+    };
+
+    /**
+     * @brief A fetched mesh or texture waiting for the budget: a response to decode, or a cached copy.
+     */
+    struct Deferred
+    {
+        Request                   request;
+        Ptr<const HTTP::Response> response;
+        Array<u8>                 payload;
+    };
+
+    struct CacheWrite
+    {
+        string       url;
+        HTTP::Header condition;
+        Array<u8>    payload;
+    };
+
+    /**
+     * @brief A request on the network, until its response arrives or it is cancelled.
+     */
+    struct Issued
+    {
+        u64                ticket = 0; // see HTTP::Cancel()
+        const CancelToken* loading;    // of the shared asset or part, kept alive by the response callback
+    };
+
+    JobSystem&              m_jobs;
+    MpscQueue<Ref<Part>>&   m_completed;
+    MpscQueue<LoadedChunk>& m_chunks;
+    MemoryBudget&           m_budget;
+    u32                     m_maxInFlight;
+    Ptr<AssetCache>         m_cache;
+
+    // by an id of their own: a response may arrive before HTTP::GET() returns the ticket
+    std::unordered_map<u32, Issued> m_issued;
+    u32                             m_nextIssued = 0;
+
+    // parts were cancelled since the last update()
+    bool m_cancelled = false;
+
+    // converted assets waiting to be stored by update()
+    MpscQueue<CacheWrite> m_cacheWrites;
+
+    // requests not issued yet, most urgent last
+    Array<Request> m_pending;
+    bool           m_pendingDirty = false;
+    u64            m_nextSequence = 0;
+
+    // fetched assets the budget has not admitted yet
+    Array<Deferred> m_deferred;
+
+    // shared assets by kind and URL
+    std::unordered_map<string, Ptr<Shared>> m_shared;
+    u32                                     m_updates = 0;
+
+    // chunks not requested yet, most urgent last
+    Array<ChunkRequest> m_chunkQueue;
+    Array<ChunkRetry>   m_chunkRetries;
+
+    // chunks that could not be loaded, waiting for room in the chunks queue
+    Array<LoadedChunk> m_failedChunks;
+
+    bool                m_chunkQueueDirty    = false;
+    glm::mat4           m_lastViewProjection = glm::mat4( 0.0f );
+    glm::vec3           m_lastEye            = glm::vec3( 0.0f );
+    bool                m_hasView            = false;
+
+    // expires with the loader so late responses can tell
+    Ptr<u8> m_alive = std::make_shared<u8>( 0 );
+
+    void pump();
+    void enqueue( Request request );
+    void retry( Request request );
+    void share( const Ptr<Load>& load, const string& url, Asset asset );
+    void complete( Shared& shared );
+    void resolve( const Shared& shared, const Ptr<Load>& load );
+    void prune();
+    void sweep();
+    void issue( const Request& request );
+    void issueChunk( const ChunkRequest& request );
+    void onResponse( const Request& request, const Ptr<const HTTP::Response>& response );
+    void onChunkTable( const Request& request, const Ptr<const HTTP::Response>& response );
+    void onChunk( const ChunkRequest& request, const Ptr<const HTTP::Response>& response );
+    void requeueChunks();
+    void failChunk( const ChunkRequest& request );
+    void reread( const Ptr<Stream>& stream, u32 chunk, const Ref<Mesh>& mesh );
+    void admit( Deferred work );
+    void decode( const Request& request, const Ptr<const HTTP::Response>& response,
+        const MemoryBudget::Estimate& reserved, u32 downscale );
+    void decodeChunk( const Ptr<Stream>& stream, u32 chunk, const Ptr<const HTTP::Response>& response,
+        u64 base, const Ref<Mesh>& refill );
+    void restore( const Request& request, const Array<u8>& payload, const MemoryBudget::Estimate& reserved,
+        u32 downscale );
+    void prioritize( const glm::mat4& viewProjection, const glm::vec3& eye );
+    void prioritizeRequests( const Frustum& frustum, const glm::vec3& eye );
+    Priority priorityOf( const Request& request, const Frustum& frustum, const glm::vec3& eye ) const;
+    void finishStage( const Ptr<Load>& load );
+
+    static Priority PriorityOf( const Load& load, const Frustum& frustum, const glm::vec3& eye );
+    static bool     Precedes( const Request& a, const Request& b );
+    static bool     IsCancelled( const Request& request );
+
+    static const char*            NameOf( Asset asset );
+    static MemoryBudget::Estimate EstimateOf( const Deferred& work );
+};
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef PARTTABLE_HPP
+#define PARTTABLE_HPP
+
+#include <utils.h>
+#include <unordered_map>
+#include "HandleTable.hpp"
+#include "Part.hpp"
+
+/**
+ * @brief App's parts by id, and the external names given to them.
+ * @details Ids are HandleTable handles, so the id of a removed part stops resolving. A name always refers
+ * to a live part: removing a part, whichever way, drops its name with it.
+ */
+class PartTable
+{
+public:
+    static constexpr u32 Invalid = HandleTable<Ref<Part>>::Invalid;
+
+    /**
+     * @return u32 Id of the new entry, or Invalid if the table is full.
+     */
+    u32 insert( Ref<Part> part );
+
+    /**
+     * @return Ref<Part>* The entry, or null if the id does not resolve.
+     */
+    Ref<Part>* get( u32 id );
+
+    /**
+     * @brief Remove a part and its name.
+     *
+     * @return bool False if the id did not resolve.
+     */
+    bool remove( u32 id );
+
+    /**
+     * @brief Name a part, replacing its previous name. An empty name removes it. A name taken by another
+     * part moves to this one.
+     */
+    void setName( u32 id, const string& name );
+
+    /**
+     * @return u32 Id of the part with that name, or Invalid.
+     */
+    u32 find( const string& name ) const;
+
+    Array<Ref<Part>>& values()
+    {
+        return m_parts.values();
+    }
+
+    size_t size() const
+    {
+        return m_parts.size();
+    }
+
+    size_t nameCount() const
+    {
+        return m_names.size();
+    }
+
+    void clear();
+
+private:
+    HandleTable<Ref<Part>>          m_parts;
+    std::unordered_map<string, u32> m_names;
+};
+
+#endif
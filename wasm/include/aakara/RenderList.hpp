@@ -0,0 +1,150 @@
+#ifndef RENDERLIST_HPP
+#define RENDERLIST_HPP
+
+#include <utils.h>
+#include "Bounds.hpp"
+
+class Mesh;
+class FrameArena;
+class Texture;
+
+/**
+ * @brief A retained draw entry. Visibility and LOD are written by the frame pipeline; hidden entries are
+ * never visible.
+ */
+struct RenderEntry
+{
+    u64      key;
+    u32      keyGeneration; // Mesh::getKeyGeneration() when key was made
+    Mesh*    mesh;
+    Texture* texture;
+    u32      transform;
+    Bounds   bounds;
+    u8       visible = 1;
+    u8       hidden  = 0;
+    u8       lod     = 0;
+};
+
+/**
+ * @brief Persistent, flat list of everything the renderer draws.
+ * @details Entries are kept densely in sort-key order and addressed through stable handles. They are added
+ * and removed when parts load or unload and patched in place afterwards, so frame preparation only has to
+ * touch what changed.
+ */
+class RenderList
+{
+public:
+    static constexpr u32 Invalid = 0xFFFFFFFF;
+
+    /**
+     * @brief Add an entry.
+     *
+     * @param mesh Mesh to draw. Must outlive the entry.
+     * @param texture Diffuse texture. Must outlive the entry.
+     * @param transform TransformStore slot supplying the world matrix. Several entries may share a slot.
+     * @return u32 Handle of the new entry.
+     */
+    u32  add( Mesh* mesh, Texture* texture, u32 transform );
+    void remove( u32 handle );
+
+    void setMesh( u32 handle, Mesh* mesh );
+    void setTexture( u32 handle, Texture* texture );
+
+    /**
+     * @brief Hide or show every entry drawn with a transform slot, including entries added to it later.
+     */
+    void setHidden( u32 transform, bool hidden );
+
+    /**
+     * @brief Flag the entries driven by the given transform slots for a bounds refresh.
+     */
+    void markTransformsChanged( const Array<u32>& slots );
+
+    /**
+     * @brief Flag an entry for a bounds refresh after the LocalBounds of its mesh changed.
+     */
+    void markMeshChanged( u32 handle )
+    {
+        markBoundsDirty( handle );
+    }
+
+    /**
+     * @brief Restore sort-key order after insertions, removals and meshes moved by the GpuBufferArena.
+     * Indices into entries() change.
+     *
+     * @param scratch Arena for the temporary permutation.
+     */
+    void sort( FrameArena& scratch );
+
+    RenderEntry& get( u32 handle )
+    {
+        return m_entries[m_indices[handle]];
+    }
+
+    Array<RenderEntry>& entries()
+    {
+        return m_entries;
+    }
+
+    /**
+     * @brief Handles of entries whose bounds need to be recomputed.
+     */
+    const Array<u32>& boundsDirty() const
+    {
+        return m_boundsDirty;
+    }
+
+    /**
+     * @brief Call once the bounds of boundsDirty() are recomputed: they become boundsChanged().
+     */
+    void clearBoundsDirty();
+
+    /**
+     * @brief Handles of entries whose bounds the last clearBoundsDirty() reported as recomputed, for systems
+     * that derive data from bounds to update just those. Only complete while version() is unchanged since.
+     */
+    const Array<u32>& boundsChanged() const
+    {
+        return m_boundsChanged;
+    }
+
+    /**
+     * @brief Incremented whenever entries are added, removed, reordered or patched. Bounds changes are
+     * reported by boundsChanged() instead.
+     */
+    u64 version() const
+    {
+        return m_version;
+    }
+
+    size_t size() const
+    {
+        return m_entries.size();
+    }
+
+    /**
+     * @brief Heap bytes held by the list, including reserved capacity.
+     */
+    size_t memoryBytes() const;
+
+private:
+    Array<RenderEntry> m_entries;
+    Array<u32>         m_handles;     // entry index -> handle
+    Array<u32>         m_indices;     // handle -> entry index
+    Array<u32>         m_free;        // released handles
+    Array<u32>         m_byTransform; // transform slot -> first handle using it
+    Array<u32>         m_nextShared;  // handle -> next handle using the same transform slot
+    Array<u8>          m_hidden;      // transform slot -> hidden
+    Array<u32>         m_boundsDirty;
+    Array<u32>         m_dirtyIndex;  // handle -> position in m_boundsDirty, or Invalid
+    Array<u32>         m_boundsChanged;
+    bool               m_unsorted   = false;
+    u64                m_version    = 0;
+    u64                m_arenaMoves = 0; // GpuBufferArena::moves() when keys were last checked
+
+    void rekeyMoved();
+    void markBoundsDirty( u32 handle );
+    void unlinkTransform( u32 handle, u32 transform );
+};
+
+#endif
@@ -7,29 +7,29 @@
 #include "Lights.hpp"
 #include "Texture.hpp"
 #include "Skybox.hpp"
+#include "RenderList.hpp"
 
-#include <queue>
 #include <utils.h>
 #include <glm/glm.hpp>
 #include <emscripten/bind.h>
 
-class Transform;
-
 /**
- * @brief A struct representing a render command
- *
+ * @brief A compact draw command recorded while preparing a frame and replayed by Renderer::submit().
+ * @details Packets only point at engine-owned data that stays alive for the frame.
  */
-struct RenderCmd
+struct DrawPacket
 {
-    Ptr<Mesh>      mesh;
-    Ptr<Transform> transform;
-    Ptr<Texture>   texture;
-
-    RenderCmd( Ptr<Mesh> mesh, Ptr<Texture> texture, Ptr<Transform> transform )
-        : mesh( mesh )
-        , texture( texture )
-        , transform( transform )
+    u64              key;
+    Mesh*            mesh;
+    Texture*         texture;
+    const glm::mat4* model;
+
+    /**
+     * @brief Sort key grouping packets by texture, then by buffer block and mesh, to minimise state changes.
+     */
+    static u64 MakeKey( Mesh* mesh, Texture* texture )
     {
+        return ( (u64)texture->getTextureId() << 32 ) | mesh->getDrawKey();
     }
 };
 
@@ -57,19 +57,27 @@ public:
     void activateContext();
 
     /**
-     * @brief Draw submitted render jobs.
+     * @brief Replay draw packets into WebGL. Must be called on the context thread.
      *
-     * @param queue Render commands to issue to the renderer.
+     * @param packets Packets to draw, ideally sorted by DrawPacket::key.
      * @param camera Main camera to use for rendering.
      * @param light Main light to use for rendering.
      */
-    void drawItems( std::queue<RenderCmd>& queue, Ptr<Camera> camera, Ptr<Light> light );
+    void submit( const Array<DrawPacket>& packets, Ptr<Camera> camera, Ptr<Light> light );
 
     Ptr<Shader> GetShader()
     {
         return m_shader;
     }
 
+    /**
+     * @brief Retained list of everything this renderer draws.
+     */
+    RenderList& getRenderList()
+    {
+        return m_renderList;
+    }
+
 private:
     int m_width = -1, m_height = -1;
 
@@ -79,6 +87,8 @@ private:
 
     Ptr<Shader> m_shader = nullptr;
     Skybox*     m_skybox = nullptr;
+
+    RenderList m_renderList;
 };
 
 #endif
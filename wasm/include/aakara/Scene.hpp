@@ -5,6 +5,7 @@
 #include "Camera.hpp"
 #include "Mesh.hpp"
 #include "Texture.hpp"
+#include "TransformStore.hpp"
 
 #include <utils.h>
 #include <entt/entity/registry.hpp>
@@ -36,8 +37,9 @@ public:
 private:
     Ptr<SceneObject>    m_rootNode = nullptr;
     Array<Ptr<Camera>>  m_cameras;
-    Array<Ptr<Mesh>>    m_meshes;
-    Array<Ptr<Texture>> m_textures;
+    Array<Ref<Mesh>>    m_meshes;
+    Array<Ref<Texture>> m_textures;
+    TransformStore      m_transforms;
     entt::registry      m_registry;
 };
 
@@ -17,8 +17,8 @@ public:
 
     std::string             id;
     std::string             name;
-    Ptr<Part>               part      = nullptr;
-    Ptr<Transform>          transform = nullptr;
+    Ref<Part>               part      = nullptr;
+    Ref<Transform>          transform = nullptr;
     Array<Ptr<SceneObject>> children;
 
 private:
@@ -48,27 +48,52 @@ public:
         return m_shaderID;
     }
 
-    void SetInt( std::string location, int value );
-    void SetBool( std::string location, bool value );
-    void SetFloat( std::string location, float value );
-    void SetVector( std::string location, glm::vec2 value );
-    void SetVector( std::string location, glm::vec3 value );
-    void SetVector( std::string location, glm::vec4 value );
-    void SetVectorArray( std::string location, int size, const std::vector<glm::vec2>& values );
-    void SetVectorArray( std::string location, int size, const std::vector<glm::vec3>& values );
-    void SetVectorArray( std::string location, int size, const std::vector<glm::vec4>& values );
-    void SetMatrix( std::string location, const glm::mat2& value );
-    void SetMatrix( std::string location, const glm::mat3& value );
-    void SetMatrix( std::string location, const glm::mat4& value );
-    void SetMatrixArray( std::string location, int size, glm::mat2* values );
-    void SetMatrixArray( std::string location, int size, glm::mat3* values );
-    void SetMatrixArray( std::string location, int size, glm::mat4* values );
-    void SetVertexAttribute( const std::string& name, u32 size, u32 stride );
-
-    bool EnableVertexAttribute( string location );
+    void SetInt( const char* location, int value );
+    void SetBool( const char* location, bool value );
+    void SetFloat( const char* location, float value );
+    void SetVector( const char* location, glm::vec2 value );
+    void SetVector( const char* location, glm::vec3 value );
+    void SetVector( const char* location, glm::vec4 value );
+    void SetVectorArray( const char* location, int size, const std::vector<glm::vec2>& values );
+    void SetVectorArray( const char* location, int size, const std::vector<glm::vec3>& values );
+    void SetVectorArray( const char* location, int size, const std::vector<glm::vec4>& values );
+    void SetMatrix( const char* location, const glm::mat2& value );
+    void SetMatrix( const char* location, const glm::mat3& value );
+    void SetMatrix( const char* location, const glm::mat4& value );
+    void SetMatrixArray( const char* location, int size, glm::mat2* values );
+    void SetMatrixArray( const char* location, int size, glm::mat3* values );
+    void SetMatrixArray( const char* location, int size, glm::mat4* values );
+    void SetVertexAttribute( const char* name, u32 size, u32 stride );
+
+    /**
+     * @brief Set a mat4 uniform by location, for uniforms set many times per frame.
+     */
+    void SetMatrix( i32 location, const glm::mat4& value );
+
+    bool EnableVertexAttribute( const char* location );
+
+    /**
+     * @brief Location of a uniform, or -1 if the program has none by that name. Looked up once per name.
+     */
+    i32 GetUniformLocation( const char* name );
+
+    /**
+     * @brief Location of a vertex attribute, or -1. Looked up once per name.
+     */
+    i32 GetAttribLocation( const char* name );
 
 private:
-    u32 m_shaderID;
+    struct Location
+    {
+        string name;
+        i32    location;
+    };
+
+    u32             m_shaderID;
+    Array<Location> m_uniforms;
+    Array<Location> m_attributes;
+
+    i32 Lookup( Array<Location>& cache, const char* name, i32 ( *query )( u32, const char* ) );
 
     void Load( const char* vert_shader_file, const char* frag_shader_file );
 };
@@ -3,6 +3,7 @@
 
 #include <utils.h>
 #include "Shader.hpp"
+#include "MemoryBudget.hpp"
 
 class Camera;
 
@@ -24,6 +25,9 @@ private:
     u32         m_textureID    = 0;
     u32         m_VBO          = 0;
     Ptr<Shader> m_skyboxShader = nullptr;
+
+    MemoryCharge m_cubemapCharge;
+    MemoryCharge m_vertexCharge;
 };
 
 #endif
@@ -2,12 +2,15 @@
 #define TEXTURE_H
 
 #include <utils.h>
+#include "ObjectPool.hpp"
+#include "MemoryBudget.hpp"
+#include "CancelToken.hpp"
 
 #define STBI_ONLY_JPEG
 #define STBI_ONLY_PNG
 
 // LINK: https://docs.gl/es2/glTexImage2D
-class Texture
+class Texture : public RefCounted
 {
 public:
     enum class PixelType
@@ -19,31 +22,62 @@ public:
     /**
      * @brief Construct a new Texture object
      *
-     * @param pixels pixel data in unsigned int array
+     * @param pixels pixel data in unsigned int array, moved in: a texture's pixels are never copied
      * @param width width of image in pixels
      * @param height height of image in pixels
      */
-    Texture( const Array<u8>& pixels, int width, int height, PixelType pixelType );
+    Texture( Array<u8>&& pixels, int width, int height, PixelType pixelType );
     ~Texture();
 
-    // static Ptr<Texture> LoadFromURL( const std::string& url );
+    // static Ref<Texture> LoadFromURL( const std::string& url );
 
     /**
      * @brief Load a new texture from memory.
      *
      * @param data Unsigned char pointer containing encoded image.
      * @param size Size of the buffer.
-     * @return Ptr<Texture> A shared pointer to the texture
+     * @param downscale Number of times to halve the width and height of the decoded image, see MemoryBudget.
+     * @param cancel Checked between decoding and each halving, if given.
+     * @return Ref<Texture> A reference to the pooled texture
      * @throws std::runtime_error if the image decoding failed
+     * @throws CancelToken::Cancelled if cancelled
      */
-    static Ptr<Texture> LoadFromMemory( const u8* data, u64 size );
+    static Ref<Texture> LoadFromMemory(
+        const u8* data, u64 size, u32 downscale = 0, const CancelToken* cancel = nullptr );
 
     /**
-     * @brief Update texture in WebGL
+     * @brief Recreate a texture written by Serialize(), skipping image decoding.
+     * @param downscale Number of times to halve the width and height of the texture, see MemoryBudget.
+     * @throws std::runtime_error if the data is not a serialized texture
+     */
+    static Ref<Texture> Deserialize( const u8* data, size_t size, u32 downscale = 0 );
+
+    /**
+     * @brief Size of an encoded image, read from its header without decoding it.
+     * @return false if the image format is not supported
+     */
+    static bool ReadSize( const u8* data, u64 size, int& width, int& height );
+
+    /**
+     * @brief Append the decoded pixels in the form they are uploaded to the GPU.
+     */
+    void Serialize( Array<u8>& out ) const;
+
+    /**
+     * @brief Update texture in WebGL, all at once.
      *
      */
     void update();
 
+    /**
+     * @brief Upload the next rows of the texture, or its mip chain once all rows are uploaded. The texture
+     * can be bound once it is complete.
+     *
+     * @param budget Bytes that may be uploaded; reduced by the bytes uploaded. At least one row is.
+     * @return bool Whether the texture is complete.
+     */
+    bool upload( u64& budget );
+
     /**
      * @brief Get the Texture Id as unsigned int
      *
@@ -69,6 +103,21 @@ private:
     int       m_width = 0, m_height = 0;
     int       m_format = 0;
     Array<u8> m_pixelBuffer;
+
+    // texture being uploaded by upload(), and its rows uploaded so far; becomes m_textureId once complete
+    u32 m_pendingId    = 0;
+    int m_uploadedRows = 0;
+
+    // the pixel buffer, and the texture it becomes on the GPU (pending until update())
+    MemoryCharge m_cpuCharge;
+    MemoryCharge m_gpuCharge;
+
+    u64 gpuBytes() const;
+
+    bool isMipmapped() const
+    {
+        return m_width % 2 == 0 && m_height % 2 == 0;
+    }
 };
 
 #endif
@@ -3,8 +3,11 @@
 
 #include <utils.h>
 #include <glm/vec3.hpp>
+#include "ObjectPool.hpp"
 
-class Transform
+class TransformStore;
+
+class Transform : public RefCounted
 {
 public:
     glm::vec3 position = glm::vec3( 0.0f );
@@ -15,9 +18,44 @@ public:
     Transform( const Transform& other );
     Transform( glm::vec3 pos, glm::vec3 rot, glm::vec3 scale );
 
+    /**
+     * @brief Copy position, rotation and scale. The store attachment is left untouched.
+     */
+    Transform& operator=( const Transform& other );
+
     glm::vec3 forward();
     glm::vec3 up();
     glm::vec3 right();
+
+    glm::vec3 getPosition() const;
+    glm::vec3 getRotation() const;
+    glm::vec3 getScale() const;
+
+    /**
+     * @brief Setters write through to the attached TransformStore slot, if any. Attached transforms must be
+     * modified through these rather than the public fields.
+     */
+    void setPosition( glm::vec3 position );
+    void setRotation( glm::vec3 rotation );
+    void setScale( glm::vec3 scale );
+
+    /**
+     * @brief Mirror this transform into a slot of a TransformStore.
+     *
+     * @param store Store owning the slot.
+     * @param slot Slot index returned by TransformStore::create().
+     */
+    void attach( TransformStore* store, u32 slot );
+    void detach();
+
+    u32 getSlot() const
+    {
+        return m_slot;
+    }
+
+private:
+    TransformStore* m_store = nullptr;
+    u32             m_slot  = 0xFFFFFFFF;
 };
 
 #endif
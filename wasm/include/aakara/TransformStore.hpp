@@ -0,0 +1,171 @@
+#ifndef TRANSFORM_STORE_HPP
+#define TRANSFORM_STORE_HPP
+
+#include <utils.h>
+#include <glm/vec3.hpp>
+#include <glm/mat4x4.hpp>
+
+class Transform;
+
+/**
+ * @brief Contiguous structure-of-arrays storage for transform components.
+ *
+ * Every transform is addressed by a slot index. Position, rotation and scale live in separate dense arrays
+ * and world matrices are cached next to them. Only slots marked dirty (and their descendants) are
+ * recomputed by update(), one hierarchy level at a time so parents are always resolved before children, and
+ * four slots of a level at a time in SIMD lanes.
+ */
+class TransformStore
+{
+public:
+    static constexpr u32 Invalid = 0xFFFFFFFF;
+
+    TransformStore();
+
+    /**
+     * @brief Allocate a slot for a transform.
+     *
+     * @param transform Initial local position, rotation and scale.
+     * @param parent Slot of the parent transform, or TransformStore::Invalid for a root.
+     * @return u32 Slot index of the new transform.
+     */
+    u32 create( const Transform& transform, u32 parent = Invalid );
+
+    /**
+     * @brief Release a slot. Children of the slot become roots.
+     *
+     * @param id Slot index to release.
+     */
+    void destroy( u32 id );
+
+    void set( u32 id, const Transform& transform );
+    void setPosition( u32 id, const glm::vec3& position );
+    void setRotation( u32 id, const glm::vec3& rotation );
+    void setScale( u32 id, const glm::vec3& scale );
+
+    const glm::vec3& getPosition( u32 id ) const
+    {
+        return m_positions[id];
+    }
+
+    const glm::vec3& getRotation( u32 id ) const
+    {
+        return m_rotations[id];
+    }
+
+    const glm::vec3& getScale( u32 id ) const
+    {
+        return m_scales[id];
+    }
+
+    /**
+     * @brief Get the cached world matrix of a slot. Only valid after update().
+     */
+    const glm::mat4& getWorld( u32 id ) const
+    {
+        return m_world[id];
+    }
+
+    u32 getParent( u32 id ) const
+    {
+        return m_parents[id];
+    }
+
+    void markDirty( u32 id );
+
+    /**
+     * @brief Mark a range of slots dirty after writing their components through the raw arrays. Released
+     * slots and slots past the end are ignored.
+     */
+    void markDirty( u32 first, u32 count );
+
+    /**
+     * @brief Raw position, rotation and scale arrays, three floats per slot, for bulk writers. Pointers stay
+     * valid until layoutVersion() changes.
+     */
+    f32* positionData()
+    {
+        return &m_positions.data()->x;
+    }
+
+    f32* rotationData()
+    {
+        return &m_rotations.data()->x;
+    }
+
+    f32* scaleData()
+    {
+        return &m_scales.data()->x;
+    }
+
+    /**
+     * @brief Incremented whenever slots are appended, which may move the component arrays.
+     */
+    u32 layoutVersion() const
+    {
+        return m_layoutVersion;
+    }
+
+    /**
+     * @brief Recompute world matrices of all dirty slots and their descendants.
+     *
+     * @return size_t Number of world matrices recomputed.
+     */
+    size_t update();
+
+    /**
+     * @brief Slots whose world matrix was recomputed by the last update().
+     */
+    const Array<u32>& updated() const
+    {
+        return m_updated;
+    }
+
+    /**
+     * @brief Number of slots, including released ones awaiting reuse.
+     */
+    size_t capacity() const
+    {
+        return m_positions.size();
+    }
+
+    /**
+     * @brief Heap bytes held by the store, including reserved capacity.
+     */
+    size_t memoryBytes() const;
+
+    /**
+     * @brief Compute the local matrix of a single transform with the plain glm path.
+     * @details Kept as the reference implementation for the batched path in update().
+     */
+    static glm::mat4 ComputeLocal(
+        const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale );
+
+private:
+    /* ------------------------------- Components ------------------------------- */
+    Array<glm::vec3> m_positions;
+    Array<glm::vec3> m_rotations;
+    Array<glm::vec3> m_scales;
+    Array<glm::mat4> m_world;
+
+    /* -------------------------------- Hierarchy ------------------------------- */
+    Array<u32> m_parents;
+    Array<u32> m_firstChild;
+    Array<u32> m_nextSibling;
+    Array<u16> m_depths;
+
+    /* ------------------------------- Bookkeeping ------------------------------ */
+    Array<u8>         m_alive;
+    Array<u8>         m_dirty;
+    Array<u32>        m_dirtyList;
+    Array<u32>        m_updated;
+    Array<u32>        m_free;
+    Array<Array<u32>> m_levels;
+    u32               m_layoutVersion = 0;
+
+    void link( u32 id, u32 parent );
+    void unlink( u32 id );
+    void setDepth( u32 id, u16 depth );
+};
+
+#endif
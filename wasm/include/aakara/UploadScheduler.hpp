@@ -0,0 +1,93 @@
+#ifndef UPLOADSCHEDULER_HPP
+#define UPLOADSCHEDULER_HPP
+
+#include <utils.h>
+#include <deque>
+#include "ObjectPool.hpp"
+#include "PartLoader.hpp"
+
+/**
+ * @brief Spreads the GPU uploads of loaded parts and chunks over frames.
+ *
+ * Parts and chunks are uploaded in the order they were pushed, within a per-frame budget of bytes and of
+ * milliseconds. Meshes are written into the GpuBufferArena in slices and textures in bands of rows followed
+ * by their mip chain, so a large asset takes several frames while small ones finish together; whatever is
+ * left over continues next frame. A part is handed back once its texture and mesh are complete, never
+ * before, so nothing is drawn half uploaded. Assets shared with parts uploaded earlier cost nothing.
+ *
+ * Every frame's first upload makes progress whatever the budget, so the queue always drains. Only used on
+ * the render thread.
+ */
+class UploadScheduler
+{
+public:
+    struct Stats
+    {
+        u32 parts  = 0;
+        u32 chunks = 0;
+
+        // of the last run()
+        u64 bytes        = 0;
+        f32 milliseconds = 0.0f;
+
+        // how long the oldest queued upload has been waiting
+        f32 stallMilliseconds = 0.0f;
+    };
+
+    /**
+     * @param bytesPerFrame Bytes run() may upload, or 0 for no limit.
+     * @param millisecondsPerFrame Time run() may spend uploading, or 0 for no limit.
+     */
+    UploadScheduler( u64 bytesPerFrame, double millisecondsPerFrame );
+
+    UploadScheduler( const UploadScheduler& )            = delete;
+    UploadScheduler& operator=( const UploadScheduler& ) = delete;
+
+    void setBudget( u64 bytesPerFrame, double millisecondsPerFrame );
+
+    void push( Ref<Part> part );
+    void push( LoadedChunk chunk );
+
+    /**
+     * @brief Drop the queued uploads of a part and of its chunks. Assets partly uploaded stay that way until
+     * another part needs them.
+     *
+     * @return bool Whether the part itself was queued.
+     */
+    bool cancel( const Part& part );
+
+    /**
+     * @brief Upload queued parts and chunks within the frame's budget, appending those now complete to parts
+     * and chunks in the order they were pushed. Call once per frame.
+     */
+    void run( Array<Ref<Part>>& parts, Array<LoadedChunk>& chunks );
+
+    bool empty() const
+    {
+        return m_queue.empty();
+    }
+
+    Stats stats() const;
+
+private:
+    struct Entry
+    {
+        Ref<Part> part;
+
+        // null for the part's own mesh and texture
+        Ref<Mesh> chunk;
+
+        double queuedAt;
+    };
+
+    std::deque<Entry> m_queue;
+
+    u64    m_bytesPerFrame;
+    double m_millisecondsPerFrame;
+
+    Stats m_stats;
+
+    static bool Upload( const Entry& entry, u64& budget );
+};
+
+#endif
@@ -2,18 +2,268 @@
 #define FETCH_H
 
 #include <utils.h>
+#include <mutex>
+#include <memory>
+#include <utility>
+#include <cstdlib>
 #include <functional>
-#include <emscripten/fetch.h>
+#include <unordered_map>
+#include "MemoryBudget.hpp"
+
+struct emscripten_fetch_t;
 
 namespace HTTP
 {
+    struct Header
+    {
+        string Key;
+        string Value;
+    };
+
+    /**
+     * @brief Bytes of a response body. Move-only: FetchTransport hands over the buffer emscripten_fetch read
+     * the response into rather than copying it, and other transports move in an array of their own.
+     */
+    class Body
+    {
+    public:
+        Body() = default;
+
+        explicit Body( Array<u8> bytes )
+            : m_bytes( std::move( bytes ) )
+            , m_data( m_bytes.data() )
+            , m_size( m_bytes.size() )
+        {
+        }
+
+        /**
+         * @brief Take ownership of a buffer from malloc(), freed with the body.
+         */
+        static Body Adopt( u8* data, size_t size )
+        {
+            Body body;
+            body.m_adopted.reset( data );
+            body.m_data = data;
+            body.m_size = size;
+            return body;
+        }
+
+        Body( Body&& other )
+            : m_bytes( std::move( other.m_bytes ) )
+            , m_adopted( std::move( other.m_adopted ) )
+            , m_data( std::exchange( other.m_data, nullptr ) )
+            , m_size( std::exchange( other.m_size, 0 ) )
+        {
+        }
+
+        Body& operator=( Body&& other )
+        {
+            m_bytes   = std::move( other.m_bytes );
+            m_adopted = std::move( other.m_adopted );
+            m_data    = std::exchange( other.m_data, nullptr );
+            m_size    = std::exchange( other.m_size, 0 );
+            return *this;
+        }
+
+        Body( const Body& )            = delete;
+        Body& operator=( const Body& ) = delete;
+
+        const u8* data() const
+        {
+            return m_data;
+        }
+
+        size_t size() const
+        {
+            return m_size;
+        }
+
+        bool empty() const
+        {
+            return m_size == 0;
+        }
+
+    private:
+        struct Free
+        {
+            void operator()( u8* data ) const
+            {
+                std::free( data );
+            }
+        };
+
+        // one or the other holds the bytes; moving either keeps m_data pointing at them
+        Array<u8>                   m_bytes;
+        std::unique_ptr<u8[], Free> m_adopted;
+
+        const u8* m_data = nullptr;
+        size_t    m_size = 0;
+    };
+
+    /**
+     * @brief A completed request. Shared read-only between every waiter of the request.
+     */
+    struct Response
+    {
+        string        url;
+        u16           status = 0;
+        Body          body;
+        Array<Header> headers;
+
+        // the body, charged to MemoryTag::Loader until the last waiter lets go of the response
+        MemoryCharge charge;
+
+        bool ok() const
+        {
+            return status >= 200 && status < 300;
+        }
+
+        /**
+         * @brief Value of a response header, matched case-insensitively. Empty if absent.
+         */
+        string header( const string& key ) const;
+    };
+
+    using Callback = std::function<void( const Ptr<const Response>& )>;
+
+    struct FetchOptions
+    {
+        Array<Header> headers;
+        Callback      callback;
+    };
+
+    /**
+     * @brief Carries out a single request and reports exactly once through done, unless aborted first. A
+     * response with status 0 stands for a network error.
+     */
+    class Transport
+    {
+    public:
+        using Done = std::function<void( Ptr<Response> )>;
+
+        virtual ~Transport() = default;
+
+        /**
+         * @return u32 Id of the request, for abort().
+         */
+        virtual u32 send( const string& url, const Array<Header>& headers, Done done ) = 0;
+
+        /**
+         * @brief Stop a request early, freeing its connection and whatever of the body has arrived. Requests
+         * already reported are ignored. By default the request runs to the end, and done may still be called.
+         */
+        virtual void abort( u32 )
+        {
+        }
+    };
+
+    /**
+     * @brief Transport backed by emscripten_fetch. Requests made off the main thread are started on the main
+     * thread, where their callbacks then run; so are aborts, which close the fetch without calling done.
+     */
+    class FetchTransport : public Transport
+    {
+    public:
+        u32  send( const string& url, const Array<Header>& headers, Done done ) override;
+        void abort( u32 request ) override;
+
+    private:
+        struct Request;
+
+        // requests sent and not yet reported or aborted
+        std::mutex                        m_mutex;
+        std::unordered_map<u32, Request*> m_requests;
+        u32                               m_nextId = 1;
+
+        static void Start( void* request );
+        static void Abort( FetchTransport* transport, u32 id );
+        static void OnDone( emscripten_fetch_t* fetch );
+    };
+
+    /**
+     * @brief Issues GET requests, coalescing identical ones.
+     * @details Requests for the same URL with the same headers that overlap in time share one transport
+     * request. Every waiter receives the same Response, so the body is never copied. A waiter can cancel;
+     * once none is left the transport request is aborted. Callable from any thread; callbacks run on
+     * whichever thread the transport completes on.
+     */
+    class Client
+    {
+    public:
+        explicit Client( Ptr<Transport> transport );
+
+        /**
+         * @return u64 Ticket to cancel() the callback with.
+         */
+        u64 get( const string& url, const FetchOptions& options );
+
+        /**
+         * @brief Drop a callback that has not run yet, aborting the request once no other callback waits.
+         * @return bool Whether the callback was dropped.
+         */
+        bool cancel( u64 ticket );
+
+        /**
+         * @brief Number of distinct requests currently outstanding.
+         */
+        size_t getInFlight();
+
+    private:
+        struct Waiter
+        {
+            u64      ticket;
+            Callback callback;
+        };
+
+        // one transport request and the callbacks waiting for it
+        struct Outstanding
+        {
+            u64           id      = 0; // ticket of the first waiter: later requests for the key differ
+            u32           request = 0; // transport id, 0 until send() returns
+            Array<Waiter> waiters;
+        };
+
+        Ptr<Transport>                  m_transport;
+        std::mutex                      m_mutex;
+        std::map<string, Outstanding>   m_outstanding;
+        std::unordered_map<u64, string> m_tickets;
+        u64                             m_nextTicket = 1;
+
+        void complete( const string& key, u64 id, Ptr<Response> response );
+    };
+
+    /**
+     * @brief Client used by GET(), backed by FetchTransport unless replaced with SetTransport().
+     */
+    Client& DefaultClient();
+
+    /**
+     * @brief Replace the transport of the default client. Only safe while no request is outstanding.
+     */
+    void SetTransport( Ptr<Transport> transport );
+
     /**
      * @brief Async GET HTTP request given the URL.
      *
      * @param url URL to submit HTTP request to.
      * @param cb Callback that returns the response of the HTTP call.
+     * @return u64 Ticket to Cancel() the request with.
+     */
+    u64 GET( const string& url, Callback cb );
+
+    /**
+     * @brief Async GET HTTP request with extra request headers.
+     *
+     * @param url URL to submit HTTP request to.
+     * @param options Request headers and the callback receiving the response.
+     * @return u64 Ticket to Cancel() the request with.
+     */
+    u64 GET( const string& url, const FetchOptions& options );
+
+    /**
+     * @brief Cancel a GET request of the default client whose callback has not run yet, see Client::cancel().
      */
-    void GET( const string& url, std::function<void( emscripten_fetch_t* )> cb );
+    bool Cancel( u64 ticket );
 }
 
 #endif
@@ -2,51 +2,42 @@
 #define UUID_V4_HPP
 
 #include <random>
-#include <sstream>
+#include <cstdint>
+#include <string>
 
 namespace uuid
 {
-    static std::random_device              rd;
-    static std::mt19937                    gen( rd() );
-    static std::uniform_int_distribution<> dis( 0, 15 );
-    static std::uniform_int_distribution<> dis2( 8, 11 );
-
     /**
      * @brief Generate v4 UUID
+     * @details Thread-safe: every thread draws from its own generator, seeded once.
      *
      * @return std::string UUID in string
      */
     inline std::string generate()
     {
-        std::stringstream ss;
-        int               i;
-        ss << std::hex;
-        for ( i = 0; i < 8; i++ )
-        {
-            ss << dis( gen );
-        }
-        ss << "-";
-        for ( i = 0; i < 4; i++ )
-        {
-            ss << dis( gen );
-        }
-        ss << "-4";
-        for ( i = 0; i < 3; i++ )
-        {
-            ss << dis( gen );
-        }
-        ss << "-";
-        ss << dis2( gen );
-        for ( i = 0; i < 3; i++ )
+        static const char           digits[] = "0123456789abcdef";
+        thread_local std::mt19937_64 gen( std::random_device {}() );
+
+        uint64_t high = gen();
+        uint64_t low  = gen();
+
+        // version 4, variant 10xx
+        high = ( high & 0xFFFFFFFFFFFF0FFFull ) | 0x0000000000004000ull;
+        low  = ( low & 0x3FFFFFFFFFFFFFFFull ) | 0x8000000000000000ull;
+
+        std::string out( 36, '-' );
+        int         at = 0;
+
+        for ( int i = 0; i < 32; i++ )
         {
-            ss << dis( gen );
+            if ( at == 8 || at == 13 || at == 18 || at == 23 )
+                at++;
+
+            uint64_t word = i < 16 ? high : low;
+            out[at++]     = digits[( word >> ( 60 - ( i % 16 ) * 4 ) ) & 0xF];
         }
-        ss << "-";
-        for ( i = 0; i < 12; i++ )
-        {
-            ss << dis( gen );
-        };
-        return ss.str();
+
+        return out;
     }
 }
 
@@ -1,27 +1,62 @@
 #include <strstream>
+#include <cstring>
 #include <fstream>
-#include <emscripten/fetch.h>
 #include <emscripten/bind.h>
+#include <emscripten/console.h>
+#include <emscripten/heap.h>
 #include <glm/gtx/string_cast.hpp>
 
 #include <aakara/App.hpp>
 #include <aakara/Shader.hpp>
 #include <aakara/Mesh.hpp>
+#include <aakara/GpuBufferArena.hpp>
 #include <aakara/Camera.hpp>
 #include <aakara/Renderer.hpp>
 #include <aakara/Texture.hpp>
 #include <aakara/Global.hpp>
 #include <aakara/fetch.hpp>
-#include <uuid.hpp>
+
+#include "pipeline/FrameContext.hpp"
+#include "pipeline/RenderPipeline.hpp"
+#include "pipeline/TransformSystem.hpp"
+#include "pipeline/BoundsSystem.hpp"
+#include "pipeline/CullingSystem.hpp"
+#include "pipeline/LodSystem.hpp"
+#include "pipeline/DrawListSystem.hpp"
+#include "pipeline/RenderSystem.hpp"
 
 #define PTHREAD_POOL_SIZE 4
+#define PART_QUEUE_SIZE 256
+#define CHUNK_QUEUE_SIZE 256
+#define PART_LOADS_IN_FLIGHT 16
+#define ASSET_CACHE_MOUNT "/aakara-cache"
+#define TRANSFORM_DIRTY_RANGES 1024
+#define COMMAND_RING_SIZE ( 64 * 1024 )
+#define EVENT_BUFFER_WORDS ( 16 * 1024 )
+
+// share of the WASM heap assets may take by default; the rest is left to the engine, embind and Assimp
+#define CPU_MEMORY_BUDGET_RATIO 0.75
+
+// GPU uploads of loaded parts per frame, see UploadScheduler
+#define UPLOAD_BYTES_PER_FRAME ( 4 << 20 )
+#define UPLOAD_MILLISECONDS_PER_FRAME 4.0
+
+// bytes the GPU buffer arena may upload again per idle frame to free sparse blocks
+#define GPU_DEFRAGMENT_BYTES_PER_FRAME ( 1 << 20 )
 
 App::App( string canvas_id, int width, int height )
-    : m_threads( PTHREAD_POOL_SIZE )
-    , m_parts()
-    , m_queuedParts()
-    , m_callbacks()
+    : m_jobs( PTHREAD_POOL_SIZE )
+    , m_transformRanges( 2 + TRANSFORM_DIRTY_RANGES * 2, 0 )
+    , m_commands( COMMAND_RING_SIZE )
+    , m_queuedParts( PART_QUEUE_SIZE )
+    , m_queuedChunks( CHUNK_QUEUE_SIZE )
+    , m_loader( m_jobs, m_queuedParts, m_queuedChunks, m_budget, PART_LOADS_IN_FLIGHT,
+          std::make_shared<AssetCache>( std::make_shared<IdbfsStorage>( ASSET_CACHE_MOUNT ) ) )
+    , m_uploads( UPLOAD_BYTES_PER_FRAME, UPLOAD_MILLISECONDS_PER_FRAME )
+    , m_events( EVENT_BUFFER_WORDS )
 {
+    m_budget.setLimits( (u64)( emscripten_get_heap_max() * CPU_MEMORY_BUDGET_RATIO ), 0 );
+
     m_renderer = std::make_shared<Renderer>( canvas_id, width, height );
 
     emscripten_console_logf(
@@ -34,6 +69,22 @@ App::App( string canvas_id, int width, int height )
     m_sunlight = std::make_shared<DirectionalLight>(
         glm::vec3( 1.0f, 0.0f, 0.0f ), glm::vec3( 1.0f, 0.89f, 0.69f ), 1.0f );
 
+    m_frame             = std::make_unique<FrameContext>();
+    m_frame->jobs       = &m_jobs;
+    m_frame->transforms = &m_transforms;
+    m_frame->renderList = &m_renderer->getRenderList();
+
+    m_pipeline = std::make_unique<RenderPipeline>(
+        Array<Ptr<ISystem>> {
+            std::make_shared<TransformSystem>(),
+            std::make_shared<BoundsSystem>(),
+            std::make_shared<CullingSystem>( m_camera ),
+            std::make_shared<LodSystem>( m_camera ),
+            std::make_shared<DrawListSystem>(),
+            std::make_shared<RenderSystem>( m_renderer, m_camera, m_sunlight ),
+        },
+        &m_jobs );
+
     std::stringstream ss;
 
     ss << "Author:        Simanto Rahman" << std::endl;
@@ -46,6 +97,9 @@ App::App( string canvas_id, int width, int height )
 
 App::~App()
 {
+    for ( Ref<Part>& part : m_parts.values() )
+        part->transform->detach();
+
     m_parts.clear();
 }
 
@@ -54,135 +108,624 @@ Ptr<Camera> App::getCamera()
     return m_camera;
 }
 
-void App::setPartTransform( const string& id, const Transform& transform )
+void App::setPartTransform( u32 id, const Transform& transform )
 {
-    if ( m_parts.find( id ) == m_parts.end() )
+    Ref<Part>* part = m_parts.get( id );
+    if ( !part )
         return;
 
-    Ptr<Transform> part_transform = m_parts[id]->transform;
+    Ref<Transform> part_transform = ( *part )->transform;
+
+    part_transform->setPosition( transform.position );
+    part_transform->setRotation( transform.rotation );
+    part_transform->setScale( transform.scale );
+}
+
+JSObject App::getTransformViews()
+{
+    size_t floats = m_transforms.capacity() * 3;
+
+    JSObject views = JSObject::object();
+    views.set( "positions", emscripten::typed_memory_view( floats, m_transforms.positionData() ) );
+    views.set( "rotations", emscripten::typed_memory_view( floats, m_transforms.rotationData() ) );
+    views.set( "scales", emscripten::typed_memory_view( floats, m_transforms.scaleData() ) );
+    views.set( "dirty", emscripten::typed_memory_view( m_transformRanges.size(), m_transformRanges.data() ) );
+    views.set( "version", m_transforms.layoutVersion() );
 
-    part_transform->position = transform.position;
-    part_transform->rotation = transform.rotation;
-    part_transform->scale    = transform.scale;
+    return views;
+}
+
+void App::_applyTransformRanges()
+{
+    u32 count = std::min<u32>( m_transformRanges[0], TRANSFORM_DIRTY_RANGES );
+
+    for ( u32 i = 0; i < count; i++ )
+        m_transforms.markDirty( m_transformRanges[2 + i * 2], m_transformRanges[3 + i * 2] );
+
+    m_transformRanges[0] = 0;
+}
+
+JSObject App::getCommandRing()
+{
+    JSObject views = JSObject::object();
+    views.set( "control", emscripten::typed_memory_view( 2, m_commands.control() ) );
+    views.set( "data", emscripten::typed_memory_view( m_commands.capacity() / 4, m_commands.data() ) );
+    views.set( "capacity", m_commands.capacity() );
+
+    return views;
+}
+
+static JSObject ReportOf( const PoolStats& stats )
+{
+    JSObject report = JSObject::object();
+    report.set( "live", stats.live );
+    report.set( "peak", stats.peak );
+    report.set( "capacity", stats.capacity );
+    report.set( "blocks", stats.blocks );
+    report.set( "emptyBlocks", stats.emptyBlocks );
+    report.set( "fragmentation", stats.fragmentation );
+    report.set( "objectSize", (u32)stats.objectSize );
+    report.set( "reservedBytes", (u32)stats.reservedBytes() );
+
+    return report;
 }
 
-void App::loadPart( const string& mesh_url, const string& texture_url, Ptr<Transform> transform, JSObject cb )
+JSObject App::getMemoryReport()
 {
-    string id;
-    do
+    JSObject report = JSObject::object();
+    report.set( "parts", ReportOf( ObjectPool<Part>::Instance().stats() ) );
+    report.set( "transforms", ReportOf( ObjectPool<Transform>::Instance().stats() ) );
+    report.set( "meshes", ReportOf( ObjectPool<Mesh>::Instance().stats() ) );
+    report.set( "textures", ReportOf( ObjectPool<Texture>::Instance().stats() ) );
+
+    GpuBufferArena::Stats buffers = GpuBufferArena::Instance().stats();
+
+    JSObject gpuBuffers = JSObject::object();
+    gpuBuffers.set( "blocks", buffers.blocks );
+    gpuBuffers.set( "meshes", buffers.ranges );
+    gpuBuffers.set( "capacityBytes", (double)buffers.capacityBytes );
+    gpuBuffers.set( "usedBytes", (double)buffers.usedBytes );
+    gpuBuffers.set( "movedBytes", (double)buffers.movedBytes );
+    report.set( "gpuBuffers", gpuBuffers );
+
+    return report;
+}
+
+JSObject App::getMemoryStats()
+{
+    return m_budget.stats();
+}
+
+void App::setMemoryBudget( double cpuBytes, double gpuBytes )
+{
+    m_budget.setLimits( (u64)std::max( cpuBytes, 0.0 ), (u64)std::max( gpuBytes, 0.0 ) );
+}
+
+void App::setUploadBudget( double bytes, double milliseconds )
+{
+    m_uploads.setBudget( (u64)std::max( bytes, 0.0 ), std::max( milliseconds, 0.0 ) );
+}
+
+static f32 F32At( const u32* words )
+{
+    f32 value;
+    std::memcpy( &value, words, sizeof( value ) );
+    return value;
+}
+
+static glm::vec3 Vec3At( const u32* words )
+{
+    return glm::vec3( F32At( words ), F32At( words + 1 ), F32At( words + 2 ) );
+}
+
+void App::_applyCommands()
+{
+    RenderList& list = m_renderer->getRenderList();
+
+    m_commands.consume(
+        [this, &list]( CommandType type, const u32* payload, u32 words )
+        {
+            switch ( type )
+            {
+            case CommandType::SetTransform:
+                if ( words >= 10 && payload[0] < m_transforms.capacity() )
+                {
+                    u32 slot = payload[0];
+
+                    std::memcpy( m_transforms.positionData() + slot * 3, payload + 1, 3 * sizeof( f32 ) );
+                    std::memcpy( m_transforms.rotationData() + slot * 3, payload + 4, 3 * sizeof( f32 ) );
+                    std::memcpy( m_transforms.scaleData() + slot * 3, payload + 7, 3 * sizeof( f32 ) );
+                    m_transforms.markDirty( slot );
+                }
+                break;
+
+            case CommandType::SetVisible:
+                if ( words >= 2 && payload[0] < m_transforms.capacity() )
+                    list.setHidden( payload[0], payload[1] == 0 );
+                break;
+
+            case CommandType::SetCamera:
+                if ( words >= 6 )
+                {
+                    m_camera->transform->setPosition( Vec3At( payload ) );
+                    m_camera->transform->setRotation( Vec3At( payload + 3 ) );
+                }
+                break;
+
+            case CommandType::SetCameraLens:
+                if ( words >= 3 )
+                {
+                    m_camera->FOV   = F32At( payload );
+                    m_camera->ZNear = F32At( payload + 1 );
+                    m_camera->ZFar  = F32At( payload + 2 );
+                }
+                break;
+
+            case CommandType::SetLightDirection:
+                if ( words >= 3 )
+                    m_sunlight->Direction = Vec3At( payload );
+                break;
+
+            case CommandType::SetLightColor:
+                if ( words >= 4 )
+                {
+                    m_sunlight->Color    = Vec3At( payload );
+                    m_sunlight->Strength = F32At( payload + 3 );
+                }
+                break;
+
+            case CommandType::SetClearColor:
+                if ( words >= 3 )
+                    m_renderer->setColor( F32At( payload ), F32At( payload + 1 ), F32At( payload + 2 ) );
+                break;
+
+            default:
+                break;
+            }
+        } );
+
+    if ( m_commands.corrupt() != m_commandsCorrupt )
     {
-        id = uuid::generate();
-    } while ( m_parts.find( id ) != m_parts.end() );
+        m_commandsCorrupt = m_commands.corrupt();
+        emscripten_console_error( "Malformed command record, pending commands dropped" );
+    }
+}
+
+JSObject App::getEvents()
+{
+    return JSObject( emscripten::typed_memory_view( m_events.size(), m_events.data() ) );
+}
 
-    m_callbacks.insert( std::map<string, JSObject>::value_type( id, JSObject( cb ) ) );
+u32 App::loadPart( const string& mesh_url, const string& texture_url, Ptr<Transform> transform )
+{
+    Ref<Transform> part_transform;
+    try
+    {
+        part_transform = RefOf( transform );
+    }
+    catch ( const std::exception& e )
+    {
+        emscripten_console_errorf( "Cannot load part: %s", e.what() );
+        return 0;
+    }
 
-    auto LoadPartFn = [id, this]( string mesh_url, string texture_url, Ptr<Transform> transform )
+    u32 handle = m_parts.insert( nullptr );
+    if ( handle == PartTable::Invalid )
     {
-        emscripten_fetch_attr_t attr;
-        emscripten_fetch_t*     fetch = nullptr;
-        try
-        {
-            /* ------------------------------- Fetch mesh ------------------------------- */
-            emscripten_fetch_attr_init( &attr );
+        emscripten_console_error( "Part table is full" );
+        return 0;
+    }
 
-            attr.attributes = EMSCRIPTEN_FETCH_LOAD_TO_MEMORY | EMSCRIPTEN_FETCH_SYNCHRONOUS;
-            std::strcpy( attr.requestMethod, "GET" );
+    // only read on this thread, after the part comes back through m_queuedParts
+    Ref<Part> part = m_loader.load( mesh_url, texture_url, part_transform );
+    part->handle   = handle;
 
-            fetch = emscripten_fetch( &attr, mesh_url.c_str() );
+    *m_parts.get( handle ) = part;
 
-            if ( fetch->status != 200 || fetch->numBytes == 0 )
-                throw std::runtime_error( "Mesh fetch failed" );
+    return handle;
+}
 
-            Ptr<Mesh> mesh = Mesh::LoadFromMemory( fetch->data, fetch->numBytes );
+void App::setPartName( u32 id, const string& name )
+{
+    m_parts.setName( id, name );
+}
 
-            emscripten_fetch_close( fetch );
-            fetch = nullptr;
+u32 App::findPart( const string& name )
+{
+    return m_parts.find( name );
+}
 
-            /* ------------------------------ Fetch texture ----------------------------- */
-            emscripten_fetch_attr_init( &attr );
+u32 App::loadParts( JSObject manifest )
+{
+    for ( const char* field : { "urls", "parts", "transforms" } )
+    {
+        if ( manifest[field].isUndefined() )
+        {
+            emscripten_console_errorf( "Manifest has no %s", field );
+            return 0;
+        }
+    }
 
-            attr.attributes = EMSCRIPTEN_FETCH_LOAD_TO_MEMORY | EMSCRIPTEN_FETCH_SYNCHRONOUS;
-            std::strcpy( attr.requestMethod, "GET" );
+    // a few crossings per manifest rather than per part: URLs are joined in JS, numbers copied in bulk
+    string     joined     = manifest["urls"].call<string>( "join", string( "\n" ) );
+    Array<u32> indices    = emscripten::convertJSArrayToNumberVector<u32>( manifest["parts"] );
+    Array<f32> transforms = emscripten::convertJSArrayToNumberVector<f32>( manifest["transforms"] );
 
-            fetch = emscripten_fetch( &attr, texture_url.c_str() );
+    // optional: loads of parts with known bounds are ranked by visibility
+    Array<f32> bounds;
+    if ( !manifest["bounds"].isUndefined() )
+        bounds = emscripten::convertJSArrayToNumberVector<f32>( manifest["bounds"] );
 
-            if ( fetch->status != 200 || fetch->numBytes == 0 )
-                throw std::runtime_error( "Texture fetch failed" );
+    Array<string> urls;
+    for ( size_t begin = 0, end = 0; end != string::npos; begin = end + 1 )
+    {
+        end = joined.find( '\n', begin );
+        urls.push_back( joined.substr( begin, end == string::npos ? string::npos : end - begin ) );
+    }
 
-            Ptr<Texture> texture
-                = Texture::LoadFromMemory( reinterpret_cast<const u8*>( fetch->data ), fetch->numBytes );
+    if ( indices.size() % 2 != 0 )
+    {
+        emscripten_console_errorf(
+            "Manifest parts has %zu values, not a mesh and texture index per part", indices.size() );
+        return 0;
+    }
 
-            emscripten_fetch_close( fetch );
-            fetch = nullptr;
+    u32 count = (u32)( indices.size() / 2 );
+    if ( transforms.size() < (size_t)count * 9 )
+    {
+        emscripten_console_errorf(
+            "Manifest has %u parts but only %zu transform values", count, transforms.size() );
+        return 0;
+    }
+
+    if ( !bounds.empty() && bounds.size() < (size_t)count * 6 )
+    {
+        emscripten_console_errorf( "Manifest has %u parts but only %zu bounds values", count, bounds.size() );
+        return 0;
+    }
+
+    u32    id    = m_nextBatch++;
+    Batch& batch = m_batches.emplace( id, Batch { count } ).first->second;
+
+    batch.changed = true;
 
-            /* --------------------------- Create and queue part -------------------------- */
-            Ptr<Part> part = std::make_shared<Part>( id, mesh, texture, transform );
+    for ( u32 i = 0; i < count; i++ )
+    {
+        u32 mesh    = indices[i * 2];
+        u32 texture = indices[i * 2 + 1];
 
-            this->m_queuedParts.push( part );
+        u32 handle = mesh < urls.size() && texture < urls.size() ? m_parts.insert( nullptr ) : 0;
+        if ( handle == PartTable::Invalid )
+        {
+            batch.failed++;
+            m_events.push( EventType::PartFailed, { 0, id, i } );
+            continue;
         }
-        catch ( const std::exception& err )
+
+        const f32*     t         = &transforms[i * 9];
+        Ref<Transform> transform = MakeRef<Transform>(
+            glm::vec3( t[0], t[1], t[2] ), glm::vec3( t[3], t[4], t[5] ), glm::vec3( t[6], t[7], t[8] ) );
+
+        Bounds partBounds;
+        if ( !bounds.empty() )
         {
-            emscripten_console_errorf( "Failed to load mesh: %s", err.what() );
-            return;
+            const f32* b = &bounds[i * 6];
+            partBounds   = { glm::vec3( b[0], b[1], b[2] ), glm::vec3( b[3], b[4], b[5] ) };
         }
-    };
 
-    m_threads.push_task( LoadPartFn, mesh_url, texture_url, transform );
+        Ref<Part> part
+            = m_loader.load( urls[mesh], urls[texture], transform, bounds.empty() ? nullptr : &partBounds );
+
+        // batch fields are only read on this thread, after the part comes back through m_queuedParts
+        part->handle     = handle;
+        part->batch      = id;
+        part->batchIndex = i;
+
+        *m_parts.get( handle ) = part;
+    }
+
+    return id;
+}
+
+u32 App::createDynamicPart( u32 vertexCount, JSObject indices, Ptr<Transform> transform, bool stream )
+{
+    Ref<Part>              part  = MakeRef<Part>();
+    DynamicGeometry::Usage usage = stream ? DynamicGeometry::Usage::Stream : DynamicGeometry::Usage::Dynamic;
+    try
+    {
+        part->transform = RefOf( transform );
+        part->mesh      = Mesh::CreateDynamic(
+            vertexCount, emscripten::convertJSArrayToNumberVector<u16>( indices ), usage );
+    }
+    catch ( const std::exception& e )
+    {
+        emscripten_console_errorf( "Cannot create dynamic part: %s", e.what() );
+        return 0;
+    }
+
+    part->handle = m_parts.insert( part );
+    if ( part->handle == PartTable::Invalid )
+    {
+        emscripten_console_error( "Part table is full" );
+        return 0;
+    }
+
+    if ( !m_blankTexture )
+    {
+        m_blankTexture = MakeRef<Texture>( Array<u8>( 4, 0xFF ), 1, 1, Texture::PixelType::RGBA );
+        m_blankTexture->update();
+    }
+
+    part->texture = m_blankTexture;
+    _addPart( *part );
+
+    return part->handle;
+}
+
+JSObject App::getDynamicVertices( u32 id )
+{
+    Ref<Part>* part = m_parts.get( id );
+    if ( !part || !( *part )->mesh || !( *part )->mesh->getDynamic() )
+        return JSObject::null();
+
+    DynamicGeometry* geometry = ( *part )->mesh->getDynamic();
+    size_t           floats   = (size_t)geometry->vertexCount() * sizeof( GpuVertex ) / sizeof( f32 );
+    f32*             data     = reinterpret_cast<f32*>( geometry->vertices() );
+
+    return JSObject( emscripten::typed_memory_view( floats, data ) );
+}
+
+void App::updateDynamicPart( u32 id, u32 firstVertex, u32 count )
+{
+    Ref<Part>* part = m_parts.get( id );
+    if ( !part || !( *part )->mesh || !( *part )->mesh->getDynamic() )
+        return;
+
+    DynamicGeometry* geometry = ( *part )->mesh->getDynamic();
+
+    if ( !geometry->isDirty() )
+        m_dirtyDynamicParts.push_back( id );
+
+    geometry->markDirty( firstVertex, count );
+}
+
+void App::_flushDynamicParts()
+{
+    for ( u32 id : m_dirtyDynamicParts )
+    {
+        Ref<Part>* part = m_parts.get( id );
+        if ( part && ( *part )->mesh->flush() )
+            m_renderer->getRenderList().markMeshChanged( ( *part )->renderHandle );
+    }
+
+    m_dirtyDynamicParts.clear();
 }
 
-void App::removePart( const string& id )
+void App::removePart( u32 id )
 {
     clearById( id );
 }
 
+void App::setMaxConcurrentLoads( u32 count )
+{
+    m_loader.setMaxInFlight( count );
+}
+
 size_t App::draw()
 {
+    m_frame->arena.reset();
+
+    _applyTransformRanges();
+    _applyCommands();
     _processQueue();
+    _flushDynamicParts();
+
+    m_transformRanges[1] = m_transforms.layoutVersion();
+
+    m_loader.update(
+        m_camera->GetPerspectiveProjection() * m_camera->GetView(), m_camera->transform->position );
 
-    std::queue<RenderCmd> queue;
+    m_renderer->getRenderList().sort( m_frame->arena );
 
-    for ( auto [id, part] : m_parts )
-        queue.emplace( part->mesh, part->texture, part->transform );
+    m_pipeline->Run( *m_frame );
 
-    // emscripten_console_logf( "Drawing %lu items...", queue.size() );
+    // loading frames have better uses for upload bandwidth than compacting
+    if ( m_loader.getInFlight() == 0 && m_loader.getPending() == 0 && m_uploads.empty() )
+        GpuBufferArena::Instance().defragment( GPU_DEFRAGMENT_BYTES_PER_FRAME );
 
-    size_t queue_size = queue.size();
-    m_renderer->drawItems( queue, m_camera, m_sunlight );
+    size_t packetBytes = Memory::BytesOf( m_frame->packets );
+    for ( const Array<DrawPacket>& packets : m_frame->chunkPackets )
+        packetBytes += Memory::BytesOf( packets );
+
+    // both halves of the double-buffered arena are allocated
+    m_renderCharge = MemoryCharge( MemoryTag::Render,
+        m_renderer->getRenderList().memoryBytes() + m_transforms.memoryBytes() + m_frame->arena.capacity() * 2
+            + packetBytes );
+
+    m_events.push( EventType::FrameStats,
+        { (u32)m_frame->packets.size(), (u32)m_renderer->getRenderList().size(), m_loader.getInFlight(),
+            (u32)m_loader.getPending() } );
+
+    UploadScheduler::Stats uploads = m_uploads.stats();
+    if ( uploads.bytes || !m_uploads.empty() )
+    {
+        m_events.push( EventType::UploadStats,
+            { uploads.parts, uploads.chunks, (u32)std::min<u64>( uploads.bytes, UINT32_MAX ),
+                (u32)( uploads.milliseconds * 1000.0f ), (u32)uploads.stallMilliseconds } );
+    }
 
     Global::Time::Reset();
 
-    return queue_size;
+    return m_frame->packets.size();
 }
 
-void App::clearById( const string& id )
+void App::clearById( u32 id )
 {
-    if ( m_parts.find( id ) != m_parts.end() )
-        m_parts.erase( id );
+    Ref<Part>* entry = m_parts.get( id );
+    if ( !entry )
+        return;
+
+    Part& part = **entry;
+
+    // loads and uploads in progress stop, and the part counts as failed in its batch right away
+    if ( m_uploads.cancel( part ) )
+    {
+        _countInBatch( part, false );
+    }
+    else if ( !part.ready )
+    {
+        m_loader.cancel( part );
+        _countInBatch( part, false );
+    }
+
+    if ( part.ready )
+    {
+        m_renderer->getRenderList().remove( part.renderHandle );
+        for ( u32 handle : part.chunkHandles )
+            m_renderer->getRenderList().remove( handle );
+
+        u32 slot = part.transform->getSlot();
+
+        part.transform->detach();
+        m_transforms.destroy( slot );
+        m_renderer->getRenderList().setHidden( slot, false );
+    }
+
+    m_parts.remove( id );
 }
 
 void App::_processQueue()
 {
-    while ( !m_queuedParts.empty() )
+    Ref<Part> part;
+    while ( m_queuedParts.tryPop( part ) )
+    {
+        // removed after the loader handed it over, and already counted by clearById()
+        Ref<Part>* entry = m_parts.get( part->handle );
+        if ( !entry || *entry != part )
+            continue;
+
+        if ( part->failed )
+        {
+            _countInBatch( *part, false );
+            m_events.push( EventType::PartFailed, { part->handle, part->batch, part->batchIndex } );
+            m_parts.remove( part->handle );
+            continue;
+        }
+
+        m_uploads.push( std::move( part ) );
+    }
+
+    LoadedChunk chunk;
+    while ( m_queuedChunks.tryPop( chunk ) )
     {
-        Ptr<Part> part = m_queuedParts.front();
-        m_queuedParts.pop();
+        Ref<Part>* entry = m_parts.get( chunk.part->handle );
+        if ( !entry || *entry != chunk.part )
+            continue;
+
+        // a failed read leaves the chunk where it is, without arrays, until the arena asks again
+        if ( chunk.refill )
+        {
+            Mesh& mesh = *chunk.refill;
+
+            if ( chunk.mesh )
+                mesh.restoreArrays( std::move( chunk.mesh->Vertices ), std::move( chunk.mesh->Indices ) );
+            else
+                mesh.restoreArrays( {}, {} );
+
+            continue;
+        }
+
+        // the part keeps the chunks it has; whether to load it again is up to JS
+        if ( !chunk.mesh )
+        {
+            const Part& part = *chunk.part;
+            m_events.push(
+                EventType::ChunkFailed, { part.handle, chunk.index, part.batch, part.batchIndex } );
+            continue;
+        }
+
+        m_uploads.push( std::move( chunk ) );
+    }
 
-        string& id = part->id;
+    Array<Ref<Part>>   uploaded;
+    Array<LoadedChunk> uploadedChunks;
+    m_uploads.run( uploaded, uploadedChunks );
 
-        part->mesh->update( m_renderer->GetShader().get() );
-        part->texture->update();
+    for ( const Ref<Part>& part : uploaded )
+        _addPart( *part );
 
-        emscripten_console_logf( "Part loaded with vertex count: %lu", part->mesh->Positions.size() );
+    _flushBatches();
 
-        // m_parts.insert( std::map<string, Part>::value_type( id, part ) );
+    for ( const LoadedChunk& chunk : uploadedChunks )
+    {
+        Part& owner = *chunk.part;
+        owner.chunks.push_back( chunk.mesh );
+
+        // chunks of parts still loading or uploading are added with the part
+        if ( owner.ready )
+            _addChunk( owner, *chunk.mesh );
+    }
+}
+
+void App::_addPart( Part& part )
+{
+    part.transform->attach( &m_transforms, m_transforms.create( *part.transform ) );
 
-        m_parts[id] = part;
+    // streamed parts have no mesh of their own, only the chunks that arrived so far
+    if ( part.mesh )
+    {
+        part.renderHandle = m_renderer->getRenderList().add(
+            part.mesh.get(), part.texture.get(), part.transform->getSlot() );
+
+        emscripten_console_logf( "Part loaded with vertex count: %lu", part.mesh->Vertices.size() );
+    }
+
+    for ( const Ref<Mesh>& chunk : part.chunks )
+        _addChunk( part, *chunk );
+
+    part.ready = true;
+
+    _countInBatch( part, true );
+    m_events.push(
+        EventType::PartLoaded, { part.handle, part.transform->getSlot(), part.batch, part.batchIndex } );
+}
+
+void App::_countInBatch( const Part& part, bool loaded )
+{
+    if ( !part.batch )
+        return;
+
+    auto batch = m_batches.find( part.batch );
+    if ( batch == m_batches.end() )
+        return;
+
+    ( loaded ? batch->second.loaded : batch->second.failed )++;
+    batch->second.changed = true;
+}
+
+void App::_addChunk( Part& part, Mesh& chunk )
+{
+    chunk.update( m_renderer->GetShader().get() );
+
+    part.chunkHandles.push_back(
+        m_renderer->getRenderList().add( &chunk, part.texture.get(), part.transform->getSlot() ) );
+}
+
+void App::_flushBatches()
+{
+    for ( auto it = m_batches.begin(); it != m_batches.end(); )
+    {
+        Batch& batch = it->second;
+        if ( !batch.changed )
+        {
+            ++it;
+            continue;
+        }
 
-        // call the JS callback function for this given part
-        JSObject onPartLoad( m_callbacks.find( id )->second );
+        m_events.push( EventType::BatchProgress, { it->first, batch.total, batch.loaded, batch.failed } );
+        batch.changed = false;
 
-        onPartLoad( part );
-        m_callbacks.erase( id );
+        it = batch.loaded + batch.failed == batch.total ? m_batches.erase( it ) : std::next( it );
     }
 }
 
@@ -217,8 +760,22 @@ EMSCRIPTEN_BINDINGS( APP_HPP )
         .function( "createLight", &createLight )
         // .function( "deltaTime", &Global::Time::DeltaTime )
         .function( "setTransform", &App::setPartTransform )
+        .function( "getTransformViews", &App::getTransformViews )
+        .function( "getCommandRing", &App::getCommandRing )
+        .function( "getEvents", &App::getEvents )
+        .function( "getMemoryReport", &App::getMemoryReport )
+        .function( "getMemoryStats", &App::getMemoryStats )
+        .function( "setMemoryBudget", &App::setMemoryBudget )
+        .function( "setUploadBudget", &App::setUploadBudget )
         .function( "loadPart", &App::loadPart )
-        .function( "removePart", &App::removePart );
+        .function( "loadParts", &App::loadParts )
+        .function( "createDynamicPart", &App::createDynamicPart )
+        .function( "getDynamicVertices", &App::getDynamicVertices )
+        .function( "updateDynamicPart", &App::updateDynamicPart )
+        .function( "setPartName", &App::setPartName )
+        .function( "findPart", &App::findPart )
+        .function( "removePart", &App::removePart )
+        .function( "setMaxConcurrentLoads", &App::setMaxConcurrentLoads );
 
     emscripten::value_object<glm::vec3>( "Vec3" )
         .field( "x", &glm::vec3::x )
@@ -0,0 +1,203 @@
+#include <cstdio>
+#include <sys/stat.h>
+
+#ifdef __EMSCRIPTEN__
+#    include <emscripten/emscripten.h>
+#endif
+
+#include <aakara/AssetCache.hpp>
+
+/* -------------------------------------------------------------------------- */
+/*                              DirectoryStorage                              */
+/* -------------------------------------------------------------------------- */
+DirectoryStorage::DirectoryStorage( const string& directory )
+    : m_directory( directory )
+{
+    mkdir( m_directory.c_str(), 0777 );
+}
+
+bool DirectoryStorage::read( const string& name, Array<u8>& out )
+{
+    FILE* file = std::fopen( pathOf( name ).c_str(), "rb" );
+    if ( !file )
+        return false;
+
+    std::fseek( file, 0, SEEK_END );
+    long size = std::ftell( file );
+    std::fseek( file, 0, SEEK_SET );
+
+    bool ok = size >= 0;
+    if ( ok )
+    {
+        out.resize( size );
+        ok = std::fread( out.data(), 1, out.size(), file ) == out.size();
+    }
+
+    std::fclose( file );
+
+    return ok;
+}
+
+void DirectoryStorage::write( const string& name, const Array<u8>& data )
+{
+    // write next to the target and rename, so a reader never sees a partial file
+    string path      = pathOf( name );
+    string temporary = path + ".tmp";
+
+    FILE* file = std::fopen( temporary.c_str(), "wb" );
+    if ( !file )
+        return;
+
+    bool ok = std::fwrite( data.data(), 1, data.size(), file ) == data.size();
+    ok &= std::fclose( file ) == 0;
+
+    if ( ok )
+        std::rename( temporary.c_str(), path.c_str() );
+    else
+        std::remove( temporary.c_str() );
+}
+
+void DirectoryStorage::remove( const string& name )
+{
+    std::remove( pathOf( name ).c_str() );
+}
+
+string DirectoryStorage::pathOf( const string& name ) const
+{
+    return m_directory + "/" + name;
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                IdbfsStorage                                */
+/* -------------------------------------------------------------------------- */
+#ifdef __EMSCRIPTEN__
+IdbfsStorage::IdbfsStorage( const string& mountPoint )
+    : DirectoryStorage( mountPoint )
+{
+    // clang-format off
+    EM_ASM( {
+        var dir = UTF8ToString( $0 );
+        FS.mount( IDBFS, {}, dir );
+        FS.syncfs( true, function( err ) {
+            if ( err )
+                console.error( "Asset cache restore failed", err );
+            HEAPU8[$1] = 1;
+        } );
+    }, m_directory.c_str(), &m_ready );
+    // clang-format on
+}
+
+void IdbfsStorage::flush()
+{
+    if ( !m_ready )
+        return;
+
+    // clang-format off
+    EM_ASM( {
+        FS.syncfs( false, function( err ) {
+            if ( err )
+                console.error( "Asset cache persist failed", err );
+        } );
+    } );
+    // clang-format on
+}
+#endif
+
+/* -------------------------------------------------------------------------- */
+/*                                 AssetCache                                 */
+/* -------------------------------------------------------------------------- */
+AssetCache::AssetCache( Ptr<CacheStorage> storage, u32 version )
+    : m_storage( storage )
+    , m_version( version )
+{
+}
+
+bool AssetCache::condition( const string& url, HTTP::Header& out )
+{
+    Array<u8> meta;
+    if ( !m_storage->ready() || !m_storage->read( nameOf( url ) + ".meta", meta ) )
+        return false;
+
+    // url, header name and header value on separate lines; the url guards against name collisions
+    string text( meta.begin(), meta.end() );
+
+    size_t first  = text.find( '\n' );
+    size_t second = first == string::npos ? string::npos : text.find( '\n', first + 1 );
+
+    if ( second == string::npos || text.compare( 0, first, url ) != 0 )
+        return false;
+
+    out.Key   = text.substr( first + 1, second - first - 1 );
+    out.Value = text.substr( second + 1 );
+
+    return true;
+}
+
+bool AssetCache::load( const string& url, Array<u8>& payload )
+{
+    if ( !m_storage->ready() || !m_storage->read( nameOf( url ) + ".bin", payload ) )
+        return false;
+
+    Memory::CountCopy( CopyStage::Cache, payload.size() );
+    return true;
+}
+
+void AssetCache::store( const string& url, const HTTP::Header& condition, const Array<u8>& payload )
+{
+    if ( !m_storage->ready() )
+        return;
+
+    string    text = url + "\n" + condition.Key + "\n" + condition.Value;
+    Array<u8> meta( text.begin(), text.end() );
+
+    // payload first: a validator must never point at a missing or stale payload
+    m_storage->write( nameOf( url ) + ".bin", payload );
+    m_storage->write( nameOf( url ) + ".meta", meta );
+}
+
+void AssetCache::flush()
+{
+    m_storage->flush();
+}
+
+bool AssetCache::ConditionFor( const HTTP::Response& response, HTTP::Header& out )
+{
+    string etag = response.header( "ETag" );
+    if ( !etag.empty() )
+    {
+        out = { "If-None-Match", etag };
+        return true;
+    }
+
+    string lastModified = response.header( "Last-Modified" );
+    if ( !lastModified.empty() )
+    {
+        out = { "If-Modified-Since", lastModified };
+        return true;
+    }
+
+    return false;
+}
+
+string AssetCache::nameOf( const string& url ) const
+{
+    // FNV-1a over the layout version and the URL
+    u64 hash = 14695981039346656037ull;
+
+    auto mix = [&hash]( u8 byte )
+    {
+        hash ^= byte;
+        hash *= 1099511628211ull;
+    };
+
+    for ( u32 i = 0; i < 4; i++ )
+        mix( (u8)( m_version >> ( i * 8 ) ) );
+
+    for ( char c : url )
+        mix( (u8)c );
+
+    char name[17];
+    std::snprintf( name, sizeof( name ), "%016llx", hash );
+
+    return name;
+}
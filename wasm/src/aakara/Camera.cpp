@@ -12,7 +12,7 @@
 
 Camera::Camera()
 {
-    transform = std::make_shared<Transform>();
+    transform = MakeShared<Transform>();
 }
 
 glm::mat4 Camera::GetView()
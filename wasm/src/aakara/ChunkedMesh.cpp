@@ -0,0 +1,143 @@
+#include <numeric>
+#include <algorithm>
+#include <stdexcept>
+
+#include <aakara/ChunkedMesh.hpp>
+#include <aakara/Mesh.hpp>
+#include <aakara/Binary.hpp>
+
+bool ChunkedMesh::ReadTable( const u8* data, size_t size, Array<Chunk>& out, size_t& required )
+{
+    required = HEADER_SIZE;
+    if ( size < required )
+        return false;
+
+    ByteReader reader( data, size );
+
+    if ( reader.read<u32>() != MAGIC )
+        throw std::runtime_error( "Not a chunked mesh" );
+
+    u32 count = reader.read<u32>();
+
+    required = HEADER_SIZE + (size_t)count * sizeof( Chunk );
+    if ( size < required )
+        return false;
+
+    out.resize( count );
+    reader.readArray( out.data(), count );
+
+    return true;
+}
+
+void ChunkedMesh::Write( const Array<Ref<Mesh>>& chunks, Array<u8>& out )
+{
+    Array<Chunk> table( chunks.size() );
+    Array<u8>    body;
+
+    u64 offset = HEADER_SIZE + chunks.size() * sizeof( Chunk );
+
+    for ( size_t i = 0; i < chunks.size(); i++ )
+    {
+        size_t start = body.size();
+        chunks[i]->Serialize( body );
+
+        table[i].offset      = offset + start;
+        table[i].size        = (u32)( body.size() - start );
+        table[i].vertexCount = (u32)chunks[i]->Vertices.size();
+        table[i].bounds      = chunks[i]->LocalBounds;
+    }
+
+    ByteWriter writer( out );
+
+    writer.write( MAGIC );
+    writer.write( (u32)table.size() );
+    writer.writeArray( table.data(), table.size() );
+    writer.writeArray( body.data(), body.size() );
+}
+
+Array<Ref<Mesh>> ChunkedMesh::Split( const Mesh& mesh, u32 maxVertices )
+{
+    constexpr u32 Unmapped = 0xFFFFFFFF;
+
+    maxVertices = std::max<u32>( std::min<u32>( maxVertices, 0xFFFF ), 3 );
+
+    const Array<GpuVertex>& vertices = mesh.Vertices;
+    const Array<u16>&       indices  = mesh.Indices;
+
+    Bounds    bounds = Bounds::FromVertices( vertices );
+    glm::vec3 size   = bounds.Max - bounds.Min;
+    int       axis   = size.x >= size.y && size.x >= size.z ? 0 : ( size.y >= size.z ? 1 : 2 );
+
+    u32 triangleCount = (u32)( indices.size() / 3 );
+
+    // order triangles by centroid along the longest axis
+    Array<f32> keys( triangleCount );
+    for ( u32 t = 0; t < triangleCount; t++ )
+        keys[t] = vertices[indices[t * 3]].position[axis] + vertices[indices[t * 3 + 1]].position[axis]
+                  + vertices[indices[t * 3 + 2]].position[axis];
+
+    Array<u32> order( triangleCount );
+    std::iota( order.begin(), order.end(), 0 );
+    std::sort( order.begin(), order.end(), [&keys]( u32 a, u32 b ) { return keys[a] < keys[b]; } );
+
+    Array<Ref<Mesh>> chunks;
+    Array<u32>       remap( vertices.size(), Unmapped );
+    Array<u32>       used; // source vertices of the current chunk, in chunk order
+
+    Array<GpuVertex> chunkVertices;
+    Array<u16>       chunkIndices;
+
+    auto flush = [&]()
+    {
+        if ( chunkIndices.empty() )
+            return;
+
+        chunks.push_back( MakeRef<Mesh>( std::move( chunkVertices ), std::move( chunkIndices ) ) );
+
+        for ( u32 vertex : used )
+            remap[vertex] = Unmapped;
+
+        used.clear();
+        chunkVertices.clear();
+        chunkIndices.clear();
+    };
+
+    for ( u32 t : order )
+    {
+        u32 added = 0;
+        for ( u32 k = 0; k < 3; k++ )
+            added += remap[indices[t * 3 + k]] == Unmapped;
+
+        if ( used.size() + added > maxVertices )
+            flush();
+
+        for ( u32 k = 0; k < 3; k++ )
+        {
+            u32 vertex = indices[t * 3 + k];
+
+            if ( remap[vertex] == Unmapped )
+            {
+                remap[vertex] = (u32)used.size();
+                used.push_back( vertex );
+
+                chunkVertices.push_back( vertices[vertex] );
+            }
+
+            chunkIndices.push_back( (u16)remap[vertex] );
+        }
+    }
+
+    flush();
+
+    return chunks;
+}
+
+bool ChunkedMesh::IsChunked( const string& url )
+{
+    static const string extension = ".akc";
+
+    string path = url.substr( 0, url.find_first_of( "?#" ) );
+
+    return path.size() >= extension.size()
+           && path.compare( path.size() - extension.size(), extension.size(), extension ) == 0;
+}
@@ -0,0 +1,51 @@
+#include <cstring>
+
+#include <aakara/CommandRing.hpp>
+
+CommandRing::CommandRing( u32 capacity )
+{
+    static_assert( sizeof( std::atomic<u32> ) == sizeof( u32 ), "JS accesses the control words as u32" );
+
+    u32 size = 64;
+    while ( size < capacity )
+        size <<= 1;
+
+    m_data.resize( size / 4 );
+    m_mask = size - 1;
+}
+
+bool CommandRing::write( CommandType type, const u32* payload, u32 words )
+{
+    u32 record = words + 1;
+    if ( record > 0xFFFF )
+        return false;
+
+    u32 head = m_head.load( std::memory_order_relaxed );
+    u32 tail = m_tail.load( std::memory_order_acquire );
+    u32 free = capacity() - ( head - tail );
+    u32 end  = capacity() - ( head & m_mask );
+
+    if ( record * 4 > end )
+    {
+        // pad to the end of the ring and start over
+        if ( end + record * 4 > free )
+            return false;
+
+        m_data[( head & m_mask ) / 4] = ( end / 4 ) << 16 | (u32)CommandType::Pad;
+
+        head += end;
+        free -= end;
+    }
+
+    if ( record * 4 > free )
+        return false;
+
+    u32 offset = ( head & m_mask ) / 4;
+
+    m_data[offset] = record << 16 | (u32)type;
+    std::memcpy( &m_data[offset + 1], payload, words * 4 );
+
+    m_head.store( head + record * 4, std::memory_order_release );
+
+    return true;
+}
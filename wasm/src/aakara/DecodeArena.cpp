@@ -0,0 +1,191 @@
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <new>
+
+#include <aakara/DecodeArena.hpp>
+#include <aakara/MemoryBudget.hpp>
+
+// what malloc would guarantee natively; wasm32 malloc only aligns to 8
+constexpr size_t DECODE_ARENA_ALIGNMENT = 16;
+constexpr size_t DECODE_ARENA_MIN_BLOCK = 1 << 20;
+
+static size_t AlignUp( size_t value )
+{
+    return ( value + DECODE_ARENA_ALIGNMENT - 1 ) & ~( DECODE_ARENA_ALIGNMENT - 1 );
+}
+
+static u8* AllocateBlock( size_t size )
+{
+    void* data = nullptr;
+    if ( posix_memalign( &data, DECODE_ARENA_ALIGNMENT, size ) != 0 )
+        return nullptr;
+
+    Memory::Track( MemoryTag::Decode, (i64)size );
+    return static_cast<u8*>( data );
+}
+
+static void FreeBlock( u8* data, size_t size )
+{
+    std::free( data );
+    Memory::Track( MemoryTag::Decode, -(i64)size );
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                    Scope                                   */
+/* -------------------------------------------------------------------------- */
+DecodeArena::Scope::Scope()
+    : m_arena( DecodeArena::Local() )
+    , m_block( m_arena.m_block )
+    , m_offset( m_arena.m_offset )
+{
+    m_arena.m_depth++;
+}
+
+DecodeArena::Scope::~Scope()
+{
+    if ( --m_arena.m_depth == 0 )
+        m_arena.release();
+    else
+        m_arena.rewind( m_block, m_offset );
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                 DecodeArena                                */
+/* -------------------------------------------------------------------------- */
+DecodeArena::~DecodeArena()
+{
+    for ( Block& block : m_blocks )
+        FreeBlock( block.data, block.size );
+}
+
+DecodeArena& DecodeArena::Local()
+{
+    thread_local DecodeArena arena;
+    return arena;
+}
+
+void* DecodeArena::Malloc( size_t size )
+{
+    DecodeArena& arena = Local();
+    return arena.m_depth ? arena.allocate( size ) : std::malloc( size );
+}
+
+void* DecodeArena::Realloc( void* pointer, size_t size, size_t newSize )
+{
+    DecodeArena& arena = Local();
+
+    if ( !pointer )
+        return Malloc( newSize );
+
+    if ( arena.owns( pointer ) )
+        return arena.reallocate( pointer, size, newSize );
+
+    return std::realloc( pointer, newSize );
+}
+
+void DecodeArena::Free( void* pointer )
+{
+    if ( pointer && !Local().owns( pointer ) )
+        std::free( pointer );
+}
+
+void* DecodeArena::allocate( size_t size )
+{
+    size = AlignUp( std::max<size_t>( size, 1 ) );
+
+    // move on to the next block that fits, adding one if none does
+    while ( m_block < m_blocks.size() && m_offset + size > m_blocks[m_block].size )
+    {
+        m_block++;
+        m_offset = 0;
+    }
+
+    if ( m_block == m_blocks.size() )
+    {
+        size_t previous = m_blocks.empty() ? 0 : m_blocks.back().size;
+        size_t capacity = std::max( { size, previous * 2, DECODE_ARENA_MIN_BLOCK } );
+
+        u8* data = AllocateBlock( capacity );
+        if ( !data )
+            return nullptr;
+
+        m_blocks.push_back( { data, capacity } );
+        m_offset = 0;
+    }
+
+    m_last = m_blocks[m_block].data + m_offset;
+    m_offset += size;
+    m_used += size;
+
+    return m_last;
+}
+
+void* DecodeArena::reallocate( void* pointer, size_t size, size_t newSize )
+{
+    // the last allocation grows or shrinks in place while its block has room
+    if ( pointer == m_last )
+    {
+        size_t start = m_last - m_blocks[m_block].data;
+        size_t end   = start + AlignUp( std::max<size_t>( newSize, 1 ) );
+
+        if ( end <= m_blocks[m_block].size )
+        {
+            m_used   = m_used - ( m_offset - start ) + ( end - start );
+            m_offset = end;
+            return pointer;
+        }
+    }
+
+    void* moved = allocate( newSize );
+    if ( moved )
+        std::memcpy( moved, pointer, std::min( size, newSize ) );
+
+    return moved;
+}
+
+bool DecodeArena::owns( const void* pointer ) const
+{
+    const u8* address = static_cast<const u8*>( pointer );
+
+    for ( const Block& block : m_blocks )
+    {
+        if ( address >= block.data && address < block.data + block.size )
+            return true;
+    }
+
+    return false;
+}
+
+void DecodeArena::rewind( size_t block, size_t offset )
+{
+    m_block  = block;
+    m_offset = offset;
+    m_last   = nullptr;
+}
+
+void DecodeArena::release()
+{
+    m_highWater = std::max( m_highWater, m_used );
+
+    // merge what this asset needed into a single block for the next one, within the retain limit
+    size_t total = 0;
+    for ( const Block& block : m_blocks )
+        total += block.size;
+
+    if ( m_blocks.size() > 1 || total > RETAIN_LIMIT )
+    {
+        size_t keep = std::min( std::max( AlignUp( m_used ), DECODE_ARENA_MIN_BLOCK ), RETAIN_LIMIT );
+
+        for ( Block& block : m_blocks )
+            FreeBlock( block.data, block.size );
+        m_blocks.clear();
+
+        if ( u8* data = AllocateBlock( keep ) )
+            m_blocks.push_back( { data, keep } );
+    }
+
+    m_used = 0;
+    rewind( 0, 0 );
+}
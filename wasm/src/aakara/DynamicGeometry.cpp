@@ -0,0 +1,107 @@
+#include <stdexcept>
+#include <algorithm>
+#include <webgl/webgl1.h>
+
+#include <aakara/DynamicGeometry.hpp>
+
+DynamicGeometry::DynamicGeometry( u32 vertexCount, Array<u16> indices, Usage usage )
+    : m_vertices( vertexCount, GpuVertex {} )
+    , m_indexCount( (u32)indices.size() )
+    , m_usage( usage )
+{
+    if ( !vertexCount || indices.empty() )
+        throw std::runtime_error( "Dynamic mesh has no vertices or indices" );
+
+    if ( *std::max_element( indices.begin(), indices.end() ) >= vertexCount )
+        throw std::runtime_error( "Dynamic mesh index out of range" );
+
+    u64    vertexBytes = (u64)vertexCount * sizeof( GpuVertex );
+    GLenum glUsage     = usage == Usage::Stream ? GL_STREAM_DRAW : GL_DYNAMIC_DRAW;
+
+    glGenBuffers( buffers(), m_vertexBuffers );
+    for ( u32 i = 0; i < buffers(); i++ )
+    {
+        glBindBuffer( GL_ARRAY_BUFFER, m_vertexBuffers[i] );
+        glBufferData( GL_ARRAY_BUFFER, vertexBytes, m_vertices.data(), glUsage );
+    }
+
+    glGenBuffers( 1, &m_indexBuffer );
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer );
+    glBufferData( GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof( u16 ), indices.data(), GL_STATIC_DRAW );
+
+    Memory::CountCopy( CopyStage::Upload, vertexBytes * buffers() + indices.size() * sizeof( u16 ) );
+
+    // the arena's buffers are no longer bound
+    GpuBufferArena::Instance().resetBinding();
+
+    // indices only live on the GPU
+    m_cpuCharge = MemoryCharge( MemoryTag::Meshes, Memory::BytesOf( m_vertices ) );
+    m_gpuCharge
+        = MemoryCharge( MemoryTag::GpuBuffers, vertexBytes * buffers() + indices.size() * sizeof( u16 ) );
+}
+
+DynamicGeometry::~DynamicGeometry()
+{
+    glDeleteBuffers( RING_SIZE, m_vertexBuffers );
+    glDeleteBuffers( 1, &m_indexBuffer );
+}
+
+void DynamicGeometry::markDirty( u32 first, u32 count )
+{
+    u32 end = (u32)std::min<u64>( (u64)first + count, m_vertices.size() );
+    if ( first >= end )
+        return;
+
+    for ( u32 i = 0; i < buffers(); i++ )
+    {
+        Stale& stale = m_stale[i];
+
+        bool empty  = stale.first == stale.end;
+        stale.first = empty ? first : std::min( stale.first, first );
+        stale.end   = empty ? end : std::max( stale.end, end );
+    }
+
+    m_dirty = true;
+}
+
+u64 DynamicGeometry::flush()
+{
+    if ( !m_dirty )
+        return 0;
+
+    m_dirty = false;
+
+    if ( m_usage == Usage::Stream )
+    {
+        u64 bytes = (u64)m_vertices.size() * sizeof( GpuVertex );
+
+        // re-specifying the whole buffer orphans the storage frames in flight still read
+        glBindBuffer( GL_ARRAY_BUFFER, m_vertexBuffers[0] );
+        glBufferData( GL_ARRAY_BUFFER, bytes, m_vertices.data(), GL_STREAM_DRAW );
+        GpuBufferArena::Instance().resetBinding();
+
+        m_stale[0] = {};
+        Memory::CountCopy( CopyStage::Upload, bytes );
+        return bytes;
+    }
+
+    // the buffer drawn longest ago, and least likely to still be in use
+    m_current    = ( m_current + 1 ) % RING_SIZE;
+    Stale& stale = m_stale[m_current];
+
+    u64 bytes = (u64)( stale.end - stale.first ) * sizeof( GpuVertex );
+
+    glBindBuffer( GL_ARRAY_BUFFER, m_vertexBuffers[m_current] );
+    glBufferSubData(
+        GL_ARRAY_BUFFER, (u64)stale.first * sizeof( GpuVertex ), bytes, m_vertices.data() + stale.first );
+    GpuBufferArena::Instance().resetBinding();
+
+    stale = {};
+    Memory::CountCopy( CopyStage::Upload, bytes );
+    return bytes;
+}
+
+Bounds DynamicGeometry::bounds() const
+{
+    return Bounds::FromVertices( m_vertices );
+}
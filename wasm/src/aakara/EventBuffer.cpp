@@ -0,0 +1,27 @@
+#include <algorithm>
+
+#include <aakara/EventBuffer.hpp>
+
+EventBuffer::EventBuffer( u32 words )
+    : m_words( std::max<u32>( words, HEADER_WORDS + 1 ), 0 )
+{
+}
+
+bool EventBuffer::push( EventType type, std::initializer_list<u32> payload )
+{
+    u32    record = (u32)payload.size() + 1;
+    size_t used   = HEADER_WORDS + m_words[0];
+
+    if ( used + record > m_words.size() )
+    {
+        m_words[1]++;
+        return false;
+    }
+
+    m_words[used] = record << 16 | (u32)type;
+    std::copy( payload.begin(), payload.end(), m_words.begin() + used + 1 );
+
+    m_words[0] += record;
+
+    return true;
+}
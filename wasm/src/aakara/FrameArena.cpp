@@ -0,0 +1,94 @@
+#include <cstdlib>
+#include <cstdint>
+#include <algorithm>
+#include <new>
+
+#include <aakara/FrameArena.hpp>
+
+FrameArena::FrameArena( size_t capacity )
+{
+    for ( Buffer& buffer : m_buffers )
+    {
+        buffer.data     = static_cast<u8*>( std::malloc( capacity ) );
+        buffer.capacity = buffer.data ? capacity : 0;
+    }
+}
+
+FrameArena::~FrameArena()
+{
+    for ( Buffer& buffer : m_buffers )
+    {
+        for ( void* block : buffer.spilled )
+            std::free( block );
+
+        std::free( buffer.data );
+    }
+}
+
+void* FrameArena::allocate( size_t size, size_t alignment )
+{
+    Buffer& buffer = m_buffers[m_current];
+
+    // reserve enough to align within, so a single atomic add suffices
+    size_t padded = size + alignment - 1;
+    size_t offset = buffer.offset.fetch_add( padded, std::memory_order_relaxed );
+
+    if ( offset + padded > buffer.capacity )
+        return spill( buffer, size, alignment );
+
+    uintptr_t address = reinterpret_cast<uintptr_t>( buffer.data + offset );
+    address           = ( address + alignment - 1 ) & ~( uintptr_t )( alignment - 1 );
+
+    return reinterpret_cast<void*>( address );
+}
+
+void FrameArena::reset()
+{
+    m_current = 1 - m_current;
+    rewind( m_buffers[m_current] );
+}
+
+size_t FrameArena::used() const
+{
+    const Buffer& buffer = m_buffers[m_current];
+    return std::min( buffer.offset.load(), buffer.capacity ) + buffer.spilledBytes;
+}
+
+void* FrameArena::spill( Buffer& buffer, size_t size, size_t alignment )
+{
+    void* block = nullptr;
+    if ( posix_memalign( &block, std::max( alignment, sizeof( void* ) ), size ) != 0 )
+        throw std::bad_alloc();
+
+    std::lock_guard<std::mutex> lock( buffer.spillMutex );
+
+    buffer.spilled.push_back( block );
+    buffer.spilledBytes += size + alignment - 1;
+    m_spills++;
+
+    return block;
+}
+
+void FrameArena::rewind( Buffer& buffer )
+{
+    if ( !buffer.spilled.empty() )
+    {
+        for ( void* block : buffer.spilled )
+            std::free( block );
+
+        // grow to hold everything the last frame on this buffer needed
+        size_t needed = buffer.capacity + buffer.spilledBytes;
+        size_t grown  = std::max<size_t>( buffer.capacity, 4096 );
+        while ( grown < needed )
+            grown *= 2;
+
+        std::free( buffer.data );
+        buffer.data     = static_cast<u8*>( std::malloc( grown ) );
+        buffer.capacity = buffer.data ? grown : 0;
+
+        buffer.spilled.clear();
+        buffer.spilledBytes = 0;
+    }
+
+    buffer.offset.store( 0, std::memory_order_relaxed );
+}
@@ -0,0 +1,349 @@
+#include <algorithm>
+#include <webgl/webgl1.h>
+
+#include <aakara/GpuBufferArena.hpp>
+#include <aakara/Mesh.hpp>
+
+static_assert( sizeof( GpuVertex ) == 32, "vertices are uploaded as 32 tightly packed bytes" );
+
+// blocks with less of their vertices or indices in use are evacuated by defragment()
+constexpr f32 DEFRAGMENT_OCCUPANCY = 0.5f;
+
+static u64 BytesOf( u32 vertices, u32 indices )
+{
+    return (u64)vertices * sizeof( GpuVertex ) + (u64)indices * sizeof( u16 );
+}
+
+GpuBufferArena& GpuBufferArena::Instance()
+{
+    static GpuBufferArena* arena = new GpuBufferArena();
+    return *arena;
+}
+
+u32 GpuBufferArena::allocate( Mesh& mesh )
+{
+    Range range;
+    range.vertexCount = (u32)mesh.Vertices.size();
+    range.indexCount  = (u32)mesh.Indices.size();
+    range.owner       = &mesh;
+
+    if ( !range.vertexCount || !range.indexCount )
+        return Invalid;
+
+    // no block has room: add one, sized for the mesh if it is larger than a block
+    if ( !place( range, NO_BLOCK ) )
+    {
+        createBlock(
+            std::max( range.vertexCount, BLOCK_VERTICES ), std::max( range.indexCount, BLOCK_INDICES ) );
+        place( range, NO_BLOCK );
+    }
+
+    return m_ranges.insert( range );
+}
+
+bool GpuBufferArena::upload( u32 handle, u64& budget )
+{
+    Range* range = m_ranges.get( handle );
+    if ( !range )
+        return true;
+
+    budget -= std::min( budget, write( *range, budget ) );
+
+    return range->resident();
+}
+
+void GpuBufferArena::release( u32 handle )
+{
+    const Range* range = m_ranges.get( handle );
+    if ( !range )
+        return;
+
+    free( *range );
+    m_ranges.remove( handle );
+}
+
+const GpuBufferArena::Range* GpuBufferArena::get( u32 handle )
+{
+    return m_ranges.get( handle );
+}
+
+void GpuBufferArena::bind( u32 block )
+{
+    if ( block == m_bound )
+        return;
+
+    glBindBuffer( GL_ARRAY_BUFFER, m_blocks[block].vertexBuffer );
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_blocks[block].indexBuffer );
+
+    m_bound = block;
+}
+
+u64 GpuBufferArena::defragment( u64 maxBytes )
+{
+    u32 sparsest   = NO_BLOCK;
+    u32 liveBlocks = 0;
+    f32 lowest     = DEFRAGMENT_OCCUPANCY;
+
+    for ( u32 i = 0; i < m_blocks.size(); i++ )
+    {
+        const Block& block = m_blocks[i];
+        if ( !block.vertexBuffer )
+            continue;
+
+        liveBlocks++;
+
+        f32 occupancy = std::max( (f32)block.liveVertices / block.vertexCapacity,
+            (f32)block.liveIndices / block.indexCapacity );
+
+        if ( block.ranges && occupancy < lowest )
+        {
+            sparsest = i;
+            lowest   = occupancy;
+        }
+    }
+
+    if ( sparsest == NO_BLOCK || liveBlocks < 2 )
+        return 0;
+
+    u64 moved = 0;
+
+    // the block's last range going frees it
+    for ( Range& range : m_ranges.values() )
+    {
+        // meshes still uploading move once they are resident
+        if ( range.block != sparsest || !range.resident() )
+            continue;
+
+        if ( moved >= maxBytes )
+            break;
+
+        // possibly read again over the network: the block empties on a later idle frame
+        if ( !range.owner->hasArrays() )
+        {
+            range.owner->requestArrays();
+            continue;
+        }
+
+        Range target = range;
+        if ( !place( target, sparsest ) )
+            break;
+
+        target.uploaded = 0;
+        write( target, range.bytes() );
+        free( range );
+
+        range = target;
+        moved += range.bytes();
+        m_moves++;
+
+        range.owner->onMoved();
+    }
+
+    m_movedBytes += moved;
+
+    return moved;
+}
+
+GpuBufferArena::Stats GpuBufferArena::stats() const
+{
+    Stats stats;
+    stats.ranges     = (u32)m_ranges.size();
+    stats.movedBytes = m_movedBytes;
+
+    for ( const Block& block : m_blocks )
+    {
+        if ( !block.vertexBuffer )
+            continue;
+
+        stats.blocks++;
+        stats.capacityBytes += BytesOf( block.vertexCapacity, block.indexCapacity );
+        stats.usedBytes += BytesOf( block.liveVertices, block.liveIndices );
+    }
+
+    return stats;
+}
+
+void GpuBufferArena::createBlock( u32 vertexCapacity, u32 indexCapacity )
+{
+    u32 index;
+    if ( !m_freeBlocks.empty() )
+    {
+        index = m_freeBlocks.back();
+        m_freeBlocks.pop_back();
+    }
+    else
+    {
+        index = (u32)m_blocks.size();
+        m_blocks.emplace_back();
+    }
+
+    Block& block         = m_blocks[index];
+    block.vertexCapacity = vertexCapacity;
+    block.indexCapacity  = indexCapacity;
+    block.freeVertices   = { { 0, vertexCapacity } };
+    block.freeIndices    = { { 0, indexCapacity } };
+
+    glGenBuffers( 1, &block.vertexBuffer );
+    glGenBuffers( 1, &block.indexBuffer );
+
+    glBindBuffer( GL_ARRAY_BUFFER, block.vertexBuffer );
+    glBufferData( GL_ARRAY_BUFFER, (u64)vertexCapacity * sizeof( GpuVertex ), nullptr, GL_STATIC_DRAW );
+
+    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, block.indexBuffer );
+    glBufferData( GL_ELEMENT_ARRAY_BUFFER, (u64)indexCapacity * sizeof( u16 ), nullptr, GL_STATIC_DRAW );
+
+    block.charge = MemoryCharge( MemoryTag::GpuBuffers, BytesOf( vertexCapacity, indexCapacity ) );
+    m_bound      = index;
+}
+
+void GpuBufferArena::destroyBlock( u32 index )
+{
+    Block& block = m_blocks[index];
+
+    u32 buffers[] = { block.vertexBuffer, block.indexBuffer };
+    glDeleteBuffers( 2, buffers );
+
+    block = Block();
+    m_freeBlocks.push_back( index );
+
+    if ( m_bound == index )
+        m_bound = NO_BLOCK;
+}
+
+bool GpuBufferArena::place( Range& range, u32 skipBlock )
+{
+    for ( u32 i = 0; i < m_blocks.size(); i++ )
+    {
+        Block& block = m_blocks[i];
+        if ( i == skipBlock || !block.vertexBuffer )
+            continue;
+
+        u32 firstVertex, firstIndex;
+        if ( !Take( block.freeVertices, range.vertexCount, firstVertex ) )
+            continue;
+
+        if ( !Take( block.freeIndices, range.indexCount, firstIndex ) )
+        {
+            Give( block.freeVertices, firstVertex, range.vertexCount );
+            continue;
+        }
+
+        range.block       = i;
+        range.firstVertex = firstVertex;
+        range.firstIndex  = firstIndex;
+
+        block.liveVertices += range.vertexCount;
+        block.liveIndices += range.indexCount;
+        block.ranges++;
+
+        return true;
+    }
+
+    return false;
+}
+
+u64 GpuBufferArena::write( Range& range, u64 maxBytes )
+{
+    const Mesh& mesh        = *range.owner;
+    u64         vertexBytes = (u64)range.vertexCount * sizeof( GpuVertex );
+    u64         written     = 0;
+
+    bind( range.block );
+
+    // vertices first, then indices, in whole elements; the first element is written whatever the budget
+    if ( range.uploaded < vertexBytes )
+    {
+        u32 first = (u32)( range.uploaded / sizeof( GpuVertex ) );
+        u32 count = (u32)std::clamp<u64>( maxBytes / sizeof( GpuVertex ), 1, range.vertexCount - first );
+
+        // the mesh keeps its vertices in the GPU layout: handed to WebGL as they are
+        glBufferSubData( GL_ARRAY_BUFFER, (u64)( range.firstVertex + first ) * sizeof( GpuVertex ),
+            (u64)count * sizeof( GpuVertex ), mesh.Vertices.data() + first );
+
+        written += (u64)count * sizeof( GpuVertex );
+        range.uploaded += (u64)count * sizeof( GpuVertex );
+    }
+
+    if ( range.uploaded >= vertexBytes && !range.resident() && ( written == 0 || written < maxBytes ) )
+    {
+        u32 first     = (u32)( ( range.uploaded - vertexBytes ) / sizeof( u16 ) );
+        u64 remaining = ( maxBytes - written ) / sizeof( u16 );
+        u32 count     = (u32)std::clamp<u64>( remaining, 1, range.indexCount - first );
+
+        glBufferSubData( GL_ELEMENT_ARRAY_BUFFER, (u64)( range.firstIndex + first ) * sizeof( u16 ),
+            (u64)count * sizeof( u16 ), mesh.Indices.data() + first );
+
+        written += (u64)count * sizeof( u16 );
+        range.uploaded += (u64)count * sizeof( u16 );
+    }
+
+    Memory::CountCopy( CopyStage::Upload, written );
+
+    return written;
+}
+
+void GpuBufferArena::free( const Range& range )
+{
+    Block& block = m_blocks[range.block];
+
+    Give( block.freeVertices, range.firstVertex, range.vertexCount );
+    Give( block.freeIndices, range.firstIndex, range.indexCount );
+
+    block.liveVertices -= range.vertexCount;
+    block.liveIndices -= range.indexCount;
+    block.ranges--;
+
+    // one empty block is kept so that loading and unloading a single part does not recreate buffers
+    if ( block.ranges == 0 && m_blocks.size() - m_freeBlocks.size() > 1 )
+        destroyBlock( range.block );
+}
+
+bool GpuBufferArena::Take( Array<Span>& free, u32 size, u32& offset )
+{
+    for ( size_t i = 0; i < free.size(); i++ )
+    {
+        if ( free[i].size < size )
+            continue;
+
+        offset = free[i].offset;
+        free[i].offset += size;
+        free[i].size -= size;
+
+        if ( free[i].size == 0 )
+            free.erase( free.begin() + i );
+
+        return true;
+    }
+
+    return false;
+}
+
+void GpuBufferArena::Give( Array<Span>& free, u32 offset, u32 size )
+{
+    auto next = std::lower_bound(
+        free.begin(), free.end(), offset, []( const Span& span, u32 value ) { return span.offset < value; } );
+
+    auto previous = next != free.begin() ? std::prev( next ) : free.end();
+
+    bool joinsPrevious = previous != free.end() && previous->offset + previous->size == offset;
+    bool joinsNext     = next != free.end() && offset + size == next->offset;
+
+    if ( joinsPrevious && joinsNext )
+    {
+        previous->size += size + next->size;
+        free.erase( next );
+    }
+    else if ( joinsPrevious )
+    {
+        previous->size += size;
+    }
+    else if ( joinsNext )
+    {
+        next->offset = offset;
+        next->size += size;
+    }
+    else
+    {
+        free.insert( next, { offset, size } );
+    }
+}
@@ -0,0 +1,379 @@
+#include <exception>
+#include <stdexcept>
+#include <emscripten/console.h>
+
+#include <aakara/JobSystem.hpp>
+
+// Yields an idle worker spends looking for work before it parks
+constexpr u32 JOB_SPIN_COUNT = 64;
+
+namespace
+{
+    thread_local const JobSystem* t_system = nullptr;
+    thread_local u32              t_index  = 0;
+}
+
+/**
+ * @brief Per-thread state: a Chase-Lev deque of scheduled jobs and the ring jobs are allocated from.
+ */
+struct JobSystem::Worker
+{
+    alignas( 64 ) std::atomic<i64> top { 0 };
+    alignas( 64 ) std::atomic<i64> bottom { 0 };
+
+    UPtr<std::atomic<Job*>[]> buffer;
+    UPtr<Job[]>               jobs;
+    u32                       nextJob = 0;
+
+    Worker()
+        : buffer( new std::atomic<Job*>[JOB_CAPACITY] )
+        , jobs( new Job[JOB_CAPACITY] )
+    {
+    }
+
+    /**
+     * @brief Owner only. Returns false when the deque is full.
+     */
+    bool push( Job* job )
+    {
+        i64 b = bottom.load( std::memory_order_relaxed );
+        i64 t = top.load( std::memory_order_acquire );
+
+        if ( b - t >= (i64)JOB_CAPACITY )
+            return false;
+
+        buffer[b & ( JOB_CAPACITY - 1 )].store( job, std::memory_order_relaxed );
+        bottom.store( b + 1, std::memory_order_seq_cst );
+
+        return true;
+    }
+
+    /**
+     * @brief Owner only. Takes the most recently pushed job.
+     */
+    Job* pop()
+    {
+        i64 b = bottom.load( std::memory_order_relaxed ) - 1;
+        bottom.store( b, std::memory_order_seq_cst );
+        i64 t = top.load( std::memory_order_seq_cst );
+
+        if ( t > b )
+        {
+            bottom.store( b + 1, std::memory_order_relaxed );
+            return nullptr;
+        }
+
+        Job* job = buffer[b & ( JOB_CAPACITY - 1 )].load( std::memory_order_relaxed );
+
+        if ( t == b )
+        {
+            // last job: race the thieves for it
+            if ( !top.compare_exchange_strong( t, t + 1, std::memory_order_seq_cst ) )
+                job = nullptr;
+
+            bottom.store( b + 1, std::memory_order_relaxed );
+        }
+
+        return job;
+    }
+
+    /**
+     * @brief Any thread. Takes the oldest job, or returns null if empty or another thread won the race.
+     */
+    Job* steal()
+    {
+        i64 t = top.load( std::memory_order_seq_cst );
+        i64 b = bottom.load( std::memory_order_seq_cst );
+
+        if ( t >= b )
+            return nullptr;
+
+        Job* job = buffer[t & ( JOB_CAPACITY - 1 )].load( std::memory_order_relaxed );
+
+        if ( !top.compare_exchange_strong( t, t + 1, std::memory_order_seq_cst ) )
+            return nullptr;
+
+        return job;
+    }
+
+    bool empty() const
+    {
+        return bottom.load( std::memory_order_seq_cst ) <= top.load( std::memory_order_seq_cst );
+    }
+};
+
+JobSystem::JobSystem( u32 workers )
+    : m_workerCount( workers )
+    , m_owner( std::this_thread::get_id() )
+{
+    for ( u32 i = 0; i <= workers; i++ )
+        m_workers.push_back( std::make_unique<Worker>() );
+
+    for ( u32 i = 1; i <= workers; i++ )
+        m_threads.emplace_back( &JobSystem::workerLoop, this, i );
+}
+
+JobSystem::~JobSystem()
+{
+    waitForTasks();
+
+    // run whatever is still queued so no job outlives its captures
+    while ( runPending() )
+        ;
+
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_stop = true;
+    }
+    m_wake.notify_all();
+
+    for ( std::thread& thread : m_threads )
+        thread.join();
+}
+
+void JobSystem::run( Job* job )
+{
+    u32 index = threadIndex();
+    if ( index == Invalid )
+        throw std::logic_error( "JobSystem::run called from a thread outside the job system" );
+
+    if ( !m_workers[index]->push( job ) )
+    {
+        execute( job );
+        return;
+    }
+
+    wake();
+}
+
+void JobSystem::wait( Job* job )
+{
+    u32 index = threadIndex();
+
+    while ( job->unfinished.load( std::memory_order_acquire ) > 0 )
+    {
+        Job* next = index != Invalid ? findWork( index, false ) : nullptr;
+
+        if ( next )
+            execute( next );
+        else
+            std::this_thread::yield();
+    }
+}
+
+bool JobSystem::runPending()
+{
+    u32 index = threadIndex();
+    if ( index == Invalid )
+        return false;
+
+    Job* job = findWork( index, false );
+    if ( !job )
+        return false;
+
+    execute( job );
+    return true;
+}
+
+void JobSystem::waitForTasks()
+{
+    std::unique_lock<std::mutex> lock( m_mutex );
+    m_idle.wait( lock, [this] { return m_backgroundActive.load() == 0; } );
+}
+
+u32 JobSystem::threadIndex() const
+{
+    if ( t_system == this )
+        return t_index;
+
+    if ( std::this_thread::get_id() == m_owner )
+        return 0;
+
+    return Invalid;
+}
+
+Job* JobSystem::allocate()
+{
+    u32 index = threadIndex();
+    if ( index == Invalid )
+        throw std::logic_error( "JobSystem::create called from a thread outside the job system" );
+
+    Worker& worker = *m_workers[index];
+
+    // When the ring wraps onto jobs still in flight, skip them. Should every slot be taken, help until one
+    // frees up; a parent still waiting for its children keeps its slot until they are done.
+    for ( ;; )
+    {
+        for ( u32 i = 0; i < JOB_CAPACITY; i++ )
+        {
+            Job* job = &worker.jobs[worker.nextJob++ & ( JOB_CAPACITY - 1 )];
+
+            if ( job->unfinished.load( std::memory_order_acquire ) == 0 )
+                return job;
+        }
+
+        if ( !runPending() )
+            std::this_thread::yield();
+    }
+}
+
+Job* JobSystem::allocateBackground()
+{
+    std::lock_guard<std::mutex> lock( m_mutex );
+
+    m_backgroundActive++;
+
+    if ( m_backgroundFree.empty() )
+    {
+        m_backgroundJobs.push_back( std::make_unique<Job>() );
+        return m_backgroundJobs.back().get();
+    }
+
+    Job* job = m_backgroundFree.back();
+    m_backgroundFree.pop_back();
+
+    return job;
+}
+
+void JobSystem::submitBackground( Job* job )
+{
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        m_backgroundQueue.push_back( job );
+        m_backgroundPending++;
+    }
+
+    m_wake.notify_one();
+}
+
+bool JobSystem::localQueueEmpty() const
+{
+    return m_workers[threadIndex()]->empty();
+}
+
+bool JobSystem::anyQueued() const
+{
+    for ( const UPtr<Worker>& worker : m_workers )
+    {
+        if ( !worker->empty() )
+            return true;
+    }
+
+    return false;
+}
+
+Job* JobSystem::findWork( u32 index, bool background )
+{
+    if ( Job* job = m_workers[index]->pop() )
+        return job;
+
+    u32 count = (u32)m_workers.size();
+    for ( u32 i = 1; i < count; i++ )
+    {
+        if ( Job* job = m_workers[( index + i ) % count]->steal() )
+            return job;
+    }
+
+    if ( background && m_backgroundPending.load() > 0 )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        if ( !m_backgroundQueue.empty() )
+        {
+            Job* job = m_backgroundQueue.front();
+            m_backgroundQueue.pop_front();
+            m_backgroundPending--;
+
+            return job;
+        }
+    }
+
+    return nullptr;
+}
+
+void JobSystem::execute( Job* job )
+{
+    try
+    {
+        job->task.invoke();
+    }
+    catch ( const std::exception& err )
+    {
+        emscripten_console_errorf( "Job failed: %s", err.what() );
+    }
+
+    job->task.reset();
+
+    finish( job );
+}
+
+void JobSystem::finish( Job* job )
+{
+    // The job may be reused as soon as it completes, so read it first.
+    Job* parent     = job->parent;
+    bool background = job->background;
+
+    if ( job->unfinished.fetch_sub( 1, std::memory_order_acq_rel ) != 1 )
+        return;
+
+    if ( background )
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        m_backgroundFree.push_back( job );
+        if ( --m_backgroundActive == 0 )
+            m_idle.notify_all();
+
+        return;
+    }
+
+    if ( parent )
+        finish( parent );
+}
+
+void JobSystem::wake()
+{
+    if ( m_sleeping.load() == 0 )
+        return;
+
+    std::lock_guard<std::mutex> lock( m_mutex );
+    m_wake.notify_one();
+}
+
+void JobSystem::workerLoop( u32 index )
+{
+    t_system = this;
+    t_index  = index;
+
+    u32 idle = 0;
+
+    for ( ;; )
+    {
+        if ( Job* job = findWork( index, true ) )
+        {
+            execute( job );
+            idle = 0;
+            continue;
+        }
+
+        if ( ++idle < JOB_SPIN_COUNT )
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock( m_mutex );
+
+        if ( m_stop )
+            return;
+
+        // Checked after announcing ourselves, so a push either sees the sleeper or is seen here.
+        m_sleeping++;
+        if ( m_backgroundQueue.empty() && !anyQueued() )
+            m_wake.wait( lock );
+        m_sleeping--;
+
+        idle = 0;
+    }
+}
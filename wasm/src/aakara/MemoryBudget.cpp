@@ -0,0 +1,291 @@
+#include <algorithm>
+#include <emscripten/val.h>
+
+#include <aakara/MemoryBudget.hpp>
+
+// halvings of a texture's width and height the budget tries before rejecting it
+constexpr u32 MAX_DOWNSCALE_LEVELS = 4;
+
+namespace
+{
+    struct Counter
+    {
+        std::atomic<i64> usage { 0 };
+        std::atomic<i64> peak { 0 };
+    };
+
+    Counter g_counters[(size_t)MemoryTag::Count];
+
+    std::atomic<u64> g_copied[(size_t)CopyStage::Count];
+
+    bool IsGpu( MemoryTag tag )
+    {
+        return tag >= MemoryTag::GpuPending;
+    }
+
+    u64 Sum( bool gpu )
+    {
+        u64 total = 0;
+        for ( u32 tag = 0; tag < (u32)MemoryTag::Count; tag++ )
+        {
+            if ( IsGpu( (MemoryTag)tag ) == gpu )
+                total += Memory::Usage( (MemoryTag)tag );
+        }
+
+        return total;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                   Memory                                   */
+/* -------------------------------------------------------------------------- */
+namespace Memory
+{
+    void Track( MemoryTag tag, i64 bytes )
+    {
+        if ( tag == MemoryTag::Count || bytes == 0 )
+            return;
+
+        Counter& counter = g_counters[(size_t)tag];
+        i64      usage   = counter.usage.fetch_add( bytes, std::memory_order_relaxed ) + bytes;
+
+        i64 peak = counter.peak.load( std::memory_order_relaxed );
+        while ( usage > peak
+                && !counter.peak.compare_exchange_weak( peak, usage, std::memory_order_relaxed ) )
+        {
+        }
+    }
+
+    void CountCopy( CopyStage stage, u64 bytes )
+    {
+        g_copied[(size_t)stage].fetch_add( bytes, std::memory_order_relaxed );
+    }
+
+    u64 Copied( CopyStage stage )
+    {
+        return g_copied[(size_t)stage].load( std::memory_order_relaxed );
+    }
+
+    u64 Usage( MemoryTag tag )
+    {
+        return (u64)std::max<i64>( g_counters[(size_t)tag].usage.load( std::memory_order_relaxed ), 0 );
+    }
+
+    u64 Peak( MemoryTag tag )
+    {
+        return (u64)g_counters[(size_t)tag].peak.load( std::memory_order_relaxed );
+    }
+
+    u64 CpuUsage()
+    {
+        return Sum( false );
+    }
+
+    u64 GpuUsage()
+    {
+        return Sum( true );
+    }
+
+    const char* NameOf( MemoryTag tag )
+    {
+        switch ( tag )
+        {
+        case MemoryTag::Meshes:
+            return "meshes";
+        case MemoryTag::Textures:
+            return "textures";
+        case MemoryTag::Assimp:
+            return "assimp";
+        case MemoryTag::Decode:
+            return "decode";
+        case MemoryTag::Loader:
+            return "loader";
+        case MemoryTag::Render:
+            return "render";
+        case MemoryTag::GpuPending:
+            return "pending";
+        case MemoryTag::GpuBuffers:
+            return "buffers";
+        case MemoryTag::GpuTextures:
+            return "textures";
+        case MemoryTag::Count:
+            break;
+        }
+
+        return "unknown";
+    }
+
+    const char* NameOf( CopyStage stage )
+    {
+        switch ( stage )
+        {
+        case CopyStage::Fetch:
+            return "fetch";
+        case CopyStage::Decode:
+            return "decode";
+        case CopyStage::Cache:
+            return "cache";
+        case CopyStage::Upload:
+            return "upload";
+        case CopyStage::Count:
+            break;
+        }
+
+        return "unknown";
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                MemoryCharge                                */
+/* -------------------------------------------------------------------------- */
+MemoryCharge::MemoryCharge( MemoryTag tag, u64 bytes )
+    : m_tag( tag )
+    , m_bytes( bytes )
+{
+    Memory::Track( m_tag, (i64)m_bytes );
+}
+
+MemoryCharge::MemoryCharge( MemoryCharge&& other ) noexcept
+    : m_tag( other.m_tag )
+    , m_bytes( other.m_bytes )
+{
+    other.m_bytes = 0;
+}
+
+MemoryCharge& MemoryCharge::operator=( MemoryCharge&& other ) noexcept
+{
+    if ( this != &other )
+    {
+        Memory::Track( m_tag, -(i64)m_bytes );
+
+        m_tag         = other.m_tag;
+        m_bytes       = other.m_bytes;
+        other.m_bytes = 0;
+    }
+
+    return *this;
+}
+
+MemoryCharge::~MemoryCharge()
+{
+    Memory::Track( m_tag, -(i64)m_bytes );
+}
+
+/* -------------------------------------------------------------------------- */
+/*                                MemoryBudget                                */
+/* -------------------------------------------------------------------------- */
+void MemoryBudget::setLimits( u64 cpuLimit, u64 gpuLimit )
+{
+    m_cpuLimit = cpuLimit;
+    m_gpuLimit = gpuLimit;
+}
+
+bool MemoryBudget::fits( u64 cpu, u64 gpu ) const
+{
+    bool cpuFits = !m_cpuLimit || Memory::CpuUsage() + m_reservedCpu + cpu <= m_cpuLimit;
+    bool gpuFits = !m_gpuLimit || Memory::GpuUsage() + m_reservedGpu + gpu <= m_gpuLimit;
+
+    return cpuFits && gpuFits;
+}
+
+MemoryBudget::Decision MemoryBudget::admit( Estimate& estimate, bool scalable, u32& levels )
+{
+    levels            = 0;
+    Decision decision = Decision::Admit;
+
+    if ( !fits( estimate.cpu, estimate.gpu ) )
+    {
+        // decodes in flight may still free their transient memory: try again once they are done
+        if ( m_reservations > 0 )
+            return Decision::Defer;
+
+        Estimate scaled = estimate;
+        while ( scalable && levels < MAX_DOWNSCALE_LEVELS && !fits( scaled.cpu, scaled.gpu ) )
+        {
+            scaled.cpu /= 4;
+            scaled.gpu /= 4;
+            levels++;
+        }
+
+        if ( !scalable || !fits( scaled.cpu, scaled.gpu ) )
+        {
+            levels = 0;
+            m_rejected++;
+            return Decision::Reject;
+        }
+
+        estimate = scaled;
+        decision = Decision::Downscale;
+        m_downscaled++;
+    }
+
+    m_reservedCpu += estimate.cpu;
+    m_reservedGpu += estimate.gpu;
+    m_reservations++;
+
+    return decision;
+}
+
+void MemoryBudget::release( const Estimate& estimate )
+{
+    m_reservedCpu -= estimate.cpu;
+    m_reservedGpu -= estimate.gpu;
+    m_reservations--;
+}
+
+JSObject MemoryBudget::stats() const
+{
+    // byte counts may exceed 2^32, so they go to JS as doubles
+    auto bytes = []( u64 value ) { return (double)value; };
+
+    JSObject cpu   = JSObject::object();
+    JSObject gpu   = JSObject::object();
+    JSObject peaks = JSObject::object();
+
+    JSObject cpuPeaks = JSObject::object();
+    JSObject gpuPeaks = JSObject::object();
+
+    for ( u32 i = 0; i < (u32)MemoryTag::Count; i++ )
+    {
+        MemoryTag tag = (MemoryTag)i;
+
+        ( IsGpu( tag ) ? gpu : cpu ).set( Memory::NameOf( tag ), bytes( Memory::Usage( tag ) ) );
+        ( IsGpu( tag ) ? gpuPeaks : cpuPeaks ).set( Memory::NameOf( tag ), bytes( Memory::Peak( tag ) ) );
+    }
+
+    cpu.set( "total", bytes( Memory::CpuUsage() ) );
+    gpu.set( "total", bytes( Memory::GpuUsage() ) );
+    peaks.set( "cpu", cpuPeaks );
+    peaks.set( "gpu", gpuPeaks );
+
+    JSObject budget = JSObject::object();
+    budget.set( "cpuLimit", bytes( m_cpuLimit ) );
+    budget.set( "gpuLimit", bytes( m_gpuLimit ) );
+    budget.set( "cpuReserved", bytes( m_reservedCpu ) );
+    budget.set( "gpuReserved", bytes( m_reservedGpu ) );
+    budget.set( "deferred", m_deferred );
+    budget.set( "downscaled", m_downscaled );
+    budget.set( "rejected", m_rejected );
+
+    JSObject copied = JSObject::object();
+    u64      total  = 0;
+
+    for ( u32 i = 0; i < (u32)CopyStage::Count; i++ )
+    {
+        CopyStage stage = (CopyStage)i;
+
+        copied.set( Memory::NameOf( stage ), bytes( Memory::Copied( stage ) ) );
+        total += Memory::Copied( stage );
+    }
+
+    copied.set( "total", bytes( total ) );
+
+    JSObject stats = JSObject::object();
+    stats.set( "cpu", cpu );
+    stats.set( "gpu", gpu );
+    stats.set( "peaks", peaks );
+    stats.set( "budget", budget );
+    stats.set( "copied", copied );
+
+    return stats;
+}
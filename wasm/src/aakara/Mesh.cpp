@@ -1,85 +1,284 @@
 #include <aakara/Mesh.hpp>
 #include <aakara/Shader.hpp>
 #include <aakara/fetch.hpp>
+#include <aakara/Binary.hpp>
 #include <sstream>
 #include <webgl/webgl1.h>
 #include <emscripten/fetch.h>
 #include <assimp/Importer.hpp>
+#include <assimp/ProgressHandler.hpp>
 #include <assimp/postprocess.h>
 #include <assimp/scene.h>
 #include <glm/vec3.hpp>
+#include <cstddef>
+#include <cstdint>
 
 void updateNormals( Array<glm::vec3>& pos, Array<glm::vec3>& norms, Array<u16> indices );
 
+namespace
+{
+    // asks Assimp to stop at its next step once the load is cancelled
+    class CancelProgress : public Assimp::ProgressHandler
+    {
+    public:
+        explicit CancelProgress( const CancelToken& cancel )
+            : m_cancel( cancel )
+        {
+        }
+
+        bool Update( float ) override
+        {
+            return !m_cancel.cancelled();
+        }
+
+    private:
+        const CancelToken& m_cancel;
+    };
+}
+
 Mesh::Mesh()
-    : Positions()
-    , Normals()
+    : Vertices()
     , Indices()
-    , UVMap()
 {
 }
 
-Mesh::Mesh( Array<glm::vec3>& pos, Array<glm::vec3>& norm, Array<u16>& indices, Array<glm::vec2>& uvmap )
-    : Positions( pos )
-    , Normals( norm )
-    , Indices( indices )
-    , UVMap( uvmap )
+Mesh::Mesh( Array<GpuVertex>&& vertices, Array<u16>&& indices )
+    : Vertices( std::move( vertices ) )
+    , Indices( std::move( indices ) )
 {
+    computeBounds();
+    track();
 }
 
 Mesh::~Mesh()
 {
-    u32 bufferIds[] = { VBO, NBO, IBO };
-    glDeleteBuffers( 1, bufferIds );
+    if ( m_gpuRange != GpuBufferArena::Invalid )
+        GpuBufferArena::Instance().release( m_gpuRange );
+}
 
-    VBO = 0, IBO = 0;
+static void BindAttribute( i32 location, i32 size, size_t offset )
+{
+    if ( location < 0 )
+        return;
+
+    glEnableVertexAttribArray( location );
+    glVertexAttribPointer(
+        location, size, GL_FLOAT, GL_FALSE, sizeof( GpuVertex ), reinterpret_cast<const void*>( offset ) );
 }
 
 bool Mesh::Bind( Shader* shader )
 {
-    u32 shaderId       = shader->GetID();
-    int attribLocation = 0;
+    GpuBufferArena& arena = GpuBufferArena::Instance();
+    size_t          base  = 0;
 
-    // emscripten_console_logf( "VBO: %u", m_VBO );
-    if ( !VBO || !IBO || !NBO )
-        return false;
+    if ( m_dynamic )
+    {
+        glBindBuffer( GL_ARRAY_BUFFER, m_dynamic->vertexBuffer() );
+        glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, m_dynamic->indexBuffer() );
+        arena.resetBinding();
+    }
+    else
+    {
+        const GpuBufferArena::Range* range = arena.get( m_gpuRange );
+        if ( !range || !range->resident() )
+            return false;
+
+        // consecutive meshes of one block keep its buffers bound
+        arena.bind( range->block );
+
+        // WebGL 1 has no base vertex: the attributes start at the mesh's first vertex instead
+        base = (size_t)range->firstVertex * sizeof( GpuVertex );
+    }
+
+    BindAttribute( shader->GetAttribLocation( "v_position" ), 3, base + offsetof( GpuVertex, position ) );
+    BindAttribute( shader->GetAttribLocation( "v_normal" ), 3, base + offsetof( GpuVertex, normal ) );
+    BindAttribute( shader->GetAttribLocation( "v_uv" ), 2, base + offsetof( GpuVertex, uv ) );
+
+    return true;
+}
+
+void Mesh::Unbind()
+{
+    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+    GpuBufferArena::Instance().resetBinding();
+}
+
+void Mesh::Draw()
+{
+    if ( m_dynamic )
+    {
+        glDrawElements( GL_TRIANGLES, m_dynamic->indexCount(), GL_UNSIGNED_SHORT, nullptr );
+        return;
+    }
+
+    const GpuBufferArena::Range* range = GpuBufferArena::Instance().get( m_gpuRange );
+
+    if ( range && range->resident() )
+    {
+        glDrawElements( GL_TRIANGLES, range->indexCount, GL_UNSIGNED_SHORT,
+            reinterpret_cast<const void*>( (size_t)range->firstIndex * sizeof( u16 ) ) );
+    }
+}
 
-    glBindBuffer( GL_ARRAY_BUFFER, VBO );
-    attribLocation = glGetAttribLocation( shaderId, "v_position" );
-    glEnableVertexAttribArray( attribLocation );
+bool Mesh::isResident() const
+{
+    if ( m_dynamic )
+        return true;
 
-    glVertexAttribPointer( attribLocation, 3, GL_FLOAT, GL_FALSE, 3 * sizeof( float ), nullptr );
+    const GpuBufferArena::Range* range = GpuBufferArena::Instance().get( m_gpuRange );
+    return range && range->resident();
+}
 
-    // Activate normal buffer
-    glBindBuffer( GL_ARRAY_BUFFER, NBO );
-    attribLocation = glGetAttribLocation( shaderId, "v_normal" );
-    glEnableVertexAttribArray( attribLocation );
+u32 Mesh::getDrawKey() const
+{
+    const GpuBufferArena::Range* range = GpuBufferArena::Instance().get( m_gpuRange );
 
-    glVertexAttribPointer( attribLocation, 3, GL_FLOAT, GL_FALSE, 3 * sizeof( float ), nullptr );
+    // block in the high bits, the mesh itself in the low ones so that its packets stay together; dynamic
+    // meshes have buffers of their own and sort first
+    u32 block = range ? range->block + 1 : 0;
+    return block << 20 | ( getPoolIndex() & 0xFFFFF );
+}
 
-    // Activate uv buffer
-    glBindBuffer( GL_ARRAY_BUFFER, CBO );
-    attribLocation = glGetAttribLocation( shaderId, "v_uv" );
-    glEnableVertexAttribArray( attribLocation );
+void Mesh::computeBounds()
+{
+    LocalBounds = m_dynamic ? m_dynamic->bounds() : Bounds::FromVertices( Vertices );
+}
 
-    glVertexAttribPointer( attribLocation, 2, GL_FLOAT, GL_FALSE, 2 * sizeof( float ), nullptr );
+bool Mesh::flush()
+{
+    if ( !m_dynamic || !m_dynamic->isDirty() )
+        return false;
 
-    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, IBO );
+    m_dynamic->flush();
+    computeBounds();
 
     return true;
 }
 
-void Mesh::Unbind()
+void Mesh::setReread( Reread reread )
 {
-    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+    m_reread = std::move( reread );
 }
 
-void Mesh::Draw()
+void Mesh::requestArrays()
+{
+    if ( !m_reread || m_rereading || hasArrays() )
+        return;
+
+    m_rereading = true;
+    m_reread( Ref<Mesh>( this ) );
+}
+
+void Mesh::restoreArrays( Array<GpuVertex>&& vertices, Array<u16>&& indices )
+{
+    m_rereading = false;
+
+    const GpuBufferArena::Range* range = GpuBufferArena::Instance().get( m_gpuRange );
+    if ( !range || vertices.size() != range->vertexCount || indices.size() != range->indexCount )
+        return;
+
+    Vertices = std::move( vertices );
+    Indices  = std::move( indices );
+    track();
+}
+
+void Mesh::onMoved()
 {
-    glDrawElements( GL_TRIANGLES, Indices.size(), GL_UNSIGNED_SHORT, 0 );
+    m_keyGeneration++;
+    releaseArrays();
 }
 
-Ptr<Mesh> Mesh::LoadFromMemory( const char* data, u32 size )
+void Mesh::releaseArrays()
+{
+    if ( !m_reread || !isResident() || !hasArrays() )
+        return;
+
+    Array<GpuVertex>().swap( Vertices );
+    Array<u16>().swap( Indices );
+
+    m_cpuCharge = MemoryCharge();
+}
+
+static u64 GpuBytesOf( const Mesh& mesh )
+{
+    return sizeof( GpuVertex ) * mesh.Vertices.size() + sizeof( u16 ) * mesh.Indices.size();
+}
+
+void Mesh::track()
+{
+    m_cpuCharge = MemoryCharge( MemoryTag::Meshes, Memory::BytesOf( Vertices ) + Memory::BytesOf( Indices ) );
+
+    if ( !isResident() )
+        m_gpuCharge = MemoryCharge( MemoryTag::GpuPending, GpuBytesOf( *this ) );
+}
+
+constexpr u32 MESH_BINARY_MAGIC = 0x324D4B41; // "AKM2", interleaved GpuVertex array
+
+// positions, normals and UVs as separate arrays; still found in caches and chunked meshes written before
+constexpr u32 MESH_BINARY_MAGIC_PLANAR = 0x314D4B41; // "AKM1"
+
+void Mesh::Serialize( Array<u8>& out ) const
+{
+    ByteWriter writer( out );
+    size_t     start = out.size();
+
+    writer.write( MESH_BINARY_MAGIC );
+    writer.write( (u32)Vertices.size() );
+    writer.write( (u32)Indices.size() );
+
+    writer.writeArray( Vertices.data(), Vertices.size() );
+    writer.writeArray( Indices.data(), Indices.size() );
+
+    Memory::CountCopy( CopyStage::Cache, out.size() - start );
+}
+
+/**
+ * @brief Read one attribute of every vertex from a planar array of it, into the interleaved vertices.
+ */
+template <typename T>
+static void ReadPlanar( ByteReader& reader, Array<GpuVertex>& vertices, T GpuVertex::*member )
+{
+    for ( GpuVertex& vertex : vertices )
+        vertex.*member = reader.read<T>();
+}
+
+Ref<Mesh> Mesh::Deserialize( const u8* data, size_t size )
+{
+    ByteReader reader( data, size );
+
+    u32 magic = reader.read<u32>();
+    if ( magic != MESH_BINARY_MAGIC && magic != MESH_BINARY_MAGIC_PLANAR )
+        throw std::runtime_error( "Not a serialized mesh" );
+
+    u32 vertexCount = reader.read<u32>();
+    u32 indexCount  = reader.read<u32>();
+
+    // a truncated header must not allocate more than the data could hold
+    if ( (u64)vertexCount * sizeof( GpuVertex ) + (u64)indexCount * sizeof( u16 ) > reader.remaining() )
+        throw std::runtime_error( "Unexpected end of binary data" );
+
+    Array<GpuVertex> vertices( vertexCount );
+    Array<u16>       indices( indexCount );
+
+    if ( magic == MESH_BINARY_MAGIC )
+    {
+        reader.readArray( vertices.data(), vertexCount );
+    }
+    else
+    {
+        ReadPlanar( reader, vertices, &GpuVertex::position );
+        ReadPlanar( reader, vertices, &GpuVertex::normal );
+        ReadPlanar( reader, vertices, &GpuVertex::uv );
+    }
+
+    reader.readArray( indices.data(), indexCount );
+
+    Memory::CountCopy( CopyStage::Decode, Memory::BytesOf( vertices ) + Memory::BytesOf( indices ) );
+
+    return MakeRef<Mesh>( std::move( vertices ), std::move( indices ) );
+}
+
+Ref<Mesh> Mesh::LoadFromMemory( const char* data, u32 size, const CancelToken* cancel )
 {
     const u32 import_flags = aiProcess_CalcTangentSpace | aiProcess_Triangulate | aiProcess_SortByPType
                              | aiProcess_GenNormals | aiProcess_GenUVCoords | aiProcess_OptimizeMeshes
@@ -87,27 +286,44 @@ Ptr<Mesh> Mesh::LoadFromMemory( const char* data, u32 size )
 
     Assimp::Importer importer;
 
+    // owned by the importer
+    if ( cancel )
+        importer.SetProgressHandler( new CancelProgress( *cancel ) );
+
     const aiScene* scene = importer.ReadFileFromMemory( data, (size_t)size, import_flags );
 
-    if ( !scene->HasMeshes() )
+    if ( cancel )
+        cancel->throwIfCancelled();
+
+    if ( !scene || !scene->HasMeshes() )
         throw std::runtime_error( importer.GetErrorString() );
 
+    // the imported scene lives until the importer goes out of scope
+    aiMemoryInfo imported;
+    importer.GetMemoryRequirements( imported );
+    MemoryCharge assimp( MemoryTag::Assimp, imported.total );
+
     aiMesh* loadedMesh = scene->mMeshes[0];
 
     u32 vertexCount = loadedMesh->mNumVertices;
     u32 faceCount   = loadedMesh->mNumFaces;
 
-    std::vector<glm::vec3> positions( vertexCount );
-    std::vector<glm::vec3> normals( vertexCount );
-    std::vector<glm::vec2> uvmap( vertexCount );
-    std::vector<u16>       indices;
+    // written once, straight from the imported scene into the layout uploaded to the GPU
+    Array<GpuVertex> vertices( vertexCount );
+    Array<u16>       indices;
+
+    // triangulated by the importer
+    indices.reserve( (size_t)faceCount * 3 );
 
     for ( u32 j = 0; j < vertexCount; j++ )
     {
-        positions[j] = { loadedMesh->mVertices[j].x, loadedMesh->mVertices[j].y, loadedMesh->mVertices[j].z };
-        normals[j]   = { loadedMesh->mNormals[j].x, loadedMesh->mNormals[j].y, loadedMesh->mNormals[j].z };
+        const aiVector3D& position = loadedMesh->mVertices[j];
+        const aiVector3D& normal   = loadedMesh->mNormals[j];
+        const aiVector3D& uv       = loadedMesh->mTextureCoords[0][j];
 
-        uvmap[j] = { loadedMesh->mTextureCoords[0][j].x, loadedMesh->mTextureCoords[0][j].y };
+        vertices[j].position = { position.x, position.y, position.z };
+        vertices[j].normal   = { normal.x, normal.y, normal.z };
+        vertices[j].uv       = { uv.x, uv.y };
     }
 
     for ( u32 j = 0; j < loadedMesh->mNumFaces; j++ )
@@ -117,170 +333,81 @@ Ptr<Mesh> Mesh::LoadFromMemory( const char* data, u32 size )
             indices.push_back( (u16)face.mIndices[k] );
     }
 
-    return std::make_shared<Mesh>( positions, normals, indices, uvmap );
+    Memory::CountCopy( CopyStage::Decode, Memory::BytesOf( vertices ) + Memory::BytesOf( indices ) );
+
+    return MakeRef<Mesh>( std::move( vertices ), std::move( indices ) );
 }
 
-Ptr<Mesh> Mesh::Create( Shader* shader, const Array<glm::vec3>& pos, const Array<glm::vec3>& norm,
-    const Array<u16> indices, const Array<glm::vec2>& uvmap )
+Ref<Mesh> Mesh::CreateDynamic( u32 vertexCount, Array<u16> indices, DynamicGeometry::Usage usage )
 {
-    if ( !pos.size() || !norm.size() || !indices.size() )
-        throw std::runtime_error( "Mesh is invalid" );
+    Ref<Mesh> mesh = MakeRef<Mesh>();
 
-    Ptr<Mesh> mesh = std::make_shared<Mesh>();
+    mesh->m_dynamic = std::make_unique<DynamicGeometry>( vertexCount, std::move( indices ), usage );
+    mesh->computeBounds();
 
-    mesh->Positions = pos;
-    mesh->Normals   = norm;
-    mesh->Indices   = indices;
-    mesh->UVMap     = uvmap;
+    return mesh;
+}
 
-    std::vector<float> vertexBuffer;
-    std::vector<float> normalBuffer;
-    std::vector<float> uvBuffer;
+Ref<Mesh> Mesh::Create( Shader* shader, const Array<glm::vec3>& pos, const Array<glm::vec3>& norm,
+    const Array<u16> indices, const Array<glm::vec2>& uvmap )
+{
+    if ( !pos.size() || !norm.size() || !indices.size() )
+        throw std::runtime_error( "Mesh is invalid" );
 
-    for ( u32 i = 0; i < pos.size(); i++ )
+    Array<GpuVertex> vertices( pos.size() );
+    for ( size_t i = 0; i < pos.size(); i++ )
     {
-        vertexBuffer.push_back( pos[i].x );
-        vertexBuffer.push_back( pos[i].y );
-        vertexBuffer.push_back( pos[i].z );
-
-        normalBuffer.push_back( norm[i].x );
-        normalBuffer.push_back( norm[i].y );
-        normalBuffer.push_back( norm[i].z );
-
-        uvBuffer.push_back( uvmap[i].x );
-        uvBuffer.push_back( uvmap[i].y );
-
-        // float x = uvmap[i].x;
-        // float y = uvmap[i].y;
-
-        // if ( x > 1.0f )
-        //     while ( x > 1.0f )
-        //         x--;
-        // else if ( x < 0.0f )
-        //     while ( x < 0.0f )
-        //         x++;
-
-        // if ( y > 1.0f )
-        //     while ( y > 1.0f )
-        //         y--;
-        // else if ( y < 0.0f )
-        //     while ( y < 0.0f )
-        //         y++;
-
-        // uvBuffer.push_back( x );
-        // uvBuffer.push_back( y );
+        vertices[i].position = pos[i];
+        vertices[i].normal   = i < norm.size() ? norm[i] : glm::vec3( 0.0f );
+        vertices[i].uv       = i < uvmap.size() ? uvmap[i] : glm::vec2( 0.0f );
     }
 
-    u32 attribLocation = 0;
-
-    u32 vbo = 0, nbo = 0, ibo = 0, cbo = 0;
-
-    glGenBuffers( 1, &vbo );
-    glBindBuffer( GL_ARRAY_BUFFER, vbo );
-    glBufferData(
-        GL_ARRAY_BUFFER, sizeof( float ) * vertexBuffer.size(), vertexBuffer.data(), GL_STATIC_DRAW );
-
-    glGenBuffers( 1, &ibo );
-    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, ibo );
-    glBufferData( GL_ELEMENT_ARRAY_BUFFER, sizeof( u16 ) * indices.size(), indices.data(), GL_STATIC_DRAW );
-
-    attribLocation = glGetAttribLocation( shader->GetID(), "v_position" );
-    glEnableVertexAttribArray( attribLocation );
-    glBindAttribLocation( shader->GetID(), attribLocation, "v_position" );
+    Ref<Mesh> mesh = MakeRef<Mesh>( std::move( vertices ), Array<u16>( indices ) );
 
-    glGenBuffers( 1, &nbo );
-    glBindBuffer( GL_ARRAY_BUFFER, nbo );
-    glBufferData(
-        GL_ARRAY_BUFFER, sizeof( float ) * normalBuffer.size(), normalBuffer.data(), GL_STATIC_DRAW );
-
-    attribLocation = glGetAttribLocation( shader->GetID(), "v_normal" );
-    glEnableVertexAttribArray( attribLocation );
-    glBindAttribLocation( shader->GetID(), attribLocation, "v_normal" );
-
-    glGenBuffers( 1, &cbo );
-    glBindBuffer( GL_ARRAY_BUFFER, cbo );
-    glBufferData( GL_ARRAY_BUFFER, sizeof( float ) * uvBuffer.size(), uvBuffer.data(), GL_STATIC_DRAW );
-
-    attribLocation = glGetAttribLocation( shader->GetID(), "v_uv" );
-    glEnableVertexAttribArray( attribLocation );
-    glBindAttribLocation( shader->GetID(), attribLocation, "v_uv" );
-
-    glBindBuffer( GL_ARRAY_BUFFER, 0 );
-
-    mesh->VBO = vbo;
-    mesh->NBO = nbo;
-    mesh->IBO = ibo;
-    mesh->CBO = cbo;
+    u64 unlimited = UINT64_MAX;
+    mesh->upload( unlimited );
 
     return mesh;
 }
 
-// TODO: Release all mesh data from memory
-bool Mesh::update( Shader* shader )
+bool Mesh::upload( u64& budget )
 {
-    std::vector<float> vertexBuffer;
-    std::vector<float> normalBuffer;
-    std::vector<float> uvBuffer;
+    GpuBufferArena& arena = GpuBufferArena::Instance();
 
-    if ( Positions.size() == 0 || Normals.size() == 0 || UVMap.size() == 0 )
-        return false;
-
-    for ( u32 i = 0; i < Positions.size(); i++ )
+    if ( m_gpuRange == GpuBufferArena::Invalid )
     {
-        vertexBuffer.push_back( Positions[i].x );
-        vertexBuffer.push_back( Positions[i].y );
-        vertexBuffer.push_back( Positions[i].z );
+        m_gpuRange = arena.allocate( *this );
 
-        normalBuffer.push_back( Normals[i].x );
-        normalBuffer.push_back( Normals[i].y );
-        normalBuffer.push_back( Normals[i].z );
-
-        uvBuffer.push_back( UVMap[i].x );
-        uvBuffer.push_back( UVMap[i].y );
+        // an empty mesh is never drawn
+        if ( m_gpuRange == GpuBufferArena::Invalid )
+            return true;
     }
 
-    u32 attribLocation = 0;
-
-    u32 vbo = 0, nbo = 0, ibo = 0, cbo = 0;
-
-    glGenBuffers( 1, &vbo );
-    glBindBuffer( GL_ARRAY_BUFFER, vbo );
-    glBufferData(
-        GL_ARRAY_BUFFER, sizeof( float ) * vertexBuffer.size(), vertexBuffer.data(), GL_STATIC_DRAW );
-
-    glGenBuffers( 1, &ibo );
-    glBindBuffer( GL_ELEMENT_ARRAY_BUFFER, ibo );
-    glBufferData( GL_ELEMENT_ARRAY_BUFFER, sizeof( u16 ) * Indices.size(), Indices.data(), GL_STATIC_DRAW );
-
-    attribLocation = glGetAttribLocation( shader->GetID(), "v_position" );
-    glEnableVertexAttribArray( attribLocation );
-    glBindAttribLocation( shader->GetID(), attribLocation, "v_position" );
+    if ( !arena.upload( m_gpuRange, budget ) )
+        return false;
 
-    glGenBuffers( 1, &nbo );
-    glBindBuffer( GL_ARRAY_BUFFER, nbo );
-    glBufferData(
-        GL_ARRAY_BUFFER, sizeof( float ) * normalBuffer.size(), normalBuffer.data(), GL_STATIC_DRAW );
+    // from here on the arena's blocks account for the mesh
+    m_gpuCharge = MemoryCharge();
 
-    attribLocation = glGetAttribLocation( shader->GetID(), "v_normal" );
-    glEnableVertexAttribArray( attribLocation );
-    glBindAttribLocation( shader->GetID(), attribLocation, "v_normal" );
+    releaseArrays();
 
-    glGenBuffers( 1, &cbo );
-    glBindBuffer( GL_ARRAY_BUFFER, cbo );
-    glBufferData( GL_ARRAY_BUFFER, sizeof( float ) * uvBuffer.size(), uvBuffer.data(), GL_STATIC_DRAW );
+    return true;
+}
 
-    attribLocation = glGetAttribLocation( shader->GetID(), "v_uv" );
-    glEnableVertexAttribArray( attribLocation );
-    glBindAttribLocation( shader->GetID(), attribLocation, "v_uv" );
+// TODO: Release all mesh data from memory
+bool Mesh::update( Shader* shader )
+{
+    // meshes shared between parts are uploaded once
+    if ( isResident() )
+        return true;
 
-    glBindBuffer( GL_ARRAY_BUFFER, 0 );
+    if ( Vertices.empty() )
+        return false;
 
-    this->VBO = vbo;
-    this->NBO = nbo;
-    this->IBO = ibo;
-    this->CBO = cbo;
+    u64 unlimited = UINT64_MAX;
+    upload( unlimited );
 
-    return true;
+    return isResident();
 }
 
 void updateNormals( std::vector<glm::vec3>& pos, std::vector<glm::vec3>& norms, std::vector<u32> indices )
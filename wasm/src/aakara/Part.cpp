@@ -1,41 +1,54 @@
 #include <emscripten/bind.h>
 #include <aakara/Part.hpp>
+#include <aakara/Transform.hpp>
+#include <aakara/Mesh.hpp>
+#include <aakara/Texture.hpp>
 
 Part::Part()
 {
 }
 
 Part::Part( const Part& other )
-    : id( other.id )
-    , mesh( other.mesh )
+    : mesh( other.mesh )
     , texture( other.texture )
     , transform( other.transform )
+    , chunks( other.chunks )
 {
 }
 
-Part::Part( const string& id, Ptr<Mesh> mesh, Ptr<Texture> texture, Ptr<Transform> transform )
-    : id( id )
-    , mesh( mesh )
+Part::Part( Ref<Mesh> mesh, Ref<Texture> texture, Ref<Transform> transform )
+    : mesh( mesh )
     , texture( texture )
     , transform( transform )
 {
 }
 
+// out of line, where releasing the mesh and texture references can see their types
+Part::~Part()
+{
+}
+
 /* -------------------------------- Bindings -------------------------------- */
-string getId( Ptr<Part> part )
+u32 getId( Ptr<Part> part )
 {
-    return part->id;
+    return part->handle;
 }
 
 Ptr<Transform> getTransform( Ptr<Part> part )
 {
-    return part->transform;
+    return Share( part->transform );
+}
+
+u32 getTransformIndex( Ptr<Part> part )
+{
+    return part->transform->getSlot();
 }
 
 EMSCRIPTEN_BINDINGS( PART_HPP )
 {
     emscripten::class_<Part>( "Part" )
-        .smart_ptr_constructor( "Part", &std::make_shared<Part> )
+        .smart_ptr_constructor( "Part", &MakeShared<Part> )
         .function( "getId", &getId )
-        .function( "getTransform", &getTransform );
+        .function( "getTransform", &getTransform )
+        .function( "getTransformIndex", &getTransformIndex );
 }
@@ -0,0 +1,927 @@
+#include <thread>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#include <emscripten/console.h>
+#include <emscripten/emscripten.h>
+#include <glm/glm.hpp>
+
+#include <aakara/PartLoader.hpp>
+#include <aakara/JobSystem.hpp>
+#include <aakara/Mesh.hpp>
+#include <aakara/Texture.hpp>
+#include <aakara/Transform.hpp>
+#include <aakara/TransformStore.hpp>
+#include <aakara/Frustum.hpp>
+#include <aakara/Part.hpp>
+#include <aakara/DecodeArena.hpp>
+
+constexpr u32 CACHE_WRITE_QUEUE_SIZE = 64;
+
+// first request for a chunked mesh; large enough for the table of most files
+constexpr u32 CHUNK_TABLE_PROBE_SIZE = 16384;
+
+// update() calls between sweeps for shared assets nothing uses any more
+constexpr u32 SHARED_PRUNE_INTERVAL = 120;
+
+// fetches of a chunk before it is given up, and the wait before the first retry, doubled for every other
+constexpr u8     CHUNK_FETCH_ATTEMPTS = 4;
+constexpr double CHUNK_RETRY_DELAY    = 250.0;
+
+// ranks of Priority
+constexpr u8 RANK_HIDDEN  = 0;
+constexpr u8 RANK_VISIBLE = 1;
+constexpr u8 RANK_RETRY   = 2;
+
+// heap taken by an Assimp import, its scene graph and the converted arrays, relative to the file size
+constexpr u64 MESH_IMPORT_MEMORY_FACTOR = 3;
+
+// fixed fields of a serialized texture: magic, width, height and format
+constexpr u64 TEXTURE_BINARY_HEADER = 16;
+
+namespace
+{
+    HTTP::Header RangeOf( u64 offset, u64 size )
+    {
+        return { "Range", "bytes=" + std::to_string( offset ) + "-" + std::to_string( offset + size - 1 ) };
+    }
+
+    // network errors, timeouts, throttling and server errors may well pass
+    bool IsTransient( u16 status )
+    {
+        return status == 0 || status == 408 || status == 429 || status >= 500;
+    }
+}
+
+PartLoader::PartLoader( JobSystem& jobs, MpscQueue<Ref<Part>>& completed, MpscQueue<LoadedChunk>& chunks,
+    MemoryBudget& budget, u32 maxInFlight, Ptr<AssetCache> cache )
+    : m_jobs( jobs )
+    , m_completed( completed )
+    , m_chunks( chunks )
+    , m_budget( budget )
+    , m_maxInFlight( std::max<u32>( maxInFlight, 1 ) )
+    , m_cache( cache )
+    , m_cacheWrites( CACHE_WRITE_QUEUE_SIZE )
+{
+}
+
+void PartLoader::update( const glm::mat4& viewProjection, const glm::vec3& eye )
+{
+    if ( m_cache )
+    {
+        size_t stored = m_cacheWrites.drain( [this]( CacheWrite write )
+            { m_cache->store( write.url, write.condition, write.payload ); } );
+
+        if ( stored )
+            m_cache->flush();
+    }
+
+    // before anything else is issued or admitted
+    if ( m_cancelled )
+        sweep();
+
+    if ( !m_deferred.empty() )
+    {
+        Array<Deferred> deferred;
+        deferred.swap( m_deferred );
+
+        // the most urgent get the memory freed first
+        std::sort( deferred.begin(), deferred.end(),
+            []( const Deferred& a, const Deferred& b ) { return Precedes( b.request, a.request ); } );
+
+        for ( Deferred& work : deferred )
+            admit( std::move( work ) );
+    }
+
+    m_budget.setDeferred( (u32)m_deferred.size() );
+
+    if ( !m_chunkRetries.empty() || !m_failedChunks.empty() )
+        requeueChunks();
+
+    bool moved = !m_hasView || eye != m_lastEye
+                 || std::memcmp( &viewProjection, &m_lastViewProjection, sizeof( viewProjection ) ) != 0;
+
+    m_lastViewProjection = viewProjection;
+    m_lastEye            = eye;
+    m_hasView            = true;
+
+    if ( !m_pending.empty() && ( moved || m_pendingDirty ) )
+        prioritizeRequests( Frustum::FromMatrix( viewProjection ), eye );
+
+    if ( !m_chunkQueue.empty() && ( moved || m_chunkQueueDirty ) )
+        prioritize( viewProjection, eye );
+
+    if ( ++m_updates % SHARED_PRUNE_INTERVAL == 0 )
+        prune();
+
+    // new loads, and chunks held back by the budget once memory is freed
+    pump();
+}
+
+Ref<Part> PartLoader::load(
+    const string& meshUrl, const string& textureUrl, Ref<Transform> transform, const Bounds* bounds )
+{
+    Ptr<Load> load = std::make_shared<Load>();
+    load->part     = MakeRef<Part>( nullptr, nullptr, transform );
+
+    if ( bounds )
+    {
+        load->bounds    = *bounds;
+        load->hasBounds = true;
+    }
+
+    // streamed meshes are not shared: their chunks are delivered to one part
+    if ( ChunkedMesh::IsChunked( meshUrl ) )
+    {
+        Request request;
+        request.load        = load;
+        request.url         = meshUrl;
+        request.asset       = Asset::ChunkTable;
+        request.conditional = false;
+        request.range       = CHUNK_TABLE_PROBE_SIZE;
+
+        enqueue( std::move( request ) );
+    }
+    else
+    {
+        share( load, meshUrl, Asset::Mesh );
+    }
+
+    share( load, textureUrl, Asset::Texture );
+
+    return load->part;
+}
+
+void PartLoader::share( const Ptr<Load>& load, const string& url, Asset asset )
+{
+    Ptr<Shared>& shared = m_shared[( asset == Asset::Mesh ? "mesh:" : "texture:" ) + url];
+
+    if ( !shared )
+    {
+        shared        = std::make_shared<Shared>();
+        shared->asset = asset;
+        shared->waiters.push_back( load );
+
+        Request request;
+        request.shared = shared;
+        request.url    = url;
+        request.asset  = asset;
+
+        enqueue( std::move( request ) );
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock( shared->mutex );
+    if ( !shared->done )
+    {
+        // a request still pending may now be more urgent
+        shared->waiters.push_back( load );
+        m_pendingDirty = true;
+        return;
+    }
+
+    lock.unlock();
+    resolve( *shared, load );
+}
+
+void PartLoader::complete( Shared& shared )
+{
+    Array<Ptr<Load>> waiters;
+    {
+        std::lock_guard<std::mutex> lock( shared.mutex );
+        shared.done = true;
+        waiters.swap( shared.waiters );
+    }
+
+    for ( const Ptr<Load>& load : waiters )
+        resolve( shared, load );
+}
+
+void PartLoader::resolve( const Shared& shared, const Ptr<Load>& load )
+{
+    if ( shared.failed )
+        load->failed = true;
+    else if ( shared.asset == Asset::Mesh )
+        load->mesh = shared.mesh;
+    else
+        load->texture = shared.texture;
+
+    finishStage( load );
+}
+
+void PartLoader::prune()
+{
+    // forget assets no part uses any more, and failures so that later loads retry them
+    for ( auto it = m_shared.begin(); it != m_shared.end(); )
+    {
+        Shared& shared = *it->second;
+        bool    drop   = false;
+        {
+            std::lock_guard<std::mutex> lock( shared.mutex );
+
+            // a worker may still be writing the asset of one not done
+            if ( shared.done )
+            {
+                long users = shared.mesh ? shared.mesh.useCount() : shared.texture.useCount();
+                drop       = shared.failed || users <= 1;
+            }
+        }
+
+        it = drop ? m_shared.erase( it ) : std::next( it );
+    }
+}
+
+void PartLoader::cancel( Part& part )
+{
+    part.loading.cancel();
+    m_cancelled = true;
+}
+
+void PartLoader::sweep()
+{
+    // shared assets no part waits for any more are abandoned; a later load of the URL starts over
+    for ( auto it = m_shared.begin(); it != m_shared.end(); )
+    {
+        Shared& shared    = *it->second;
+        bool    abandoned = false;
+        {
+            std::lock_guard<std::mutex> lock( shared.mutex );
+            if ( !shared.done )
+            {
+                Array<Ptr<Load>>& waiters = shared.waiters;
+                waiters.erase( std::remove_if( waiters.begin(), waiters.end(),
+                                   []( const Ptr<Load>& load ) { return load->part->loading.cancelled(); } ),
+                    waiters.end() );
+
+                abandoned = waiters.empty();
+            }
+        }
+
+        if ( abandoned )
+            shared.loading.cancel();
+
+        it = abandoned ? m_shared.erase( it ) : std::next( it );
+    }
+
+    m_pending.erase( std::remove_if( m_pending.begin(), m_pending.end(), IsCancelled ), m_pending.end() );
+
+    // aborting frees the connection and whatever of the body has arrived
+    for ( auto it = m_issued.begin(); it != m_issued.end(); )
+    {
+        const Issued& issued = it->second;
+        bool          abort  = issued.loading->cancelled() && HTTP::Cancel( issued.ticket );
+
+        it = abort ? m_issued.erase( it ) : std::next( it );
+    }
+
+    m_deferred.erase( std::remove_if( m_deferred.begin(), m_deferred.end(),
+                          []( const Deferred& work ) { return IsCancelled( work.request ); } ),
+        m_deferred.end() );
+
+    m_chunkQueue.erase( std::remove_if( m_chunkQueue.begin(), m_chunkQueue.end(),
+                            []( const ChunkRequest& request )
+                            { return request.stream->part->loading.cancelled(); } ),
+        m_chunkQueue.end() );
+
+    m_chunkRetries.erase( std::remove_if( m_chunkRetries.begin(), m_chunkRetries.end(),
+                              []( const ChunkRetry& retry )
+                              { return retry.request.stream->part->loading.cancelled(); } ),
+        m_chunkRetries.end() );
+
+    m_budget.setDeferred( (u32)m_deferred.size() );
+
+    m_cancelled = false;
+}
+
+void PartLoader::setMaxInFlight( u32 maxInFlight )
+{
+    m_maxInFlight = std::max<u32>( maxInFlight, 1 );
+    pump();
+}
+
+void PartLoader::pump()
+{
+    // whole assets and chunk tables go first: they are small and unblock parts
+    while ( getInFlight() < m_maxInFlight && !m_pending.empty() )
+    {
+        Request request = std::move( m_pending.back() );
+        m_pending.pop_back();
+
+        issue( request );
+    }
+
+    // a chunk is small, so it is not admitted on its own: none is requested while the budget is exhausted
+    while ( getInFlight() < m_maxInFlight && !m_chunkQueue.empty() && !m_budget.exhausted() )
+    {
+        ChunkRequest request = std::move( m_chunkQueue.back() );
+        m_chunkQueue.pop_back();
+
+        issueChunk( request );
+    }
+}
+
+void PartLoader::enqueue( Request request )
+{
+    request.sequence = m_nextSequence++;
+
+    if ( m_hasView )
+        request.priority = priorityOf( request, Frustum::FromMatrix( m_lastViewProjection ), m_lastEye );
+
+    m_pending.insert( std::upper_bound( m_pending.begin(), m_pending.end(), request, Precedes ), request );
+}
+
+void PartLoader::retry( Request request )
+{
+    // ahead of everything else: its part was already waiting
+    request.priority.rank = RANK_RETRY;
+    m_pending.insert( std::upper_bound( m_pending.begin(), m_pending.end(), request, Precedes ), request );
+}
+
+void PartLoader::issue( const Request& request )
+{
+    std::weak_ptr<u8> alive = m_alive;
+
+    HTTP::FetchOptions options;
+
+    HTTP::Header condition;
+    if ( request.asset == Asset::ChunkTable )
+        options.headers.push_back( RangeOf( 0, request.range ) );
+    else if ( m_cache && request.conditional && m_cache->condition( request.url, condition ) )
+        options.headers.push_back( condition );
+
+    u32 id = m_nextIssued++;
+
+    options.callback = [this, alive, id, request]( const Ptr<const HTTP::Response>& response )
+    {
+        if ( alive.expired() )
+            return;
+
+        m_issued.erase( id );
+        onResponse( request, response );
+    };
+
+    m_issued[id].loading = request.shared ? &request.shared->loading : &request.load->part->loading;
+
+    u64  ticket = HTTP::GET( request.url, options );
+    auto issued = m_issued.find( id );
+    if ( issued != m_issued.end() )
+        issued->second.ticket = ticket;
+}
+
+void PartLoader::issueChunk( const ChunkRequest& request )
+{
+    std::weak_ptr<u8>         alive = m_alive;
+    const ChunkedMesh::Chunk& chunk = request.stream->chunks[request.chunk];
+
+    HTTP::FetchOptions options;
+    options.headers.push_back( RangeOf( chunk.offset, chunk.size ) );
+
+    u32 id = m_nextIssued++;
+
+    options.callback = [this, alive, id, request]( const Ptr<const HTTP::Response>& response )
+    {
+        if ( alive.expired() )
+            return;
+
+        m_issued.erase( id );
+        onChunk( request, response );
+    };
+
+    m_issued[id].loading = &request.stream->part->loading;
+
+    u64  ticket = HTTP::GET( request.stream->url, options );
+    auto issued = m_issued.find( id );
+    if ( issued != m_issued.end() )
+        issued->second.ticket = ticket;
+}
+
+void PartLoader::onResponse( const Request& request, const Ptr<const HTTP::Response>& response )
+{
+    // cancelled after the request could no longer be aborted
+    if ( IsCancelled( request ) )
+    {
+        pump();
+        return;
+    }
+
+    if ( request.asset == Asset::ChunkTable )
+    {
+        onChunkTable( request, response );
+    }
+    else if ( response->status == 304 )
+    {
+        Array<u8> payload;
+
+        if ( m_cache && m_cache->load( request.url, payload ) )
+        {
+            admit( { request, nullptr, std::move( payload ) } );
+        }
+        else
+        {
+            // the cached copy vanished since the request went out: ask again without a condition
+            Request unconditional     = request;
+            unconditional.conditional = false;
+            retry( unconditional );
+        }
+    }
+    else if ( !response->ok() || response->body.empty() )
+    {
+        emscripten_console_errorf( "%s fetch failed with status %d: %s", NameOf( request.asset ),
+            response->status, request.url.c_str() );
+
+        request.shared->failed = true;
+        complete( *request.shared );
+    }
+    else
+    {
+        // the response is shared with any other waiter for the same URL, so it is passed on, not copied
+        admit( { request, response, {} } );
+    }
+
+    pump();
+}
+
+void PartLoader::admit( Deferred work )
+{
+    const Request& request = work.request;
+
+    MemoryBudget::Estimate estimate  = EstimateOf( work );
+    u32                    downscale = 0;
+
+    switch ( m_budget.admit( estimate, request.asset == Asset::Texture, downscale ) )
+    {
+    case MemoryBudget::Decision::Defer:
+        m_deferred.push_back( std::move( work ) );
+        return;
+
+    case MemoryBudget::Decision::Reject:
+        emscripten_console_errorf( "%s needs %llu bytes of memory and %llu of GPU memory, over budget: %s",
+            NameOf( request.asset ), estimate.cpu, estimate.gpu, request.url.c_str() );
+
+        request.shared->failed = true;
+        complete( *request.shared );
+        return;
+
+    case MemoryBudget::Decision::Admit:
+    case MemoryBudget::Decision::Downscale:
+        break;
+    }
+
+    if ( work.response )
+    {
+        m_jobs.pushTask( [this, request, response = std::move( work.response ), estimate, downscale]
+            { decode( request, response, estimate, downscale ); } );
+    }
+    else
+    {
+        m_jobs.pushTask( [this, request, payload = std::move( work.payload ), estimate, downscale]
+            { restore( request, payload, estimate, downscale ); } );
+    }
+}
+
+void PartLoader::onChunkTable( const Request& request, const Ptr<const HTTP::Response>& response )
+{
+    const HTTP::Body& body = response->body;
+
+    Ptr<Stream> stream = std::make_shared<Stream>();
+    stream->part       = request.load->part;
+    stream->url        = request.url;
+
+    try
+    {
+        if ( !response->ok() )
+            throw std::runtime_error( "status " + std::to_string( response->status ) );
+
+        size_t required = 0;
+        if ( !ChunkedMesh::ReadTable( body.data(), body.size(), stream->chunks, required ) )
+        {
+            // the probe was too small for the table: ask again for exactly the header and table
+            if ( response->status == 206 && body.size() >= request.range && required > request.range )
+            {
+                Request larger = request;
+                larger.range   = (u32)required;
+                retry( larger );
+                return;
+            }
+
+            throw std::runtime_error( "truncated chunk table" );
+        }
+    }
+    catch ( const std::exception& err )
+    {
+        emscripten_console_errorf( "Failed to read chunk table of %s: %s", request.url.c_str(), err.what() );
+
+        request.load->failed = true;
+        finishStage( request.load );
+        return;
+    }
+
+    // chunks already in hand (small files, or a server that ignored the range) decode straight away
+    for ( u32 i = 0; i < stream->chunks.size(); i++ )
+    {
+        const ChunkedMesh::Chunk& chunk = stream->chunks[i];
+
+        if ( chunk.offset + chunk.size <= body.size() )
+            m_jobs.pushTask(
+                [this, stream, i, response] { decodeChunk( stream, i, response, 0, nullptr ); } );
+        else
+        {
+            ChunkRequest request;
+            request.stream = stream;
+            request.chunk  = i;
+
+            m_chunkQueue.push_back( std::move( request ) );
+        }
+    }
+
+    m_chunkQueueDirty = true;
+
+    finishStage( request.load );
+}
+
+void PartLoader::onChunk( const ChunkRequest& request, const Ptr<const HTTP::Response>& response )
+{
+    // cancelled after the request could no longer be aborted
+    if ( request.stream->part->loading.cancelled() )
+    {
+        pump();
+        return;
+    }
+
+    if ( !response->ok() )
+    {
+        ChunkRequest retry = request;
+
+        if ( IsTransient( response->status ) && ++retry.attempts < CHUNK_FETCH_ATTEMPTS )
+        {
+            double delay = CHUNK_RETRY_DELAY * ( 1 << ( retry.attempts - 1 ) );
+
+            emscripten_console_warnf( "Chunk %u fetch failed with status %d, retrying in %.0f ms: %s",
+                request.chunk, response->status, delay, request.stream->url.c_str() );
+
+            m_chunkRetries.push_back( { retry, emscripten_get_now() + delay } );
+        }
+        else
+        {
+            emscripten_console_errorf( "Chunk %u fetch failed with status %d: %s", request.chunk,
+                response->status, request.stream->url.c_str() );
+
+            failChunk( request );
+        }
+    }
+    else
+    {
+        // a 206 body starts at the chunk, a 200 body at the start of the file
+        u64 base = response->status == 206 ? request.stream->chunks[request.chunk].offset : 0;
+
+        m_jobs.pushTask( [this, request, response, base]
+            { decodeChunk( request.stream, request.chunk, response, base, request.refill ); } );
+    }
+
+    pump();
+}
+
+void PartLoader::requeueChunks()
+{
+    double now = emscripten_get_now();
+
+    for ( auto it = m_chunkRetries.begin(); it != m_chunkRetries.end(); )
+    {
+        if ( it->at > now )
+        {
+            ++it;
+            continue;
+        }
+
+        m_chunkQueue.push_back( std::move( it->request ) );
+        m_chunkQueueDirty = true;
+
+        it = m_chunkRetries.erase( it );
+    }
+
+    // this thread drains the chunks queue, so it cannot wait for room like the workers do
+    while ( !m_failedChunks.empty() && m_chunks.tryPush( std::move( m_failedChunks.back() ) ) )
+        m_failedChunks.pop_back();
+}
+
+void PartLoader::failChunk( const ChunkRequest& request )
+{
+    m_failedChunks.push_back( { request.stream->part, nullptr, request.chunk, request.refill } );
+}
+
+void PartLoader::reread( const Ptr<Stream>& stream, u32 chunk, const Ref<Mesh>& mesh )
+{
+    ChunkRequest request;
+    request.stream = stream;
+    request.chunk  = chunk;
+    request.refill = mesh;
+
+    m_chunkQueue.push_back( std::move( request ) );
+    m_chunkQueueDirty = true;
+}
+
+void PartLoader::decode( const Request& request, const Ptr<const HTTP::Response>& response,
+    const MemoryBudget::Estimate& reserved, u32 downscale )
+{
+    const HTTP::Body& bytes  = response->body;
+    Shared&           shared = *request.shared;
+
+    // scratch memory of the decoders is released as soon as this asset is done
+    DecodeArena::Scope scratch;
+
+    try
+    {
+        // possibly cancelled while waiting for a worker
+        shared.loading.throwIfCancelled();
+
+        if ( request.asset == Asset::Mesh )
+        {
+            shared.mesh = Mesh::LoadFromMemory(
+                reinterpret_cast<const char*>( bytes.data() ), bytes.size(), &shared.loading );
+        }
+        else
+        {
+            shared.texture
+                = Texture::LoadFromMemory( bytes.data(), bytes.size(), downscale, &shared.loading );
+        }
+
+        // a decoded asset is still cached when cancelled since: the part may well be loaded again
+        // a downscaled texture is not cached, so that it loads at full size once memory allows
+        HTTP::Header condition;
+        if ( m_cache && !downscale && AssetCache::ConditionFor( *response, condition ) )
+        {
+            CacheWrite write { request.url, condition, {} };
+
+            if ( request.asset == Asset::Mesh )
+                shared.mesh->Serialize( write.payload );
+            else
+                shared.texture->Serialize( write.payload );
+
+            // caching is best effort: drop the write rather than wait for the main thread
+            m_cacheWrites.tryPush( std::move( write ) );
+        }
+    }
+    catch ( const CancelToken::Cancelled& )
+    {
+        shared.failed = true;
+    }
+    catch ( const std::exception& err )
+    {
+        emscripten_console_errorf( "Failed to decode %s: %s", NameOf( request.asset ), err.what() );
+        shared.failed = true;
+    }
+
+    // the asset's own memory charges take over from the reservation
+    m_budget.release( reserved );
+
+    complete( shared );
+}
+
+void PartLoader::decodeChunk( const Ptr<Stream>& stream, u32 chunk, const Ptr<const HTTP::Response>& response,
+    u64 base, const Ref<Mesh>& refill )
+{
+    const ChunkedMesh::Chunk& entry = stream->chunks[chunk];
+    const HTTP::Body&         body  = response->body;
+
+    if ( stream->part->loading.cancelled() )
+        return;
+
+    LoadedChunk loaded;
+    loaded.part   = stream->part;
+    loaded.index  = chunk;
+    loaded.refill = refill;
+
+    // handed over without a mesh when it cannot be decoded: fetching it again would not help
+    try
+    {
+        if ( entry.offset < base || entry.offset - base + entry.size > body.size() )
+            throw std::runtime_error( "chunk lies outside the response" );
+
+        loaded.mesh = Mesh::Deserialize( body.data() + ( entry.offset - base ), entry.size );
+
+        // uploaded, the chunk frees its arrays; they are fetched again if the GpuBufferArena moves it
+        std::weak_ptr<u8> alive = m_alive;
+        loaded.mesh->setReread( [this, alive, stream, chunk]( const Ref<Mesh>& mesh )
+            {
+                if ( !alive.expired() )
+                    reread( stream, chunk, mesh );
+            } );
+    }
+    catch ( const std::exception& err )
+    {
+        emscripten_console_errorf(
+            "Failed to decode chunk %u of %s: %s", chunk, stream->url.c_str(), err.what() );
+    }
+
+    // the render thread drains every frame, so a full ring only costs a few yields
+    while ( !m_chunks.tryPush( std::move( loaded ) ) )
+        std::this_thread::yield();
+}
+
+void PartLoader::restore( const Request& request, const Array<u8>& payload,
+    const MemoryBudget::Estimate& reserved, u32 downscale )
+{
+    Shared& shared = *request.shared;
+
+    try
+    {
+        shared.loading.throwIfCancelled();
+
+        if ( request.asset == Asset::Mesh )
+            shared.mesh = Mesh::Deserialize( payload.data(), payload.size() );
+        else
+            shared.texture = Texture::Deserialize( payload.data(), payload.size(), downscale );
+    }
+    catch ( const CancelToken::Cancelled& )
+    {
+        shared.failed = true;
+    }
+    catch ( const std::exception& err )
+    {
+        emscripten_console_errorf( "Failed to restore cached %s: %s", NameOf( request.asset ), err.what() );
+        shared.failed = true;
+    }
+
+    m_budget.release( reserved );
+
+    complete( shared );
+}
+
+void PartLoader::prioritize( const glm::mat4& viewProjection, const glm::vec3& eye )
+{
+    Frustum frustum = Frustum::FromMatrix( viewProjection );
+
+    const Stream* stream = nullptr;
+    glm::mat4     world;
+
+    for ( ChunkRequest& request : m_chunkQueue )
+    {
+        if ( request.stream.get() != stream )
+        {
+            stream = request.stream.get();
+
+            const Transform& transform = *stream->part->transform;
+            world = TransformStore::ComputeLocal(
+                transform.getPosition(), transform.getRotation(), transform.getScale() );
+        }
+
+        Bounds bounds = stream->chunks[request.chunk].bounds.transformed( world );
+        f32    radius = glm::length( bounds.extents() );
+
+        request.visible  = frustum.intersects( bounds ) ? 1 : 0;
+        request.distance = std::max( glm::distance( eye, bounds.center() ) - radius, 0.0f );
+    }
+
+    // visible before hidden, near before far; pump() takes from the back
+    // a total order keeps this deterministic without the merge buffer std::stable_sort allocates
+    std::sort( m_chunkQueue.begin(), m_chunkQueue.end(),
+        []( const ChunkRequest& a, const ChunkRequest& b )
+        {
+            if ( a.visible != b.visible )
+                return a.visible < b.visible;
+            if ( a.distance != b.distance )
+                return a.distance > b.distance;
+            if ( a.stream != b.stream )
+                return std::less<Stream*>()( a.stream.get(), b.stream.get() );
+            return a.chunk > b.chunk;
+        } );
+
+    m_chunkQueueDirty = false;
+}
+
+void PartLoader::prioritizeRequests( const Frustum& frustum, const glm::vec3& eye )
+{
+    for ( Request& request : m_pending )
+    {
+        if ( request.priority.rank != RANK_RETRY )
+            request.priority = priorityOf( request, frustum, eye );
+    }
+
+    std::sort( m_pending.begin(), m_pending.end(), Precedes );
+
+    m_pendingDirty = false;
+}
+
+PartLoader::Priority PartLoader::priorityOf(
+    const Request& request, const Frustum& frustum, const glm::vec3& eye ) const
+{
+    if ( request.load )
+        return PriorityOf( *request.load, frustum, eye );
+
+    // a shared asset is as urgent as the most urgent part waiting for it
+    Priority priority { RANK_HIDDEN, 0.0f };
+
+    std::lock_guard<std::mutex> lock( request.shared->mutex );
+    for ( const Ptr<Load>& load : request.shared->waiters )
+        priority = std::max( priority, PriorityOf( *load, frustum, eye ) );
+
+    return priority;
+}
+
+PartLoader::Priority PartLoader::PriorityOf( const Load& load, const Frustum& frustum, const glm::vec3& eye )
+{
+    if ( !load.hasBounds )
+        return { RANK_VISIBLE, 0.0f };
+
+    const Transform& transform = *load.part->transform;
+
+    Bounds bounds = load.bounds.transformed( TransformStore::ComputeLocal(
+        transform.getPosition(), transform.getRotation(), transform.getScale() ) );
+
+    f32 radius   = glm::length( bounds.extents() );
+    f32 distance = glm::distance( eye, bounds.center() );
+
+    Priority priority;
+    priority.rank     = frustum.intersects( bounds ) ? RANK_VISIBLE : RANK_HIDDEN;
+    priority.coverage = distance > radius ? radius / distance : 1.0f;
+
+    return priority;
+}
+
+bool PartLoader::Precedes( const Request& a, const Request& b )
+{
+    // less urgent first, so the most urgent and oldest request is at the back
+    if ( a.priority < b.priority )
+        return true;
+    if ( b.priority < a.priority )
+        return false;
+
+    return a.sequence > b.sequence;
+}
+
+void PartLoader::finishStage( const Ptr<Load>& load )
+{
+    if ( load->remaining.fetch_sub( 1 ) != 1 )
+        return;
+
+    // App already let go of a cancelled part
+    if ( load->part->loading.cancelled() )
+        return;
+
+    // a streamed part has no mesh of its own: its chunks are handed over separately
+    Ref<Part> part = load->part;
+    part->mesh     = load->mesh;
+    part->texture  = load->texture;
+    part->failed   = load->failed;
+
+    // the render thread drains every frame, so a full ring only costs a few yields
+    while ( !m_completed.tryPush( std::move( part ) ) )
+        std::this_thread::yield();
+}
+
+bool PartLoader::IsCancelled( const Request& request )
+{
+    return request.shared ? request.shared->loading.cancelled() : request.load->part->loading.cancelled();
+}
+
+const char* PartLoader::NameOf( Asset asset )
+{
+    switch ( asset )
+    {
+    case Asset::Mesh:
+        return "mesh";
+    case Asset::Texture:
+        return "texture";
+    case Asset::ChunkTable:
+        return "chunk table";
+    }
+
+    return "asset";
+}
+
+MemoryBudget::Estimate PartLoader::EstimateOf( const Deferred& work )
+{
+    MemoryBudget::Estimate estimate;
+
+    // cached copies hold exactly what is uploaded
+    if ( !work.response )
+    {
+        u64 size = work.payload.size();
+        if ( work.request.asset == Asset::Texture )
+            size = size > TEXTURE_BINARY_HEADER ? size - TEXTURE_BINARY_HEADER : 0;
+
+        estimate.cpu = size;
+        estimate.gpu = work.request.asset == Asset::Texture ? size + size / 3 : size;
+        return estimate;
+    }
+
+    const HTTP::Body& body = work.response->body;
+
+    if ( work.request.asset == Asset::Mesh )
+    {
+        estimate.cpu = body.size() * MESH_IMPORT_MEMORY_FACTOR;
+        estimate.gpu = body.size();
+    }
+    else
+    {
+        // decoded to RGBA, uploaded with a mip chain; an unreadable header fails the decode anyway
+        int width = 0, height = 0;
+        if ( Texture::ReadSize( body.data(), body.size(), width, height ) )
+        {
+            estimate.cpu = (u64)width * height * 4;
+            estimate.gpu = estimate.cpu + estimate.cpu / 3;
+        }
+    }
+
+    return estimate;
+}
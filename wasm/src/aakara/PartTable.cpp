@@ -0,0 +1,59 @@
+#include <aakara/PartTable.hpp>
+
+u32 PartTable::insert( Ref<Part> part )
+{
+    return m_parts.insert( std::move( part ) );
+}
+
+Ref<Part>* PartTable::get( u32 id )
+{
+    return m_parts.get( id );
+}
+
+bool PartTable::remove( u32 id )
+{
+    Ref<Part>* part = m_parts.get( id );
+    if ( !part )
+        return false;
+
+    // entries reserved by App before the loader hands back their part are still null
+    if ( *part && !( *part )->name.empty() )
+        m_names.erase( ( *part )->name );
+
+    return m_parts.remove( id );
+}
+
+void PartTable::setName( u32 id, const string& name )
+{
+    Ref<Part>* part = m_parts.get( id );
+    if ( !part || !*part )
+        return;
+
+    if ( !( *part )->name.empty() )
+        m_names.erase( ( *part )->name );
+
+    ( *part )->name = name;
+    if ( name.empty() )
+        return;
+
+    auto [it, inserted] = m_names.emplace( name, id );
+    if ( !inserted )
+    {
+        if ( Ref<Part>* previous = m_parts.get( it->second ) )
+            ( *previous )->name.clear();
+
+        it->second = id;
+    }
+}
+
+u32 PartTable::find( const string& name ) const
+{
+    auto it = m_names.find( name );
+    return it == m_names.end() ? Invalid : it->second;
+}
+
+void PartTable::clear()
+{
+    m_parts.clear();
+    m_names.clear();
+}
@@ -0,0 +1,232 @@
+#include <numeric>
+#include <algorithm>
+
+#include <aakara/RenderList.hpp>
+#include <aakara/Renderer.hpp>
+#include <aakara/FrameArena.hpp>
+#include <aakara/MemoryBudget.hpp>
+#include <aakara/GpuBufferArena.hpp>
+
+static void Rekey( RenderEntry& entry )
+{
+    entry.key           = DrawPacket::MakeKey( entry.mesh, entry.texture );
+    entry.keyGeneration = entry.mesh->getKeyGeneration();
+}
+
+u32 RenderList::add( Mesh* mesh, Texture* texture, u32 transform )
+{
+    u32 handle = Invalid;
+
+    if ( !m_free.empty() )
+    {
+        handle = m_free.back();
+        m_free.pop_back();
+    }
+    else
+    {
+        handle = (u32)m_indices.size();
+        m_indices.push_back( Invalid );
+        m_nextShared.push_back( Invalid );
+        m_dirtyIndex.push_back( Invalid );
+    }
+
+    RenderEntry entry;
+    entry.mesh      = mesh;
+    entry.texture   = texture;
+    entry.transform = transform;
+    entry.hidden    = transform < m_hidden.size() ? m_hidden[transform] : 0;
+    Rekey( entry );
+
+    m_indices[handle] = (u32)m_entries.size();
+    m_entries.push_back( entry );
+    m_handles.push_back( handle );
+
+    if ( transform >= m_byTransform.size() )
+        m_byTransform.resize( transform + 1, Invalid );
+    m_nextShared[handle]     = m_byTransform[transform];
+    m_byTransform[transform] = handle;
+
+    markBoundsDirty( handle );
+
+    m_unsorted = true;
+    m_version++;
+
+    return handle;
+}
+
+void RenderList::remove( u32 handle )
+{
+    if ( handle >= m_indices.size() || m_indices[handle] == Invalid )
+        return;
+
+    u32 index = m_indices[handle];
+    u32 last  = (u32)m_entries.size() - 1;
+
+    unlinkTransform( handle, m_entries[index].transform );
+
+    if ( index != last )
+    {
+        m_entries[index]            = m_entries[last];
+        m_handles[index]            = m_handles[last];
+        m_indices[m_handles[index]] = index;
+        m_unsorted                  = true;
+    }
+
+    m_entries.pop_back();
+    m_handles.pop_back();
+
+    m_indices[handle] = Invalid;
+    m_free.push_back( handle );
+
+    u32 dirty = m_dirtyIndex[handle];
+    if ( dirty != Invalid )
+    {
+        m_boundsDirty[dirty]               = m_boundsDirty.back();
+        m_dirtyIndex[m_boundsDirty[dirty]] = dirty;
+        m_boundsDirty.pop_back();
+        m_dirtyIndex[handle] = Invalid;
+    }
+
+    m_version++;
+}
+
+void RenderList::setMesh( u32 handle, Mesh* mesh )
+{
+    RenderEntry& entry = get( handle );
+
+    entry.mesh = mesh;
+    Rekey( entry );
+
+    markBoundsDirty( handle );
+
+    m_unsorted = true;
+    m_version++;
+}
+
+void RenderList::setTexture( u32 handle, Texture* texture )
+{
+    RenderEntry& entry = get( handle );
+
+    entry.texture = texture;
+    Rekey( entry );
+
+    m_unsorted = true;
+    m_version++;
+}
+
+void RenderList::setHidden( u32 transform, bool hidden )
+{
+    if ( transform >= m_hidden.size() )
+    {
+        if ( !hidden )
+            return;
+        m_hidden.resize( transform + 1, 0 );
+    }
+
+    if ( m_hidden[transform] == (u8)hidden )
+        return;
+
+    m_hidden[transform] = hidden;
+
+    if ( transform < m_byTransform.size() )
+    {
+        for ( u32 handle = m_byTransform[transform]; handle != Invalid; handle = m_nextShared[handle] )
+            get( handle ).hidden = hidden;
+    }
+
+    m_version++;
+}
+
+void RenderList::markTransformsChanged( const Array<u32>& slots )
+{
+    for ( u32 slot : slots )
+    {
+        if ( slot >= m_byTransform.size() )
+            continue;
+
+        for ( u32 handle = m_byTransform[slot]; handle != Invalid; handle = m_nextShared[handle] )
+            markBoundsDirty( handle );
+    }
+}
+
+void RenderList::sort( FrameArena& scratch )
+{
+    rekeyMoved();
+
+    if ( !m_unsorted )
+        return;
+
+    size_t count = m_entries.size();
+
+    FrameArray<u32> order( count, 0, scratch );
+    std::iota( order.begin(), order.end(), 0 );
+    std::sort( order.begin(), order.end(),
+        [this]( u32 a, u32 b ) { return m_entries[a].key < m_entries[b].key; } );
+
+    FrameArray<RenderEntry> entries( m_entries.begin(), m_entries.end(), scratch );
+    FrameArray<u32>         handles( m_handles.begin(), m_handles.end(), scratch );
+
+    for ( u32 i = 0; i < count; i++ )
+    {
+        m_entries[i]            = entries[order[i]];
+        m_handles[i]            = handles[order[i]];
+        m_indices[m_handles[i]] = i;
+    }
+
+    m_unsorted = false;
+    m_version++;
+}
+
+void RenderList::clearBoundsDirty()
+{
+    for ( u32 handle : m_boundsDirty )
+        m_dirtyIndex[handle] = Invalid;
+
+    m_boundsChanged.swap( m_boundsDirty );
+    m_boundsDirty.clear();
+}
+
+size_t RenderList::memoryBytes() const
+{
+    return Memory::BytesOf( m_entries ) + Memory::BytesOf( m_handles ) + Memory::BytesOf( m_indices )
+           + Memory::BytesOf( m_free ) + Memory::BytesOf( m_byTransform ) + Memory::BytesOf( m_nextShared )
+           + Memory::BytesOf( m_hidden ) + Memory::BytesOf( m_boundsDirty ) + Memory::BytesOf( m_dirtyIndex )
+           + Memory::BytesOf( m_boundsChanged );
+}
+
+void RenderList::rekeyMoved()
+{
+    u64 moves = GpuBufferArena::Instance().moves();
+    if ( moves == m_arenaMoves )
+        return;
+
+    m_arenaMoves = moves;
+
+    for ( RenderEntry& entry : m_entries )
+    {
+        if ( entry.keyGeneration == entry.mesh->getKeyGeneration() )
+            continue;
+
+        Rekey( entry );
+        m_unsorted = true;
+    }
+}
+
+void RenderList::markBoundsDirty( u32 handle )
+{
+    if ( m_dirtyIndex[handle] != Invalid )
+        return;
+
+    m_dirtyIndex[handle] = (u32)m_boundsDirty.size();
+    m_boundsDirty.push_back( handle );
+}
+
+void RenderList::unlinkTransform( u32 handle, u32 transform )
+{
+    u32* link = &m_byTransform[transform];
+    while ( *link != handle )
+        link = &m_nextShared[*link];
+
+    *link                = m_nextShared[handle];
+    m_nextShared[handle] = Invalid;
+}
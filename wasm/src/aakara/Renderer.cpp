@@ -10,7 +10,6 @@
 #include <aakara/Renderer.hpp>
 #include <aakara/Texture.hpp>
 #include <aakara/fetch.hpp>
-#include <aakara/Transform.hpp>
 
 std::string readFile( FILE* file )
 {
@@ -90,7 +89,7 @@ bool Renderer::init()
     }
 }
 
-void Renderer::drawItems( std::queue<RenderCmd>& queue, Ptr<Camera> camera, Ptr<Light> light )
+void Renderer::submit( const Array<DrawPacket>& packets, Ptr<Camera> camera, Ptr<Light> light )
 {
     activateContext();
 
@@ -98,55 +97,48 @@ void Renderer::drawItems( std::queue<RenderCmd>& queue, Ptr<Camera> camera, Ptr<
 
     glViewport( 0, 0, camera->Viewport.x, camera->Viewport.y );
 
-    Ptr<Mesh>      mesh      = nullptr;
-    Ptr<Transform> transform = nullptr;
-    Ptr<Texture>   texture   = nullptr;
-
     m_skybox->Draw( camera );
 
-    u32 shaderId = m_shader->GetID();
+    // the skybox binds a vertex buffer of its own
+    GpuBufferArena::Instance().resetBinding();
+
     m_shader->Bind();
     {
         light->Bind( m_shader.get() );
 
-        while ( !queue.empty() )
-        {
-            // log_stream.clear();
-            RenderCmd cmd = queue.front();
-            queue.pop();
+        m_shader->SetInt( "diffuseTex", 0 );
+        m_shader->SetMatrix( "view", camera->GetView() );
+        m_shader->SetMatrix( "proj", camera->GetPerspectiveProjection() );
 
-            mesh      = cmd.mesh;
-            transform = cmd.transform;
-            texture   = cmd.texture;
+        // looked up once: the loop below runs per packet
+        i32 model = m_shader->GetUniformLocation( "model" );
 
-            if ( !mesh->Bind( m_shader.get() ) )
+        Mesh*    boundMesh    = nullptr;
+        Texture* boundTexture = nullptr;
+
+        for ( const DrawPacket& packet : packets )
+        {
+            if ( packet.mesh != boundMesh )
             {
-                emscripten_console_error( "Failed to bind mesh" );
-                continue;
+                if ( !packet.mesh->Bind( m_shader.get() ) )
+                {
+                    emscripten_console_error( "Failed to bind mesh" );
+                    boundMesh = nullptr;
+                    continue;
+                }
+
+                boundMesh = packet.mesh;
             }
 
-            texture->Bind();
-            m_shader->SetInt( "diffuseTex", 0 );
-
-            glm::mat4 view       = camera->GetView();
-            glm::mat4 projection = camera->GetPerspectiveProjection();
-
-            glm::mat4 model( 1.0f );
-
-            model = glm::translate( model, transform->position );
-
-            // forward = z, right = x, top = y
-            model = glm::rotate( model, glm::radians( transform->rotation.x ), { 0.0f, 1.0f, 0.0f } );
-            model = glm::rotate( model, glm::radians( transform->rotation.y ), { 0.0f, 0.0f, 1.0f } );
-            model = glm::rotate( model, glm::radians( transform->rotation.z ), { 1.0f, 0.0f, 0.0f } );
-
-            model = glm::scale( model, transform->scale );
+            if ( packet.texture != boundTexture )
+            {
+                packet.texture->Bind();
+                boundTexture = packet.texture;
+            }
 
-            m_shader->SetMatrix( "model", model );
-            m_shader->SetMatrix( "view", view );
-            m_shader->SetMatrix( "proj", projection );
+            m_shader->SetMatrix( model, *packet.model );
 
-            mesh->Draw();
+            packet.mesh->Draw();
         }
     }
     m_shader->Unbind();
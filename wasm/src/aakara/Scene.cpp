@@ -8,6 +8,7 @@
 
 #include <aakara/Scene.hpp>
 #include <aakara/Texture.hpp>
+#include <aakara/MemoryBudget.hpp>
 
 Scene::Scene()
 {
@@ -23,6 +24,10 @@ Ptr<Scene> Scene::LoadScene( std::string filepath )
 
     const aiScene* loadedScene = importer.ReadFile( filepath, import_flags );
 
+    aiMemoryInfo imported;
+    importer.GetMemoryRequirements( imported );
+    MemoryCharge assimp( MemoryTag::Assimp, imported.total );
+
     Array<Ptr<Camera>> cameraList( loadedScene->mNumCameras );
 
     for ( size_t i = 0; i < loadedScene->mNumCameras; i++ )
@@ -48,7 +53,7 @@ Ptr<Scene> Scene::LoadScene( std::string filepath )
         cameraList[i] = camera;
     }
 
-    Array<Ptr<Texture>> textureList;
+    Array<Ref<Texture>> textureList;
 
     /* ------------------------------ Load textures ----------------------------- */
     for ( size_t i = 0; i < loadedScene->mNumMaterials; i++ )
@@ -76,8 +81,8 @@ Ptr<Scene> Scene::LoadScene( std::string filepath )
                 pixels[pixl_idx + 3] = reinterpret_cast<u8>( loadedPixel->a );
             }
 
-            Ptr<Texture> texture = std::make_shared<Texture>(
-                pixels, loadedTexture->mWidth, loadedTexture->mHeight, Texture::PixelType::RGBA );
+            Ref<Texture> texture = MakeRef<Texture>( std::move( pixels ), loadedTexture->mWidth,
+                loadedTexture->mHeight, Texture::PixelType::RGBA );
 
             // load texture to OpenGL
             texture->update();
@@ -90,7 +95,7 @@ Ptr<Scene> Scene::LoadScene( std::string filepath )
     if ( !loadedScene->HasMeshes() )
         throw std::runtime_error( importer.GetErrorString() );
 
-    Array<Ptr<Mesh>> meshList( loadedScene->mNumMeshes );
+    Array<Ref<Mesh>> meshList( loadedScene->mNumMeshes );
     for ( size_t i = 0; i < loadedScene->mNumMeshes; i++ )
     {
         aiMesh* loadedMesh = loadedScene->mMeshes[i];
@@ -98,18 +103,18 @@ Ptr<Scene> Scene::LoadScene( std::string filepath )
         u32 vertexCount = loadedMesh->mNumVertices;
         u32 faceCount   = loadedMesh->mNumFaces;
 
-        std::vector<glm::vec3> positions( vertexCount );
-        std::vector<glm::vec3> normals( vertexCount );
-        std::vector<glm::vec2> uvmap( vertexCount );
-        std::vector<u16>       indices;
+        Array<GpuVertex> vertices( vertexCount );
+        Array<u16>       indices;
 
         for ( u32 j = 0; j < vertexCount; j++ )
         {
-            positions[j]
-                = { loadedMesh->mVertices[j].x, loadedMesh->mVertices[j].y, loadedMesh->mVertices[j].z };
-            normals[j] = { loadedMesh->mNormals[j].x, loadedMesh->mNormals[j].y, loadedMesh->mNormals[j].z };
+            const aiVector3D& position = loadedMesh->mVertices[j];
+            const aiVector3D& normal   = loadedMesh->mNormals[j];
+            const aiVector3D& uv       = loadedMesh->mTextureCoords[0][j];
 
-            uvmap[j] = { loadedMesh->mTextureCoords[0][j].x, loadedMesh->mTextureCoords[0][j].y };
+            vertices[j].position = { position.x, position.y, position.z };
+            vertices[j].normal   = { normal.x, normal.y, normal.z };
+            vertices[j].uv       = { uv.x, uv.y };
         }
 
         for ( u32 j = 0; j < loadedMesh->mNumFaces; j++ )
@@ -119,13 +124,16 @@ Ptr<Scene> Scene::LoadScene( std::string filepath )
                 indices.push_back( (u16)face.mIndices[k] );
         }
 
-        meshList[i] = std::make_shared<Mesh>( positions, normals, indices, uvmap );
+        meshList[i] = MakeRef<Mesh>( std::move( vertices ), std::move( indices ) );
     }
 
     entt::registry registry;
 
+    Ptr<Scene> scene = std::make_shared<Scene>();
+
     /* ---------------------------- Create scene tree --------------------------- */
-    std::function<Ptr<SceneObject>( aiNode* )> traverseTree = [&traverseTree, &meshList]( aiNode* node )
+    std::function<Ptr<SceneObject>( aiNode*, u32 )> traverseTree
+        = [&traverseTree, &meshList, &scene]( aiNode* node, u32 parentSlot )
     {
         std::string name = node->mParent ? "ROOT" : std::string( node->mName.C_Str() );
 
@@ -138,11 +146,14 @@ Ptr<Scene> Scene::LoadScene( std::string filepath )
         sceneNode->transform->rotation = glm::vec3( rot.x, rot.y, rot.z );
         sceneNode->transform->scale    = glm::vec3( scale.x, scale.y, scale.z );
 
+        u32 slot = scene->m_transforms.create( *sceneNode->transform, parentSlot );
+        sceneNode->transform->attach( &scene->m_transforms, slot );
+
         if ( node->mNumMeshes > 0 )
-            Ptr<Mesh> mesh = meshList[*node->mMeshes];
+            Ref<Mesh> mesh = meshList[*node->mMeshes];
 
         for ( size_t i = 0; i < node->mNumChildren; i++ )
-            sceneNode->children.push_back( traverseTree( node->mChildren[i] ) );
+            sceneNode->children.push_back( traverseTree( node->mChildren[i], slot ) );
 
         return sceneNode;
     };
@@ -159,11 +170,11 @@ Ptr<Scene> Scene::LoadScene( std::string filepath )
 
     traverse( loadedScene->mRootNode, nullptr );
 
-    Ptr<SceneObject> rootNode = traverseTree( loadedScene->mRootNode );
+    Ptr<SceneObject> rootNode = traverseTree( loadedScene->mRootNode, TransformStore::Invalid );
 
-    /* -------------------- Create scene from all loaded data ------------------- */
-    Ptr<Scene> scene = std::make_shared<Scene>();
+    scene->m_transforms.update();
 
+    /* -------------------- Create scene from all loaded data ------------------- */
     scene->m_rootNode = rootNode;
     scene->m_meshes   = meshList;
     scene->m_cameras  = cameraList;
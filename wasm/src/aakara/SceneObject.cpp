@@ -9,7 +9,7 @@ SceneObject::SceneObject( std::string name )
     , name( name )
     , children()
 {
-    this->transform = std::make_shared<Transform>();
+    this->transform = MakeRef<Transform>();
 }
 
 SceneObject::~SceneObject()
@@ -2,6 +2,7 @@
 #include <webgl/webgl1.h>
 #include <glm/ext.hpp>
 #include <fstream>
+#include <cstring>
 #include <exception>
 
 #include <aakara/Shader.hpp>
@@ -59,99 +60,130 @@ void Shader::Unbind()
     glUseProgram( 0 );
 }
 
-void Shader::SetInt( std::string location, int value )
+void Shader::SetInt( const char* location, int value )
 {
-    int loc = glGetUniformLocation( m_shaderID, location.c_str() );
+    int loc = GetUniformLocation( location );
     if ( loc >= 0 )
         glUniform1i( loc, value );
 }
 
-void Shader::SetBool( std::string location, bool value )
+void Shader::SetBool( const char* location, bool value )
 {
-    int loc = glGetUniformLocation( m_shaderID, location.c_str() );
+    int loc = GetUniformLocation( location );
     if ( loc >= 0 )
         glUniform1i( loc, (int)value );
 }
 
-void Shader::SetFloat( std::string location, float value )
+void Shader::SetFloat( const char* location, float value )
 {
-    int loc = glGetUniformLocation( m_shaderID, location.c_str() );
+    int loc = GetUniformLocation( location );
     if ( loc >= 0 )
         glUniform1f( loc, value );
 }
 
-void Shader::SetVector( std::string location, glm::vec2 value )
+void Shader::SetVector( const char* location, glm::vec2 value )
 {
-    int loc = glGetUniformLocation( m_shaderID, location.c_str() );
+    int loc = GetUniformLocation( location );
     if ( loc >= 0 )
         glUniform2fv( loc, 1, &value[0] );
 }
 
-void Shader::SetVector( std::string location, glm::vec3 value )
+void Shader::SetVector( const char* location, glm::vec3 value )
 {
-    int loc = glGetUniformLocation( m_shaderID, location.c_str() );
+    int loc = GetUniformLocation( location );
     if ( loc >= 0 )
         glUniform3fv( loc, 1, &value[0] );
 }
 
-void Shader::SetVector( std::string location, glm::vec4 value )
+void Shader::SetVector( const char* location, glm::vec4 value )
 {
-    int loc = glGetUniformLocation( m_shaderID, location.c_str() );
+    int loc = GetUniformLocation( location );
     if ( loc >= 0 )
         glUniform4fv( loc, 1, &value[0] );
 }
 
-void Shader::SetVectorArray( std::string location, int size, const std::vector<glm::vec2>& values )
+void Shader::SetVectorArray( const char* location, int size, const std::vector<glm::vec2>& values )
 {
-    unsigned int loc = glGetUniformLocation( m_shaderID, location.c_str() );
+    int loc = GetUniformLocation( location );
     if ( loc >= 0 )
     {
         glUniform2fv( loc, size, (float*)( &values[0].x ) );
     }
 }
 
-void Shader::SetVectorArray( std::string location, int size, const std::vector<glm::vec3>& values )
+void Shader::SetVectorArray( const char* location, int size, const std::vector<glm::vec3>& values )
 {
-    unsigned int loc = glGetUniformLocation( m_shaderID, location.c_str() );
+    int loc = GetUniformLocation( location );
     if ( loc >= 0 )
     {
         glUniform3fv( loc, size, (float*)( &values[0].x ) );
     }
 }
 
-void Shader::SetVectorArray( std::string location, int size, const std::vector<glm::vec4>& values )
+void Shader::SetVectorArray( const char* location, int size, const std::vector<glm::vec4>& values )
 {
-    unsigned int loc = glGetUniformLocation( m_shaderID, location.c_str() );
+    int loc = GetUniformLocation( location );
     if ( loc >= 0 )
     {
         glUniform4fv( loc, size, (float*)( &values[0].x ) );
     }
 }
 
-void Shader::SetMatrix( std::string location, const glm::mat2& value )
+void Shader::SetMatrix( const char* location, const glm::mat2& value )
 {
-    int loc = glGetUniformLocation( m_shaderID, location.c_str() );
+    int loc = GetUniformLocation( location );
     if ( loc >= 0 )
         glUniformMatrix2fv( loc, 1, GL_FALSE, glm::value_ptr( value ) );
 }
 
-void Shader::SetMatrix( std::string location, const glm::mat3& value )
+void Shader::SetMatrix( const char* location, const glm::mat3& value )
 {
-    int loc = glGetUniformLocation( m_shaderID, location.c_str() );
+    int loc = GetUniformLocation( location );
     if ( loc >= 0 )
         glUniformMatrix3fv( loc, 1, GL_FALSE, glm::value_ptr( value ) );
 }
 
-void Shader::SetMatrix( std::string location, const glm::mat4& value )
+void Shader::SetMatrix( const char* location, const glm::mat4& value )
 {
-    int loc = glGetUniformLocation( m_shaderID, location.c_str() );
+    int loc = GetUniformLocation( location );
     if ( loc >= 0 )
         glUniformMatrix4fv( loc, 1, GL_FALSE, glm::value_ptr( value ) );
 }
 
-void Shader::SetVertexAttribute( const std::string& name, u32 size, u32 stride )
+void Shader::SetMatrix( i32 location, const glm::mat4& value )
 {
-    GLint attribLocation = glGetAttribLocation( m_shaderID, name.c_str() );
+    if ( location >= 0 )
+        glUniformMatrix4fv( location, 1, GL_FALSE, glm::value_ptr( value ) );
+}
+
+i32 Shader::GetUniformLocation( const char* name )
+{
+    return Lookup( m_uniforms, name, glGetUniformLocation );
+}
+
+i32 Shader::GetAttribLocation( const char* name )
+{
+    return Lookup( m_attributes, name, glGetAttribLocation );
+}
+
+i32 Shader::Lookup( Array<Location>& cache, const char* name, i32 ( *query )( u32, const char* ) )
+{
+    // a handful of names per program: a linear scan beats hashing and never allocates once warm
+    for ( const Location& entry : cache )
+    {
+        if ( std::strcmp( entry.name.c_str(), name ) == 0 )
+            return entry.location;
+    }
+
+    i32 location = query( m_shaderID, name );
+    cache.push_back( { name, location } );
+
+    return location;
+}
+
+void Shader::SetVertexAttribute( const char* name, u32 size, u32 stride )
+{
+    GLint attribLocation = GetAttribLocation( name );
     glVertexAttribPointer( //
         attribLocation,    // location
         size,              // size
@@ -163,9 +195,9 @@ void Shader::SetVertexAttribute( const std::string& name, u32 size, u32 stride )
     glEnableVertexAttribArray( attribLocation );
 }
 
-bool Shader::EnableVertexAttribute( string location )
+bool Shader::EnableVertexAttribute( const char* location )
 {
-    i32 locationIndex = glGetAttribLocation( m_shaderID, location.c_str() );
+    i32 locationIndex = GetAttribLocation( location );
     if ( !locationIndex )
         return false;
 
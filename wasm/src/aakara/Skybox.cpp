@@ -76,7 +76,9 @@ Skybox::Skybox( const string left, const string front, const string top, const s
     int width, height, channel;
     u8* pixels = nullptr;
 
-    std::function<void( const string, size_t )> LoadFace = []( const string imgpath, size_t i )
+    u64 cubemapBytes = 0;
+
+    std::function<void( const string, size_t )> LoadFace = [&cubemapBytes]( const string imgpath, size_t i )
     {
         int width, height, channel;
         u8* pixels = stbi_load( imgpath.c_str(), &width, &height, &channel, STBI_rgb );
@@ -84,6 +86,9 @@ Skybox::Skybox( const string left, const string front, const string top, const s
         glTexImage2D( GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB, width, height, 0, GL_RGB,
             GL_UNSIGNED_BYTE, pixels );
 
+        if ( pixels )
+            cubemapBytes += (u64)width * height * 3;
+
         stbi_image_free( pixels );
     };
 
@@ -96,6 +101,8 @@ Skybox::Skybox( const string left, const string front, const string top, const s
 
     glGenerateMipmap( GL_TEXTURE_CUBE_MAP );
 
+    m_cubemapCharge = MemoryCharge( MemoryTag::GpuTextures, cubemapBytes + cubemapBytes / 3 );
+
     glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
     glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR );
     glTexParameteri( GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE );
@@ -108,6 +115,8 @@ Skybox::Skybox( const string left, const string front, const string top, const s
     glBindBuffer( GL_ARRAY_BUFFER, m_VBO );
     glBufferData(
         GL_ARRAY_BUFFER, sizeof( float ) * skyboxVertices.size(), skyboxVertices.data(), GL_STATIC_DRAW );
+
+    m_vertexCharge = MemoryCharge( MemoryTag::GpuBuffers, sizeof( float ) * skyboxVertices.size() );
 }
 
 void Skybox::Draw( Ptr<Camera> camera )
@@ -1,24 +1,45 @@
 #define STB_IMAGE_IMPLEMENTATION
 
+// image decoding scratch comes from the decoding thread's arena, see DecodeArena
+#define STBI_MALLOC( size ) DecodeArena::Malloc( size )
+#define STBI_REALLOC_SIZED( pointer, size, newSize ) DecodeArena::Realloc( pointer, size, newSize )
+#define STBI_FREE( pointer ) DecodeArena::Free( pointer )
+
 #include <exception>
+#include <algorithm>
+#include <cstdint>
 #include <emscripten/fetch.h>
 #include <webgl/webgl1.h>
 
 #include <aakara/Texture.hpp>
 #include <aakara/fetch.hpp>
+#include <aakara/Binary.hpp>
+#include <aakara/DecodeArena.hpp>
 #include <stbi_image.h>
 
-Texture::Texture( const std::vector<u8>& pixels, int width, int height, PixelType pixelType )
-    : m_pixelBuffer( pixels )
+Texture::Texture( Array<u8>&& pixels, int width, int height, PixelType pixelType )
+    : m_pixelBuffer( std::move( pixels ) )
     , m_width( width )
     , m_height( height )
 {
     m_format = pixelType == PixelType::RGBA ? GL_RGBA : GL_RGB;
+
+    m_cpuCharge = MemoryCharge( MemoryTag::Textures, Memory::BytesOf( m_pixelBuffer ) );
+    m_gpuCharge = MemoryCharge( MemoryTag::GpuPending, gpuBytes() );
+}
+
+u64 Texture::gpuBytes() const
+{
+    u64 bytes = (u64)m_width * m_height * ( m_format == GL_RGBA ? 4 : 3 );
+
+    // upload() adds a mip chain to textures of even size, a third of the base level
+    return isMipmapped() ? bytes + bytes / 3 : bytes;
 }
 
 Texture::~Texture()
 {
-    glDeleteTextures( 1, &m_textureId );
+    u32 textures[] = { m_textureId, m_pendingId };
+    glDeleteTextures( 2, textures );
 };
 
 u32 Texture::getTextureId()
@@ -39,20 +60,54 @@ void Texture::Bind()
 }
 
 void Texture::update()
+{
+    u64 unlimited = UINT64_MAX;
+    upload( unlimited );
+}
+
+bool Texture::upload( u64& budget )
 {
     if ( m_textureId )
-        return;
+        return true;
+
+    // rows are read tightly packed, as decoded
+    u64 rowBytes  = (u64)m_width * ( m_format == GL_RGBA ? 4 : 3 );
+    u64 baseBytes = rowBytes * m_height;
 
-    u32 texId = 0;
-    glGenTextures( 1, &texId );
-    glBindTexture( GL_TEXTURE_2D, texId );
+    if ( !m_pendingId )
+    {
+        glGenTextures( 1, &m_pendingId );
+        glBindTexture( GL_TEXTURE_2D, m_pendingId );
 
-    glTexImage2D(
-        GL_TEXTURE_2D, 0, m_format, m_width, m_height, 0, m_format, GL_UNSIGNED_BYTE, m_pixelBuffer.data() );
+        glTexImage2D( GL_TEXTURE_2D, 0, m_format, m_width, m_height, 0, m_format, GL_UNSIGNED_BYTE, nullptr );
+    }
+    else
+    {
+        glBindTexture( GL_TEXTURE_2D, m_pendingId );
+    }
 
-    if ( m_width % 2 == 0 && m_height % 2 == 0 )
+    if ( m_uploadedRows < m_height )
+    {
+        int rows = (int)std::clamp<u64>( budget / rowBytes, 1, m_height - m_uploadedRows );
+
+        glPixelStorei( GL_UNPACK_ALIGNMENT, 1 );
+        glTexSubImage2D( GL_TEXTURE_2D, 0, 0, m_uploadedRows, m_width, rows, m_format, GL_UNSIGNED_BYTE,
+            m_pixelBuffer.data() + m_uploadedRows * rowBytes );
+
+        m_uploadedRows += rows;
+        budget -= std::min<u64>( budget, rows * rowBytes );
+
+        Memory::CountCopy( CopyStage::Upload, rows * rowBytes );
+
+        // the mip chain costs about a third of the base level again: left to the next call if it does not fit
+        if ( m_uploadedRows < m_height || ( isMipmapped() && budget < baseBytes / 3 ) )
+            return false;
+    }
+
+    if ( isMipmapped() )
     {
         glGenerateMipmap( GL_TEXTURE_2D );
+        budget -= std::min( budget, baseBytes / 3 );
     }
     else
     {
@@ -65,10 +120,43 @@ void Texture::update()
     glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE );
     glTexParameteri( GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR );
 
-    m_textureId = texId;
+    m_textureId = m_pendingId;
+    m_pendingId = 0;
+    m_gpuCharge = MemoryCharge( MemoryTag::GpuTextures, gpuBytes() );
+
+    return true;
+}
+
+/**
+ * @brief Halve an RGBA image with a 2x2 box filter, in place. Odd edges repeat their last row or column.
+ */
+static void Downscale( u8* pixels, int& width, int& height )
+{
+    int halfWidth  = std::max( width / 2, 1 );
+    int halfHeight = std::max( height / 2, 1 );
+
+    // every output pixel is read from at or after its own position, so writing in order is safe
+    for ( int y = 0; y < halfHeight; y++ )
+    {
+        const u8* row0 = pixels + (size_t)std::min( 2 * y, height - 1 ) * width * 4;
+        const u8* row1 = pixels + (size_t)std::min( 2 * y + 1, height - 1 ) * width * 4;
+
+        for ( int x = 0; x < halfWidth; x++ )
+        {
+            int x0 = std::min( 2 * x, width - 1 ) * 4;
+            int x1 = std::min( 2 * x + 1, width - 1 ) * 4;
+
+            u8* out = pixels + ( (size_t)y * halfWidth + x ) * 4;
+            for ( int c = 0; c < 4; c++ )
+                out[c] = (u8)( ( row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c] + 2 ) / 4 );
+        }
+    }
+
+    width  = halfWidth;
+    height = halfHeight;
 }
 
-Ptr<Texture> Texture::LoadFromMemory( const u8* data, u64 size )
+Ref<Texture> Texture::LoadFromMemory( const u8* data, u64 size, u32 downscale, const CancelToken* cancel )
 {
     int width, height;
     int channel;
@@ -88,18 +176,92 @@ Ptr<Texture> Texture::LoadFromMemory( const u8* data, u64 size )
         channel = GL_RGB;
     }
 
-    std::vector<u8> textureBuffer( width * height * 4 );
-    std::memcpy( textureBuffer.data(), buffer, 4 * width * height * sizeof( u8 ) );
+    bool cancelled = cancel && cancel->cancelled();
+
+    for ( u32 level = 0; level < downscale && ( width > 1 || height > 1 ) && !cancelled; level++ )
+    {
+        Downscale( buffer, width, height );
+        cancelled = cancel && cancel->cancelled();
+    }
+
+    if ( cancelled )
+    {
+        stbi_image_free( buffer );
+        throw CancelToken::Cancelled();
+    }
+
+    // the one allocation outliving the decode: the pixels, copied out of the decode arena
+    std::vector<u8> textureBuffer( buffer, buffer + (size_t)width * height * 4 );
 
     stbi_image_free( buffer );
 
-    Ptr<Texture> texture = std::make_shared<Texture>( textureBuffer, width, height,
+    Memory::CountCopy( CopyStage::Decode, textureBuffer.size() );
+
+    Ref<Texture> texture = MakeRef<Texture>( std::move( textureBuffer ), width, height,
         channel == GL_RGBA ? Texture::PixelType::RGBA : Texture::PixelType::RGB );
     texture->m_format    = channel;
 
     return texture;
 }
 
+constexpr u32 TEXTURE_BINARY_MAGIC = 0x31544B41; // "AKT1"
+
+bool Texture::ReadSize( const u8* data, u64 size, int& width, int& height )
+{
+    int channel;
+    return stbi_info_from_memory( data, (int)size, &width, &height, &channel ) == 1;
+}
+
+Ref<Texture> Texture::Deserialize( const u8* data, size_t size, u32 downscale )
+{
+    ByteReader reader( data, size );
+
+    if ( reader.read<u32>() != TEXTURE_BINARY_MAGIC )
+        throw std::runtime_error( "Not a serialized texture" );
+
+    int width  = reader.read<i32>();
+    int height = reader.read<i32>();
+    int format = reader.read<i32>();
+
+    if ( width <= 0 || height <= 0 )
+        throw std::runtime_error( "Serialized texture has no pixels" );
+
+    std::vector<u8> pixels( reader.remaining() );
+    reader.readArray( pixels.data(), pixels.size() );
+
+    Memory::CountCopy( CopyStage::Decode, pixels.size() );
+
+    // pixels are always stored as RGBA, see LoadFromMemory()
+    if ( downscale && pixels.size() == (size_t)width * height * 4 )
+    {
+        for ( u32 level = 0; level < downscale && ( width > 1 || height > 1 ); level++ )
+            Downscale( pixels.data(), width, height );
+
+        pixels.resize( (size_t)width * height * 4 );
+        pixels.shrink_to_fit();
+    }
+
+    Ref<Texture> texture = MakeRef<Texture>( std::move( pixels ), width, height,
+        format == GL_RGBA ? Texture::PixelType::RGBA : Texture::PixelType::RGB );
+    texture->m_format = format;
+
+    return texture;
+}
+
+void Texture::Serialize( Array<u8>& out ) const
+{
+    ByteWriter writer( out );
+    size_t     start = out.size();
+
+    writer.write( TEXTURE_BINARY_MAGIC );
+    writer.write( (i32)m_width );
+    writer.write( (i32)m_height );
+    writer.write( (i32)m_format );
+    writer.writeArray( m_pixelBuffer.data(), m_pixelBuffer.size() );
+
+    Memory::CountCopy( CopyStage::Cache, out.size() - start );
+}
+
 Texture::PixelType Texture::GetFormat()
 {
     switch ( m_format )
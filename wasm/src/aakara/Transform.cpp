@@ -2,15 +2,16 @@
 #include <glm/gtx/rotate_vector.hpp>
 
 #include <aakara/Transform.hpp>
+#include <aakara/TransformStore.hpp>
 
 Transform::Transform()
 {
 }
 
 Transform::Transform( const Transform& other )
-    : position( other.position )
-    , rotation( other.rotation )
-    , scale( other.scale )
+    : position( other.getPosition() )
+    , rotation( other.getRotation() )
+    , scale( other.getScale() )
 {
 }
 
@@ -21,24 +22,38 @@ Transform::Transform( glm::vec3 pos, glm::vec3 rot, glm::vec3 scale )
 {
 }
 
+Transform& Transform::operator=( const Transform& other )
+{
+    position = other.getPosition();
+    rotation = other.getRotation();
+    scale    = other.getScale();
+
+    if ( m_store )
+        m_store->set( m_slot, *this );
+
+    return *this;
+}
+
 glm::vec3 Transform::forward()
 {
+    glm::vec3 angles  = getRotation();
     glm::vec3 forward = { 0.0f, 0.0f, 1.0f };
 
-    forward = glm::rotateX( forward, this->rotation.x );
-    forward = glm::rotateY( forward, this->rotation.y );
-    forward = glm::rotateZ( forward, this->rotation.z );
+    forward = glm::rotateX( forward, angles.x );
+    forward = glm::rotateY( forward, angles.y );
+    forward = glm::rotateZ( forward, angles.z );
 
     return glm::normalize( forward );
 }
 
 glm::vec3 Transform::up()
 {
-    glm::vec3 up = { 0.0f, 1.0f, 0.0f };
+    glm::vec3 angles = getRotation();
+    glm::vec3 up     = { 0.0f, 1.0f, 0.0f };
 
-    up = glm::rotateX( up, this->rotation.x );
-    up = glm::rotateY( up, this->rotation.y );
-    up = glm::rotateZ( up, this->rotation.z );
+    up = glm::rotateX( up, angles.x );
+    up = glm::rotateY( up, angles.y );
+    up = glm::rotateZ( up, angles.z );
 
     return glm::normalize( up );
 }
@@ -48,17 +63,72 @@ glm::vec3 Transform::right()
     return glm::normalize( glm::cross( this->up(), this->forward() ) );
 }
 
+// attached transforms read back from the store, which bulk writers update directly
+
+glm::vec3 Transform::getPosition() const
+{
+    return m_store ? m_store->getPosition( m_slot ) : position;
+}
+
+glm::vec3 Transform::getRotation() const
+{
+    return m_store ? m_store->getRotation( m_slot ) : rotation;
+}
+
+glm::vec3 Transform::getScale() const
+{
+    return m_store ? m_store->getScale( m_slot ) : scale;
+}
+
+void Transform::setPosition( glm::vec3 position )
+{
+    this->position = position;
+    if ( m_store )
+        m_store->setPosition( m_slot, position );
+}
+
+void Transform::setRotation( glm::vec3 rotation )
+{
+    this->rotation = rotation;
+    if ( m_store )
+        m_store->setRotation( m_slot, rotation );
+}
+
+void Transform::setScale( glm::vec3 scale )
+{
+    this->scale = scale;
+    if ( m_store )
+        m_store->setScale( m_slot, scale );
+}
+
+void Transform::attach( TransformStore* store, u32 slot )
+{
+    m_store = store;
+    m_slot  = slot;
+}
+
+void Transform::detach()
+{
+    // keep the last values written through the store
+    position = getPosition();
+    rotation = getRotation();
+    scale    = getScale();
+
+    m_store = nullptr;
+    m_slot  = TransformStore::Invalid;
+}
+
 void translate( Ptr<Transform> transform, glm::vec3 delta )
 {
-    transform->position += delta;
+    transform->setPosition( transform->getPosition() + delta );
 }
 
 EMSCRIPTEN_BINDINGS( TRANSFORM_HPP )
 {
     emscripten::class_<Transform>( "Transform" )
-        .smart_ptr_constructor( "Transform", &std::make_shared<Transform, glm::vec3, glm::vec3, glm::vec3> )
-        .property( "position", &Transform::position )
-        .property( "rotation", &Transform::rotation )
-        .property( "scale", &Transform::scale )
+        .smart_ptr_constructor( "Transform", &MakeShared<Transform, glm::vec3, glm::vec3, glm::vec3> )
+        .property( "position", &Transform::getPosition, &Transform::setPosition )
+        .property( "rotation", &Transform::getRotation, &Transform::setRotation )
+        .property( "scale", &Transform::getScale, &Transform::setScale )
         .function( "translate", &translate );
 }
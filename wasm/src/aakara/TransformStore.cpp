@@ -0,0 +1,539 @@
+#include <cmath>
+#include <algorithm>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <aakara/TransformStore.hpp>
+#include <aakara/Transform.hpp>
+#include <aakara/MemoryBudget.hpp>
+
+#if defined( __wasm_simd128__ )
+#    include <wasm_simd128.h>
+#elif defined( __SSE2__ )
+#    include <emmintrin.h>
+#endif
+
+namespace
+{
+    /* -------------------------------------------------------------------------- */
+    /*                        4-wide float helpers per target                     */
+    /* -------------------------------------------------------------------------- */
+#if defined( __wasm_simd128__ )
+    using f32x4 = v128_t;
+
+    inline f32x4 load4( const float* p )
+    {
+        return wasm_v128_load( p );
+    }
+
+    inline void store4( float* p, f32x4 v )
+    {
+        wasm_v128_store( p, v );
+    }
+
+    inline f32x4 splat4( float v )
+    {
+        return wasm_f32x4_splat( v );
+    }
+
+    inline f32x4 make4( float x, float y, float z, float w )
+    {
+        return wasm_f32x4_make( x, y, z, w );
+    }
+
+    inline f32x4 add4( f32x4 a, f32x4 b )
+    {
+        return wasm_f32x4_add( a, b );
+    }
+
+    inline f32x4 sub4( f32x4 a, f32x4 b )
+    {
+        return wasm_f32x4_sub( a, b );
+    }
+
+    inline f32x4 mul4( f32x4 a, f32x4 b )
+    {
+        return wasm_f32x4_mul( a, b );
+    }
+
+    inline f32x4 round4( f32x4 v )
+    {
+        return wasm_f32x4_nearest( v );
+    }
+
+    inline void transpose4( f32x4& a, f32x4& b, f32x4& c, f32x4& d )
+    {
+        const f32x4 t0 = wasm_i32x4_shuffle( a, b, 0, 4, 1, 5 );
+        const f32x4 t1 = wasm_i32x4_shuffle( a, b, 2, 6, 3, 7 );
+        const f32x4 t2 = wasm_i32x4_shuffle( c, d, 0, 4, 1, 5 );
+        const f32x4 t3 = wasm_i32x4_shuffle( c, d, 2, 6, 3, 7 );
+
+        a = wasm_i32x4_shuffle( t0, t2, 0, 1, 4, 5 );
+        b = wasm_i32x4_shuffle( t0, t2, 2, 3, 6, 7 );
+        c = wasm_i32x4_shuffle( t1, t3, 0, 1, 4, 5 );
+        d = wasm_i32x4_shuffle( t1, t3, 2, 3, 6, 7 );
+    }
+#elif defined( __SSE2__ )
+    using f32x4 = __m128;
+
+    inline f32x4 load4( const float* p )
+    {
+        return _mm_loadu_ps( p );
+    }
+
+    inline void store4( float* p, f32x4 v )
+    {
+        _mm_storeu_ps( p, v );
+    }
+
+    inline f32x4 splat4( float v )
+    {
+        return _mm_set1_ps( v );
+    }
+
+    inline f32x4 make4( float x, float y, float z, float w )
+    {
+        return _mm_setr_ps( x, y, z, w );
+    }
+
+    inline f32x4 add4( f32x4 a, f32x4 b )
+    {
+        return _mm_add_ps( a, b );
+    }
+
+    inline f32x4 sub4( f32x4 a, f32x4 b )
+    {
+        return _mm_sub_ps( a, b );
+    }
+
+    inline f32x4 mul4( f32x4 a, f32x4 b )
+    {
+        return _mm_mul_ps( a, b );
+    }
+
+    inline f32x4 round4( f32x4 v )
+    {
+        return _mm_cvtepi32_ps( _mm_cvtps_epi32( v ) );
+    }
+
+    inline void transpose4( f32x4& a, f32x4& b, f32x4& c, f32x4& d )
+    {
+        _MM_TRANSPOSE4_PS( a, b, c, d );
+    }
+#else
+    struct f32x4
+    {
+        float v[4];
+    };
+
+    inline f32x4 load4( const float* p )
+    {
+        return { { p[0], p[1], p[2], p[3] } };
+    }
+
+    inline void store4( float* p, f32x4 v )
+    {
+        p[0] = v.v[0], p[1] = v.v[1], p[2] = v.v[2], p[3] = v.v[3];
+    }
+
+    inline f32x4 splat4( float v )
+    {
+        return { { v, v, v, v } };
+    }
+
+    inline f32x4 make4( float x, float y, float z, float w )
+    {
+        return { { x, y, z, w } };
+    }
+
+    inline f32x4 add4( f32x4 a, f32x4 b )
+    {
+        return { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } };
+    }
+
+    inline f32x4 sub4( f32x4 a, f32x4 b )
+    {
+        return { { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] } };
+    }
+
+    inline f32x4 mul4( f32x4 a, f32x4 b )
+    {
+        return { { a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] } };
+    }
+
+    inline f32x4 round4( f32x4 v )
+    {
+        return { { std::nearbyint( v.v[0] ), std::nearbyint( v.v[1] ), std::nearbyint( v.v[2] ),
+            std::nearbyint( v.v[3] ) } };
+    }
+
+    inline void transpose4( f32x4& a, f32x4& b, f32x4& c, f32x4& d )
+    {
+        f32x4 rows[4] = { a, b, c, d };
+
+        a = { { rows[0].v[0], rows[1].v[0], rows[2].v[0], rows[3].v[0] } };
+        b = { { rows[0].v[1], rows[1].v[1], rows[2].v[1], rows[3].v[1] } };
+        c = { { rows[0].v[2], rows[1].v[2], rows[2].v[2], rows[3].v[2] } };
+        d = { { rows[0].v[3], rows[1].v[3], rows[2].v[3], rows[3].v[3] } };
+    }
+#endif
+
+    /**
+     * @brief Sine and cosine of four angles given in degrees.
+     * @details The angle is wrapped to [-180, 180] and halved, where Taylor series to the 11th and 12th power
+     * are exact to float precision; the double-angle formulas then give the full angle.
+     */
+    inline void SinCos4( f32x4 degrees, f32x4& sin, f32x4& cos )
+    {
+        // radians per degree, halved
+        const f32x4 halfRadians = splat4( 3.14159265f / 360.0f );
+
+        const f32x4 turns = round4( mul4( degrees, splat4( 1.0f / 360.0f ) ) );
+        const f32x4 half  = mul4( sub4( degrees, mul4( turns, splat4( 360.0f ) ) ), halfRadians );
+        const f32x4 h2    = mul4( half, half );
+
+        f32x4 s = splat4( -1.0f / 39916800.0f );
+        s       = add4( mul4( s, h2 ), splat4( 1.0f / 362880.0f ) );
+        s       = add4( mul4( s, h2 ), splat4( -1.0f / 5040.0f ) );
+        s       = add4( mul4( s, h2 ), splat4( 1.0f / 120.0f ) );
+        s       = add4( mul4( s, h2 ), splat4( -1.0f / 6.0f ) );
+        s       = add4( mul4( s, h2 ), splat4( 1.0f ) );
+        s       = mul4( s, half );
+
+        f32x4 c = splat4( 1.0f / 479001600.0f );
+        c       = add4( mul4( c, h2 ), splat4( -1.0f / 3628800.0f ) );
+        c       = add4( mul4( c, h2 ), splat4( 1.0f / 40320.0f ) );
+        c       = add4( mul4( c, h2 ), splat4( -1.0f / 720.0f ) );
+        c       = add4( mul4( c, h2 ), splat4( 1.0f / 24.0f ) );
+        c       = add4( mul4( c, h2 ), splat4( -0.5f ) );
+        c       = add4( mul4( c, h2 ), splat4( 1.0f ) );
+
+        sin = mul4( splat4( 2.0f ), mul4( s, c ) );
+        cos = sub4( splat4( 1.0f ), mul4( splat4( 2.0f ), mul4( s, s ) ) );
+    }
+
+    /**
+     * @brief out = a * b for column-major 4x4 matrices. out may alias b.
+     */
+    inline void MultiplyMat4( const float* a, const float* b, float* out )
+    {
+        const f32x4 a0 = load4( a + 0 );
+        const f32x4 a1 = load4( a + 4 );
+        const f32x4 a2 = load4( a + 8 );
+        const f32x4 a3 = load4( a + 12 );
+
+        for ( int j = 0; j < 4; j++ )
+        {
+            const float* col = b + j * 4;
+
+            f32x4 r = mul4( a0, splat4( col[0] ) );
+            r       = add4( r, mul4( a1, splat4( col[1] ) ) );
+            r       = add4( r, mul4( a2, splat4( col[2] ) ) );
+            r       = add4( r, mul4( a3, splat4( col[3] ) ) );
+
+            store4( out + j * 4, r );
+        }
+    }
+
+    /**
+     * @brief Build T * Ry( rot.x ) * Rz( rot.y ) * Rx( rot.z ) * S of four slots into their column-major
+     * world matrices, one slot per lane.
+     * @details Same axis order the renderer has always used; rotation is given in degrees. Lanes past count
+     * repeat the last slot and are not stored.
+     */
+    inline void ComposeLocal4( const glm::vec3* t, const glm::vec3* r, const glm::vec3* s, glm::mat4* world,
+        const u32* ids, u32 count )
+    {
+        u32 id[4];
+        for ( u32 k = 0; k < 4; k++ )
+            id[k] = ids[k < count ? k : count - 1];
+
+        f32x4 sa, ca, sb, cb, sc, cc;
+        SinCos4( make4( r[id[0]].x, r[id[1]].x, r[id[2]].x, r[id[3]].x ), sa, ca );
+        SinCos4( make4( r[id[0]].y, r[id[1]].y, r[id[2]].y, r[id[3]].y ), sb, cb );
+        SinCos4( make4( r[id[0]].z, r[id[1]].z, r[id[2]].z, r[id[3]].z ), sc, cc );
+
+        const f32x4 sx = make4( s[id[0]].x, s[id[1]].x, s[id[2]].x, s[id[3]].x );
+        const f32x4 sy = make4( s[id[0]].y, s[id[1]].y, s[id[2]].y, s[id[3]].y );
+        const f32x4 sz = make4( s[id[0]].z, s[id[1]].z, s[id[2]].z, s[id[3]].z );
+
+        const f32x4 zero = splat4( 0.0f );
+        const f32x4 sasb = mul4( sa, sb );
+        const f32x4 casb = mul4( ca, sb );
+
+        // one element of a column per vector, across the lanes; the transposes turn them into one column per
+        // slot
+        f32x4 c0[4] = { mul4( ca, cb ), sb, sub4( zero, mul4( sa, cb ) ), zero };
+        f32x4 c1[4] = { sub4( mul4( sa, sc ), mul4( casb, cc ) ), mul4( cb, cc ),
+            add4( mul4( sasb, cc ), mul4( ca, sc ) ), zero };
+        f32x4 c2[4] = { add4( mul4( casb, sc ), mul4( sa, cc ) ), sub4( zero, mul4( cb, sc ) ),
+            sub4( mul4( ca, cc ), mul4( sasb, sc ) ), zero };
+
+        for ( u32 j = 0; j < 3; j++ )
+        {
+            c0[j] = mul4( c0[j], sx );
+            c1[j] = mul4( c1[j], sy );
+            c2[j] = mul4( c2[j], sz );
+        }
+
+        transpose4( c0[0], c0[1], c0[2], c0[3] );
+        transpose4( c1[0], c1[1], c1[2], c1[3] );
+        transpose4( c2[0], c2[1], c2[2], c2[3] );
+
+        for ( u32 k = 0; k < count; k++ )
+        {
+            float* out = &world[id[k]][0][0];
+
+            store4( out + 0, c0[k] );
+            store4( out + 4, c1[k] );
+            store4( out + 8, c2[k] );
+            store4( out + 12, make4( t[id[k]].x, t[id[k]].y, t[id[k]].z, 1.0f ) );
+        }
+    }
+}
+
+TransformStore::TransformStore()
+{
+}
+
+u32 TransformStore::create( const Transform& transform, u32 parent )
+{
+    u32 id = Invalid;
+
+    if ( !m_free.empty() )
+    {
+        id = m_free.back();
+        m_free.pop_back();
+    }
+    else
+    {
+        id = (u32)m_positions.size();
+
+        m_positions.emplace_back();
+        m_rotations.emplace_back();
+        m_scales.emplace_back();
+        m_world.emplace_back( 1.0f );
+        m_parents.push_back( Invalid );
+        m_firstChild.push_back( Invalid );
+        m_nextSibling.push_back( Invalid );
+        m_depths.push_back( 0 );
+        m_alive.push_back( 0 );
+        m_dirty.push_back( 0 );
+
+        m_layoutVersion++;
+    }
+
+    m_positions[id]   = transform.position;
+    m_rotations[id]   = transform.rotation;
+    m_scales[id]      = transform.scale;
+    m_parents[id]     = Invalid;
+    m_firstChild[id]  = Invalid;
+    m_nextSibling[id] = Invalid;
+    m_depths[id]      = 0;
+    m_alive[id]       = 1;
+    m_dirty[id]       = 0;
+
+    link( id, parent );
+    markDirty( id );
+
+    return id;
+}
+
+void TransformStore::destroy( u32 id )
+{
+    if ( id >= m_alive.size() || !m_alive[id] )
+        return;
+
+    unlink( id );
+
+    u32 child = m_firstChild[id];
+    while ( child != Invalid )
+    {
+        u32 next = m_nextSibling[child];
+
+        m_parents[child]     = Invalid;
+        m_nextSibling[child] = Invalid;
+        setDepth( child, 0 );
+        markDirty( child );
+
+        child = next;
+    }
+
+    m_firstChild[id] = Invalid;
+    m_alive[id]      = 0;
+    m_free.push_back( id );
+}
+
+void TransformStore::set( u32 id, const Transform& transform )
+{
+    m_positions[id] = transform.position;
+    m_rotations[id] = transform.rotation;
+    m_scales[id]    = transform.scale;
+    markDirty( id );
+}
+
+void TransformStore::setPosition( u32 id, const glm::vec3& position )
+{
+    m_positions[id] = position;
+    markDirty( id );
+}
+
+void TransformStore::setRotation( u32 id, const glm::vec3& rotation )
+{
+    m_rotations[id] = rotation;
+    markDirty( id );
+}
+
+void TransformStore::setScale( u32 id, const glm::vec3& scale )
+{
+    m_scales[id] = scale;
+    markDirty( id );
+}
+
+void TransformStore::markDirty( u32 id )
+{
+    if ( !m_alive[id] || m_dirty[id] )
+        return;
+
+    m_dirty[id] = 1;
+    m_dirtyList.push_back( id );
+}
+
+void TransformStore::markDirty( u32 first, u32 count )
+{
+    u32 end = (u32)std::min<u64>( (u64)first + count, m_alive.size() );
+
+    for ( u32 id = first; id < end; id++ )
+        markDirty( id );
+}
+
+size_t TransformStore::update()
+{
+    m_updated.clear();
+
+    if ( m_dirtyList.empty() )
+        return 0;
+
+    // Children of a dirty transform must follow it. The list grows while it is walked.
+    for ( size_t i = 0; i < m_dirtyList.size(); i++ )
+    {
+        for ( u32 child = m_firstChild[m_dirtyList[i]]; child != Invalid; child = m_nextSibling[child] )
+            markDirty( child );
+    }
+
+    for ( Array<u32>& level : m_levels )
+        level.clear();
+
+    for ( u32 id : m_dirtyList )
+    {
+        m_dirty[id] = 0;
+
+        if ( !m_alive[id] )
+            continue;
+
+        if ( m_depths[id] >= m_levels.size() )
+            m_levels.resize( m_depths[id] + 1 );
+
+        m_levels[m_depths[id]].push_back( id );
+    }
+
+    for ( const Array<u32>& level : m_levels )
+    {
+        for ( size_t i = 0; i < level.size(); i += 4 )
+        {
+            u32 count = (u32)std::min<size_t>( 4, level.size() - i );
+
+            ComposeLocal4( m_positions.data(), m_rotations.data(), m_scales.data(), m_world.data(), &level[i],
+                count );
+
+            // parents are on an earlier level, so already final
+            for ( u32 k = 0; k < count; k++ )
+            {
+                u32 id = level[i + k];
+
+                if ( m_parents[id] != Invalid )
+                    MultiplyMat4( &m_world[m_parents[id]][0][0], &m_world[id][0][0], &m_world[id][0][0] );
+            }
+        }
+
+        m_updated.insert( m_updated.end(), level.begin(), level.end() );
+    }
+
+    m_dirtyList.clear();
+
+    return m_updated.size();
+}
+
+glm::mat4 TransformStore::ComputeLocal(
+    const glm::vec3& position, const glm::vec3& rotation, const glm::vec3& scale )
+{
+    glm::mat4 model( 1.0f );
+
+    model = glm::translate( model, position );
+
+    // forward = z, right = x, top = y
+    model = glm::rotate( model, glm::radians( rotation.x ), { 0.0f, 1.0f, 0.0f } );
+    model = glm::rotate( model, glm::radians( rotation.y ), { 0.0f, 0.0f, 1.0f } );
+    model = glm::rotate( model, glm::radians( rotation.z ), { 1.0f, 0.0f, 0.0f } );
+
+    return glm::scale( model, scale );
+}
+
+void TransformStore::link( u32 id, u32 parent )
+{
+    if ( parent == Invalid || !m_alive[parent] )
+        return;
+
+    m_parents[id]        = parent;
+    m_nextSibling[id]    = m_firstChild[parent];
+    m_firstChild[parent] = id;
+
+    setDepth( id, m_depths[parent] + 1 );
+}
+
+void TransformStore::unlink( u32 id )
+{
+    u32 parent = m_parents[id];
+    if ( parent == Invalid )
+        return;
+
+    if ( m_firstChild[parent] == id )
+    {
+        m_firstChild[parent] = m_nextSibling[id];
+    }
+    else
+    {
+        u32 sibling = m_firstChild[parent];
+        while ( m_nextSibling[sibling] != id )
+            sibling = m_nextSibling[sibling];
+
+        m_nextSibling[sibling] = m_nextSibling[id];
+    }
+
+    m_parents[id]     = Invalid;
+    m_nextSibling[id] = Invalid;
+
+    setDepth( id, 0 );
+}
+
+void TransformStore::setDepth( u32 id, u16 depth )
+{
+    m_depths[id] = depth;
+
+    for ( u32 child = m_firstChild[id]; child != Invalid; child = m_nextSibling[child] )
+        setDepth( child, depth + 1 );
+}
+
+size_t TransformStore::memoryBytes() const
+{
+    size_t bytes = Memory::BytesOf( m_positions ) + Memory::BytesOf( m_rotations )
+                   + Memory::BytesOf( m_scales ) + Memory::BytesOf( m_world ) + Memory::BytesOf( m_parents )
+                   + Memory::BytesOf( m_firstChild ) + Memory::BytesOf( m_nextSibling )
+                   + Memory::BytesOf( m_depths ) + Memory::BytesOf( m_alive ) + Memory::BytesOf( m_dirty )
+                   + Memory::BytesOf( m_dirtyList ) + Memory::BytesOf( m_updated ) + Memory::BytesOf( m_free )
+                   + Memory::BytesOf( m_levels );
+
+    for ( const Array<u32>& level : m_levels )
+        bytes += Memory::BytesOf( level );
+
+    return bytes;
+}
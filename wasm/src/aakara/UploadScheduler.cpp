@@ -0,0 +1,128 @@
+#include <cstdint>
+#include <algorithm>
+#include <emscripten/emscripten.h>
+
+#include <aakara/UploadScheduler.hpp>
+#include <aakara/Part.hpp>
+#include <aakara/Mesh.hpp>
+#include <aakara/Texture.hpp>
+
+UploadScheduler::UploadScheduler( u64 bytesPerFrame, double millisecondsPerFrame )
+    : m_bytesPerFrame( bytesPerFrame )
+    , m_millisecondsPerFrame( millisecondsPerFrame )
+{
+}
+
+void UploadScheduler::setBudget( u64 bytesPerFrame, double millisecondsPerFrame )
+{
+    m_bytesPerFrame        = bytesPerFrame;
+    m_millisecondsPerFrame = millisecondsPerFrame;
+}
+
+void UploadScheduler::push( Ref<Part> part )
+{
+    m_queue.push_back( { std::move( part ), nullptr, emscripten_get_now() } );
+    m_stats.parts++;
+}
+
+void UploadScheduler::push( LoadedChunk chunk )
+{
+    m_queue.push_back( { std::move( chunk.part ), std::move( chunk.mesh ), emscripten_get_now() } );
+    m_stats.chunks++;
+}
+
+bool UploadScheduler::cancel( const Part& part )
+{
+    bool queued = false;
+
+    for ( auto it = m_queue.begin(); it != m_queue.end(); )
+    {
+        if ( it->part.get() != &part )
+        {
+            ++it;
+            continue;
+        }
+
+        if ( it->chunk )
+        {
+            m_stats.chunks--;
+        }
+        else
+        {
+            m_stats.parts--;
+            queued = true;
+        }
+
+        it = m_queue.erase( it );
+    }
+
+    return queued;
+}
+
+void UploadScheduler::run( Array<Ref<Part>>& parts, Array<LoadedChunk>& chunks )
+{
+    double start  = emscripten_get_now();
+    u64 budget = m_bytesPerFrame ? m_bytesPerFrame : UINT64_MAX;
+
+    m_stats.bytes = 0;
+
+    while ( !m_queue.empty() )
+    {
+        double elapsed   = emscripten_get_now() - start;
+        bool   outOfTime = m_millisecondsPerFrame > 0.0 && elapsed >= m_millisecondsPerFrame;
+
+        if ( m_stats.bytes && ( budget == 0 || outOfTime ) )
+            break;
+
+        Entry& entry  = m_queue.front();
+        u64    before = budget;
+        bool   done   = Upload( entry, budget );
+
+        m_stats.bytes += before - budget;
+
+        // the budget ran out part way through
+        if ( !done )
+            break;
+
+        if ( entry.chunk )
+        {
+            LoadedChunk loaded;
+            loaded.part = std::move( entry.part );
+            loaded.mesh = std::move( entry.chunk );
+
+            chunks.push_back( std::move( loaded ) );
+            m_stats.chunks--;
+        }
+        else
+        {
+            parts.push_back( std::move( entry.part ) );
+            m_stats.parts--;
+        }
+
+        m_queue.pop_front();
+    }
+
+    m_stats.milliseconds = (f32)( emscripten_get_now() - start );
+}
+
+UploadScheduler::Stats UploadScheduler::stats() const
+{
+    Stats stats = m_stats;
+    if ( !m_queue.empty() )
+        stats.stallMilliseconds = (f32)( emscripten_get_now() - m_queue.front().queuedAt );
+
+    return stats;
+}
+
+bool UploadScheduler::Upload( const Entry& entry, u64& budget )
+{
+    if ( entry.chunk )
+        return entry.chunk->upload( budget );
+
+    Part& part = *entry.part;
+
+    if ( !part.texture->upload( budget ) )
+        return false;
+
+    return !part.mesh || part.mesh->upload( budget );
+}
@@ -1,48 +1,350 @@
-#include <queue>
+#include <cctype>
+#include <cstring>
+#include <algorithm>
+#include <emscripten/fetch.h>
+#include <emscripten/threading.h>
+
 #include <aakara/fetch.hpp>
 
-std::map<std::string, std::function<void( emscripten_fetch_t* )>> cbs;
-std::queue<string>                                                fetchQueue;
+namespace
+{
+    Ptr<HTTP::Response> MakeResponse( emscripten_fetch_t* fetch )
+    {
+        Ptr<HTTP::Response> response = std::make_shared<HTTP::Response>();
 
-void onResponse( emscripten_fetch_t* fetch );
+        response->url    = fetch->url;
+        response->status = fetch->status;
 
-struct Header
-{
-    string Key;
-    string Value;
-};
+        // the body is the buffer emscripten_fetch allocated; the browser's copy into it is the only one
+        if ( fetch->data && fetch->numBytes )
+        {
+            response->body = HTTP::Body::Adopt( (u8*)fetch->data, fetch->numBytes );
+            fetch->data    = nullptr;
 
-struct FetchOptions
-{
-    Array<Header>                              headers;
-    std::function<void( emscripten_fetch_t* )> callback;
-};
+            Memory::CountCopy( CopyStage::Fetch, fetch->numBytes );
+        }
+
+        response->charge = MemoryCharge( MemoryTag::Loader, response->body.size() );
+
+        size_t length = emscripten_fetch_get_response_headers_length( fetch );
+        if ( length == 0 )
+            return response;
+
+        string raw( length + 1, '\0' );
+        emscripten_fetch_get_response_headers( fetch, &raw[0], raw.size() );
+
+        char** pairs = emscripten_fetch_unpack_response_headers( raw.c_str() );
+        for ( char** pair = pairs; pair && pair[0] && pair[1]; pair += 2 )
+            response->headers.push_back( { pair[0], pair[1] } );
+
+        emscripten_fetch_free_unpacked_response_headers( pairs );
+
+        return response;
+    }
+
+    UPtr<HTTP::Client>& DefaultClientSlot()
+    {
+        static UPtr<HTTP::Client> client
+            = std::make_unique<HTTP::Client>( std::make_shared<HTTP::FetchTransport>() );
+        return client;
+    }
+}
 
 namespace HTTP
 {
-    void GET( const std::string& url, std::function<void( emscripten_fetch_t* )> cb )
+    struct FetchTransport::Request
+    {
+        FetchTransport*    transport;
+        u32                id;
+        string             url;
+        Array<string>      headers;  // key, value, key, value ...
+        Array<const char*> cHeaders; // null-terminated view of headers
+        Done               done;
+
+        // only touched on the main thread
+        emscripten_fetch_t* fetch   = nullptr;
+        bool                aborted = false;
+    };
+
+    string Response::header( const string& key ) const
+    {
+        auto equals = []( const string& a, const string& b )
+        {
+            return a.size() == b.size()
+                && std::equal( a.begin(), a.end(), b.begin(),
+                    []( char x, char y ) { return std::tolower( x ) == std::tolower( y ); } );
+        };
+
+        for ( const Header& header : headers )
+        {
+            if ( equals( header.Key, key ) )
+                return header.Value;
+        }
+
+        return "";
+    }
+
+    u32 FetchTransport::send( const string& url, const Array<Header>& headers, Done done )
+    {
+        Request* request   = new Request();
+        request->transport = this;
+        request->url       = url;
+        request->done      = std::move( done );
+
+        for ( const Header& header : headers )
+        {
+            request->headers.push_back( header.Key );
+            request->headers.push_back( header.Value );
+        }
+
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+
+            // 0 is not an id, see Client::Outstanding
+            if ( m_nextId == 0 )
+                m_nextId = 1;
+
+            request->id = m_nextId++;
+            m_requests.emplace( request->id, request );
+        }
+
+        u32 id = request->id;
+
+        // fetch callbacks run on the starting thread's event loop, which only the main thread returns to
+        if ( emscripten_is_main_runtime_thread() )
+            Start( request );
+        else
+            emscripten_async_run_in_main_runtime_thread( EM_FUNC_SIG_VI, Start, request );
+
+        return id;
+    }
+
+    void FetchTransport::abort( u32 request )
     {
+        if ( emscripten_is_main_runtime_thread() )
+            Abort( this, request );
+        else
+            emscripten_async_run_in_main_runtime_thread( EM_FUNC_SIG_VII, Abort, this, request );
+    }
+
+    void FetchTransport::Start( void* pending )
+    {
+        Request*        request   = static_cast<Request*>( pending );
+        FetchTransport* transport = request->transport;
+        u32             id        = request->id;
+
+        // aborted before it could start
+        if ( request->aborted )
+        {
+            std::lock_guard<std::mutex> lock( transport->m_mutex );
+            transport->m_requests.erase( id );
+
+            delete request;
+            return;
+        }
+
         emscripten_fetch_attr_t attr;
         emscripten_fetch_attr_init( &attr );
+
         std::strcpy( attr.requestMethod, "GET" );
         attr.attributes = EMSCRIPTEN_FETCH_LOAD_TO_MEMORY;
+        attr.userData   = request;
+        attr.onsuccess  = OnDone;
+        attr.onerror    = OnDone;
 
-        attr.onsuccess = onResponse;
-        attr.onerror   = onResponse;
+        if ( !request->headers.empty() )
+        {
+            for ( const string& value : request->headers )
+                request->cHeaders.push_back( value.c_str() );
 
-        cbs[url] = cb;
+            request->cHeaders.push_back( nullptr );
+            attr.requestHeaders = request->cHeaders.data();
+        }
 
-        // emscripten_console_log( "Starting fetch..." );
-        emscripten_fetch( &attr, url.c_str() );
+        emscripten_fetch_t* fetch = emscripten_fetch( &attr, request->url.c_str() );
+
+        // a fetch failing straight away has already been reported, and its request deleted
+        std::lock_guard<std::mutex> lock( transport->m_mutex );
+
+        auto it = transport->m_requests.find( id );
+        if ( it != transport->m_requests.end() )
+            it->second->fetch = fetch;
     }
-}
 
-void onResponse( emscripten_fetch_t* fetch )
-{
-    std::string url( fetch->url );
+    void FetchTransport::Abort( FetchTransport* transport, u32 id )
+    {
+        Request* request = nullptr;
+        {
+            std::lock_guard<std::mutex> lock( transport->m_mutex );
+
+            auto it = transport->m_requests.find( id );
+            if ( it == transport->m_requests.end() )
+                return;
+
+            request          = it->second;
+            request->aborted = true;
+
+            // not started yet: Start() drops it
+            if ( !request->fetch )
+                return;
+
+            transport->m_requests.erase( it );
+        }
+
+        // reports the fetch as an error to OnDone(), which leaves the aborted request alone
+        emscripten_fetch_close( request->fetch );
+        delete request;
+    }
+
+    void FetchTransport::OnDone( emscripten_fetch_t* fetch )
+    {
+        Request* request = static_cast<Request*>( fetch->userData );
+        if ( request->aborted )
+            return;
 
-    auto func = cbs[url];
-    func( fetch );
+        {
+            std::lock_guard<std::mutex> lock( request->transport->m_mutex );
+            request->transport->m_requests.erase( request->id );
+        }
 
-    cbs.erase( url );
+        Ptr<Response> response = MakeResponse( fetch );
+
+        emscripten_fetch_close( fetch );
+
+        request->done( response );
+        delete request;
+    }
+
+    Client::Client( Ptr<Transport> transport )
+        : m_transport( transport )
+    {
+    }
+
+    u64 Client::get( const string& url, const FetchOptions& options )
+    {
+        string key = url;
+        for ( const Header& header : options.headers )
+            key += "\n" + header.Key + ": " + header.Value;
+
+        u64  ticket = 0;
+        bool first  = false;
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+
+            ticket = m_nextTicket++;
+
+            Outstanding& outstanding = m_outstanding[key];
+
+            first = outstanding.waiters.empty();
+            if ( first )
+                outstanding.id = ticket;
+
+            outstanding.waiters.push_back( { ticket, options.callback } );
+            m_tickets.emplace( ticket, key );
+        }
+
+        if ( !first )
+            return ticket;
+
+        u32 request = m_transport->send( url, options.headers,
+            [this, key, ticket]( Ptr<Response> response ) { complete( key, ticket, response ); } );
+
+        // unless it already completed, or every waiter cancelled meanwhile
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        auto it = m_outstanding.find( key );
+        if ( it != m_outstanding.end() && it->second.id == ticket )
+            it->second.request = request;
+
+        return ticket;
+    }
+
+    bool Client::cancel( u64 ticket )
+    {
+        u32 request = 0;
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+
+            auto key = m_tickets.find( ticket );
+            if ( key == m_tickets.end() )
+                return false;
+
+            auto           it      = m_outstanding.find( key->second );
+            Array<Waiter>& waiters = it->second.waiters;
+
+            waiters.erase( std::find_if( waiters.begin(), waiters.end(),
+                [ticket]( const Waiter& waiter ) { return waiter.ticket == ticket; } ) );
+            m_tickets.erase( key );
+
+            // a request still being sent cannot be aborted; its response is ignored instead
+            if ( waiters.empty() )
+            {
+                request = it->second.request;
+                m_outstanding.erase( it );
+            }
+        }
+
+        if ( request )
+            m_transport->abort( request );
+
+        return true;
+    }
+
+    size_t Client::getInFlight()
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        return m_outstanding.size();
+    }
+
+    void Client::complete( const string& key, u64 id, Ptr<Response> response )
+    {
+        Array<Waiter> waiters;
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+
+            // gone if every waiter cancelled; the key may have been requested again since
+            auto it = m_outstanding.find( key );
+            if ( it == m_outstanding.end() || it->second.id != id )
+                return;
+
+            waiters.swap( it->second.waiters );
+            m_outstanding.erase( it );
+
+            for ( const Waiter& waiter : waiters )
+                m_tickets.erase( waiter.ticket );
+        }
+
+        Ptr<const Response> shared = response;
+
+        for ( const Waiter& waiter : waiters )
+        {
+            if ( waiter.callback )
+                waiter.callback( shared );
+        }
+    }
+
+    Client& DefaultClient()
+    {
+        return *DefaultClientSlot();
+    }
+
+    void SetTransport( Ptr<Transport> transport )
+    {
+        DefaultClientSlot() = std::make_unique<Client>( transport );
+    }
+
+    u64 GET( const string& url, Callback cb )
+    {
+        return DefaultClient().get( url, FetchOptions { {}, cb } );
+    }
+
+    u64 GET( const string& url, const FetchOptions& options )
+    {
+        return DefaultClient().get( url, options );
+    }
+
+    bool Cancel( u64 ticket )
+    {
+        return DefaultClient().cancel( ticket );
+    }
 }
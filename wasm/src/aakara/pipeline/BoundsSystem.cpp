@@ -0,0 +1,30 @@
+#include "BoundsSystem.hpp"
+#include "FrameContext.hpp"
+#include "Parallel.hpp"
+
+#include <aakara/Mesh.hpp>
+#include <aakara/RenderList.hpp>
+#include <aakara/TransformStore.hpp>
+
+void BoundsSystem::Execute( FrameContext& frame )
+{
+    RenderList& list = *frame.renderList;
+
+    list.markTransformsChanged( frame.transforms->updated() );
+
+    const Array<u32>& dirty = list.boundsDirty();
+
+    ParallelFor( frame.jobs, dirty.size(), 256,
+        [&frame, &list, &dirty]( size_t begin, size_t end )
+        {
+            for ( size_t i = begin; i < end; i++ )
+            {
+                RenderEntry&     entry = list.get( dirty[i] );
+                const glm::mat4& world = frame.transforms->getWorld( entry.transform );
+
+                entry.bounds = entry.mesh->LocalBounds.transformed( world );
+            }
+        } );
+
+    list.clearBoundsDirty();
+}
@@ -0,0 +1,25 @@
+#ifndef BOUNDSSYSTEM_HPP
+#define BOUNDSSYSTEM_HPP
+
+#include "ISystem.hpp"
+
+/**
+ * @brief Refreshes the world bounds of render entries whose transform or mesh changed.
+ */
+class BoundsSystem : public ISystem
+{
+public:
+    void Execute( FrameContext& frame ) override;
+
+    u32 Reads() const override
+    {
+        return Component::Transform;
+    }
+
+    u32 Writes() const override
+    {
+        return Component::Bounds;
+    }
+};
+
+#endif
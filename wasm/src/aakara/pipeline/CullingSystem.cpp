@@ -0,0 +1,81 @@
+#include "CullingSystem.hpp"
+#include "FrameContext.hpp"
+#include "Parallel.hpp"
+
+#include <atomic>
+#include <cstring>
+#include <glm/glm.hpp>
+#include <aakara/Camera.hpp>
+#include <aakara/Frustum.hpp>
+#include <aakara/RenderList.hpp>
+
+CullingSystem::CullingSystem( Ptr<Camera> camera )
+    : m_camera( camera )
+{
+}
+
+static u8 IsVisible( const RenderEntry& entry, const Frustum& frustum )
+{
+    return !entry.hidden && frustum.intersects( entry.bounds ) ? 1 : 0;
+}
+
+void CullingSystem::Execute( FrameContext& frame )
+{
+    RenderList& list = *frame.renderList;
+    glm::mat4   m    = m_camera->GetPerspectiveProjection() * m_camera->GetView();
+
+    if ( list.version() == m_lastVersion && std::memcmp( &m, &m_lastViewProjection, sizeof( m ) ) == 0 )
+    {
+        executeChanged( frame, m );
+        return;
+    }
+
+    m_lastVersion        = list.version();
+    m_lastViewProjection = m;
+
+    Frustum frustum = Frustum::FromMatrix( m );
+
+    Array<RenderEntry>& entries = list.entries();
+
+    ParallelFor( frame.jobs, entries.size(), 512,
+        [&entries, &frustum]( size_t begin, size_t end )
+        {
+            for ( size_t i = begin; i < end; i++ )
+                entries[i].visible = IsVisible( entries[i], frustum );
+        } );
+
+    frame.visibilityVersion++;
+}
+
+void CullingSystem::executeChanged( FrameContext& frame, const glm::mat4& viewProjection )
+{
+    RenderList&       list    = *frame.renderList;
+    const Array<u32>& changed = list.boundsChanged();
+
+    if ( changed.empty() )
+        return;
+
+    Frustum frustum = Frustum::FromMatrix( viewProjection );
+
+    std::atomic<bool> flipped( false );
+
+    ParallelFor( frame.jobs, changed.size(), 512,
+        [&list, &changed, &frustum, &flipped]( size_t begin, size_t end )
+        {
+            for ( size_t i = begin; i < end; i++ )
+            {
+                RenderEntry& entry   = list.get( changed[i] );
+                u8           visible = IsVisible( entry, frustum );
+
+                if ( entry.visible != visible )
+                {
+                    entry.visible = visible;
+                    flipped.store( true, std::memory_order_relaxed );
+                }
+            }
+        } );
+
+    // the draw list only has to be rebuilt when an entry appeared or disappeared
+    if ( flipped.load( std::memory_order_relaxed ) )
+        frame.visibilityVersion++;
+}
@@ -0,0 +1,39 @@
+#ifndef CULLINGSYSTEM_HPP
+#define CULLINGSYSTEM_HPP
+
+#include "ISystem.hpp"
+#include <utils.h>
+#include <glm/mat4x4.hpp>
+
+class Camera;
+
+/**
+ * @brief Marks render entries whose world bounds lie outside the camera frustum as invisible. When neither
+ * the camera nor the render list changed since the last run, only entries whose bounds changed are tested.
+ */
+class CullingSystem : public ISystem
+{
+public:
+    CullingSystem( Ptr<Camera> camera );
+
+    void Execute( FrameContext& frame ) override;
+
+    u32 Reads() const override
+    {
+        return Component::Bounds | Component::Camera;
+    }
+
+    u32 Writes() const override
+    {
+        return Component::Visibility;
+    }
+
+private:
+    Ptr<Camera> m_camera;
+    glm::mat4   m_lastViewProjection = glm::mat4( 0.0f );
+    u64         m_lastVersion        = ~0ull;
+
+    void executeChanged( FrameContext& frame, const glm::mat4& viewProjection );
+};
+
+#endif
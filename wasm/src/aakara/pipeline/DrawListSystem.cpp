@@ -0,0 +1,61 @@
+#include "DrawListSystem.hpp"
+#include "FrameContext.hpp"
+#include "Parallel.hpp"
+
+#include <aakara/RenderList.hpp>
+#include <aakara/TransformStore.hpp>
+
+constexpr size_t DRAWLIST_GRAIN = 512;
+
+void DrawListSystem::Execute( FrameContext& frame )
+{
+    RenderList& list = *frame.renderList;
+
+    if ( list.version() == m_lastVersion && frame.visibilityVersion == m_lastVisibilityVersion
+         && frame.lodVersion == m_lastLodVersion )
+        return;
+
+    m_lastVersion           = list.version();
+    m_lastVisibilityVersion = frame.visibilityVersion;
+    m_lastLodVersion        = frame.lodVersion;
+
+    const Array<RenderEntry>& entries = list.entries();
+
+    size_t chunks = ( entries.size() + DRAWLIST_GRAIN - 1 ) / DRAWLIST_GRAIN;
+    if ( frame.chunkPackets.size() < chunks )
+        frame.chunkPackets.resize( chunks );
+
+    /* ------------------------- Prepare: record packets ------------------------ */
+    ParallelFor( frame.jobs, entries.size(), DRAWLIST_GRAIN,
+        [&frame, &entries]( size_t begin, size_t end )
+        {
+            Array<DrawPacket>& packets = frame.chunkPackets[begin / DRAWLIST_GRAIN];
+            packets.clear();
+
+            for ( size_t i = begin; i < end; i++ )
+            {
+                const RenderEntry& entry = entries[i];
+
+                if ( !entry.visible || entry.lod == Lod::Culled )
+                    continue;
+
+                const glm::mat4* model = &frame.transforms->getWorld( entry.transform );
+
+                packets.push_back( { entry.key, entry.mesh, entry.texture, model } );
+            }
+        } );
+
+    /* ---------------------------------- Merge --------------------------------- */
+    size_t total = 0;
+    for ( size_t c = 0; c < chunks; c++ )
+        total += frame.chunkPackets[c].size();
+
+    frame.packets.clear();
+    frame.packets.reserve( total );
+
+    for ( size_t c = 0; c < chunks; c++ )
+    {
+        const Array<DrawPacket>& chunk = frame.chunkPackets[c];
+        frame.packets.insert( frame.packets.end(), chunk.begin(), chunk.end() );
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef DRAWLISTSYSTEM_HPP
+#define DRAWLISTSYSTEM_HPP
+
+#include "ISystem.hpp"
+#include <utils.h>
+
+/**
+ * @brief Records a draw packet for every visible render entry, in parallel chunks, and merges them into the
+ * frame's draw list. Entries are already in sort-key order, so the merged list needs no sorting. The list is
+ * only rebuilt when the entries, their visibility or their LOD changed.
+ */
+class DrawListSystem : public ISystem
+{
+public:
+    void Execute( FrameContext& frame ) override;
+
+    u32 Reads() const override
+    {
+        return Component::Transform | Component::Visibility | Component::Lod;
+    }
+
+    u32 Writes() const override
+    {
+        return Component::DrawList;
+    }
+
+private:
+    u64 m_lastVersion           = ~0ull;
+    u64 m_lastVisibilityVersion = ~0ull;
+    u64 m_lastLodVersion        = ~0ull;
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef FRAMECONTEXT_HPP
+#define FRAMECONTEXT_HPP
+
+#include <utils.h>
+#include <aakara/Renderer.hpp>
+#include <aakara/FrameArena.hpp>
+
+class JobSystem;
+class TransformStore;
+class RenderList;
+
+namespace Lod
+{
+    /**
+     * @brief Level assigned to parts too small on screen to be drawn.
+     */
+    constexpr u8 Culled = 0xFF;
+}
+
+/**
+ * @brief Data shared by the systems of a RenderPipeline for one frame.
+ */
+struct FrameContext
+{
+    JobSystem*      jobs       = nullptr;
+    TransformStore* transforms = nullptr;
+    RenderList*     renderList = nullptr;
+
+    /**
+     * @brief Scratch memory for the frame, reset by App::draw() before anything else runs.
+     */
+    FrameArena arena;
+
+    /**
+     * @brief Incremented by the culling and LOD systems when they rewrote the retained entries.
+     */
+    u64 visibilityVersion = 0;
+    u64 lodVersion        = 0;
+
+    /**
+     * @brief Packets recorded per chunk of entries, merged into FrameContext::packets.
+     */
+    Array<Array<DrawPacket>> chunkPackets;
+    Array<DrawPacket>        packets;
+};
+
+#endif
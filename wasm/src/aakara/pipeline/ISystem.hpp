@@ -1,12 +1,48 @@
 #ifndef ISYSTEM_HPP
 #define ISYSTEM_HPP
 
-#include <entt/entity/registry.hpp>
+#include <utils.h>
+
+struct FrameContext;
+
+/**
+ * @brief Component groups a system can read or write. RenderPipeline orders systems whose accesses
+ * conflict and runs the rest in parallel.
+ */
+namespace Component
+{
+    constexpr u32 Transform  = 1 << 0;
+    constexpr u32 Bounds     = 1 << 1;
+    constexpr u32 Visibility = 1 << 2;
+    constexpr u32 Lod        = 1 << 3;
+    constexpr u32 DrawList   = 1 << 4;
+    constexpr u32 Camera     = 1 << 5;
+}
 
 class ISystem
 {
 public:
-    virtual void Execute(entt::registry* entities) = 0;
+    virtual ~ISystem() = default;
+
+    virtual void Execute( FrameContext& frame ) = 0;
+
+    /**
+     * @brief Component mask this system reads.
+     */
+    virtual u32 Reads() const = 0;
+
+    /**
+     * @brief Component mask this system writes.
+     */
+    virtual u32 Writes() const = 0;
+
+    /**
+     * @brief Whether the system issues GL calls and therefore has to run on the context thread.
+     */
+    virtual bool RequiresContext() const
+    {
+        return false;
+    }
 };
 
 #endif
@@ -0,0 +1,95 @@
+#include "LodSystem.hpp"
+#include "FrameContext.hpp"
+#include "Parallel.hpp"
+
+#include <atomic>
+#include <glm/glm.hpp>
+#include <aakara/Camera.hpp>
+#include <aakara/RenderList.hpp>
+
+LodSystem::LodSystem( Ptr<Camera> camera, const Array<f32>& thresholds, f32 minPixels )
+    : m_camera( camera )
+    , m_thresholds( thresholds )
+    , m_minPixels( minPixels )
+{
+}
+
+void LodSystem::Execute( FrameContext& frame )
+{
+    RenderList& list = *frame.renderList;
+    glm::vec3   eye  = m_camera->transform->position;
+
+    // Pixels covered by a unit-diameter object at unit distance
+    f32 pixelScale = m_camera->GetPerspectiveProjection()[1][1] * m_camera->Viewport.y * 0.5f;
+
+    if ( list.version() == m_lastVersion && eye == m_lastEye && pixelScale == m_lastPixelScale )
+    {
+        executeChanged( frame, eye, pixelScale );
+        return;
+    }
+
+    m_lastVersion    = list.version();
+    m_lastEye        = eye;
+    m_lastPixelScale = pixelScale;
+
+    Array<RenderEntry>& entries = list.entries();
+
+    ParallelFor( frame.jobs, entries.size(), 512,
+        [&entries, this, eye, pixelScale]( size_t begin, size_t end )
+        {
+            for ( size_t i = begin; i < end; i++ )
+                entries[i].lod = levelOf( entries[i], eye, pixelScale );
+        } );
+
+    frame.lodVersion++;
+}
+
+void LodSystem::executeChanged( FrameContext& frame, const glm::vec3& eye, f32 pixelScale )
+{
+    RenderList&       list    = *frame.renderList;
+    const Array<u32>& changed = list.boundsChanged();
+
+    if ( changed.empty() )
+        return;
+
+    std::atomic<bool> switched( false );
+
+    ParallelFor( frame.jobs, changed.size(), 512,
+        [&list, &changed, &switched, this, eye, pixelScale]( size_t begin, size_t end )
+        {
+            for ( size_t i = begin; i < end; i++ )
+            {
+                RenderEntry& entry = list.get( changed[i] );
+                u8           level = levelOf( entry, eye, pixelScale );
+
+                if ( entry.lod != level )
+                {
+                    entry.lod = level;
+                    switched.store( true, std::memory_order_relaxed );
+                }
+            }
+        } );
+
+    if ( switched.load( std::memory_order_relaxed ) )
+        frame.lodVersion++;
+}
+
+u8 LodSystem::levelOf( const RenderEntry& entry, const glm::vec3& eye, f32 pixelScale ) const
+{
+    f32 radius   = glm::length( entry.bounds.extents() );
+    f32 distance = glm::distance( eye, entry.bounds.center() );
+
+    if ( distance <= radius )
+        return 0;
+
+    f32 pixels = 2.0f * radius / distance * pixelScale;
+
+    if ( pixels < m_minPixels )
+        return Lod::Culled;
+
+    u8 level = 0;
+    while ( level < m_thresholds.size() && pixels < m_thresholds[level] )
+        level++;
+
+    return level;
+}
@@ -0,0 +1,51 @@
+#ifndef LODSYSTEM_HPP
+#define LODSYSTEM_HPP
+
+#include "ISystem.hpp"
+#include <utils.h>
+#include <glm/vec3.hpp>
+
+class Camera;
+struct RenderEntry;
+
+/**
+ * @brief Selects a level of detail per part from its projected size on screen.
+ * @details Level 0 is full detail and each threshold passed drops one level. Parts smaller than the
+ * minimum pixel size get Lod::Culled and are not drawn. When neither the camera nor the render list changed
+ * since the last run, only entries whose bounds changed are updated.
+ */
+class LodSystem : public ISystem
+{
+public:
+    /**
+     * @param camera Camera the parts are viewed through.
+     * @param thresholds Descending projected diameters in pixels at which the next level is selected.
+     * @param minPixels Projected diameter in pixels under which a part is skipped.
+     */
+    LodSystem( Ptr<Camera> camera, const Array<f32>& thresholds = {}, f32 minPixels = 1.0f );
+
+    void Execute( FrameContext& frame ) override;
+
+    u32 Reads() const override
+    {
+        return Component::Bounds | Component::Camera;
+    }
+
+    u32 Writes() const override
+    {
+        return Component::Lod;
+    }
+
+private:
+    Ptr<Camera> m_camera;
+    Array<f32>  m_thresholds;
+    f32         m_minPixels;
+    glm::vec3   m_lastEye        = glm::vec3( 0.0f );
+    f32         m_lastPixelScale = 0.0f;
+    u64         m_lastVersion    = ~0ull;
+
+    void executeChanged( FrameContext& frame, const glm::vec3& eye, f32 pixelScale );
+    u8   levelOf( const RenderEntry& entry, const glm::vec3& eye, f32 pixelScale ) const;
+};
+
+#endif
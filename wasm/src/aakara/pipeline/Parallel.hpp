@@ -0,0 +1,31 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include <algorithm>
+#include <utils.h>
+#include <aakara/JobSystem.hpp>
+
+/**
+ * @brief Split [0, count) into chunks of grain items and run fn( begin, end ) once per chunk.
+ * @details The calling thread works on chunks as well, so completion never waits on a worker that is busy
+ * with another task (e.g. a part load).
+ *
+ * @param jobs Job system to spread chunks over. Runs serially when null.
+ * @param count Number of items.
+ * @param grain Number of items per chunk.
+ * @param fn Function called with the half-open range of each chunk.
+ */
+template <typename F> void ParallelFor( JobSystem* jobs, size_t count, size_t grain, const F& fn )
+{
+    if ( !jobs )
+    {
+        grain = std::max<size_t>( grain, 1 );
+        for ( size_t begin = 0; begin < count; begin += grain )
+            fn( begin, std::min( begin + grain, count ) );
+        return;
+    }
+
+    jobs->parallelFor( count, grain, fn );
+}
+
+#endif
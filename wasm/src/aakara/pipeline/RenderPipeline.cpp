@@ -1,16 +1,120 @@
 #include "RenderPipeline.hpp"
 #include "ISystem.hpp"
-#include <aakara/Scene.hpp>
 
-#include <entt/entt.hpp>
+#include <thread>
+#include <exception>
+#include <aakara/JobSystem.hpp>
+#include <emscripten/console.h>
 
-RenderPipeline::RenderPipeline( const Array<Ptr<ISystem>>& systems )
-    : m_systems( systems )
+RenderPipeline::RenderPipeline( const Array<Ptr<ISystem>>& systems, JobSystem* jobs )
+    : m_jobs( jobs )
 {
+    for ( const Ptr<ISystem>& system : systems )
+    {
+        UPtr<Node> node = std::make_unique<Node>();
+        node->system    = system;
+        m_nodes.push_back( std::move( node ) );
+    }
+
+    for ( u32 j = 0; j < m_nodes.size(); j++ )
+    {
+        u32 reads  = m_nodes[j]->system->Reads();
+        u32 writes = m_nodes[j]->system->Writes();
+
+        for ( u32 i = 0; i < j; i++ )
+        {
+            u32 prevReads  = m_nodes[i]->system->Reads();
+            u32 prevWrites = m_nodes[i]->system->Writes();
+
+            if ( ( prevWrites & ( reads | writes ) ) || ( prevReads & writes ) )
+            {
+                m_nodes[i]->dependents.push_back( j );
+                m_nodes[j]->dependencies++;
+            }
+        }
+    }
+}
+
+void RenderPipeline::Run( FrameContext& frame )
+{
+    u64 frameId = ++m_frame;
+
+    m_completed = 0;
+
+    // every job offered this frame is a child of m_root, so none of them outlives Run()
+    if ( m_jobs )
+        m_root = m_jobs->create( [] {} );
+
+    for ( UPtr<Node>& node : m_nodes )
+    {
+        node->remaining = node->dependencies;
+        if ( node->dependencies == 0 )
+            node->readyFrame = frameId;
+    }
+
+    for ( u32 i = 0; i < m_nodes.size(); i++ )
+    {
+        if ( m_nodes[i]->dependencies == 0 )
+            offer( frame, i, frameId );
+    }
+
+    // The calling thread runs context-bound systems and anything the workers have not picked up yet.
+    while ( m_completed.load() < m_nodes.size() )
+    {
+        bool ran = false;
+
+        for ( u32 i = 0; i < m_nodes.size(); i++ )
+            ran |= tryRun( frame, i, frameId );
+
+        if ( !ran && !( m_jobs && m_jobs->runPending() ) )
+            std::this_thread::yield();
+    }
+
+    if ( m_jobs )
+    {
+        m_jobs->run( m_root );
+        m_jobs->wait( m_root );
+    }
+}
+
+void RenderPipeline::offer( FrameContext& frame, u32 index, u64 frameId )
+{
+    if ( !m_jobs || m_nodes[index]->system->RequiresContext() )
+        return;
+
+    auto task = [this, &frame, index, frameId] { tryRun( frame, index, frameId ); };
+
+    m_jobs->run( m_jobs->createChild( m_root, task ) );
 }
 
-void RenderPipeline::Run( entt::registry* entities )
+bool RenderPipeline::tryRun( FrameContext& frame, u32 index, u64 frameId )
 {
-    for ( Ptr<ISystem> system : m_systems )
-        system->Execute( entities );
+    Node& node = *m_nodes[index];
+
+    u64 expected = frameId;
+    if ( !node.readyFrame.compare_exchange_strong( expected, 0 ) )
+        return false;
+
+    try
+    {
+        node.system->Execute( frame );
+    }
+    catch ( const std::exception& err )
+    {
+        emscripten_console_errorf( "System failed: %s", err.what() );
+    }
+
+    for ( u32 dependent : node.dependents )
+    {
+        Node& next = *m_nodes[dependent];
+        if ( next.remaining.fetch_sub( 1 ) == 1 )
+        {
+            next.readyFrame = frameId;
+            offer( frame, dependent, frameId );
+        }
+    }
+
+    m_completed++;
+
+    return true;
 }
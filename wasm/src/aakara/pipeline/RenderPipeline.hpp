@@ -1,25 +1,45 @@
 #ifndef RENDERPIPELINE_HPP
 #define RENDERPIPELINE_HPP
 
+#include <atomic>
 #include <utils.h>
-#include <entt/entity/registry.hpp>
 
-class Scene;
 class ISystem;
+class JobSystem;
+struct Job;
+struct FrameContext;
 
 /**
- * @brief A pipeline that renders objects at the end
- *
+ * @brief Runs a set of systems once per frame.
+ * @details Systems are ordered by the components they read and write: a system depends on every earlier
+ * system whose writes it reads or writes, or whose reads it writes. Independent systems run in parallel on
+ * the job system. Systems requiring the GL context only ever run on the thread calling Run().
  */
 class RenderPipeline
 {
 public:
-    RenderPipeline( const Array<Ptr<ISystem>>& systems );
+    RenderPipeline( const Array<Ptr<ISystem>>& systems, JobSystem* jobs = nullptr );
 
-    void Run( entt::registry* entities );
+    void Run( FrameContext& frame );
 
 private:
-    std::vector<Ptr<ISystem>> m_systems;
+    struct Node
+    {
+        Ptr<ISystem>     system;
+        Array<u32>       dependents;
+        u32              dependencies = 0;
+        std::atomic<u32> remaining { 0 };
+        std::atomic<u64> readyFrame { 0 };
+    };
+
+    Array<UPtr<Node>> m_nodes;
+    JobSystem*        m_jobs  = nullptr;
+    Job*              m_root  = nullptr;
+    u64               m_frame = 0;
+    std::atomic<u32>  m_completed { 0 };
+
+    void offer( FrameContext& frame, u32 index, u64 frameId );
+    bool tryRun( FrameContext& frame, u32 index, u64 frameId );
 };
 
 #endif
@@ -1,12 +1,18 @@
 #include "RenderSystem.hpp"
+#include "FrameContext.hpp"
 
 #include <aakara/Camera.hpp>
 #include <aakara/Lights.hpp>
+#include <aakara/Renderer.hpp>
 
-RenderSystem::RenderSystem( Ptr<Camera> cam, Ptr<Light> light )
+RenderSystem::RenderSystem( Ptr<Renderer> renderer, Ptr<Camera> cam, Ptr<Light> light )
+    : m_renderer( renderer )
+    , m_camera( cam )
+    , m_light( light )
 {
 }
 
-void RenderSystem::Execute( entt::registry* entities )
+void RenderSystem::Execute( FrameContext& frame )
 {
+    m_renderer->submit( frame.packets, m_camera, m_light );
 }
@@ -6,13 +6,37 @@
 
 class Camera;
 class Light;
+class Renderer;
 
+/**
+ * @brief Submits the frame's draw list to WebGL. Runs on the context thread.
+ */
 class RenderSystem : public ISystem
 {
 public:
-    RenderSystem( Ptr<Camera> cam, Ptr<Light> light );
+    RenderSystem( Ptr<Renderer> renderer, Ptr<Camera> cam, Ptr<Light> light );
 
-    void Execute( entt::registry* entities ) override;
+    void Execute( FrameContext& frame ) override;
+
+    u32 Reads() const override
+    {
+        return Component::DrawList | Component::Camera;
+    }
+
+    u32 Writes() const override
+    {
+        return 0;
+    }
+
+    bool RequiresContext() const override
+    {
+        return true;
+    }
+
+private:
+    Ptr<Renderer> m_renderer;
+    Ptr<Camera>   m_camera;
+    Ptr<Light>    m_light;
 };
 
 #endif
@@ -0,0 +1,9 @@
+#include "TransformSystem.hpp"
+#include "FrameContext.hpp"
+
+#include <aakara/TransformStore.hpp>
+
+void TransformSystem::Execute( FrameContext& frame )
+{
+    frame.transforms->update();
+}
@@ -0,0 +1,25 @@
+#ifndef TRANSFORMSYSTEM_HPP
+#define TRANSFORMSYSTEM_HPP
+
+#include "ISystem.hpp"
+
+/**
+ * @brief Recomputes world matrices of dirty transforms.
+ */
+class TransformSystem : public ISystem
+{
+public:
+    void Execute( FrameContext& frame ) override;
+
+    u32 Reads() const override
+    {
+        return 0;
+    }
+
+    u32 Writes() const override
+    {
+        return Component::Transform;
+    }
+};
+
+#endif
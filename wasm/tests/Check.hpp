@@ -0,0 +1,45 @@
+#ifndef CHECK_HPP
+#define CHECK_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <utils.h>
+
+/**
+ * @brief Fail the running test with the expression and its location when it does not hold.
+ */
+#define CHECK( condition )                                                                                   \
+    do                                                                                                       \
+    {                                                                                                        \
+        if ( !( condition ) )                                                                                \
+        {                                                                                                    \
+            std::fprintf( stderr, "%s:%d: CHECK( %s ) failed\n", __FILE__, __LINE__, #condition );           \
+            std::exit( 1 );                                                                                  \
+        }                                                                                                    \
+    } while ( 0 )
+
+namespace Check
+{
+    /**
+     * @brief Median wall time of `runs` calls of `fn`, in milliseconds.
+     */
+    template <typename Fn> double Milliseconds( u32 runs, Fn&& fn )
+    {
+        using Clock = std::chrono::steady_clock;
+
+        Array<double> times( runs );
+        for ( double& time : times )
+        {
+            Clock::time_point start = Clock::now();
+            fn();
+            time = std::chrono::duration<double, std::milli>( Clock::now() - start ).count();
+        }
+
+        std::nth_element( times.begin(), times.begin() + runs / 2, times.end() );
+        return times[runs / 2];
+    }
+}
+
+#endif
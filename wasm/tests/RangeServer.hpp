@@ -0,0 +1,196 @@
+#ifndef RANGESERVER_HPP
+#define RANGESERVER_HPP
+
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
+
+#include <aakara/Mesh.hpp>
+#include <aakara/fetch.hpp>
+
+// 1x1 RGBA PNG
+static const u8 Png[] = {
+    0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+    0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01, 0x08, 0x06, 0x00, 0x00, 0x00, 0x1F, 0x15, 0xC4,
+    0x89, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x44, 0x41, 0x54, 0x78, 0x9C, 0x63, 0xF8, 0xDF, 0xE0, 0xF0,
+    0x1F, 0x00, 0x07, 0x00, 0x02, 0xBF, 0x2B, 0xD7, 0xC7, 0xE2, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45,
+    0x4E, 0x44, 0xAE, 0x42, 0x60, 0x82
+};
+
+/**
+ * @brief Transport serving files with HTTP range semantics. Responses are held until respond(), which the
+ * test calls on the main thread like the browser's event loop. A URL and range can be made to fail with a
+ * given status a number of times first. Files with an ETag are revalidated: a request carrying it in
+ * If-None-Match is answered 304 without a body.
+ */
+class RangeServer : public HTTP::Transport
+{
+public:
+    std::map<string, Array<u8>> files;
+    std::map<string, string>    etags;
+
+    // status to fail "url bytes=a-b" with, and how many more times
+    std::map<string, std::pair<u16, u32>> failures;
+
+    u32    requests    = 0;
+    u32    conditional = 0; // requests carrying If-None-Match
+    u32    notModified = 0; // answered 304
+    u32    aborted     = 0; // held requests aborted
+    size_t largestBody = 0;
+
+    // URL of every request, in the order they were sent
+    Array<string> sent;
+
+    u32 send( const string& url, const Array<HTTP::Header>& headers, Done done ) override
+    {
+        string range;
+        string match;
+        for ( const HTTP::Header& header : headers )
+        {
+            if ( header.Key == "Range" )
+                range = header.Value;
+            else if ( header.Key == "If-None-Match" )
+                match = header.Value;
+        }
+
+        requests++;
+        conditional += match.empty() ? 0 : 1;
+        sent.push_back( url );
+
+        m_held.push_back( { m_nextId, url, range, match, std::move( done ) } );
+        return m_nextId++;
+    }
+
+    void abort( u32 request ) override
+    {
+        auto held = std::find_if(
+            m_held.begin(), m_held.end(), [request]( const Held& held ) { return held.id == request; } );
+
+        if ( held != m_held.end() )
+        {
+            m_held.erase( held );
+            aborted++;
+        }
+    }
+
+    /**
+     * @brief Answer every held request. Returns how many were answered.
+     */
+    u32 respond()
+    {
+        Array<Held> held;
+        held.swap( m_held );
+
+        for ( Held& request : held )
+            request.done( answer( request ) );
+
+        return (u32)held.size();
+    }
+
+    size_t held() const
+    {
+        return m_held.size();
+    }
+
+    /**
+     * @brief Whether a request for url is held.
+     */
+    bool holds( const string& url ) const
+    {
+        return std::any_of(
+            m_held.begin(), m_held.end(), [&url]( const Held& held ) { return held.url == url; } );
+    }
+
+private:
+    struct Held
+    {
+        u32    id;
+        string url;
+        string range;
+        string match;
+        Done   done;
+    };
+
+    Array<Held> m_held;
+    u32         m_nextId = 1;
+
+    Ptr<HTTP::Response> answer( const Held& request )
+    {
+        Ptr<HTTP::Response> response = std::make_shared<HTTP::Response>();
+        response->url                = request.url;
+
+        auto failure = failures.find( request.url + " " + request.range );
+        if ( failure != failures.end() && failure->second.second > 0 )
+        {
+            failure->second.second--;
+            response->status = failure->second.first;
+            return response;
+        }
+
+        auto file = files.find( request.url );
+        if ( file == files.end() )
+        {
+            response->status = 404;
+            return response;
+        }
+
+        auto etag = etags.find( request.url );
+        if ( etag != etags.end() )
+        {
+            response->headers.push_back( { "ETag", etag->second } );
+
+            if ( request.match == etag->second )
+            {
+                notModified++;
+                response->status = 304;
+                return response;
+            }
+        }
+
+        const Array<u8>& bytes = file->second;
+        size_t           first = 0;
+        size_t           last  = bytes.size() - 1;
+
+        response->status = 200;
+        if ( std::sscanf( request.range.c_str(), "bytes=%zu-%zu", &first, &last ) == 2 )
+        {
+            last             = std::min( last, bytes.size() - 1 );
+            response->status = 206;
+        }
+
+        response->body   = HTTP::Body( Array<u8>( bytes.begin() + first, bytes.begin() + last + 1 ) );
+        response->charge = MemoryCharge( MemoryTag::Loader, response->body.size() );
+
+        largestBody = std::max( largestBody, response->body.size() );
+        return response;
+    }
+};
+
+/**
+ * @brief A grid of size x size vertices, two triangles per cell.
+ */
+static inline Ref<Mesh> Grid( u32 size )
+{
+    Array<GpuVertex> vertices( size * size );
+    for ( u32 y = 0; y < size; y++ )
+        for ( u32 x = 0; x < size; x++ )
+            vertices[y * size + x] = { glm::vec3( x, y, 0.0f ), glm::vec3( 0.0f, 0.0f, 1.0f ),
+                glm::vec2( (f32)x / size, (f32)y / size ) };
+
+    Array<u16> indices;
+    for ( u32 y = 0; y + 1 < size; y++ )
+    {
+        for ( u32 x = 0; x + 1 < size; x++ )
+        {
+            u16 corner = (u16)( y * size + x );
+            for ( u16 offset : { 0u, 1u, size, 1u, size + 1, size } )
+                indices.push_back( (u16)( corner + offset ) );
+        }
+    }
+
+    return MakeRef<Mesh>( std::move( vertices ), std::move( indices ) );
+}
+
+#endif
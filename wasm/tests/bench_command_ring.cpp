@@ -0,0 +1,210 @@
+#include <cstdio>
+#include <cstring>
+
+#include <aakara/Camera.hpp>
+#include <aakara/CommandRing.hpp>
+#include <aakara/Lights.hpp>
+#include <aakara/Mesh.hpp>
+#include <aakara/RenderList.hpp>
+#include <aakara/Texture.hpp>
+#include <aakara/Transform.hpp>
+#include <aakara/TransformStore.hpp>
+
+#include "Check.hpp"
+
+// Commands through the ring App::draw() drains: decoding alone, and decoding plus applying them the way
+// App::_applyCommands() does. Nine in ten commands move a transform, the rest cover the other opcodes.
+
+static const u32 Slots    = 10000;
+static const u32 Commands = 1000000;
+
+static f32 F32At( const u32* words )
+{
+    f32 value;
+    std::memcpy( &value, words, sizeof( value ) );
+    return value;
+}
+
+static glm::vec3 Vec3At( const u32* words )
+{
+    return glm::vec3( F32At( words ), F32At( words + 1 ), F32At( words + 2 ) );
+}
+
+static u32 WordOf( f32 value )
+{
+    u32 word;
+    std::memcpy( &word, &value, sizeof( word ) );
+    return word;
+}
+
+struct Scene
+{
+    TransformStore   transforms;
+    RenderList       list;
+    Mesh             mesh;
+    Texture          texture { Array<u8>( 4, 255 ), 1, 1, Texture::PixelType::RGBA };
+    Camera           camera;
+    DirectionalLight light { glm::vec3( 0.0f, -1.0f, 0.0f ), glm::vec3( 1.0f ), 1.0f };
+    glm::vec3        clearColor { 0.0f };
+
+    /**
+     * @brief The body of App::_applyCommands(), against this scene.
+     */
+    void apply( CommandType type, const u32* payload, u32 words )
+    {
+        switch ( type )
+        {
+        case CommandType::SetTransform:
+            if ( words >= 10 && payload[0] < transforms.capacity() )
+            {
+                u32 slot = payload[0];
+
+                std::memcpy( transforms.positionData() + slot * 3, payload + 1, 3 * sizeof( f32 ) );
+                std::memcpy( transforms.rotationData() + slot * 3, payload + 4, 3 * sizeof( f32 ) );
+                std::memcpy( transforms.scaleData() + slot * 3, payload + 7, 3 * sizeof( f32 ) );
+                transforms.markDirty( slot );
+            }
+            break;
+
+        case CommandType::SetVisible:
+            if ( words >= 2 && payload[0] < transforms.capacity() )
+                list.setHidden( payload[0], payload[1] == 0 );
+            break;
+
+        case CommandType::SetCamera:
+            if ( words >= 6 )
+            {
+                camera.transform->setPosition( Vec3At( payload ) );
+                camera.transform->setRotation( Vec3At( payload + 3 ) );
+            }
+            break;
+
+        case CommandType::SetCameraLens:
+            if ( words >= 3 )
+            {
+                camera.FOV   = F32At( payload );
+                camera.ZNear = F32At( payload + 1 );
+                camera.ZFar  = F32At( payload + 2 );
+            }
+            break;
+
+        case CommandType::SetLightDirection:
+            if ( words >= 3 )
+                light.Direction = Vec3At( payload );
+            break;
+
+        case CommandType::SetLightColor:
+            if ( words >= 4 )
+            {
+                light.Color    = Vec3At( payload );
+                light.Strength = F32At( payload + 3 );
+            }
+            break;
+
+        case CommandType::SetClearColor:
+            if ( words >= 3 )
+                clearColor = Vec3At( payload );
+            break;
+
+        default:
+            break;
+        }
+    }
+};
+
+/**
+ * @brief Write command i of the workload. Returns false if the ring is full.
+ */
+static bool Write( CommandRing& ring, u32 i )
+{
+    u32 payload[10];
+    f32 value = (f32)( i % 1000 );
+
+    switch ( i % 20 )
+    {
+    case 0:
+        payload[0] = ( i / 20 ) % Slots;
+        payload[1] = i % 2;
+        return ring.write( CommandType::SetVisible, payload, 2 );
+
+    case 10:
+        for ( u32 w = 0; w < 6; w++ )
+            payload[w] = WordOf( value + w );
+        return ring.write( CommandType::SetCamera, payload, 6 );
+
+    default:
+        payload[0] = i % Slots;
+        for ( u32 w = 1; w < 10; w++ )
+            payload[w] = WordOf( value + w );
+        return ring.write( CommandType::SetTransform, payload, 10 );
+    }
+}
+
+/**
+ * @brief Push the workload through the ring, draining it whenever it fills up like a frame would.
+ */
+template <typename F> static u64 Run( CommandRing& ring, F&& fn )
+{
+    u64 consumed = 0;
+    for ( u32 i = 0; i < Commands; )
+    {
+        while ( i < Commands && Write( ring, i ) )
+            i++;
+
+        consumed += ring.consume( fn );
+    }
+
+    return consumed;
+}
+
+int main()
+{
+    Scene scene;
+    for ( u32 i = 0; i < Slots; i++ )
+    {
+        u32 slot = scene.transforms.create( Transform() );
+        scene.list.add( &scene.mesh, &scene.texture, slot );
+    }
+
+    // 256 KB holds about 6000 transform commands, so the workload wraps the ring many times
+    CommandRing ring( 256 * 1024 );
+
+    u64 decoded = 0;
+    u64 words   = 0;
+
+    double decode = Check::Milliseconds( 5,
+        [&]()
+        {
+            decoded = Run( ring, [&words]( CommandType, const u32*, u32 count ) { words += count; } );
+        } );
+
+    u64 applied = 0;
+
+    double apply = Check::Milliseconds( 5,
+        [&]()
+        {
+            applied = Run( ring, [&scene]( CommandType type, const u32* payload, u32 count )
+                { scene.apply( type, payload, count ); } );
+        } );
+
+    CHECK( decoded == Commands && applied == Commands && words > 0 );
+    CHECK( ring.corrupt() == 0 );
+
+    // the last transform commands landed in the store
+    for ( u32 i = Commands - 40; i < Commands; i++ )
+    {
+        if ( i % 20 == 0 || i % 20 == 10 )
+            continue;
+
+        f32 value = (f32)( i % 1000 );
+        CHECK( scene.transforms.getPosition( i % Slots ) == glm::vec3( value + 1, value + 2, value + 3 ) );
+        CHECK( scene.transforms.getScale( i % Slots ) == glm::vec3( value + 7, value + 8, value + 9 ) );
+    }
+
+    CHECK( scene.camera.transform->position == glm::vec3( 990.0f, 991.0f, 992.0f ) );
+
+    std::printf( "%u commands: decode %.2f ms (%.1f M/s), decode and apply %.2f ms (%.1f M/s)\n", Commands,
+                 decode, Commands / decode / 1000.0, apply, Commands / apply / 1000.0 );
+
+    return 0;
+}
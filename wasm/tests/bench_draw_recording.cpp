@@ -0,0 +1,152 @@
+#include <cstdio>
+#include <thread>
+#include <webgl/stats.h>
+
+#include <aakara/JobSystem.hpp>
+#include <aakara/Mesh.hpp>
+#include <aakara/RenderList.hpp>
+#include <aakara/Shader.hpp>
+#include <aakara/Texture.hpp>
+#include <aakara/Transform.hpp>
+#include <aakara/TransformStore.hpp>
+#include "pipeline/DrawListSystem.hpp"
+#include "pipeline/FrameContext.hpp"
+
+#include "Check.hpp"
+
+// The prepare phase of a frame, DrawListSystem recording packets in parallel chunks, on 1 to 8 threads,
+// then the submit phase replaying the packets into the recording GL.
+
+static const u32 Count    = 200000;
+static const u32 Meshes   = 64;
+static const u32 Textures = 8;
+
+/**
+ * @brief The packet loop of Renderer::submit(), which also needs a skybox and the shader files.
+ */
+static void Submit( const Array<DrawPacket>& packets, Shader& shader )
+{
+    shader.Bind();
+
+    i32 model = shader.GetUniformLocation( "model" );
+
+    Mesh*    boundMesh    = nullptr;
+    Texture* boundTexture = nullptr;
+
+    for ( const DrawPacket& packet : packets )
+    {
+        if ( packet.mesh != boundMesh )
+        {
+            CHECK( packet.mesh->Bind( &shader ) );
+            boundMesh = packet.mesh;
+        }
+
+        if ( packet.texture != boundTexture )
+        {
+            packet.texture->Bind();
+            boundTexture = packet.texture;
+        }
+
+        shader.SetMatrix( model, *packet.model );
+
+        packet.mesh->Draw();
+    }
+
+    shader.Unbind();
+}
+
+int main()
+{
+    Shader shader( "", "" );
+
+    Array<Ref<Mesh>> meshes;
+    for ( u32 m = 0; m < Meshes; m++ )
+    {
+        Array<GpuVertex> vertices( 24 );
+        Array<u16>       indices( 36 );
+        for ( u32 i = 0; i < indices.size(); i++ )
+            indices[i] = (u16)( ( i * 7 + m ) % vertices.size() );
+
+        meshes.push_back( MakeRef<Mesh>( std::move( vertices ), std::move( indices ) ) );
+        CHECK( meshes.back()->update( &shader ) );
+    }
+
+    Array<UPtr<Texture>> textures;
+    for ( u32 t = 0; t < Textures; t++ )
+    {
+        textures.push_back(
+            std::make_unique<Texture>( Array<u8>( 4, 255 ), 1, 1, Texture::PixelType::RGBA ) );
+        textures.back()->update();
+    }
+
+    TransformStore transforms;
+    RenderList     list;
+    u32            visible = 0;
+
+    for ( u32 i = 0; i < Count; i++ )
+    {
+        Transform transform( glm::vec3( (f32)( i % 100 ), (f32)( i / 100 ), 0.0f ), glm::vec3( 0.0f ),
+                             glm::vec3( 1.0f ) );
+
+        u32 handle = list.add( meshes[( i * 13 ) % Meshes].get(), textures[i % Textures].get(),
+                               transforms.create( transform ) );
+
+        // every fifth entry is culled, as a camera would
+        list.get( handle ).visible = i % 5 != 0;
+        visible += i % 5 != 0;
+    }
+
+    transforms.update();
+
+    FrameContext frame;
+    frame.transforms = &transforms;
+    frame.renderList = &list;
+
+    frame.arena.reset();
+    list.sort( frame.arena );
+
+    DrawListSystem drawList;
+
+    // scaling stops at the number of cores
+    std::printf( "%u visible of %u entries, %u hardware threads\n", visible, Count,
+                 std::thread::hardware_concurrency() );
+
+    double single = 0.0;
+    for ( u32 threads = 1; threads <= 8; threads++ )
+    {
+        JobSystem jobs( threads - 1 );
+        frame.jobs = &jobs;
+
+        double prepare = Check::Milliseconds( 25,
+            [&]()
+            {
+                // the system skips frames where nothing changed
+                frame.visibilityVersion++;
+                drawList.Execute( frame );
+            } );
+
+        CHECK( frame.packets.size() == visible );
+
+        if ( threads == 1 )
+            single = prepare;
+
+        std::printf( "prepare, %u thread%s: %.3f ms (%.2fx)\n", threads, threads == 1 ? " " : "s", prepare,
+                     single / prepare );
+    }
+
+    frame.jobs = nullptr;
+
+    for ( size_t i = 1; i < frame.packets.size(); i++ )
+        CHECK( frame.packets[i - 1].key <= frame.packets[i].key );
+
+    aakara_stub_gl_reset_stats();
+    double submit = Check::Milliseconds( 1, [&]() { Submit( frame.packets, shader ); } );
+
+    AakaraGLStats stats = aakara_stub_gl_stats();
+    CHECK( stats.draws == visible );
+
+    std::printf( "submit: %.3f ms for %llu draws, %llu GL calls, %llu buffer binds, %llu texture binds\n",
+                 submit, stats.draws, stats.calls, stats.bufferBinds, stats.textureBinds );
+
+    return 0;
+}
@@ -0,0 +1,226 @@
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+
+#include <aakara/JobSystem.hpp>
+
+#include "Check.hpp"
+
+// JobSystem against the thread pool it replaced, with the browser build's four workers.
+
+static const u32 Workers = 4;
+
+/**
+ * @brief The scheduling core of the removed include/thread_pool.h (v2.0.0): one std::function queue behind
+ * one mutex, with workers and waiters polling through sleep_or_yield().
+ */
+class SharedQueuePool
+{
+public:
+    explicit SharedQueuePool( u32 threads )
+    {
+        for ( u32 i = 0; i < threads; i++ )
+            m_threads.emplace_back( &SharedQueuePool::worker, this );
+    }
+
+    ~SharedQueuePool()
+    {
+        wait_for_tasks();
+        m_running = false;
+
+        for ( std::thread& thread : m_threads )
+            thread.join();
+    }
+
+    template <typename F> void push_task( const F& task )
+    {
+        m_total++;
+
+        std::lock_guard<std::mutex> lock( m_mutex );
+        m_tasks.push( std::function<void()>( task ) );
+    }
+
+    template <typename F> void parallelize_loop( size_t first, size_t last, const F& loop )
+    {
+        size_t blocks = m_threads.size();
+        size_t block  = ( last - first ) / blocks;
+
+        std::atomic<u32> running { 0 };
+        for ( size_t b = 0; b < blocks; b++ )
+        {
+            size_t start = first + b * block;
+            size_t end   = b == blocks - 1 ? last : start + block;
+
+            running++;
+            push_task(
+                [start, end, &loop, &running]
+                {
+                    loop( start, end );
+                    running--;
+                } );
+        }
+
+        wait_until( [&running] { return running == 0; } );
+    }
+
+    void wait_for_tasks()
+    {
+        wait_until( [this] { return m_total == 0; } );
+    }
+
+    /**
+     * @brief Poll done through sleep_or_yield(), as every waiter of the pool did.
+     */
+    template <typename F> void wait_until( const F& done )
+    {
+        while ( !done() )
+            sleep_or_yield();
+    }
+
+private:
+    void sleep_or_yield()
+    {
+        std::this_thread::sleep_for( std::chrono::microseconds( 1000 ) );
+    }
+
+    void worker()
+    {
+        while ( m_running )
+        {
+            std::function<void()> task;
+            {
+                std::lock_guard<std::mutex> lock( m_mutex );
+                if ( !m_tasks.empty() )
+                {
+                    task = std::move( m_tasks.front() );
+                    m_tasks.pop();
+                }
+            }
+
+            if ( task )
+            {
+                task();
+                m_total--;
+            }
+            else
+            {
+                sleep_or_yield();
+            }
+        }
+    }
+
+    std::mutex                        m_mutex;
+    std::queue<std::function<void()>> m_tasks;
+    Array<std::thread>                m_threads;
+    std::atomic<bool>                 m_running { true };
+    std::atomic<u32>                  m_total { 0 };
+};
+
+static void Report( const char* name, double jobs, double pool )
+{
+    std::printf( "%-34s JobSystem %8.3f ms, thread_pool %8.3f ms (%.1fx)\n", name, jobs, pool, pool / jobs );
+}
+
+int main()
+{
+    JobSystem       jobs( Workers );
+    SharedQueuePool pool( Workers );
+
+    /* -------------------------- parallel loop, 1M items ----------------------- */
+    const size_t Count = 1 << 20;
+    Array<f32>   values( Count );
+
+    auto body = [&values]( size_t begin, size_t end )
+    {
+        for ( size_t i = begin; i < end; i++ )
+            values[i] = std::sqrt( (f32)i );
+    };
+
+    auto checkValues = [&values]()
+    {
+        for ( size_t i = 0; i < values.size(); i += 4099 )
+            CHECK( values[i] == std::sqrt( (f32)i ) );
+    };
+
+    double jobLoop = Check::Milliseconds( 30, [&]() { jobs.parallelFor( Count, 4096, body ); } );
+    checkValues();
+    std::fill( values.begin(), values.end(), 0.0f );
+
+    double poolLoop = Check::Milliseconds( 30, [&]() { pool.parallelize_loop( 0, Count, body ); } );
+    checkValues();
+
+    Report( "parallelFor / parallelize_loop", jobLoop, poolLoop );
+
+    /* ------------------------- 10k detached small tasks ----------------------- */
+    const u32        Tasks = 10000;
+    std::atomic<u64> sum { 0 };
+
+    double jobTasks = Check::Milliseconds( 10,
+        [&]()
+        {
+            for ( u32 i = 0; i < Tasks; i++ )
+                jobs.pushTask( [&sum, i]() { sum += i; } );
+
+            jobs.waitForTasks();
+        } );
+
+    CHECK( sum == 10ull * Tasks * ( Tasks - 1 ) / 2 );
+    sum = 0;
+
+    double poolTasks = Check::Milliseconds( 10,
+        [&]()
+        {
+            for ( u32 i = 0; i < Tasks; i++ )
+                pool.push_task( [&sum, i]() { sum += i; } );
+
+            pool.wait_for_tasks();
+        } );
+
+    CHECK( sum == 10ull * Tasks * ( Tasks - 1 ) / 2 );
+
+    Report( "pushTask / push_task, 10k tasks", jobTasks, poolTasks );
+
+    /* ------------------------ fork-join, 256 child jobs ----------------------- */
+    const u32 Children = 256;
+    sum                = 0;
+
+    double jobTree = Check::Milliseconds( 30,
+        [&]()
+        {
+            Job* root = jobs.create( [] {} );
+            for ( u32 i = 0; i < Children; i++ )
+                jobs.run( jobs.createChild( root, [&sum, i]() { sum += i; } ) );
+
+            jobs.run( root );
+            jobs.wait( root );
+        } );
+
+    CHECK( sum == 30ull * Children * ( Children - 1 ) / 2 );
+    sum = 0;
+
+    double poolTree = Check::Milliseconds( 30,
+        [&]()
+        {
+            std::atomic<u32> running { Children };
+            for ( u32 i = 0; i < Children; i++ )
+                pool.push_task(
+                    [&sum, &running, i]()
+                    {
+                        sum += i;
+                        running--;
+                    } );
+
+            pool.wait_until( [&running] { return running == 0; } );
+        } );
+
+    CHECK( sum == 30ull * Children * ( Children - 1 ) / 2 );
+
+    Report( "child jobs / push_task, 256 jobs", jobTree, poolTree );
+
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <cmath>
+#include <cstdio>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <aakara/Transform.hpp>
+#include <aakara/TransformStore.hpp>
+
+#include "Check.hpp"
+
+// 100k transforms, a quarter of them roots with three levels of children below: the batched
+// TransformStore::update() against the per-object glm path it replaced.
+
+static const u32 Count = 100000;
+
+static glm::vec3 Wave( u32 i, f32 scale )
+{
+    return glm::vec3( std::sin( i * 0.37f ), std::cos( i * 0.11f ), std::sin( i * 0.07f + 1.0f ) ) * scale;
+}
+
+static f32 MaxDifference( const glm::mat4& a, const glm::mat4& b )
+{
+    f32 difference = 0.0f;
+    for ( u32 column = 0; column < 4; column++ )
+        for ( u32 row = 0; row < 4; row++ )
+            difference = std::max( difference, std::fabs( a[column][row] - b[column][row] ) );
+
+    return difference;
+}
+
+int main()
+{
+    TransformStore store;
+    Array<u32>     parents( Count, TransformStore::Invalid );
+
+    for ( u32 i = 0; i < Count; i++ )
+    {
+        // parents always come before their children, so the glm path can walk the slots in order
+        if ( i % 4 != 0 )
+            parents[i] = i - 1;
+
+        Transform transform( Wave( i, 10.0f ), Wave( i + 5, 180.0f ), glm::vec3( 1.0f ) + Wave( i, 0.5f ) );
+        CHECK( store.create( transform, parents[i] ) == i );
+    }
+
+    Array<glm::mat4> reference( Count );
+    auto             glmPath = [&]()
+    {
+        for ( u32 i = 0; i < Count; i++ )
+        {
+            glm::mat4 local = TransformStore::ComputeLocal(
+                store.getPosition( i ), store.getRotation( i ), store.getScale( i ) );
+
+            reference[i] = parents[i] == TransformStore::Invalid ? local : reference[parents[i]] * local;
+        }
+    };
+
+    auto storePath = [&]()
+    {
+        store.markDirty( 0, Count );
+        CHECK( store.update() == Count );
+    };
+
+    glmPath();
+    storePath();
+
+    f32 worst = 0.0f;
+    for ( u32 i = 0; i < Count; i++ )
+        worst = std::max( worst, MaxDifference( store.getWorld( i ), reference[i] ) );
+
+    std::printf( "largest difference from the glm path: %g\n", worst );
+    CHECK( worst < 1e-3f );
+
+    double glmTime   = Check::Milliseconds( 15, glmPath );
+    double storeTime = Check::Milliseconds( 15, storePath );
+
+    std::printf( "%u transforms: glm %.2f ms, TransformStore %.2f ms (%.1fx)\n", Count, glmTime, storeTime,
+                 glmTime / storeTime );
+
+    return 0;
+}
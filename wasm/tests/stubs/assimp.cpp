@@ -0,0 +1,80 @@
+#include <new>
+#include <assimp/Importer.hpp>
+#include <assimp/ProgressHandler.hpp>
+#include <assimp/scene.h>
+
+// The native tests build without the assimp library: the importer reads nothing, so Mesh::Import() reports
+// every file as unreadable. Chunked meshes (ChunkedMesh) never go through assimp.
+
+namespace Assimp
+{
+    // the base of ProgressHandler, normally defined in the library
+    void* Intern::AllocateFromAssimpHeap::operator new( size_t num_bytes )
+    {
+        return ::operator new( num_bytes );
+    }
+
+    void* Intern::AllocateFromAssimpHeap::operator new( size_t num_bytes, const std::nothrow_t& ) throw()
+    {
+        return ::operator new( num_bytes, std::nothrow );
+    }
+
+    void Intern::AllocateFromAssimpHeap::operator delete( void* data )
+    {
+        ::operator delete( data );
+    }
+
+    void* Intern::AllocateFromAssimpHeap::operator new[]( size_t num_bytes )
+    {
+        return ::operator new[]( num_bytes );
+    }
+
+    void* Intern::AllocateFromAssimpHeap::operator new[]( size_t num_bytes, const std::nothrow_t& ) throw()
+    {
+        return ::operator new[]( num_bytes, std::nothrow );
+    }
+
+    void Intern::AllocateFromAssimpHeap::operator delete[]( void* data )
+    {
+        ::operator delete[]( data );
+    }
+
+    class ImporterPimpl
+    {
+    public:
+        ProgressHandler* progress = nullptr;
+    };
+
+    Importer::Importer()
+        : pimpl( new ImporterPimpl() )
+    {
+    }
+
+    Importer::~Importer()
+    {
+        delete pimpl->progress;
+        delete pimpl;
+    }
+
+    void Importer::SetProgressHandler( ProgressHandler* pHandler )
+    {
+        delete pimpl->progress;
+        pimpl->progress = pHandler;
+    }
+
+    const aiScene* Importer::ReadFileFromMemory( const void* pBuffer, size_t pLength, unsigned int pFlags,
+                                                 const char* pHint )
+    {
+        return nullptr;
+    }
+
+    const char* Importer::GetErrorString() const
+    {
+        return "assimp is not available in the native test build";
+    }
+
+    void Importer::GetMemoryRequirements( aiMemoryInfo& in ) const
+    {
+        in = aiMemoryInfo();
+    }
+}
@@ -0,0 +1,207 @@
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <emscripten/console.h>
+#include <emscripten/emscripten.h>
+#include <emscripten/fetch.h>
+#include <emscripten/heap.h>
+#include <emscripten/html5.h>
+#include <emscripten/threading.h>
+
+namespace
+{
+    std::mutex                        g_mutex;
+    std::thread::id                   g_mainThread;
+    bool                              g_mainThreadKnown = false;
+    std::deque<std::function<void()>> g_mainThreadCalls;
+
+    void Print( const char* level, const char* format, va_list args )
+    {
+        std::fprintf( stderr, "[%s] ", level );
+        std::vfprintf( stderr, format, args );
+        std::fputc( '\n', stderr );
+    }
+}
+
+extern "C"
+{
+    void emscripten_console_log( const char* message )
+    {
+        std::fprintf( stderr, "[log] %s\n", message );
+    }
+
+    void emscripten_console_warn( const char* message )
+    {
+        std::fprintf( stderr, "[warn] %s\n", message );
+    }
+
+    void emscripten_console_error( const char* message )
+    {
+        std::fprintf( stderr, "[error] %s\n", message );
+    }
+
+    void emscripten_console_logf( const char* format, ... )
+    {
+        va_list args;
+        va_start( args, format );
+        Print( "log", format, args );
+        va_end( args );
+    }
+
+    void emscripten_console_warnf( const char* format, ... )
+    {
+        va_list args;
+        va_start( args, format );
+        Print( "warn", format, args );
+        va_end( args );
+    }
+
+    void emscripten_console_errorf( const char* format, ... )
+    {
+        va_list args;
+        va_start( args, format );
+        Print( "error", format, args );
+        va_end( args );
+    }
+
+    double emscripten_get_now( void )
+    {
+        using Clock = std::chrono::steady_clock;
+
+        static const Clock::time_point start = Clock::now();
+        return std::chrono::duration<double, std::milli>( Clock::now() - start ).count();
+    }
+
+    size_t emscripten_get_heap_max( void )
+    {
+        // the engine's TOTAL_MEMORY
+        return 524288000;
+    }
+
+    int emscripten_is_main_runtime_thread( void )
+    {
+        std::lock_guard<std::mutex> lock( g_mutex );
+
+        if ( !g_mainThreadKnown )
+        {
+            g_mainThread      = std::this_thread::get_id();
+            g_mainThreadKnown = true;
+        }
+
+        return g_mainThread == std::this_thread::get_id();
+    }
+
+    void emscripten_async_run_in_main_runtime_thread_( int sig, void* func, ... )
+    {
+        va_list args;
+        va_start( args, func );
+
+        std::function<void()> call;
+        if ( sig == EM_FUNC_SIG_VI )
+        {
+            void* a = va_arg( args, void* );
+            call    = [func, a]() { ( (void ( * )( void* ))func )( a ); };
+        }
+        else if ( sig == EM_FUNC_SIG_VII )
+        {
+            void*        a = va_arg( args, void* );
+            unsigned int b = va_arg( args, unsigned int );
+            call           = [func, a, b]() { ( (void ( * )( void*, unsigned int ))func )( a, b ); };
+        }
+
+        va_end( args );
+
+        if ( !call )
+        {
+            std::fprintf( stderr, "[error] unsupported proxied call signature %d\n", sig );
+            std::abort();
+        }
+
+        std::lock_guard<std::mutex> lock( g_mutex );
+        g_mainThreadCalls.push_back( std::move( call ) );
+    }
+
+    int aakara_stub_run_main_thread_calls( void )
+    {
+        std::deque<std::function<void()>> calls;
+        {
+            std::lock_guard<std::mutex> lock( g_mutex );
+            calls.swap( g_mainThreadCalls );
+        }
+
+        for ( std::function<void()>& call : calls )
+            call();
+
+        return (int)calls.size();
+    }
+
+    EMSCRIPTEN_WEBGL_CONTEXT_HANDLE emscripten_webgl_create_context(
+        const char* target, const EmscriptenWebGLContextAttributes* attributes )
+    {
+        return 1;
+    }
+
+    EMSCRIPTEN_RESULT emscripten_webgl_make_context_current( EMSCRIPTEN_WEBGL_CONTEXT_HANDLE context )
+    {
+        return 0;
+    }
+
+    void emscripten_fetch_attr_init( emscripten_fetch_attr_t* attr )
+    {
+        std::memset( attr, 0, sizeof( *attr ) );
+    }
+
+    emscripten_fetch_t* emscripten_fetch( emscripten_fetch_attr_t* attr, const char* url )
+    {
+        // there is no network: every fetch fails straight away, the way an unreachable host does
+        emscripten_fetch_t* fetch = new emscripten_fetch_t();
+        fetch->userData           = attr->userData;
+        fetch->url                = url;
+        fetch->status             = 0;
+        fetch->__attributes       = *attr;
+
+        if ( attr->onerror )
+            attr->onerror( fetch );
+
+        return nullptr;
+    }
+
+    EMSCRIPTEN_RESULT emscripten_fetch_close( emscripten_fetch_t* fetch )
+    {
+        if ( fetch )
+        {
+            std::free( (void*)fetch->data );
+            delete fetch;
+        }
+
+        return 0;
+    }
+
+    size_t emscripten_fetch_get_response_headers_length( emscripten_fetch_t* fetch )
+    {
+        return 0;
+    }
+
+    size_t emscripten_fetch_get_response_headers( emscripten_fetch_t* fetch, char* dst, size_t size )
+    {
+        if ( size )
+            dst[0] = '\0';
+
+        return 0;
+    }
+
+    char** emscripten_fetch_unpack_response_headers( const char* headers )
+    {
+        return nullptr;
+    }
+
+    void emscripten_fetch_free_unpacked_response_headers( char** headers )
+    {
+    }
+}
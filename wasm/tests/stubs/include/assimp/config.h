@@ -0,0 +1,7 @@
+#ifndef AAKARA_STUB_ASSIMP_CONFIG_H
+#define AAKARA_STUB_ASSIMP_CONFIG_H
+
+// assimp/config.h is generated by the assimp build, which the native tests do not run. The engine reads
+// no config keys, so the vendored headers only need the file to exist.
+
+#endif
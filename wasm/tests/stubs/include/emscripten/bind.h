@@ -0,0 +1,93 @@
+#ifndef AAKARA_STUB_BIND_H
+#define AAKARA_STUB_BIND_H
+
+// Native stand-in for embind. Bindings are type-checked like any other code but never registered.
+
+#include <emscripten/val.h>
+
+#define EMSCRIPTEN_BINDINGS( name ) [[maybe_unused]] static void EmbindStub_##name()
+
+namespace emscripten
+{
+    struct allow_raw_pointers
+    {
+    };
+
+    template <typename T> struct class_
+    {
+        explicit class_( const char* )
+        {
+        }
+
+        template <typename... A> class_& constructor( A&&... )
+        {
+            return *this;
+        }
+
+        template <typename... A> class_& smart_ptr( A&&... )
+        {
+            return *this;
+        }
+
+        template <typename... A> class_& smart_ptr_constructor( A&&... )
+        {
+            return *this;
+        }
+
+        template <typename... A> class_& function( A&&... )
+        {
+            return *this;
+        }
+
+        template <typename... A> class_& class_function( A&&... )
+        {
+            return *this;
+        }
+
+        template <typename... A> class_& property( A&&... )
+        {
+            return *this;
+        }
+    };
+
+    template <typename T> struct value_object
+    {
+        explicit value_object( const char* )
+        {
+        }
+
+        template <typename... A> value_object& field( A&&... )
+        {
+            return *this;
+        }
+    };
+
+    template <typename T> struct enum_
+    {
+        explicit enum_( const char* )
+        {
+        }
+
+        enum_& value( const char*, T )
+        {
+            return *this;
+        }
+    };
+
+    template <typename T> struct register_vector
+    {
+        explicit register_vector( const char* )
+        {
+        }
+    };
+
+    template <typename... A> void function( const char*, A&&... )
+    {
+    }
+
+    template <typename... A> void constant( const char*, A&&... )
+    {
+    }
+}
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef AAKARA_STUB_CONSOLE_H
+#define AAKARA_STUB_CONSOLE_H
+
+// Native stand-in for <emscripten/console.h>: messages go to stderr
+
+extern "C"
+{
+    void emscripten_console_log( const char* message );
+    void emscripten_console_warn( const char* message );
+    void emscripten_console_error( const char* message );
+    void emscripten_console_logf( const char* format, ... );
+    void emscripten_console_warnf( const char* format, ... );
+    void emscripten_console_errorf( const char* format, ... );
+}
+
+#endif
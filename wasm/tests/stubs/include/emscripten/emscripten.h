@@ -0,0 +1,17 @@
+#ifndef AAKARA_STUB_EMSCRIPTEN_H
+#define AAKARA_STUB_EMSCRIPTEN_H
+
+// Native stand-in for the parts of <emscripten/emscripten.h> the engine uses
+
+#include <emscripten/console.h>
+
+extern "C"
+{
+    double emscripten_get_now( void );
+}
+
+// inline JavaScript has nothing to run on natively
+#define EM_ASM( ... ) ( (void)0 )
+#define EMSCRIPTEN_KEEPALIVE
+
+#endif
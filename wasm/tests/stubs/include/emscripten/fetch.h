@@ -0,0 +1,50 @@
+#ifndef AAKARA_STUB_FETCH_H
+#define AAKARA_STUB_FETCH_H
+
+// Native stand-in for <emscripten/fetch.h>. emscripten_fetch() fails every request with status 0: tests
+// serve HTTP through an HTTP::Transport of their own instead.
+
+#include <cstddef>
+#include <cstdint>
+#include <emscripten/html5.h>
+
+#define EMSCRIPTEN_FETCH_LOAD_TO_MEMORY 1
+
+struct emscripten_fetch_t;
+
+struct emscripten_fetch_attr_t
+{
+    char               requestMethod[32];
+    void*              userData;
+    void               ( *onsuccess )( emscripten_fetch_t* fetch );
+    void               ( *onerror )( emscripten_fetch_t* fetch );
+    void               ( *onprogress )( emscripten_fetch_t* fetch );
+    uint32_t           attributes;
+    const char* const* requestHeaders;
+};
+
+struct emscripten_fetch_t
+{
+    unsigned int            id;
+    void*                   userData;
+    const char*             url;
+    const char*             data;
+    uint64_t                numBytes;
+    uint64_t                totalBytes;
+    unsigned short          status;
+    emscripten_fetch_attr_t __attributes;
+};
+
+extern "C"
+{
+    void                emscripten_fetch_attr_init( emscripten_fetch_attr_t* attr );
+    emscripten_fetch_t* emscripten_fetch( emscripten_fetch_attr_t* attr, const char* url );
+    EMSCRIPTEN_RESULT   emscripten_fetch_close( emscripten_fetch_t* fetch );
+    size_t              emscripten_fetch_get_response_headers_length( emscripten_fetch_t* fetch );
+    size_t              emscripten_fetch_get_response_headers(
+        emscripten_fetch_t* fetch, char* dst, size_t size );
+    char**              emscripten_fetch_unpack_response_headers( const char* headers );
+    void                emscripten_fetch_free_unpacked_response_headers( char** headers );
+}
+
+#endif
@@ -0,0 +1,11 @@
+#ifndef AAKARA_STUB_HEAP_H
+#define AAKARA_STUB_HEAP_H
+
+#include <cstddef>
+
+extern "C"
+{
+    size_t emscripten_get_heap_max( void );
+}
+
+#endif
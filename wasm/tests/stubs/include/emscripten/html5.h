@@ -0,0 +1,27 @@
+#ifndef AAKARA_STUB_HTML5_H
+#define AAKARA_STUB_HTML5_H
+
+#include <emscripten/emscripten.h>
+
+typedef int EMSCRIPTEN_RESULT;
+typedef int EMSCRIPTEN_WEBGL_CONTEXT_HANDLE;
+
+struct EmscriptenWebGLContextAttributes
+{
+    int explicitSwapControl;
+    int depth;
+    int stencil;
+    int antialias;
+    int majorVersion;
+    int minorVersion;
+    int renderViaOffscreenBackBuffer;
+};
+
+extern "C"
+{
+    EMSCRIPTEN_WEBGL_CONTEXT_HANDLE emscripten_webgl_create_context(
+        const char* target, const EmscriptenWebGLContextAttributes* attributes );
+    EMSCRIPTEN_RESULT emscripten_webgl_make_context_current( EMSCRIPTEN_WEBGL_CONTEXT_HANDLE context );
+}
+
+#endif
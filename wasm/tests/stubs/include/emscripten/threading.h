@@ -0,0 +1,24 @@
+#ifndef AAKARA_STUB_THREADING_H
+#define AAKARA_STUB_THREADING_H
+
+// Native stand-in for <emscripten/threading.h>. The thread that first asks is taken as the main runtime
+// thread; calls proxied to it are queued until it runs them with aakara_stub_run_main_thread_calls().
+
+#define EM_FUNC_SIG_VI 0
+#define EM_FUNC_SIG_VII 1
+
+extern "C"
+{
+    int  emscripten_is_main_runtime_thread( void );
+    void emscripten_async_run_in_main_runtime_thread_( int sig, void* func, ... );
+
+    /**
+     * @brief Run the calls proxied to the main runtime thread so far. Returns how many ran.
+     */
+    int aakara_stub_run_main_thread_calls( void );
+}
+
+#define emscripten_async_run_in_main_runtime_thread( sig, func, ... )                                        \
+    emscripten_async_run_in_main_runtime_thread_( sig, (void*)( func ), __VA_ARGS__ )
+
+#endif
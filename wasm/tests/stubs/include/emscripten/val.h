@@ -0,0 +1,92 @@
+#ifndef AAKARA_STUB_VAL_H
+#define AAKARA_STUB_VAL_H
+
+// Native stand-in for emscripten::val. There is no JavaScript side: every value is undefined, writes are
+// dropped and reads give default values.
+
+#include <cstddef>
+
+namespace emscripten
+{
+    template <typename T> struct memory_view
+    {
+        size_t   size;
+        const T* data;
+    };
+
+    template <typename T> memory_view<T> typed_memory_view( size_t size, const T* data )
+    {
+        return { size, data };
+    }
+
+    class val
+    {
+    public:
+        val() = default;
+
+        template <typename T> explicit val( T&& )
+        {
+        }
+
+        static val object()
+        {
+            return val();
+        }
+
+        static val array()
+        {
+            return val();
+        }
+
+        static val global( const char* )
+        {
+            return val();
+        }
+
+        static val undefined()
+        {
+            return val();
+        }
+
+        static val null()
+        {
+            return val();
+        }
+
+        template <typename K> val operator[]( const K& ) const
+        {
+            return val();
+        }
+
+        template <typename K, typename V> void set( const K&, const V& )
+        {
+        }
+
+        template <typename... A> val operator()( A&&... ) const
+        {
+            return val();
+        }
+
+        template <typename R = val, typename... A> R call( const char*, A&&... ) const
+        {
+            return R();
+        }
+
+        template <typename T> T as() const
+        {
+            return T();
+        }
+
+        bool isUndefined() const
+        {
+            return true;
+        }
+
+        bool isNull() const
+        {
+            return false;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef AAKARA_STUB_STATS_H
+#define AAKARA_STUB_STATS_H
+
+// Counters kept by the recording GL in tests/stubs/webgl.cpp. Like a real WebGL context it is only
+// called from one thread, so neither the counters nor the GL objects are locked.
+
+struct AakaraGLStats
+{
+    unsigned long long calls;        // every gl* entry point
+    unsigned long long draws;        // glDrawElements and glDrawArrays
+    unsigned long long bufferBinds;  // glBindBuffer
+    unsigned long long textureBinds; // glBindTexture
+    unsigned long long uniforms;     // glUniform*
+    unsigned long long uploadBytes;  // glBufferData, glBufferSubData, glTexImage2D and glTexSubImage2D
+    unsigned long long liveBuffers;  // generated and not deleted
+    unsigned long long liveTextures; // generated and not deleted
+};
+
+extern "C"
+{
+    AakaraGLStats aakara_stub_gl_stats( void );
+    void          aakara_stub_gl_reset_stats( void );
+
+    // contents of the buffer bound to GL_ARRAY_BUFFER or GL_ELEMENT_ARRAY_BUFFER, null if none is bound
+    const unsigned char* aakara_stub_gl_bound_data( unsigned int target, unsigned long long* size );
+}
+
+#endif
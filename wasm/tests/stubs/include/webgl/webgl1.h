@@ -0,0 +1,127 @@
+#ifndef AAKARA_STUB_WEBGL1_H
+#define AAKARA_STUB_WEBGL1_H
+
+// Native stand-in for <webgl/webgl1.h>. Enum values match GLES2; the functions are implemented by the
+// recording GL in tests/stubs/webgl.cpp.
+
+#include <cstddef>
+
+typedef unsigned int   GLenum;
+typedef unsigned int   GLuint;
+typedef int            GLint;
+typedef int            GLsizei;
+typedef float          GLfloat;
+typedef unsigned char  GLboolean;
+typedef char           GLchar;
+typedef ptrdiff_t      GLsizeiptr;
+typedef ptrdiff_t      GLintptr;
+typedef unsigned int   GLbitfield;
+typedef unsigned char  GLubyte;
+typedef void           GLvoid;
+
+#define GL_FALSE                        0
+#define GL_TRUE                         1
+#define GL_TRIANGLES                    0x0004
+#define GL_DEPTH_BUFFER_BIT             0x00000100
+#define GL_COLOR_BUFFER_BIT             0x00004000
+#define GL_LESS                         0x0201
+#define GL_LEQUAL                       0x0203
+#define GL_CULL_FACE                    0x0B44
+#define GL_DEPTH_TEST                   0x0B71
+#define GL_UNPACK_ALIGNMENT             0x0CF5
+#define GL_TEXTURE_2D                   0x0DE1
+#define GL_UNSIGNED_BYTE                0x1401
+#define GL_UNSIGNED_SHORT               0x1403
+#define GL_UNSIGNED_INT                 0x1405
+#define GL_FLOAT                        0x1406
+#define GL_RGB                          0x1907
+#define GL_RGBA                         0x1908
+#define GL_VERSION                      0x1F02
+#define GL_NEAREST                      0x2600
+#define GL_LINEAR                       0x2601
+#define GL_LINEAR_MIPMAP_LINEAR         0x2703
+#define GL_TEXTURE_MAG_FILTER           0x2800
+#define GL_TEXTURE_MIN_FILTER           0x2801
+#define GL_TEXTURE_WRAP_S               0x2802
+#define GL_TEXTURE_WRAP_T               0x2803
+#define GL_CLAMP_TO_EDGE                0x812F
+#define GL_TEXTURE0                     0x84C0
+#define GL_TEXTURE_CUBE_MAP             0x8513
+#define GL_TEXTURE_CUBE_MAP_POSITIVE_X  0x8515
+#define GL_BUFFER_SIZE                  0x8764
+#define GL_ARRAY_BUFFER                 0x8892
+#define GL_ELEMENT_ARRAY_BUFFER         0x8893
+#define GL_STREAM_DRAW                  0x88E0
+#define GL_STATIC_DRAW                  0x88E4
+#define GL_DYNAMIC_DRAW                 0x88E8
+#define GL_FRAGMENT_SHADER              0x8B30
+#define GL_VERTEX_SHADER                0x8B31
+#define GL_COMPILE_STATUS               0x8B81
+#define GL_LINK_STATUS                  0x8B82
+#define GL_INFO_LOG_LENGTH              0x8B84
+
+extern "C"
+{
+    void glGenBuffers( GLsizei n, GLuint* buffers );
+    void glDeleteBuffers( GLsizei n, const GLuint* buffers );
+    void glBindBuffer( GLenum target, GLuint buffer );
+    void glBufferData( GLenum target, GLsizeiptr size, const void* data, GLenum usage );
+    void glBufferSubData( GLenum target, GLintptr offset, GLsizeiptr size, const void* data );
+
+    GLint glGetAttribLocation( GLuint program, const GLchar* name );
+    void  glBindAttribLocation( GLuint program, GLuint index, const GLchar* name );
+    void  glEnableVertexAttribArray( GLuint index );
+    void  glDisableVertexAttribArray( GLuint index );
+    void  glVertexAttribPointer( GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride,
+                                 const void* pointer );
+    void  glDrawElements( GLenum mode, GLsizei count, GLenum type, const void* indices );
+    void  glDrawArrays( GLenum mode, GLint first, GLsizei count );
+
+    void glGenTextures( GLsizei n, GLuint* textures );
+    void glDeleteTextures( GLsizei n, const GLuint* textures );
+    void glBindTexture( GLenum target, GLuint texture );
+    void glActiveTexture( GLenum texture );
+    void glTexImage2D( GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
+                       GLint border, GLenum format, GLenum type, const void* pixels );
+    void glTexSubImage2D( GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width,
+                          GLsizei height, GLenum format, GLenum type, const void* pixels );
+    void glGenerateMipmap( GLenum target );
+    void glTexParameteri( GLenum target, GLenum pname, GLint param );
+    void glPixelStorei( GLenum pname, GLint param );
+
+    void            glEnable( GLenum cap );
+    void            glDisable( GLenum cap );
+    void            glDepthFunc( GLenum func );
+    void            glViewport( GLint x, GLint y, GLsizei width, GLsizei height );
+    void            glClearColor( GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha );
+    void            glClear( GLbitfield mask );
+    const GLubyte*  glGetString( GLenum name );
+    GLenum          glGetError();
+
+    GLuint glCreateShader( GLenum type );
+    void   glShaderSource( GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length );
+    void   glCompileShader( GLuint shader );
+    void   glGetShaderiv( GLuint shader, GLenum pname, GLint* params );
+    void   glGetShaderInfoLog( GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog );
+    GLuint glCreateProgram();
+    void   glAttachShader( GLuint program, GLuint shader );
+    void   glDetachShader( GLuint program, GLuint shader );
+    void   glLinkProgram( GLuint program );
+    void   glDeleteShader( GLuint shader );
+    void   glDeleteProgram( GLuint program );
+    void   glUseProgram( GLuint program );
+    void   glGetProgramiv( GLuint program, GLenum pname, GLint* params );
+    void   glGetProgramInfoLog( GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog );
+
+    GLint glGetUniformLocation( GLuint program, const GLchar* name );
+    void  glUniform1i( GLint location, GLint v0 );
+    void  glUniform1f( GLint location, GLfloat v0 );
+    void  glUniform2fv( GLint location, GLsizei count, const GLfloat* value );
+    void  glUniform3fv( GLint location, GLsizei count, const GLfloat* value );
+    void  glUniform4fv( GLint location, GLsizei count, const GLfloat* value );
+    void  glUniformMatrix2fv( GLint location, GLsizei count, GLboolean transpose, const GLfloat* value );
+    void  glUniformMatrix3fv( GLint location, GLsizei count, GLboolean transpose, const GLfloat* value );
+    void  glUniformMatrix4fv( GLint location, GLsizei count, GLboolean transpose, const GLfloat* value );
+}
+
+#endif
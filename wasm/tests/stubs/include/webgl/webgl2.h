@@ -0,0 +1,15 @@
+#ifndef AAKARA_STUB_WEBGL2_H
+#define AAKARA_STUB_WEBGL2_H
+
+// Native stand-in for <webgl/webgl2.h>, only the additions over WebGL1 the engine uses.
+
+#include <webgl/webgl1.h>
+
+#define GL_TEXTURE_WRAP_R 0x8072
+
+extern "C"
+{
+    void glDepthMask( GLboolean flag );
+}
+
+#endif
@@ -0,0 +1,414 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unordered_map>
+#include <vector>
+#include <webgl/stats.h>
+#include <webgl/webgl2.h>
+
+// A recording WebGL: buffers keep their bytes so out-of-range writes fail loudly, everything else only
+// counts calls. Shaders always compile and every uniform and attribute has a location.
+
+namespace
+{
+    AakaraGLStats                                     g_stats {};
+    GLuint                                            g_next = 1;
+    std::unordered_map<GLuint, std::vector<GLubyte>> g_buffers;
+    std::unordered_map<GLuint, bool>                  g_textures;
+    GLuint                                            g_arrayBuffer   = 0;
+    GLuint                                            g_elementBuffer = 0;
+
+    void Fail( const char* what )
+    {
+        std::fprintf( stderr, "[gl] %s\n", what );
+        std::abort();
+    }
+
+    std::vector<GLubyte>& Bound( GLenum target )
+    {
+        GLuint buffer = target == GL_ELEMENT_ARRAY_BUFFER ? g_elementBuffer : g_arrayBuffer;
+
+        auto it = g_buffers.find( buffer );
+        if ( it == g_buffers.end() )
+            Fail( "no buffer bound" );
+
+        return it->second;
+    }
+}
+
+extern "C"
+{
+    AakaraGLStats aakara_stub_gl_stats( void )
+    {
+        AakaraGLStats stats = g_stats;
+        stats.liveBuffers   = g_buffers.size();
+        stats.liveTextures  = g_textures.size();
+        return stats;
+    }
+
+    void aakara_stub_gl_reset_stats( void )
+    {
+        g_stats = AakaraGLStats {};
+    }
+
+    const unsigned char* aakara_stub_gl_bound_data( unsigned int target, unsigned long long* size )
+    {
+        auto it = g_buffers.find( target == GL_ELEMENT_ARRAY_BUFFER ? g_elementBuffer : g_arrayBuffer );
+        if ( it == g_buffers.end() )
+            return nullptr;
+
+        *size = it->second.size();
+        return it->second.data();
+    }
+
+    void glGenBuffers( GLsizei n, GLuint* buffers )
+    {
+        g_stats.calls++;
+        for ( GLsizei i = 0; i < n; i++ )
+        {
+            buffers[i] = g_next++;
+            g_buffers[buffers[i]];
+        }
+    }
+
+    void glDeleteBuffers( GLsizei n, const GLuint* buffers )
+    {
+        g_stats.calls++;
+        for ( GLsizei i = 0; i < n; i++ )
+        {
+            if ( buffers[i] == 0 )
+                continue;
+
+            if ( g_buffers.erase( buffers[i] ) == 0 )
+                Fail( "glDeleteBuffers: unknown buffer" );
+
+            if ( g_arrayBuffer == buffers[i] )
+                g_arrayBuffer = 0;
+            if ( g_elementBuffer == buffers[i] )
+                g_elementBuffer = 0;
+        }
+    }
+
+    void glBindBuffer( GLenum target, GLuint buffer )
+    {
+        g_stats.calls++;
+        g_stats.bufferBinds++;
+
+        if ( buffer != 0 && g_buffers.find( buffer ) == g_buffers.end() )
+            Fail( "glBindBuffer: unknown buffer" );
+
+        if ( target == GL_ELEMENT_ARRAY_BUFFER )
+            g_elementBuffer = buffer;
+        else
+            g_arrayBuffer = buffer;
+    }
+
+    void glBufferData( GLenum target, GLsizeiptr size, const void* data, GLenum usage )
+    {
+        g_stats.calls++;
+        g_stats.uploadBytes += size;
+
+        std::vector<GLubyte>& bytes = Bound( target );
+        bytes.assign( size, 0 );
+        if ( data )
+            std::memcpy( bytes.data(), data, size );
+    }
+
+    void glBufferSubData( GLenum target, GLintptr offset, GLsizeiptr size, const void* data )
+    {
+        g_stats.calls++;
+        g_stats.uploadBytes += size;
+
+        std::vector<GLubyte>& bytes = Bound( target );
+        if ( offset < 0 || offset + size > (GLintptr)bytes.size() )
+            Fail( "glBufferSubData: write past the end of the buffer" );
+
+        std::memcpy( bytes.data() + offset, data, size );
+    }
+
+    GLint glGetAttribLocation( GLuint program, const GLchar* name )
+    {
+        g_stats.calls++;
+        return 0;
+    }
+
+    void glBindAttribLocation( GLuint program, GLuint index, const GLchar* name )
+    {
+        g_stats.calls++;
+    }
+
+    void glEnableVertexAttribArray( GLuint index )
+    {
+        g_stats.calls++;
+    }
+
+    void glDisableVertexAttribArray( GLuint index )
+    {
+        g_stats.calls++;
+    }
+
+    void glVertexAttribPointer( GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride,
+                                const void* pointer )
+    {
+        g_stats.calls++;
+        if ( g_arrayBuffer == 0 )
+            Fail( "glVertexAttribPointer: no array buffer bound" );
+    }
+
+    void glDrawElements( GLenum mode, GLsizei count, GLenum type, const void* indices )
+    {
+        g_stats.calls++;
+        g_stats.draws++;
+
+        size_t size = type == GL_UNSIGNED_INT ? 4 : type == GL_UNSIGNED_SHORT ? 2 : 1;
+        if ( (size_t)indices + count * size > Bound( GL_ELEMENT_ARRAY_BUFFER ).size() )
+            Fail( "glDrawElements: indices past the end of the element buffer" );
+    }
+
+    void glDrawArrays( GLenum mode, GLint first, GLsizei count )
+    {
+        g_stats.calls++;
+        g_stats.draws++;
+    }
+
+    void glGenTextures( GLsizei n, GLuint* textures )
+    {
+        g_stats.calls++;
+        for ( GLsizei i = 0; i < n; i++ )
+        {
+            textures[i]             = g_next++;
+            g_textures[textures[i]] = true;
+        }
+    }
+
+    void glDeleteTextures( GLsizei n, const GLuint* textures )
+    {
+        g_stats.calls++;
+        for ( GLsizei i = 0; i < n; i++ )
+            g_textures.erase( textures[i] );
+    }
+
+    void glBindTexture( GLenum target, GLuint texture )
+    {
+        g_stats.calls++;
+        g_stats.textureBinds++;
+    }
+
+    void glActiveTexture( GLenum texture )
+    {
+        g_stats.calls++;
+    }
+
+    void glTexImage2D( GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height,
+                       GLint border, GLenum format, GLenum type, const void* pixels )
+    {
+        g_stats.calls++;
+        if ( pixels )
+            g_stats.uploadBytes += (unsigned long long)width * height * ( format == GL_RGBA ? 4 : 3 );
+    }
+
+    void glTexSubImage2D( GLenum target, GLint level, GLint xoffset, GLint yoffset, GLsizei width,
+                          GLsizei height, GLenum format, GLenum type, const void* pixels )
+    {
+        g_stats.calls++;
+        g_stats.uploadBytes += (unsigned long long)width * height * ( format == GL_RGBA ? 4 : 3 );
+    }
+
+    void glGenerateMipmap( GLenum target )
+    {
+        g_stats.calls++;
+    }
+
+    void glTexParameteri( GLenum target, GLenum pname, GLint param )
+    {
+        g_stats.calls++;
+    }
+
+    void glPixelStorei( GLenum pname, GLint param )
+    {
+        g_stats.calls++;
+    }
+
+    void glEnable( GLenum cap )
+    {
+        g_stats.calls++;
+    }
+
+    void glDisable( GLenum cap )
+    {
+        g_stats.calls++;
+    }
+
+    void glDepthFunc( GLenum func )
+    {
+        g_stats.calls++;
+    }
+
+    void glDepthMask( GLboolean flag )
+    {
+        g_stats.calls++;
+    }
+
+    void glViewport( GLint x, GLint y, GLsizei width, GLsizei height )
+    {
+        g_stats.calls++;
+    }
+
+    void glClearColor( GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha )
+    {
+        g_stats.calls++;
+    }
+
+    void glClear( GLbitfield mask )
+    {
+        g_stats.calls++;
+    }
+
+    const GLubyte* glGetString( GLenum name )
+    {
+        g_stats.calls++;
+        return (const GLubyte*)"WebGL 1.0 (native stub)";
+    }
+
+    GLenum glGetError()
+    {
+        g_stats.calls++;
+        return 0;
+    }
+
+    GLuint glCreateShader( GLenum type )
+    {
+        g_stats.calls++;
+        return g_next++;
+    }
+
+    void glShaderSource( GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length )
+    {
+        g_stats.calls++;
+    }
+
+    void glCompileShader( GLuint shader )
+    {
+        g_stats.calls++;
+    }
+
+    void glGetShaderiv( GLuint shader, GLenum pname, GLint* params )
+    {
+        g_stats.calls++;
+        *params = pname == GL_COMPILE_STATUS ? GL_TRUE : 0;
+    }
+
+    void glGetShaderInfoLog( GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog )
+    {
+        g_stats.calls++;
+        if ( length )
+            *length = 0;
+        if ( bufSize > 0 )
+            infoLog[0] = '\0';
+    }
+
+    GLuint glCreateProgram()
+    {
+        g_stats.calls++;
+        return g_next++;
+    }
+
+    void glAttachShader( GLuint program, GLuint shader )
+    {
+        g_stats.calls++;
+    }
+
+    void glDetachShader( GLuint program, GLuint shader )
+    {
+        g_stats.calls++;
+    }
+
+    void glLinkProgram( GLuint program )
+    {
+        g_stats.calls++;
+    }
+
+    void glDeleteShader( GLuint shader )
+    {
+        g_stats.calls++;
+    }
+
+    void glDeleteProgram( GLuint program )
+    {
+        g_stats.calls++;
+    }
+
+    void glUseProgram( GLuint program )
+    {
+        g_stats.calls++;
+    }
+
+    void glGetProgramiv( GLuint program, GLenum pname, GLint* params )
+    {
+        g_stats.calls++;
+        *params = pname == GL_LINK_STATUS ? GL_TRUE : 0;
+    }
+
+    void glGetProgramInfoLog( GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog )
+    {
+        g_stats.calls++;
+        if ( length )
+            *length = 0;
+        if ( bufSize > 0 )
+            infoLog[0] = '\0';
+    }
+
+    GLint glGetUniformLocation( GLuint program, const GLchar* name )
+    {
+        g_stats.calls++;
+        return 1;
+    }
+
+    void glUniform1i( GLint location, GLint v0 )
+    {
+        g_stats.calls++;
+        g_stats.uniforms++;
+    }
+
+    void glUniform1f( GLint location, GLfloat v0 )
+    {
+        g_stats.calls++;
+        g_stats.uniforms++;
+    }
+
+    void glUniform2fv( GLint location, GLsizei count, const GLfloat* value )
+    {
+        g_stats.calls++;
+        g_stats.uniforms++;
+    }
+
+    void glUniform3fv( GLint location, GLsizei count, const GLfloat* value )
+    {
+        g_stats.calls++;
+        g_stats.uniforms++;
+    }
+
+    void glUniform4fv( GLint location, GLsizei count, const GLfloat* value )
+    {
+        g_stats.calls++;
+        g_stats.uniforms++;
+    }
+
+    void glUniformMatrix2fv( GLint location, GLsizei count, GLboolean transpose, const GLfloat* value )
+    {
+        g_stats.calls++;
+        g_stats.uniforms++;
+    }
+
+    void glUniformMatrix3fv( GLint location, GLsizei count, GLboolean transpose, const GLfloat* value )
+    {
+        g_stats.calls++;
+        g_stats.uniforms++;
+    }
+
+    void glUniformMatrix4fv( GLint location, GLsizei count, GLboolean transpose, const GLfloat* value )
+    {
+        g_stats.calls++;
+        g_stats.uniforms++;
+    }
+}
@@ -0,0 +1,343 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+#include <emscripten/emscripten.h>
+#include <glm/mat4x4.hpp>
+
+#include <aakara/AssetCache.hpp>
+#include <aakara/ChunkedMesh.hpp>
+#include <aakara/JobSystem.hpp>
+#include <aakara/MemoryBudget.hpp>
+#include <aakara/Mesh.hpp>
+#include <aakara/Part.hpp>
+#include <aakara/PartLoader.hpp>
+#include <aakara/Texture.hpp>
+#include <aakara/Transform.hpp>
+
+#include "Check.hpp"
+#include "RangeServer.hpp"
+
+// The persistent asset cache over a plain directory: entries round-trip with their validator, a colliding
+// or outdated entry is a miss, and PartLoader revalidates with conditional requests, falling back to an
+// unconditional one when a 304 finds the payload gone.
+
+namespace fs = std::filesystem;
+
+static const string Url   = "https://example.com/assets/wheel.glb";
+static const string Other = "https://example.com/assets/door.glb";
+
+/**
+ * @brief A fresh directory under the system's temporary one, removed again with the object.
+ */
+struct TemporaryDirectory
+{
+    fs::path path;
+
+    TemporaryDirectory()
+    {
+        string pattern = ( fs::temp_directory_path() / "aakara-cache-XXXXXX" ).string();
+        CHECK( mkdtemp( pattern.data() ) );
+        path = pattern;
+    }
+
+    ~TemporaryDirectory()
+    {
+        fs::remove_all( path );
+    }
+
+    /**
+     * @brief Files in the directory with an extension, e.g. ".meta".
+     */
+    Array<fs::path> files( const string& extension ) const
+    {
+        Array<fs::path> found;
+        for ( const fs::directory_entry& entry : fs::directory_iterator( path ) )
+        {
+            if ( entry.path().extension() == extension )
+                found.push_back( entry.path() );
+        }
+
+        return found;
+    }
+};
+
+static Array<u8> BytesOf( const string& text )
+{
+    return Array<u8>( text.begin(), text.end() );
+}
+
+static void Storage()
+{
+    TemporaryDirectory directory;
+    DirectoryStorage   storage( directory.path.string() );
+
+    Array<u8> read;
+    CHECK( !storage.read( "missing", read ) );
+
+    storage.write( "blob", BytesOf( "first" ) );
+    storage.write( "blob", BytesOf( "second" ) );
+    CHECK( storage.read( "blob", read ) && read == BytesOf( "second" ) );
+
+    // written through a temporary file that is renamed over the target
+    CHECK( directory.files( ".tmp" ).empty() );
+
+    storage.write( "empty", {} );
+    CHECK( storage.read( "empty", read ) && read.empty() );
+
+    storage.remove( "blob" );
+    CHECK( !storage.read( "blob", read ) );
+}
+
+static void RoundTrip()
+{
+    TemporaryDirectory directory;
+    AssetCache         cache( std::make_shared<DirectoryStorage>( directory.path.string() ) );
+
+    HTTP::Header condition;
+    Array<u8>    payload;
+    CHECK( !cache.condition( Url, condition ) );
+    CHECK( !cache.load( Url, payload ) );
+
+    cache.store( Url, { "If-None-Match", "\"v1\"" }, BytesOf( "converted" ) );
+    cache.flush();
+
+    CHECK( cache.condition( Url, condition ) );
+    CHECK( condition.Key == "If-None-Match" && condition.Value == "\"v1\"" );
+    CHECK( cache.load( Url, payload ) && payload == BytesOf( "converted" ) );
+    CHECK( !cache.condition( Other, condition ) );
+
+    // a validator may contain anything but a line break, and a later store replaces it
+    cache.store( Url, { "If-Modified-Since", "Wed, 21 Oct 2015 07:28:00 GMT" }, BytesOf( "again" ) );
+    CHECK( cache.condition( Url, condition ) );
+    CHECK( condition.Key == "If-Modified-Since" && condition.Value == "Wed, 21 Oct 2015 07:28:00 GMT" );
+    CHECK( cache.load( Url, payload ) && payload == BytesOf( "again" ) );
+
+    // entries live in the directory, not the object
+    AssetCache reopened( std::make_shared<DirectoryStorage>( directory.path.string() ) );
+    CHECK( reopened.condition( Url, condition ) && condition.Key == "If-Modified-Since" );
+    CHECK( directory.files( ".meta" ).size() == 1 && directory.files( ".bin" ).size() == 1 );
+}
+
+static void Collision()
+{
+    TemporaryDirectory directory;
+    AssetCache         cache( std::make_shared<DirectoryStorage>( directory.path.string() ) );
+
+    cache.store( Url, { "If-None-Match", "\"wheel\"" }, BytesOf( "wheel" ) );
+    fs::path wheel = directory.files( ".meta" ).front();
+
+    cache.store( Other, { "If-None-Match", "\"door\"" }, BytesOf( "door" ) );
+
+    fs::path door;
+    for ( const fs::path& meta : directory.files( ".meta" ) )
+    {
+        if ( meta != wheel )
+            door = meta;
+    }
+
+    // the door's name now holds the wheel's entry, as if the two URLs hashed alike
+    fs::copy_file( wheel, door, fs::copy_options::overwrite_existing );
+
+    HTTP::Header condition;
+    CHECK( !cache.condition( Other, condition ) );
+    CHECK( cache.condition( Url, condition ) && condition.Value == "\"wheel\"" );
+
+    // a meta file without all three lines is not an entry either
+    std::FILE* file = std::fopen( wheel.c_str(), "wb" );
+    CHECK( file );
+    std::fputs( Url.c_str(), file );
+    std::fclose( file );
+
+    CHECK( !cache.condition( Url, condition ) );
+}
+
+static void FormatVersion()
+{
+    TemporaryDirectory directory;
+    Ptr<CacheStorage>  storage = std::make_shared<DirectoryStorage>( directory.path.string() );
+
+    AssetCache current( storage );
+    current.store( Url, { "If-None-Match", "\"v1\"" }, BytesOf( "old layout" ) );
+
+    // entries of the previous layout are left alone, and never read
+    AssetCache   bumped( storage, AssetCache::FORMAT_VERSION + 1 );
+    HTTP::Header condition;
+    Array<u8>    payload;
+    CHECK( !bumped.condition( Url, condition ) );
+    CHECK( !bumped.load( Url, payload ) );
+
+    bumped.store( Url, { "If-None-Match", "\"v1\"" }, BytesOf( "new layout" ) );
+    CHECK( bumped.load( Url, payload ) && payload == BytesOf( "new layout" ) );
+    CHECK( current.load( Url, payload ) && payload == BytesOf( "old layout" ) );
+    CHECK( directory.files( ".meta" ).size() == 2 );
+}
+
+static void Serialize()
+{
+    Ref<Mesh> mesh = Grid( 6 );
+
+    // appended after whatever the buffer holds, as ChunkedMesh::Write() relies on
+    Array<u8> bytes = BytesOf( "prefix" );
+    mesh->Serialize( bytes );
+
+    Ref<Mesh> restored = Mesh::Deserialize( bytes.data() + 6, bytes.size() - 6 );
+    CHECK( restored->Vertices.size() == mesh->Vertices.size() );
+    CHECK( restored->Indices == mesh->Indices );
+    CHECK( std::memcmp( restored->Vertices.data(), mesh->Vertices.data(), Memory::BytesOf( mesh->Vertices ) )
+           == 0 );
+
+    bool threw = false;
+    try
+    {
+        Mesh::Deserialize( bytes.data() + 6, bytes.size() - 7 );
+    }
+    catch ( const std::runtime_error& )
+    {
+        threw = true;
+    }
+    CHECK( threw );
+
+    Array<u8> pixels( 4 * 4 * 4 );
+    for ( size_t i = 0; i < pixels.size(); i++ )
+        pixels[i] = (u8)( i * 7 );
+
+    Ref<Texture> texture = MakeRef<Texture>( std::move( pixels ), 4, 4, Texture::PixelType::RGBA );
+
+    Array<u8> serialized;
+    texture->Serialize( serialized );
+
+    Ref<Texture> copy = Texture::Deserialize( serialized.data(), serialized.size() );
+    CHECK( copy->GetWidth() == 4 && copy->GetHeight() == 4 && copy->GetFormat() == Texture::PixelType::RGBA );
+
+    Array<u8> again;
+    copy->Serialize( again );
+    CHECK( again == serialized );
+
+    // halved twice on the way in
+    Ref<Texture> small = Texture::Deserialize( serialized.data(), serialized.size(), 2 );
+    CHECK( small->GetWidth() == 1 && small->GetHeight() == 1 );
+
+    threw = false;
+    try
+    {
+        Texture::Deserialize( bytes.data() + 6, bytes.size() - 6 );
+    }
+    catch ( const std::runtime_error& )
+    {
+        threw = true;
+    }
+    CHECK( threw );
+}
+
+/**
+ * @brief Load a part with a streamed mesh and the texture through the loader, and let it store what it
+ * converted.
+ */
+static Ref<Part> Load( PartLoader& loader, RangeServer& server, JobSystem& jobs,
+    MpscQueue<Ref<Part>>& completed, MpscQueue<LoadedChunk>& chunks )
+{
+    glm::mat4 viewProjection( 1.0f );
+    glm::vec3 eye( 0.0f, 0.0f, 10.0f );
+
+    Ref<Part> requested = loader.load( "/grid.akc", "/white.png", MakeRef<Transform>() );
+    Ref<Part> loaded;
+
+    double start = emscripten_get_now();
+    while ( !loaded )
+    {
+        CHECK( emscripten_get_now() - start < 10000.0 );
+
+        loader.update( viewProjection, eye );
+        server.respond();
+        jobs.waitForTasks();
+
+        chunks.drain( []( LoadedChunk chunk ) { CHECK( chunk.mesh ); } );
+        completed.tryPop( loaded );
+    }
+
+    CHECK( loaded == requested && !loaded->failed );
+    CHECK( loaded->texture && loaded->texture->GetWidth() == 1 );
+
+    // cache writes of the decodes are stored by the next update()
+    loader.update( viewProjection, eye );
+    CHECK( loader.getInFlight() == 0 && loader.getPending() == 0 );
+
+    return loaded;
+}
+
+static void NotModified()
+{
+    TemporaryDirectory directory;
+    Ptr<AssetCache>    cache = std::make_shared<AssetCache>(
+        std::make_shared<DirectoryStorage>( directory.path.string() ) );
+
+    Array<u8> file;
+    ChunkedMesh::Write( { Grid( 8 ) }, file );
+
+    Ptr<RangeServer> server     = std::make_shared<RangeServer>();
+    server->files["/grid.akc"]  = file;
+    server->files["/white.png"] = Array<u8>( Png, Png + sizeof( Png ) );
+    server->etags["/white.png"] = "\"png-1\"";
+
+    HTTP::SetTransport( server );
+
+    JobSystem              jobs( 2 );
+    MpscQueue<Ref<Part>>   completed( 16 );
+    MpscQueue<LoadedChunk> chunks( 16 );
+    MemoryBudget           budget;
+
+    auto textureRequests = [&server]()
+    { return (u32)std::count( server->sent.begin(), server->sent.end(), string( "/white.png" ) ); };
+
+    // nothing cached: fetched, decoded and stored with its ETag
+    {
+        PartLoader loader( jobs, completed, chunks, budget, 4, cache );
+        Load( loader, *server, jobs, completed, chunks );
+    }
+
+    HTTP::Header condition;
+    CHECK( server->conditional == 0 && textureRequests() == 1 );
+    CHECK( cache->condition( "/white.png", condition ) );
+    CHECK( condition.Key == "If-None-Match" && condition.Value == "\"png-1\"" );
+
+    // revalidated: the 304 restores the cached copy
+    {
+        PartLoader loader( jobs, completed, chunks, budget, 4, cache );
+        Load( loader, *server, jobs, completed, chunks );
+    }
+
+    CHECK( server->conditional == 1 && server->notModified == 1 && textureRequests() == 2 );
+
+    // the payload vanished while its validator stayed: the 304 is followed by an unconditional request
+    for ( const fs::path& bin : directory.files( ".bin" ) )
+        fs::remove( bin );
+
+    {
+        PartLoader loader( jobs, completed, chunks, budget, 4, cache );
+        Load( loader, *server, jobs, completed, chunks );
+    }
+
+    CHECK( server->conditional == 2 && server->notModified == 2 && textureRequests() == 4 );
+    CHECK( server->sent.back() == "/white.png" );
+
+    // and the full response is cached again
+    Array<u8> payload;
+    CHECK( cache->load( "/white.png", payload ) && !payload.empty() );
+}
+
+int main()
+{
+    Storage();
+    RoundTrip();
+    Collision();
+    FormatVersion();
+    Serialize();
+    NotModified();
+
+    std::printf( "asset cache ok\n" );
+
+    return 0;
+}
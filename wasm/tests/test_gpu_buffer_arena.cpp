@@ -0,0 +1,381 @@
+#include <cstdio>
+#include <cstring>
+#include <webgl/stats.h>
+#include <webgl/webgl1.h>
+
+#include <aakara/FrameArena.hpp>
+#include <aakara/GpuBufferArena.hpp>
+#include <aakara/Mesh.hpp>
+#include <aakara/RenderList.hpp>
+#include <aakara/Renderer.hpp>
+#include <aakara/Texture.hpp>
+
+#include "Check.hpp"
+
+// GpuBufferArena over the recording GL: free spans coalesce in every direction, oversized meshes get a block
+// of their own, sliced uploads write exactly what the budget allows, and defragment() empties the sparsest
+// block, re-keying the draws of what it moved. The arena is a singleton, so every case leaves it holding no
+// ranges and a single empty block.
+
+static const u32 BlockVertices = GpuBufferArena::BLOCK_VERTICES;
+static const u32 BlockIndices  = GpuBufferArena::BLOCK_INDICES;
+
+/**
+ * @brief A mesh whose every vertex and index is distinct, so a misplaced write shows.
+ */
+static Ref<Mesh> MeshOf( u32 vertexCount, u32 indexCount )
+{
+    Array<GpuVertex> vertices( vertexCount );
+    for ( u32 i = 0; i < vertexCount; i++ )
+        vertices[i] = { glm::vec3( (f32)i, 1.0f, 2.0f ), glm::vec3( 0.0f, 0.0f, 1.0f ), glm::vec2( 0.5f ) };
+
+    Array<u16> indices( indexCount );
+    for ( u32 i = 0; i < indexCount; i++ )
+        indices[i] = (u16)( i * 31 + 7 );
+
+    return MakeRef<Mesh>( std::move( vertices ), std::move( indices ) );
+}
+
+/**
+ * @brief Whether the block's buffers hold the given arrays at a range's place.
+ */
+static bool Holds( GpuBufferArena& arena, const GpuBufferArena::Range& range,
+    const Array<GpuVertex>& vertices, const Array<u16>& indices )
+{
+    arena.resetBinding();
+    arena.bind( range.block );
+
+    unsigned long long vertexSize = 0, indexSize = 0;
+    const u8*          vertexData = aakara_stub_gl_bound_data( GL_ARRAY_BUFFER, &vertexSize );
+    const u8*          indexData  = aakara_stub_gl_bound_data( GL_ELEMENT_ARRAY_BUFFER, &indexSize );
+
+    u64 vertexOffset = (u64)range.firstVertex * sizeof( GpuVertex );
+    u64 indexOffset  = (u64)range.firstIndex * sizeof( u16 );
+
+    return vertexData && indexData && vertexOffset + Memory::BytesOf( vertices ) <= vertexSize
+           && indexOffset + Memory::BytesOf( indices ) <= indexSize
+           && std::memcmp( vertexData + vertexOffset, vertices.data(), Memory::BytesOf( vertices ) ) == 0
+           && std::memcmp( indexData + indexOffset, indices.data(), Memory::BytesOf( indices ) ) == 0;
+}
+
+static u32 Allocate( GpuBufferArena& arena, Mesh& mesh )
+{
+    u32 handle = arena.allocate( mesh );
+    CHECK( handle != GpuBufferArena::Invalid );
+
+    u64 unlimited = UINT64_MAX;
+    CHECK( arena.upload( handle, unlimited ) );
+    CHECK( Holds( arena, *arena.get( handle ), mesh.Vertices, mesh.Indices ) );
+
+    return handle;
+}
+
+// four ranges of a block are released so that every release joins the spans around it differently; each
+// time, a mesh that only fits the joined span lands at its start
+static void Coalesce()
+{
+    GpuBufferArena& arena = GpuBufferArena::Instance();
+
+    // four indices per vertex, as the block has: index spans coalesce like the vertex spans
+    const u32 quarter = 30000;
+
+    Ref<Mesh> meshes[4];
+    u32       handles[4];
+    for ( u32 i = 0; i < 4; i++ )
+    {
+        meshes[i]  = MeshOf( quarter, quarter * 4 );
+        handles[i] = Allocate( arena, *meshes[i] );
+
+        const GpuBufferArena::Range& range = *arena.get( handles[i] );
+        CHECK( range.block == arena.get( handles[0] )->block );
+        CHECK( range.firstVertex == i * quarter && range.firstIndex == i * quarter * 4 );
+    }
+
+    u32 block = arena.get( handles[0] )->block;
+    CHECK( arena.stats().blocks == 1 && arena.stats().ranges == 4 );
+
+    // neither neighbour is free: the hole stays a span of its own, too small for one vertex more
+    arena.release( handles[1] );
+    {
+        Ref<Mesh> larger = MeshOf( quarter + 1, 3 );
+        u32       handle = Allocate( arena, *larger );
+        CHECK( arena.get( handle )->block != block && arena.stats().blocks == 2 );
+
+        // its block empties and goes, the other one is still in use
+        arena.release( handle );
+        CHECK( arena.stats().blocks == 1 );
+    }
+
+    // joins the previous span
+    arena.release( handles[2] );
+    {
+        Ref<Mesh> joined = MeshOf( quarter * 2, quarter * 8 );
+        u32       handle = Allocate( arena, *joined );
+        CHECK( arena.get( handle )->block == block );
+        CHECK( arena.get( handle )->firstVertex == quarter );
+        CHECK( arena.get( handle )->firstIndex == quarter * 4 );
+        arena.release( handle );
+    }
+
+    // joins the next span
+    arena.release( handles[0] );
+    {
+        Ref<Mesh> joined = MeshOf( quarter * 3, quarter * 12 );
+        u32       handle = Allocate( arena, *joined );
+        CHECK( arena.get( handle )->block == block );
+        CHECK( arena.get( handle )->firstVertex == 0 && arena.get( handle )->firstIndex == 0 );
+        arena.release( handle );
+    }
+
+    // joins both, back to one span over the whole block
+    arena.release( handles[3] );
+    {
+        Ref<Mesh> whole  = MeshOf( BlockVertices, BlockIndices );
+        u32       handle = Allocate( arena, *whole );
+        CHECK( arena.get( handle )->block == block && arena.get( handle )->firstVertex == 0 );
+        CHECK( arena.stats().blocks == 1 );
+        arena.release( handle );
+    }
+
+    // the last block is kept, empty
+    GpuBufferArena::Stats stats = arena.stats();
+    CHECK( stats.blocks == 1 && stats.ranges == 0 && stats.usedBytes == 0 );
+    CHECK( !arena.get( handles[0] ) && !arena.get( handles[3] ) );
+}
+
+static void Oversized()
+{
+    GpuBufferArena& arena   = GpuBufferArena::Instance();
+    u64             buffers = aakara_stub_gl_stats().liveBuffers;
+    u64             before  = arena.stats().capacityBytes;
+
+    Ref<Mesh> vertices = MeshOf( BlockVertices + 1, 6 );
+    Ref<Mesh> indices  = MeshOf( 4, BlockIndices + 3 );
+
+    u32 a = Allocate( arena, *vertices );
+    u32 b = Allocate( arena, *indices );
+
+    // each in a block sized for it, not in the empty block already there
+    CHECK( arena.get( a )->block != arena.get( b )->block );
+    CHECK( arena.get( a )->firstVertex == 0 && arena.get( b )->firstIndex == 0 );
+    CHECK( arena.stats().blocks == 3 && aakara_stub_gl_stats().liveBuffers == buffers + 4 );
+
+    u64 blockA = (u64)( BlockVertices + 1 ) * sizeof( GpuVertex ) + (u64)BlockIndices * sizeof( u16 );
+    u64 blockB = (u64)BlockVertices * sizeof( GpuVertex ) + (u64)( BlockIndices + 3 ) * sizeof( u16 );
+    CHECK( arena.stats().capacityBytes == before + blockA + blockB );
+
+    arena.release( a );
+    arena.release( b );
+    CHECK( arena.stats().blocks == 1 && aakara_stub_gl_stats().liveBuffers == buffers );
+    CHECK( arena.stats().capacityBytes == before );
+}
+
+static void Sliced()
+{
+    GpuBufferArena& arena = GpuBufferArena::Instance();
+
+    const u64 vertexBytes = 5 * sizeof( GpuVertex );
+
+    Ref<Mesh> mesh   = MeshOf( 5, 7 );
+    u32       handle = arena.allocate( *mesh );
+    CHECK( handle != GpuBufferArena::Invalid && !arena.get( handle )->resident() );
+
+    // the first vertex goes whatever the budget
+    u64 budget = 0;
+    CHECK( !arena.upload( handle, budget ) );
+    CHECK( budget == 0 && arena.get( handle )->uploaded == sizeof( GpuVertex ) );
+
+    // whole vertices only, and no index before the last vertex
+    budget = sizeof( GpuVertex ) + 8;
+    CHECK( !arena.upload( handle, budget ) );
+    CHECK( budget == 8 && arena.get( handle )->uploaded == 2 * sizeof( GpuVertex ) );
+
+    // the rest of the vertices, then indices in what remains
+    budget = 3 * sizeof( GpuVertex ) + 2 * sizeof( u16 ) + 1;
+    CHECK( !arena.upload( handle, budget ) );
+    CHECK( budget == 1 && arena.get( handle )->uploaded == vertexBytes + 2 * sizeof( u16 ) );
+
+    // an index-only remainder with no budget still advances
+    budget = 0;
+    CHECK( !arena.upload( handle, budget ) );
+    CHECK( arena.get( handle )->uploaded == vertexBytes + 3 * sizeof( u16 ) );
+
+    budget = 1000;
+    CHECK( arena.upload( handle, budget ) );
+    CHECK( budget == 1000 - 4 * sizeof( u16 ) && arena.get( handle )->resident() );
+    CHECK( Holds( arena, *arena.get( handle ), mesh->Vertices, mesh->Indices ) );
+    arena.release( handle );
+
+    // a budget of exactly the vertices leaves the indices to the next call
+    handle = arena.allocate( *mesh );
+    budget = vertexBytes;
+    CHECK( !arena.upload( handle, budget ) );
+    CHECK( budget == 0 && arena.get( handle )->uploaded == vertexBytes );
+
+    budget = 0;
+    CHECK( !arena.upload( handle, budget ) );
+    CHECK( arena.get( handle )->uploaded == vertexBytes + sizeof( u16 ) );
+
+    budget = 6 * sizeof( u16 );
+    CHECK( arena.upload( handle, budget ) && budget == 0 );
+    CHECK( Holds( arena, *arena.get( handle ), mesh->Vertices, mesh->Indices ) );
+    arena.release( handle );
+
+    // nothing to upload for a handle that does not resolve, and nothing allocated for an empty mesh
+    budget = 10;
+    CHECK( arena.upload( handle, budget ) && budget == 10 );
+
+    Ref<Mesh> empty = MakeRef<Mesh>();
+    CHECK( arena.allocate( *empty ) == GpuBufferArena::Invalid );
+    CHECK( arena.stats().ranges == 0 );
+}
+
+static u32 BlockOf( const Mesh& mesh )
+{
+    return ( mesh.getDrawKey() >> 20 ) - 1;
+}
+
+static bool Sorted( RenderList& list )
+{
+    for ( size_t i = 1; i < list.entries().size(); i++ )
+    {
+        if ( list.entries()[i - 1].key > list.entries()[i].key )
+            return false;
+    }
+
+    return true;
+}
+
+// meshes uploaded through Mesh, whose draw keys follow their block
+static void Defragment()
+{
+    GpuBufferArena& arena   = GpuBufferArena::Instance();
+    u64             buffers = aakara_stub_gl_stats().liveBuffers;
+
+    Ref<Texture> texture = MakeRef<Texture>( Array<u8>( 4, 0xFF ), 1, 1, Texture::PixelType::RGBA );
+    RenderList   list;
+    FrameArena   scratch;
+
+    // the kept block takes the first two, the next two need a second block
+    Ref<Mesh> kept    = MeshOf( 50000, 3 );
+    Ref<Mesh> dropped = MeshOf( 50000, 3 );
+    Ref<Mesh> moving  = MeshOf( 40000, 3 );
+    Ref<Mesh> freed   = MeshOf( 40000, 3 );
+
+    for ( Mesh* mesh : { kept.get(), dropped.get(), moving.get(), freed.get() } )
+        CHECK( mesh->update( nullptr ) );
+
+    u32 first  = BlockOf( *kept );
+    u32 second = BlockOf( *moving );
+    CHECK( BlockOf( *dropped ) == first && BlockOf( *freed ) == second && first != second );
+
+    u32 keptEntry   = list.add( kept.get(), texture.get(), 0 );
+    u32 movingEntry = list.add( moving.get(), texture.get(), 1 );
+    list.sort( scratch );
+
+    u64 keptKey   = list.get( keptEntry ).key;
+    u64 movingKey = list.get( movingEntry ).key;
+    CHECK( keptKey < movingKey );
+
+    // both blocks are under half full now, the second one more so
+    dropped = nullptr;
+    freed   = nullptr;
+    CHECK( arena.stats().blocks == 2 && arena.stats().ranges == 2 );
+
+    u64 moves      = arena.moves();
+    u32 generation = moving->getKeyGeneration();
+
+    // one range at least moves whatever the budget, and the second block goes with its last range
+    u64 moved = arena.defragment( 1 );
+    CHECK( moved == (u64)40000 * sizeof( GpuVertex ) + 3 * sizeof( u16 ) );
+    CHECK( arena.moves() == moves + 1 && moving->getKeyGeneration() == generation + 1 );
+    CHECK( BlockOf( *moving ) == first && BlockOf( *kept ) == first );
+    CHECK( arena.stats().blocks == 1 && arena.stats().movedBytes >= moved );
+    CHECK( aakara_stub_gl_stats().liveBuffers == buffers );
+
+    // uploaded again where the dropped mesh was
+    GpuBufferArena::Range expected;
+    expected.block       = first;
+    expected.firstVertex = 50000;
+    expected.firstIndex  = 3;
+    CHECK( Holds( arena, expected, moving->Vertices, moving->Indices ) );
+
+    // sorting picks up the move: only the moved entry is re-keyed
+    CHECK( list.get( movingEntry ).key == movingKey );
+    list.sort( scratch );
+    CHECK( list.get( movingEntry ).key == DrawPacket::MakeKey( moving.get(), texture.get() ) );
+    CHECK( list.get( movingEntry ).key != movingKey && list.get( keptEntry ).key == keptKey );
+    CHECK( list.get( movingEntry ).keyGeneration == moving->getKeyGeneration() );
+    CHECK( Sorted( list ) );
+
+    // a single block is never evacuated
+    CHECK( arena.defragment( UINT64_MAX ) == 0 && arena.moves() == moves + 1 );
+
+    list.remove( keptEntry );
+    list.remove( movingEntry );
+}
+
+// a mesh that freed its arrays is asked for them, and moves once it has them back
+static void Reread()
+{
+    GpuBufferArena& arena = GpuBufferArena::Instance();
+
+    // fill the first block, so the rereadable mesh needs a block of its own
+    Ref<Mesh> base   = MeshOf( 90000, 3 );
+    Ref<Mesh> filler = MeshOf( BlockVertices - 90000, 3 );
+    CHECK( base->update( nullptr ) && filler->update( nullptr ) );
+
+    Ref<Mesh>        chunk    = MeshOf( 30000, 6 );
+    Array<GpuVertex> vertices = chunk->Vertices;
+    Array<u16>       indices  = chunk->Indices;
+
+    Ref<Mesh> requested;
+    chunk->setReread( [&requested]( const Ref<Mesh>& mesh ) { requested = mesh; } );
+
+    CHECK( chunk->update( nullptr ) );
+    CHECK( !chunk->hasArrays() && BlockOf( *chunk ) != BlockOf( *base ) );
+
+    filler = nullptr;
+
+    // the sparse block's mesh cannot be uploaded again yet
+    u64 moves = arena.moves();
+    CHECK( arena.defragment( UINT64_MAX ) == 0 && arena.moves() == moves );
+    CHECK( requested == chunk && arena.stats().blocks == 2 );
+
+    // asked once until the arrays are back
+    requested = nullptr;
+    CHECK( arena.defragment( UINT64_MAX ) == 0 && !requested );
+
+    chunk->restoreArrays( std::move( vertices ), std::move( indices ) );
+    CHECK( chunk->hasArrays() );
+    vertices = chunk->Vertices;
+    indices  = chunk->Indices;
+
+    CHECK( arena.defragment( UINT64_MAX ) > 0 && arena.moves() == moves + 1 );
+    CHECK( BlockOf( *chunk ) == BlockOf( *base ) && arena.stats().blocks == 1 );
+
+    // moved, it lets go of the arrays again
+    CHECK( !chunk->hasArrays() );
+
+    GpuBufferArena::Range expected;
+    expected.block       = BlockOf( *base );
+    expected.firstVertex = 90000;
+    expected.firstIndex  = 3;
+    CHECK( Holds( arena, expected, vertices, indices ) );
+}
+
+int main()
+{
+    Coalesce();
+    Oversized();
+    Sliced();
+    Defragment();
+    Reread();
+
+    GpuBufferArena::Stats stats = GpuBufferArena::Instance().stats();
+    CHECK( stats.blocks == 1 && stats.ranges == 0 && stats.usedBytes == 0 );
+
+    std::printf( "%llu bytes moved by defragment()\n", stats.movedBytes );
+
+    return 0;
+}
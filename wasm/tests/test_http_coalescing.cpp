@@ -0,0 +1,321 @@
+#include <atomic>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <emscripten/threading.h>
+
+#include <aakara/fetch.hpp>
+
+#include "Check.hpp"
+
+// HTTP::Client against an in-process server: identical requests in flight together share one transport
+// request and one Response, cancelled waiters are dropped, and the last one aborts the request.
+
+/**
+ * @brief Transport answering from a table of paths. Requests are held until respond() is called, from
+ * whichever thread calls it, like responses arriving from the network.
+ */
+class LoopbackServer : public HTTP::Transport
+{
+public:
+    struct Sent
+    {
+        string              url;
+        Array<HTTP::Header> headers;
+        Done                done;
+    };
+
+    std::map<string, string> files;
+
+    u32 send( const string& url, const Array<HTTP::Header>& headers, Done done ) override
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        u32 id = m_nextId++;
+        m_sent.emplace( id, Sent { url, headers, std::move( done ) } );
+        m_sends++;
+        return id;
+    }
+
+    void abort( u32 request ) override
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+
+        if ( m_sent.erase( request ) )
+            m_aborts++;
+    }
+
+    /**
+     * @brief Answer the oldest held request. Returns false if none is held.
+     */
+    bool respond()
+    {
+        Sent sent;
+        {
+            std::lock_guard<std::mutex> lock( m_mutex );
+            if ( m_sent.empty() )
+                return false;
+
+            sent = std::move( m_sent.begin()->second );
+            m_sent.erase( m_sent.begin() );
+        }
+
+        Ptr<HTTP::Response> response = std::make_shared<HTTP::Response>();
+        response->url                = sent.url;
+
+        auto file = files.find( sent.url );
+        if ( file == files.end() )
+        {
+            response->status = 404;
+        }
+        else
+        {
+            response->status = 200;
+            response->body   = HTTP::Body( Array<u8>( file->second.begin(), file->second.end() ) );
+            response->headers.push_back( { "Content-Length", std::to_string( file->second.size() ) } );
+        }
+
+        sent.done( response );
+        return true;
+    }
+
+    const Sent& last()
+    {
+        std::lock_guard<std::mutex> lock( m_mutex );
+        return m_sent.rbegin()->second;
+    }
+
+    u32 sends() const
+    {
+        return m_sends;
+    }
+
+    u32 aborts() const
+    {
+        return m_aborts;
+    }
+
+private:
+    std::mutex          m_mutex;
+    std::map<u32, Sent> m_sent;
+    u32                 m_nextId = 1;
+    std::atomic<u32>    m_sends { 0 };
+    std::atomic<u32>    m_aborts { 0 };
+};
+
+static string Text( const HTTP::Body& body )
+{
+    return string( (const char*)body.data(), body.size() );
+}
+
+static void Coalescing()
+{
+    Ptr<LoopbackServer> server = std::make_shared<LoopbackServer>();
+    server->files["/a.bin"]    = "mesh bytes";
+
+    HTTP::Client client( server );
+
+    Array<Ptr<const HTTP::Response>> received;
+    HTTP::Callback                   keep = [&received]( const Ptr<const HTTP::Response>& response )
+    { received.push_back( response ); };
+
+    for ( u32 i = 0; i < 3; i++ )
+        client.get( "/a.bin", { {}, keep } );
+
+    CHECK( server->sends() == 1 );
+    CHECK( client.getInFlight() == 1 );
+
+    CHECK( server->respond() );
+    CHECK( received.size() == 3 );
+    CHECK( client.getInFlight() == 0 );
+
+    // one response and one body for every waiter
+    for ( const Ptr<const HTTP::Response>& response : received )
+    {
+        CHECK( response == received[0] );
+        CHECK( response->ok() );
+        CHECK( Text( response->body ) == "mesh bytes" );
+        CHECK( response->header( "content-length" ) == "10" );
+    }
+
+    // a request made after the response arrived goes out again
+    client.get( "/a.bin", { {}, keep } );
+    CHECK( server->sends() == 2 );
+    CHECK( server->respond() );
+    CHECK( received.size() == 4 && received[3] != received[0] );
+}
+
+static void Headers()
+{
+    Ptr<LoopbackServer> server = std::make_shared<LoopbackServer>();
+    HTTP::Client        client( server );
+
+    u32            calls = 0;
+    HTTP::Callback count = [&calls]( const Ptr<const HTTP::Response>& response )
+    {
+        CHECK( response->status == 404 && !response->ok() );
+        calls++;
+    };
+
+    client.get( "/b.bin", { { { "Range", "bytes=0-99" } }, count } );
+    CHECK( server->last().headers.size() == 1 );
+    CHECK( server->last().headers[0].Value == "bytes=0-99" );
+
+    // different headers are a different request, the same ones join it
+    client.get( "/b.bin", { { { "Range", "bytes=100-199" } }, count } );
+    client.get( "/b.bin", { { { "Range", "bytes=0-99" } }, count } );
+    CHECK( server->sends() == 2 );
+
+    while ( server->respond() )
+        ;
+
+    CHECK( calls == 3 );
+}
+
+static void Cancelling()
+{
+    Ptr<LoopbackServer> server = std::make_shared<LoopbackServer>();
+    server->files["/c.bin"]    = "c";
+
+    HTTP::Client client( server );
+
+    u32            calls = 0;
+    HTTP::Callback count = [&calls]( const Ptr<const HTTP::Response>& ) { calls++; };
+
+    u64 first  = client.get( "/c.bin", { {}, count } );
+    u64 second = client.get( "/c.bin", { {}, count } );
+
+    // the other waiter keeps the request alive
+    CHECK( client.cancel( first ) );
+    CHECK( !client.cancel( first ) );
+    CHECK( server->aborts() == 0 );
+
+    CHECK( client.cancel( second ) );
+    CHECK( server->aborts() == 1 );
+    CHECK( client.getInFlight() == 0 );
+    CHECK( !server->respond() );
+    CHECK( calls == 0 );
+
+    u64 third = client.get( "/c.bin", { {}, count } );
+    client.get( "/c.bin", { {}, count } );
+    CHECK( client.cancel( third ) );
+    CHECK( server->respond() );
+    CHECK( calls == 1 );
+
+    // too late once the callback ran
+    CHECK( !client.cancel( third + 1 ) );
+}
+
+static void Concurrent()
+{
+    const u32 Threads = 8;
+    const u32 Files   = 50;
+
+    Ptr<LoopbackServer> server = std::make_shared<LoopbackServer>();
+    for ( u32 f = 0; f < Files; f++ )
+        server->files["/" + std::to_string( f )] = std::to_string( f * f );
+
+    HTTP::Client client( server );
+
+    std::atomic<u32>  calls { 0 };
+    std::atomic<bool> done { false };
+
+    // responses arrive on a network thread while requests are still being made
+    std::thread network(
+        [&]()
+        {
+            while ( !done )
+            {
+                if ( !server->respond() )
+                    std::this_thread::yield();
+            }
+
+            while ( server->respond() )
+                ;
+        } );
+
+    Array<std::thread> threads;
+    for ( u32 t = 0; t < Threads; t++ )
+    {
+        threads.emplace_back(
+            [&client, &calls]()
+            {
+                for ( u32 f = 0; f < Files; f++ )
+                {
+                    string path = "/" + std::to_string( f );
+                    client.get( path,
+                        { {},
+                            [&calls, f]( const Ptr<const HTTP::Response>& response )
+                            {
+                                CHECK( Text( response->body ) == std::to_string( f * f ) );
+                                calls++;
+                            } } );
+                }
+            } );
+    }
+
+    for ( std::thread& thread : threads )
+        thread.join();
+
+    done = true;
+    network.join();
+
+    CHECK( calls == Threads * Files );
+    CHECK( client.getInFlight() == 0 );
+    CHECK( server->sends() >= Files && server->sends() <= Threads * Files );
+}
+
+static void DefaultClient()
+{
+    Ptr<LoopbackServer> server = std::make_shared<LoopbackServer>();
+    server->files["/d.bin"]    = "d";
+
+    HTTP::SetTransport( server );
+
+    u32 calls = 0;
+    HTTP::GET( "/d.bin", [&calls]( const Ptr<const HTTP::Response>& response ) { calls += response->ok(); } );
+    u64 ticket = HTTP::GET( "/d.bin", [&calls]( const Ptr<const HTTP::Response>& ) { calls += 10; } );
+
+    CHECK( HTTP::Cancel( ticket ) );
+    CHECK( server->respond() );
+    CHECK( calls == 1 );
+}
+
+static void Fetch()
+{
+    // emscripten_fetch fails every request natively: a status 0 response, reported exactly once
+    CHECK( emscripten_is_main_runtime_thread() );
+
+    HTTP::Client client( std::make_shared<HTTP::FetchTransport>() );
+
+    std::atomic<u32> errors { 0 };
+    HTTP::Callback   count = [&errors]( const Ptr<const HTTP::Response>& response )
+    {
+        CHECK( response->status == 0 && response->body.empty() );
+        errors++;
+    };
+
+    client.get( "/e.bin", { {}, count } );
+    CHECK( errors == 1 );
+
+    // off the main thread the fetch starts once the main thread gets to it
+    std::thread worker( [&]() { client.get( "/f.bin", { {}, count } ); } );
+    worker.join();
+
+    CHECK( errors == 1 );
+    CHECK( aakara_stub_run_main_thread_calls() == 1 );
+    CHECK( errors == 2 );
+}
+
+int main()
+{
+    Coalescing();
+    Headers();
+    Cancelling();
+    Concurrent();
+    DefaultClient();
+    Fetch();
+
+    return 0;
+}
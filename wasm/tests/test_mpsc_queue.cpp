@@ -0,0 +1,125 @@
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+#include <aakara/MpscQueue.hpp>
+
+#include "Check.hpp"
+
+// Producers hammer a small ring with move-only payloads while the consumer drains it. Configure with
+// -DAAKARA_TSAN=ON to run it under ThreadSanitizer.
+
+static const u32 Producers   = 4;
+static const u32 PerProducer = 50000;
+
+static std::atomic<u32> g_alive { 0 };
+
+struct Payload
+{
+    Payload( u32 producer, u32 sequence )
+        : producer( producer ), sequence( sequence )
+    {
+        g_alive++;
+    }
+
+    ~Payload()
+    {
+        g_alive--;
+    }
+
+    u32 producer;
+    u32 sequence;
+};
+
+static void Stress()
+{
+    MpscQueue<UPtr<Payload>> queue( 64 );
+    std::atomic<u32>         started { 0 };
+
+    Array<std::thread> producers;
+    for ( u32 p = 0; p < Producers; p++ )
+    {
+        producers.emplace_back(
+            [&queue, &started, p]()
+            {
+                started++;
+                while ( started.load() < Producers )
+                    std::this_thread::yield();
+
+                for ( u32 i = 0; i < PerProducer; i++ )
+                {
+                    UPtr<Payload> payload = std::make_unique<Payload>( p, i );
+
+                    // a full ring leaves the payload with the producer
+                    while ( !queue.tryPush( std::move( payload ) ) )
+                    {
+                        CHECK( payload );
+                        std::this_thread::yield();
+                    }
+                }
+            } );
+    }
+
+    Array<u32> next( Producers, 0 );
+    u32        received = 0;
+
+    while ( received < Producers * PerProducer )
+    {
+        size_t drained = queue.drain(
+            [&next]( UPtr<Payload>&& payload )
+            {
+                CHECK( payload );
+                CHECK( payload->producer < Producers );
+
+                // each producer's items arrive in the order it pushed them
+                CHECK( payload->sequence == next[payload->producer] );
+                next[payload->producer]++;
+            } );
+
+        received += (u32)drained;
+
+        if ( drained == 0 )
+            std::this_thread::yield();
+    }
+
+    for ( std::thread& producer : producers )
+        producer.join();
+
+    UPtr<Payload> extra;
+    CHECK( !queue.tryPop( extra ) );
+    CHECK( g_alive == 0 );
+
+    std::printf(
+        "%u items from %u producers through a ring of %zu\n", received, Producers, queue.capacity() );
+}
+
+static void FullRing()
+{
+    {
+        MpscQueue<UPtr<Payload>> queue( 3 );
+        CHECK( queue.capacity() == 4 );
+
+        for ( u32 i = 0; i < 4; i++ )
+            CHECK( queue.tryPush( std::make_unique<Payload>( 0, i ) ) );
+
+        UPtr<Payload> rejected = std::make_unique<Payload>( 0, 4 );
+        CHECK( !queue.tryPush( std::move( rejected ) ) );
+        CHECK( rejected && rejected->sequence == 4 );
+
+        UPtr<Payload> first;
+        CHECK( queue.tryPop( first ) && first->sequence == 0 );
+        CHECK( queue.tryPush( std::move( rejected ) ) );
+        CHECK( g_alive == 5 );
+    }
+
+    // the queue destroys what was never popped
+    CHECK( g_alive == 0 );
+}
+
+int main()
+{
+    FullRing();
+    Stress();
+
+    return 0;
+}
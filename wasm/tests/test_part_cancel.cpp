@@ -0,0 +1,261 @@
+#include <algorithm>
+#include <cstdio>
+#include <emscripten/emscripten.h>
+#include <glm/mat4x4.hpp>
+
+#include <aakara/ChunkedMesh.hpp>
+#include <aakara/JobSystem.hpp>
+#include <aakara/MemoryBudget.hpp>
+#include <aakara/Mesh.hpp>
+#include <aakara/Part.hpp>
+#include <aakara/PartLoader.hpp>
+#include <aakara/Texture.hpp>
+#include <aakara/Transform.hpp>
+
+#include "Check.hpp"
+#include "RangeServer.hpp"
+
+// PartLoader::cancel(): a cancelled part's pending, deferred and issued requests are dropped, issued ones
+// aborted through HTTP::Cancel(), assets shared with parts still loading carry on, and a cancelled part is
+// never handed over.
+
+/**
+ * @brief What a test frame runs against: the server, the job system and the queues the loader fills.
+ */
+struct Harness
+{
+    Ptr<RangeServer>       server = std::make_shared<RangeServer>();
+    JobSystem              jobs { 2 };
+    MpscQueue<Ref<Part>>   completed { 16 };
+    MpscQueue<LoadedChunk> chunks { 64 };
+    MemoryBudget           budget;
+
+    // every part handed over so far
+    Array<Ref<Part>> loaded;
+
+    /**
+     * @brief One frame of App: update the loader, let the server answer and the decodes finish.
+     */
+    void frame( PartLoader& loader )
+    {
+        loader.update( glm::mat4( 1.0f ), glm::vec3( 0.0f, 0.0f, 10.0f ) );
+        server->respond();
+        jobs.waitForTasks();
+
+        completed.drain( [this]( Ref<Part> part ) { loaded.push_back( part ); } );
+        chunks.drain( []( LoadedChunk ) {} );
+    }
+
+    /**
+     * @brief Run frames until the part is handed over.
+     */
+    void finish( PartLoader& loader, const Ref<Part>& part )
+    {
+        double start = emscripten_get_now();
+        while ( std::find( loaded.begin(), loaded.end(), part ) == loaded.end() )
+        {
+            CHECK( emscripten_get_now() - start < 10000.0 );
+            frame( loader );
+        }
+    }
+
+    u32 sent( const string& url ) const
+    {
+        return (u32)std::count( server->sent.begin(), server->sent.end(), url );
+    }
+};
+
+// requests that have not gone out are dropped, the others' part loads as usual
+static void Pending( Harness& h )
+{
+    PartLoader loader( h.jobs, h.completed, h.chunks, h.budget, 2, nullptr );
+
+    Ref<Part> a = loader.load( "/a.akc", "/a.png", MakeRef<Transform>() );
+    Ref<Part> b = loader.load( "/b.akc", "/b.png", MakeRef<Transform>() );
+
+    // equal requests go in the order they were made
+    loader.update( glm::mat4( 1.0f ), glm::vec3( 0.0f ) );
+    CHECK( h.server->held() == 2 && h.server->holds( "/a.akc" ) && h.server->holds( "/a.png" ) );
+    CHECK( loader.getPending() == 2 );
+
+    u32 aborted = h.server->aborted;
+    loader.cancel( *b );
+    h.finish( loader, a );
+
+    CHECK( h.loaded.back() == a && a->texture && !a->failed );
+    CHECK( h.sent( "/b.akc" ) == 0 && h.sent( "/b.png" ) == 0 );
+    CHECK( h.server->aborted == aborted );
+    CHECK( loader.getPending() == 0 && loader.getInFlight() == 0 );
+}
+
+// requests in flight are aborted, and a later load of an abandoned asset starts over
+static void Issued( Harness& h )
+{
+    PartLoader loader( h.jobs, h.completed, h.chunks, h.budget, 4, nullptr );
+
+    Ref<Part> a = loader.load( "/a.akc", "/a.png", MakeRef<Transform>() );
+    loader.update( glm::mat4( 1.0f ), glm::vec3( 0.0f ) );
+    CHECK( h.server->held() == 2 );
+
+    u32 aborted = h.server->aborted;
+    u32 texture = h.sent( "/a.png" );
+
+    // requests are let go by the next update()
+    loader.cancel( *a );
+    CHECK( loader.getInFlight() == 2 && h.server->held() == 2 );
+
+    loader.update( glm::mat4( 1.0f ), glm::vec3( 0.0f ) );
+    CHECK( h.server->aborted == aborted + 2 && h.server->held() == 0 );
+    CHECK( loader.getInFlight() == 0 && loader.getPending() == 0 );
+
+    size_t loaded = h.loaded.size();
+    for ( u32 i = 0; i < 3; i++ )
+        h.frame( loader );
+
+    CHECK( h.loaded.size() == loaded );
+
+    Ref<Part> c = loader.load( "/c.akc", "/a.png", MakeRef<Transform>() );
+    h.finish( loader, c );
+
+    CHECK( h.sent( "/a.png" ) == texture + 1 && c->texture );
+    CHECK( h.loaded.size() == loaded + 1 );
+}
+
+// a shared asset carries on while any part waits for it, and is aborted once none does
+static void Shared( Harness& h )
+{
+    PartLoader loader( h.jobs, h.completed, h.chunks, h.budget, 8, nullptr );
+
+    Ref<Part> a = loader.load( "/a.akc", "/shared.png", MakeRef<Transform>() );
+    Ref<Part> b = loader.load( "/b.akc", "/shared.png", MakeRef<Transform>() );
+    Ref<Part> c = loader.load( "/c.akc", "/shared.png", MakeRef<Transform>() );
+
+    loader.update( glm::mat4( 1.0f ), glm::vec3( 0.0f ) );
+    CHECK( h.server->held() == 4 && h.sent( "/shared.png" ) == 1 );
+
+    u32 aborted = h.server->aborted;
+
+    loader.cancel( *a );
+    loader.update( glm::mat4( 1.0f ), glm::vec3( 0.0f ) );
+    CHECK( h.server->aborted == aborted + 1 && !h.server->holds( "/a.akc" ) );
+    CHECK( h.server->holds( "/shared.png" ) );
+
+    loader.cancel( *b );
+    loader.update( glm::mat4( 1.0f ), glm::vec3( 0.0f ) );
+    CHECK( h.server->aborted == aborted + 2 && h.server->holds( "/shared.png" ) );
+
+    size_t loaded = h.loaded.size();
+    h.finish( loader, c );
+    CHECK( h.loaded.size() == loaded + 1 && c->texture && !c->failed );
+
+    // both waiters of the other texture go: it is aborted with their meshes
+    Ref<Part> d = loader.load( "/d.akc", "/other.png", MakeRef<Transform>() );
+    Ref<Part> e = loader.load( "/e.akc", "/other.png", MakeRef<Transform>() );
+
+    loader.update( glm::mat4( 1.0f ), glm::vec3( 0.0f ) );
+    CHECK( h.server->held() == 3 );
+
+    aborted = h.server->aborted;
+    loader.cancel( *d );
+    loader.cancel( *e );
+    loader.update( glm::mat4( 1.0f ), glm::vec3( 0.0f ) );
+    CHECK( h.server->aborted == aborted + 3 && h.server->held() == 0 );
+    CHECK( loader.getInFlight() == 0 && loader.getPending() == 0 );
+}
+
+// a fetched asset waiting for the budget is freed, and chunks not requested yet are dropped
+static void Deferred( Harness& h )
+{
+    PartLoader loader( h.jobs, h.completed, h.chunks, h.budget, 4, nullptr );
+
+    // stands in for a decode in flight, so that an asset over the budget waits instead of failing
+    MemoryBudget::Estimate decoding { 1, 0 };
+    u32                    levels = 0;
+    CHECK( h.budget.admit( decoding, false, levels ) == MemoryBudget::Decision::Admit );
+    h.budget.setLimits( 1, 0 );
+
+    Ref<Part> a = loader.load( "/big.akc", "/a.png", MakeRef<Transform>() );
+    h.frame( loader );
+    h.frame( loader );
+
+    // the texture waits for the budget with its response, the chunks past the probe for room to load
+    CHECK( loader.getInFlight() == 0 && loader.getPending() > 1 );
+    CHECK( Memory::Usage( MemoryTag::Loader ) > 0 );
+
+    u32    requests = h.server->requests;
+    size_t loaded   = h.loaded.size();
+
+    loader.cancel( *a );
+    h.frame( loader );
+    CHECK( loader.getPending() == 0 && Memory::Usage( MemoryTag::Loader ) == 0 );
+
+    h.budget.release( decoding );
+    h.budget.setLimits( 0, 0 );
+
+    for ( u32 i = 0; i < 3; i++ )
+        h.frame( loader );
+
+    CHECK( h.server->requests == requests && h.loaded.size() == loaded );
+}
+
+// a response arriving between cancel() and the next update() is still decoded, but the part it completes is
+// not handed over
+static void Late( Harness& h )
+{
+    PartLoader loader( h.jobs, h.completed, h.chunks, h.budget, 1, nullptr );
+
+    // the chunk table first, then the texture once it is answered
+    Ref<Part> a = loader.load( "/a.akc", "/late.png", MakeRef<Transform>() );
+    loader.update( glm::mat4( 1.0f ), glm::vec3( 0.0f ) );
+    CHECK( h.server->held() == 1 && h.server->holds( "/a.akc" ) );
+
+    h.server->respond();
+    h.jobs.waitForTasks();
+    CHECK( h.server->held() == 1 && h.server->holds( "/late.png" ) );
+
+    u32    aborted = h.server->aborted;
+    size_t loaded  = h.loaded.size();
+
+    loader.cancel( *a );
+    h.server->respond();
+    h.jobs.waitForTasks();
+
+    for ( u32 i = 0; i < 3; i++ )
+        h.frame( loader );
+
+    CHECK( h.server->aborted == aborted && h.loaded.size() == loaded );
+    CHECK( loader.getInFlight() == 0 && loader.getPending() == 0 );
+}
+
+int main()
+{
+    Array<u8> small;
+    ChunkedMesh::Write( { Grid( 8 ) }, small );
+
+    // large enough for chunks past the table probe
+    Array<u8> big;
+    ChunkedMesh::Write( ChunkedMesh::Split( *Grid( 64 ), 512 ), big );
+    CHECK( big.size() > 16384 );
+
+    Harness h;
+    for ( const char* name : { "/a.akc", "/b.akc", "/c.akc", "/d.akc", "/e.akc" } )
+        h.server->files[name] = small;
+
+    h.server->files["/big.akc"] = big;
+
+    for ( const char* name : { "/a.png", "/b.png", "/shared.png", "/other.png", "/late.png" } )
+        h.server->files[name] = Array<u8>( Png, Png + sizeof( Png ) );
+
+    HTTP::SetTransport( h.server );
+
+    Pending( h );
+    Issued( h );
+    Shared( h );
+    Deferred( h );
+    Late( h );
+
+    std::printf( "%u requests, %u aborted, %zu parts handed over\n", h.server->requests, h.server->aborted,
+        h.loaded.size() );
+
+    return 0;
+}
@@ -0,0 +1,134 @@
+#include <cstdio>
+
+#include <aakara/HandleTable.hpp>
+#include <aakara/PartTable.hpp>
+
+#include "Check.hpp"
+
+static void Handles()
+{
+    HandleTable<u32> table;
+
+    u32 a = table.insert( 10 );
+    u32 b = table.insert( 20 );
+    u32 c = table.insert( 30 );
+    CHECK( a != HandleTable<u32>::Invalid && b != a && c != b );
+    CHECK( !table.contains( HandleTable<u32>::Invalid ) && !table.get( HandleTable<u32>::Invalid ) );
+
+    // the last value fills the hole, and its handle still finds it
+    CHECK( table.remove( a ) );
+    CHECK( !table.remove( a ) );
+    CHECK( table.size() == 2 && table.values()[0] == 30 && table.handles()[0] == c );
+    CHECK( *table.get( b ) == 20 && *table.get( c ) == 30 );
+
+    // the freed slot is reused under a new generation: the stale handle does not alias the new value
+    u32 d = table.insert( 40 );
+    CHECK( ( d & HandleTable<u32>::INDEX_MASK ) == ( a & HandleTable<u32>::INDEX_MASK ) );
+    CHECK( d != a && !table.get( a ) && *table.get( d ) == 40 );
+
+    // a slot cycled through every generation skips 0 and never hands out Invalid
+    u32 handle = d;
+    for ( u32 i = 0; i < ( 1u << ( 32 - HandleTable<u32>::INDEX_BITS ) ) + 2; i++ )
+    {
+        CHECK( table.remove( handle ) );
+        handle = table.insert( i );
+        CHECK( handle != HandleTable<u32>::Invalid && *table.get( handle ) == i );
+    }
+
+    table.clear();
+    CHECK( table.size() == 0 && !table.get( b ) && !table.get( c ) && !table.get( handle ) );
+}
+
+static void Full()
+{
+    HandleTable<u8> table;
+    for ( u32 i = 0; i <= HandleTable<u8>::INDEX_MASK; i++ )
+        CHECK( table.insert( 0 ) != HandleTable<u8>::Invalid );
+
+    CHECK( table.insert( 0 ) == HandleTable<u8>::Invalid );
+
+    u32 last = table.handles().back();
+    CHECK( table.remove( last ) );
+    CHECK( table.insert( 0 ) != HandleTable<u8>::Invalid );
+}
+
+static void Names()
+{
+    PartTable parts;
+
+    u32 a = parts.insert( MakeRef<Part>() );
+    u32 b = parts.insert( MakeRef<Part>() );
+    u32 c = parts.insert( MakeRef<Part>() );
+
+    parts.setName( a, "wheel" );
+    parts.setName( b, "door" );
+    CHECK( parts.find( "wheel" ) == a && parts.find( "door" ) == b && parts.find( "hood" ) == 0 );
+
+    // renaming frees the old name
+    parts.setName( a, "tyre" );
+    CHECK( parts.find( "wheel" ) == 0 && parts.find( "tyre" ) == a && ( *parts.get( a ) )->name == "tyre" );
+
+    // a taken name moves, and the part that had it is left unnamed
+    parts.setName( c, "door" );
+    CHECK( parts.find( "door" ) == c && ( *parts.get( b ) )->name.empty() && parts.nameCount() == 2 );
+
+    parts.setName( c, "" );
+    CHECK( parts.find( "door" ) == 0 && parts.nameCount() == 1 );
+
+    // unknown ids are ignored
+    parts.setName( 0, "ghost" );
+    parts.setName( c + ( 1u << HandleTable<Ref<Part>>::INDEX_BITS ), "ghost" );
+    CHECK( parts.find( "ghost" ) == 0 );
+
+    // removal drops the name with the part, so a reused slot is not found under it
+    CHECK( parts.remove( a ) );
+    CHECK( parts.find( "tyre" ) == 0 && parts.nameCount() == 0 && !parts.get( a ) );
+
+    u32 reused = parts.insert( MakeRef<Part>() );
+    CHECK( reused != a && parts.find( "tyre" ) == 0 );
+
+    parts.setName( b, "door" );
+    parts.clear();
+    CHECK( parts.size() == 0 && parts.nameCount() == 0 && parts.find( "door" ) == 0 );
+}
+
+// App reserves an id before the loader returns the part, names may be set while it loads, and a failed load
+// removes it again
+static void FailedLoad()
+{
+    PartTable parts;
+
+    u32 id = parts.insert( nullptr );
+    CHECK( id != PartTable::Invalid && parts.get( id ) && !*parts.get( id ) );
+
+    // nothing to name until the part is in place
+    parts.setName( id, "early" );
+    CHECK( parts.find( "early" ) == 0 );
+
+    Ref<Part> part   = MakeRef<Part>();
+    part->handle     = id;
+    *parts.get( id ) = part;
+
+    parts.setName( id, "bolt" );
+    CHECK( parts.find( "bolt" ) == id );
+
+    part->failed = true;
+    CHECK( parts.remove( part->handle ) );
+    CHECK( parts.find( "bolt" ) == 0 && parts.nameCount() == 0 && parts.size() == 0 );
+
+    // a reserved entry that never got its part is removed as well
+    u32 reserved = parts.insert( nullptr );
+    CHECK( parts.remove( reserved ) && parts.size() == 0 );
+}
+
+int main()
+{
+    Handles();
+    Full();
+    Names();
+    FailedLoad();
+
+    std::printf( "part table ok\n" );
+
+    return 0;
+}
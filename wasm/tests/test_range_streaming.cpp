@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <cstdio>
+#include <map>
+#include <set>
+#include <thread>
+#include <emscripten/emscripten.h>
+#include <glm/mat4x4.hpp>
+
+#include <aakara/ChunkedMesh.hpp>
+#include <aakara/JobSystem.hpp>
+#include <aakara/MemoryBudget.hpp>
+#include <aakara/Mesh.hpp>
+#include <aakara/Part.hpp>
+#include <aakara/PartLoader.hpp>
+#include <aakara/Texture.hpp>
+#include <aakara/Transform.hpp>
+
+#include "Check.hpp"
+#include "RangeServer.hpp"
+
+// PartLoader streaming a chunked mesh from a range-capable server: the chunk table comes first, every chunk
+// follows in a range request of its own, transient failures are retried and no response holds more than a
+// chunk.
+
+static const u32 ChunkVertices = 4096;
+static const u32 MaxInFlight   = 2;
+
+static string RangeOf( const ChunkedMesh::Chunk& chunk )
+{
+    return "bytes=" + std::to_string( chunk.offset ) + "-" + std::to_string( chunk.offset + chunk.size - 1 );
+}
+
+int main()
+{
+    Ref<Mesh>        grid   = Grid( 200 );
+    Array<Ref<Mesh>> pieces = ChunkedMesh::Split( *grid, ChunkVertices );
+
+    Array<u8> file;
+    ChunkedMesh::Write( pieces, file );
+
+    Array<ChunkedMesh::Chunk> table;
+    size_t                    required = 0;
+    CHECK( ChunkedMesh::ReadTable( file.data(), file.size(), table, required ) );
+    CHECK( table.size() == pieces.size() && table.size() > 4 );
+
+    u32 largestChunk  = 0;
+    u32 chunkVertices = 0;
+    for ( const ChunkedMesh::Chunk& chunk : table )
+    {
+        largestChunk = std::max( largestChunk, chunk.size );
+        chunkVertices += chunk.vertexCount;
+    }
+
+    Ptr<RangeServer> server      = std::make_shared<RangeServer>();
+    server->files["/grid.akc"]   = file;
+    server->files["/broken.akc"] = file;
+    server->files["/white.png"]  = Array<u8>( Png, Png + sizeof( Png ) );
+
+    // a 503 and a network error are retried, a 404 is not
+    server->failures["/grid.akc " + RangeOf( table[1] )]   = { 503, 1 };
+    server->failures["/grid.akc " + RangeOf( table[2] )]   = { 0, 2 };
+    server->failures["/broken.akc " + RangeOf( table[3] )] = { 404, 1 };
+
+    HTTP::SetTransport( server );
+
+    JobSystem              jobs( 2 );
+    MpscQueue<Ref<Part>>   completed( 16 );
+    MpscQueue<LoadedChunk> chunks( 64 );
+    MemoryBudget           budget;
+
+    Array<Ref<Part>> parts;
+    {
+        PartLoader loader( jobs, completed, chunks, budget, MaxInFlight, nullptr );
+
+        Ref<Part> part   = loader.load( "/grid.akc", "/white.png", MakeRef<Transform>() );
+        Ref<Part> broken = loader.load( "/broken.akc", "/white.png", MakeRef<Transform>() );
+
+        std::map<Part*, std::set<u32>> received;
+        u32                            missing  = 0;
+        u32                            vertices = 0;
+
+        glm::mat4 viewProjection( 1.0f );
+        glm::vec3 eye( 0.0f, 0.0f, 10.0f );
+
+        double start = emscripten_get_now();
+        while ( received[part.get()].size() + received[broken.get()].size() < 2 * table.size() )
+        {
+            CHECK( emscripten_get_now() - start < 10000.0 );
+
+            loader.update( viewProjection, eye );
+
+            // the loader never has more requests out than allowed
+            CHECK( server->held() <= MaxInFlight );
+            server->respond();
+
+            jobs.waitForTasks();
+
+            completed.drain( [&parts]( Ref<Part> loaded ) { parts.push_back( loaded ); } );
+            chunks.drain(
+                [&]( LoadedChunk chunk )
+                {
+                    CHECK( received[chunk.part.get()].insert( chunk.index ).second );
+
+                    if ( !chunk.mesh )
+                    {
+                        missing++;
+                        return;
+                    }
+
+                    // uploaded as it lands, which frees its arrays
+                    vertices += (u32)chunk.mesh->Vertices.size();
+                    CHECK( chunk.mesh->update( nullptr ) );
+                    CHECK( !chunk.mesh->hasArrays() );
+                } );
+
+            std::this_thread::sleep_for( std::chrono::milliseconds( 5 ) );
+        }
+
+        CHECK( parts.size() == 2 );
+        CHECK( parts[0]->texture && parts[1]->texture );
+        CHECK( !parts[0]->mesh && !parts[1]->mesh );
+
+        // every chunk of the grid made it, the 404 chunk of the other file was given up
+        CHECK( missing == 1 );
+        CHECK( vertices == 2 * chunkVertices - table[3].vertexCount );
+
+        CHECK( loader.getInFlight() == 0 );
+        CHECK( loader.getPending() == 0 );
+    }
+
+    std::printf( "%zu chunks of %zu bytes, %u requests, largest response %zu bytes, peak held %llu bytes\n",
+                 table.size(), file.size(), server->requests, server->largestBody,
+                 Memory::Peak( MemoryTag::Loader ) );
+
+    // table probes, two files of chunks, three failed attempts and the shared texture
+    CHECK( server->requests == 2 + 2 * table.size() + 3 + 1 );
+
+    // the heap holds the chunks in flight, not the file: no response is larger than a chunk or the probe
+    size_t largest = std::max<size_t>( largestChunk, 16384 );
+    CHECK( server->largestBody <= largest );
+    CHECK( Memory::Peak( MemoryTag::Loader ) <= MaxInFlight * largest );
+    CHECK( Memory::Peak( MemoryTag::Loader ) < file.size() );
+
+    return 0;
+}